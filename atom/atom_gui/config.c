@@ -56,6 +56,8 @@ void set_nyx_default_configuration()
 	n_cfg.jc_disable = 0;
 	n_cfg.jc_force_right = 0;
 	n_cfg.bpmp_clock = 0;
+	n_cfg.crc32_sidecar = 0;
+	n_cfg.restore_readback = 0;
 }
 
 int create_config_entry()
@@ -224,6 +226,12 @@ int create_nyx_config_entry(bool force_unmount)
 	f_puts("\nbpmpclock=", &fp);
 	itoa(n_cfg.bpmp_clock, lbuf, 10);
 	f_puts(lbuf, &fp);
+	f_puts("\ncrc32sidecar=", &fp);
+	itoa(n_cfg.crc32_sidecar, lbuf, 10);
+	f_puts(lbuf, &fp);
+	f_puts("\nrestorereadback=", &fp);
+	itoa(n_cfg.restore_readback, lbuf, 10);
+	f_puts(lbuf, &fp);
 	f_puts("\n", &fp);
 
 	f_close(&fp);
@@ -51,6 +51,8 @@ typedef struct _nyx_config
 	u32 jc_disable;
 	u32 jc_force_right;
 	u32 bpmp_clock;
+	u32 crc32_sidecar;
+	u32 restore_readback;
 } nyx_config;
 
 void set_default_configuration();
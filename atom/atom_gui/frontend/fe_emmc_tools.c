@@ -24,6 +24,8 @@
 #include <bdk.h>
 
 #include "gui.h"
+#include "gui_log.h"
+#include "gui_progress.h"
 #include "fe_emmc_tools.h"
 #include "fe_emummc_tools.h"
 #include "../config.h"
@@ -32,6 +34,7 @@
 #define NUM_SECTORS_PER_ITER 8192 // 4MB Cache.
 #define OUT_FILENAME_SZ 128
 #define HASH_FILENAME_SZ (OUT_FILENAME_SZ + 11) // 11 == strlen(".sha256sums")
+#define RESTORE_MISMATCH_LOG_MAX 16
 
 extern nyx_config n_cfg;
 
@@ -126,6 +129,77 @@ static lv_obj_t *create_mbox_text(char *text, bool button_ok)
 	return dark_bg;
 }
 
+static int _dump_emmc_crc32_sidecar(emmc_tool_gui_t *gui, const char *outFilename, u32 crc32)
+{
+	const char *name = strrchr(outFilename, '/');
+	name = name ? name + 1 : outFilename;
+
+	char *path = (char *)malloc(strlen(outFilename) + 8);
+	char *txt = (char *)malloc(strlen(name) + 16);
+	s_printf(path, "%s.crc32", outFilename);
+	s_printf(txt, "%08X  %s\n", crc32, name);
+
+	int res = sd_save_to_file(txt, strlen(txt), path);
+
+	free(path);
+	free(txt);
+
+	if (res)
+	{
+		s_printf(gui->txt_buf,
+			"\n#FF0000 CRC32 file could not be written (error %d)!#\n"
+			"#FFDD00 Please try again...#\n", res);
+		nyx_log_append(gui->label_log, gui->txt_buf);
+		manual_system_maintenance(true);
+	}
+
+	return res;
+}
+
+static bool _emmc_crc32_sidecar_read(const char *outFilename, u32 *crc32)
+{
+	char *path = (char *)malloc(strlen(outFilename) + 8);
+	s_printf(path, "%s.crc32", outFilename);
+
+	u32 size = 0;
+	char *txt = (char *)sd_file_read(path, &size);
+	free(path);
+	if (!txt)
+		return false;
+
+	// Parsed here, since strtol saturates values above 0x7FFFFFFF.
+	u32 val = 0;
+	u32 i;
+	for (i = 0; i < 8 && i < size; i++)
+	{
+		char c = txt[i];
+		if (c >= '0' && c <= '9')
+			val = (val << 4) | (c - '0');
+		else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+			val = (val << 4) | ((c | 0x20) - 'a' + 10);
+		else
+			break;
+	}
+	free(txt);
+
+	if (i != 8)
+		return false;
+
+	*crc32 = val;
+
+	return true;
+}
+
+static void _emmc_crc32_sidecar_mismatch(emmc_tool_gui_t *gui, const char *outFilename, u32 expected, u32 crc32)
+{
+	s_printf(gui->txt_buf,
+		"\n#FF0000 %s does not match its CRC32 file!#\n"
+		"#FF0000 Expected %08X, got %08X.#\n",
+		outFilename + strlen(gui->base_path), expected, crc32);
+	nyx_log_append(gui->label_log, gui->txt_buf);
+	manual_system_maintenance(true);
+}
+
 static void _update_filename(char *outFilename, u32 sdPathLen, u32 currPartIdx)
 {
 	if (currPartIdx < 10)
@@ -140,9 +214,8 @@ static void _update_filename(char *outFilename, u32 sdPathLen, u32 currPartIdx)
 static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32 lba_curr, char *outFilename, emmc_part_t *part)
 {
 	FIL fp;
-	FIL hashFp;
+	FIL hashFp = {0};
 	u8 sparseShouldVerify = 4;
-	u32 prevPct = 200;
 	u32 sdFileSector = 0;
 	int res = 0;
 	const char hexa[] = "0123456789abcdef";
@@ -167,7 +240,7 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 				s_printf(gui->txt_buf,
 						"\n#FF0000 Hash file could not be written (error %d)!#\n"
 						"#FF0000 Aborting..#\n", res);
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				return 1;
@@ -184,16 +257,20 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 
 		u32 totalSectorsVer = (u32)((u64)f_size(&fp) >> (u64)9);
 
+		// Full verification reads the whole file, so it is also checked against its CRC32 file, if any.
+		u32 crc32 = 0, crc32Expected = 0;
+		bool crc32Check = n_cfg.verification >= 2 && _emmc_crc32_sidecar_read(outFilename, &crc32Expected);
+
 		u8 *bufEm = (u8 *)EMMC_BUF_ALIGNED;
 		u8 *bufSd = (u8 *)SDXC_BUF_ALIGNED;
 
+		nyx_progress_t prog;
+		nyx_progress_init(&prog, gui->bar, gui->label_pct, gui->txt_buf, part->lba_start, part->lba_end, lba_curr);
+
 		u32 pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(part->lba_end - part->lba_start);
-		lv_bar_set_value(gui->bar, pct);
 		lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, gui->bar_teal_bg);
 		lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_teal_ind);
-		s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
-		lv_label_set_text(gui->label_pct, gui->txt_buf);
-		manual_system_maintenance(true);
+		nyx_progress_set(&prog, pct);
 
 		clmt = f_expand_cltbl(&fp, SZ_4M, 0);
 
@@ -213,7 +290,7 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 						"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
 						"#FF0000 from eMMC! Verification failed..#\n",
 						num, lba_curr);
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					nyx_log_append(gui->label_log, gui->txt_buf);
 					manual_system_maintenance(true);
 
 					free(clmt);
@@ -233,7 +310,7 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 						"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
 						"#FF0000 from SD card! Verification failed..#\n",
 						num, lba_curr);
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					nyx_log_append(gui->label_log, gui->txt_buf);
 					manual_system_maintenance(true);
 
 					free(clmt);
@@ -244,6 +321,8 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 					return 1;
 				}
 				manual_system_maintenance(false);
+				if (crc32Check)
+					crc32 = crc32_calc(crc32, bufSd, num << 9);
 				se_calc_sha256_finalize(hashEm, NULL);
 				se_calc_sha256_oneshot(hashSd, bufSd, num << 9);
 				res = memcmp(hashEm, hashSd, SE_SHA_256_SIZE / 2);
@@ -254,7 +333,7 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 						"\n#FF0000 SD & eMMC data (@LBA %08X) do not match!#\n"
 						"\n#FF0000 Verification failed..#\n",
 						lba_curr);
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					nyx_log_append(gui->label_log, gui->txt_buf);
 					manual_system_maintenance(true);
 
 					free(clmt);
@@ -282,16 +361,6 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 				}
 			}
 
-			pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(part->lba_end - part->lba_start);
-			if (pct != prevPct)
-			{
-				lv_bar_set_value(gui->bar, pct);
-				s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
-				lv_label_set_text(gui->label_pct, gui->txt_buf);
-				manual_system_maintenance(true);
-				prevPct = pct;
-			}
-
 			manual_system_maintenance(false);
 
 			lba_curr += num;
@@ -299,11 +368,13 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 			sdFileSector += num;
 			sparseShouldVerify++;
 
+			nyx_progress_update(&prog, lba_curr);
+
 			// Check for cancellation combo.
 			if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
 			{
 				s_printf(gui->txt_buf, "#FFDD00 Verification was cancelled!#\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				msleep(1000);
@@ -319,23 +390,189 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 		f_close(&fp);
 		f_close(&hashFp);
 
-		lv_bar_set_value(gui->bar, pct);
-		s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
-		lv_label_set_text(gui->label_pct, gui->txt_buf);
-		manual_system_maintenance(true);
+		if (crc32Check && crc32 != crc32Expected)
+		{
+			_emmc_crc32_sidecar_mismatch(gui, outFilename, crc32Expected, crc32);
+			s_printf(gui->txt_buf, "#FF0000 Verification failed..#\n");
+			nyx_log_append(gui->label_log, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			return 1;
+		}
+
+		pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(part->lba_end - part->lba_start);
+		nyx_progress_set(&prog, pct);
 
 		return 0;
 	}
 	else
 	{
 		s_printf(gui->txt_buf, "\n#FFDD00 File not found or could not be loaded!#\n#FFDD00 Verification failed..#\n");
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		return 1;
 	}
 }
 
+static void _restore_emmc_log_mismatch(emmc_tool_gui_t *gui, u32 lba_first, u32 lba_last, u32 *regions)
+{
+	(*regions)++;
+	if (*regions > RESTORE_MISMATCH_LOG_MAX)
+		return;
+
+	s_printf(gui->txt_buf, "#FF0000 Mismatch @LBA %08X - %08X (%d blocks)#\n",
+		lba_first, lba_last, lba_last - lba_first + 1);
+	nyx_log_append(gui->label_log, gui->txt_buf);
+	manual_system_maintenance(true);
+}
+
+// Reads back the restored range and compares it against the chunk hashes taken while writing.
+// Mismatching chunks are compared per sector against the source file to report exact regions.
+static int _restore_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32 lba_curr, u32 lba_end,
+	const u8 *hashes, char *outFilename, emmc_part_t *part)
+{
+	FIL fp;
+	u32 lba_start = lba_curr;
+	u32 regions = 0;
+	u32 bad_sectors = 0;
+	u32 run_first = 0;
+	bool run_active = false;
+	bool src_open = f_open(&fp, outFilename, FA_READ) == FR_OK;
+	DWORD *clmt = src_open ? f_expand_cltbl(&fp, SZ_4M, 0) : NULL; // Needed by f_read_fast.
+
+	u8 hashEm[SE_SHA_256_SIZE];
+	u8 hashSd[SE_SHA_256_SIZE];
+
+	u8 *bufEm = (u8 *)EMMC_BUF_ALIGNED;
+	u8 *bufSd = (u8 *)SDXC_BUF_ALIGNED;
+
+	nyx_progress_t prog;
+	nyx_progress_init(&prog, gui->bar, gui->label_pct, gui->txt_buf, part->lba_start, part->lba_end, lba_curr);
+
+	u32 pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(part->lba_end - part->lba_start);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, gui->bar_teal_bg);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_teal_ind);
+	nyx_progress_set(&prog, pct);
+
+	while (lba_curr < lba_end)
+	{
+		u32 num = MIN(lba_end - lba_curr, NUM_SECTORS_PER_ITER);
+
+		if (!sdmmc_storage_read(storage, lba_curr, num, bufEm))
+		{
+			s_printf(gui->txt_buf,
+				"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
+				"#FF0000 from eMMC! Verification failed..#\n",
+				num, lba_curr);
+			nyx_log_append(gui->label_log, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			if (src_open)
+				f_close(&fp);
+			free(clmt);
+
+			return 1;
+		}
+		manual_system_maintenance(false);
+
+		se_calc_sha256_oneshot(hashEm, bufEm, num << 9);
+		if (memcmp(hashEm, hashes, SE_SHA_256_SIZE))
+		{
+			if (!regions && !run_active)
+			{
+				s_printf(gui->txt_buf, "\n");
+				nyx_log_append(gui->label_log, gui->txt_buf);
+			}
+
+			// Locate the bad sectors. If the source can't be read or differs from what was hashed while
+			// writing, blame the whole chunk. It still goes through the runs, so it merges with its neighbours.
+			bool src_read = src_open && !f_lseek(&fp, (u64)(lba_curr - lba_start) << (u64)9) &&
+				!f_read_fast(&fp, bufSd, num << 9);
+			if (src_read)
+			{
+				se_calc_sha256_oneshot(hashSd, bufSd, num << 9);
+				src_read = !memcmp(hashSd, hashes, SE_SHA_256_SIZE);
+			}
+
+			for (u32 i = 0; i < num; i++)
+			{
+				bool bad = !src_read || memcmp(bufEm + (i << 9), bufSd + (i << 9), EMMC_BLOCKSIZE);
+				if (bad)
+				{
+					bad_sectors++;
+					if (!run_active)
+					{
+						run_first = lba_curr + i;
+						run_active = true;
+					}
+				}
+				else if (run_active)
+				{
+					_restore_emmc_log_mismatch(gui, run_first, lba_curr + i - 1, &regions);
+					run_active = false;
+				}
+			}
+		}
+		else if (run_active)
+		{
+			_restore_emmc_log_mismatch(gui, run_first, lba_curr - 1, &regions);
+			run_active = false;
+		}
+
+		hashes += SE_SHA_256_SIZE;
+		lba_curr += num;
+
+		nyx_progress_update(&prog, lba_curr);
+
+		// Check for cancellation combo.
+		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
+		{
+			s_printf(gui->txt_buf, "#FFDD00 Verification was cancelled!#\n");
+			nyx_log_append(gui->label_log, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			msleep(1000);
+
+			if (src_open)
+				f_close(&fp);
+			free(clmt);
+
+			return 0;
+		}
+	}
+
+	if (run_active)
+		_restore_emmc_log_mismatch(gui, run_first, lba_end - 1, &regions);
+
+	if (src_open)
+		f_close(&fp);
+	free(clmt);
+
+	if (regions)
+	{
+		if (regions > RESTORE_MISMATCH_LOG_MAX)
+		{
+			s_printf(gui->txt_buf, "#FF0000 ...and %d more regions.#\n", regions - RESTORE_MISMATCH_LOG_MAX);
+			nyx_log_append(gui->label_log, gui->txt_buf);
+		}
+
+		s_printf(gui->txt_buf,
+			"#FF0000 %d blocks do not match the backup!#\n"
+			"#FF0000 Verification failed..#\n",
+			bad_sectors);
+		nyx_log_append(gui->label_log, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		return 1;
+	}
+
+	pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(part->lba_end - part->lba_start);
+	nyx_progress_set(&prog, pct);
+
+	return 0;
+}
+
 bool partial_sd_full_unmount = false;
 
 static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part, sdmmc_storage_t *storage, emmc_part_t *part)
@@ -371,7 +608,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 		if (!part_idx || !sector_size)
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 Failed to find a partition...#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			return 0;
@@ -409,13 +646,13 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 		isSmallSdCard = true;
 
 		s_printf(gui->txt_buf, "\n#FFBA00 Free space is smaller than backup size.#\n");
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		if (!maxSplitParts)
 		{
 			s_printf(gui->txt_buf, "#FFDD00 Not enough free space for Partial Backup!#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			return 0;
@@ -425,7 +662,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 	if (f_open(&partialIdxFp, partialIdxFilename, FA_READ) == FR_OK && totalSectors > (FAT32_FILESIZE_LIMIT / EMMC_BLOCKSIZE))
 	{
 		s_printf(gui->txt_buf, "\n#AEFD14 Partial Backup in progress. Continuing...#\n");
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		partialDumpInProgress = true;
@@ -438,7 +675,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 		if (!maxSplitParts)
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 Not enough free space for Partial Backup!#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			return 0;
@@ -450,7 +687,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 	else if (isSmallSdCard)
 	{
 		s_printf(gui->txt_buf, "\n#FFBA00 Partial Backup enabled (%d MiB parts)...#\n", multipartSplitSize >> 20);
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 	}
 
@@ -493,7 +730,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 	if (res)
 	{
 		s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while creating#\n#FFDD00 %s#\n", res, outFilename);
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		return 0;
@@ -504,8 +741,8 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 	u32 lba_curr = part->lba_start;
 	u32 lbaStartPart = part->lba_start;
 	u32 bytesWritten = 0;
-	u32 prevPct = 200;
 	int retryCount = 0;
+	u32 part_crc32 = 0;
 	DWORD *clmt = NULL;
 
 	// Continue from where we left, if Partial Backup in progress.
@@ -522,7 +759,9 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 		clmt = f_expand_cltbl(&fp, SZ_4M, MIN(totalSize, multipartSplitSize));
 
 	u32 num = 0;
-	u32 pct = 0;
+
+	nyx_progress_t prog;
+	nyx_progress_init(&prog, gui->bar, gui->label_pct, gui->txt_buf, part->lba_start, lba_end, lba_curr);
 
 	lv_obj_set_opa_scale(gui->bar, LV_OPA_COVER);
 	lv_obj_set_opa_scale(gui->label_pct, LV_OPA_COVER);
@@ -533,6 +772,11 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 			f_close(&fp);
 			free(clmt);
 			memset(&fp, 0, sizeof(fp));
+
+			if (n_cfg.crc32_sidecar && _dump_emmc_crc32_sidecar(gui, outFilename, part_crc32))
+				return 0;
+			part_crc32 = 0;
+
 			currPartIdx++;
 
 			if (n_cfg.verification && !gui->raw_emummc)
@@ -541,13 +785,16 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 				if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part))
 				{
 					s_printf(gui->txt_buf, "#FFDD00 Please try again...#\n");
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					nyx_log_append(gui->label_log, gui->txt_buf);
 					manual_system_maintenance(true);
 
 					return 0;
 				}
 				lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, lv_theme_get_current()->bar.bg);
 				lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_white_ind);
+
+				// Restart rate tracking after verification.
+				nyx_progress_init(&prog, gui->bar, gui->label_pct, gui->txt_buf, part->lba_start, lba_end, lba_curr);
 			}
 
 			_update_filename(outFilename, sdPathLen, currPartIdx);
@@ -564,7 +811,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 				else
 				{
 					s_printf(gui->txt_buf, "#FF0000 Error creating partial.idx file!#\n");
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					nyx_log_append(gui->label_log, gui->txt_buf);
 					manual_system_maintenance(true);
 
 					return 0;
@@ -599,7 +846,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 			if (res)
 			{
 				s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while creating#\n#FFDD00 %s#\n", res, outFilename);
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				return 0;
@@ -626,14 +873,14 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 				"\n#FFDD00 Error reading %d blocks @ LBA %08X,#\n"
 				"#FFDD00 from eMMC (try %d). #",
 				num, lba_curr, ++retryCount);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			msleep(150);
 			if (retryCount >= 3)
 			{
 				s_printf(gui->txt_buf, "#FF0000 Aborting...#\nPlease try again...\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				f_close(&fp);
@@ -645,7 +892,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 			else
 			{
 				s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 			}
 		}
@@ -656,7 +903,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 		if (res)
 		{
 			s_printf(gui->txt_buf, "\n#FF0000 Fatal error (%d) when writing to SD Card#\nPlease try again...\n", res);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			f_close(&fp);
@@ -666,23 +913,18 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 			return 0;
 		}
 
-		manual_system_maintenance(false);
-
-		pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(lba_end - part->lba_start);
-		if (pct != prevPct)
-		{
-			lv_bar_set_value(gui->bar, pct);
-			s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
-			lv_label_set_text(gui->label_pct, gui->txt_buf);
-			manual_system_maintenance(true);
+		// Checksum while data is still in memory.
+		if (n_cfg.crc32_sidecar)
+			part_crc32 = crc32_calc(part_crc32, buf, EMMC_BLOCKSIZE * num);
 
-			prevPct = pct;
-		}
+		manual_system_maintenance(false);
 
 		lba_curr += num;
 		totalSectors -= num;
 		bytesWritten += num * EMMC_BLOCKSIZE;
 
+		nyx_progress_update(&prog, lba_curr);
+
 		// Force a flush after a lot of data if not splitting.
 		if (numSplitParts == 0 && bytesWritten >= multipartSplitSize)
 		{
@@ -694,7 +936,7 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 The backup was cancelled!#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			msleep(1500);
@@ -706,21 +948,22 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 			return 0;
 		}
 	}
-	lv_bar_set_value(gui->bar, 100);
-	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
-	manual_system_maintenance(true);
+	nyx_progress_set(&prog, 100);
 
 	// Backup operation ended successfully.
 	f_close(&fp);
 	free(clmt);
 
+	if (n_cfg.crc32_sidecar && _dump_emmc_crc32_sidecar(gui, outFilename, part_crc32))
+		return 0;
+
 	if (n_cfg.verification && !gui->raw_emummc)
 	{
 		// Verify last part or single file backup.
 		if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part))
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 Please try again...#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			return 0;
@@ -754,7 +997,7 @@ void dump_emmc_selected(emmcPartType_t dumpType, emmc_tool_gui_t *gui)
 	gui->txt_buf = txt_buf;
 
 	txt_buf[0] = 0;
-	lv_label_set_text(gui->label_log, txt_buf);
+	nyx_log_set_text(gui->label_log, txt_buf);
 
 	lv_label_set_text(gui->label_info, "Checking for available free space...");
 	manual_system_maintenance(true);
@@ -804,7 +1047,7 @@ void dump_emmc_selected(emmcPartType_t dumpType, emmc_tool_gui_t *gui)
 				i, bootPart.name, bootPart.lba_start, bootPart.lba_end);
 			lv_label_set_text(gui->label_info, txt_buf);
 			s_printf(txt_buf, "%02d: %s... ", i, bootPart.name);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+			nyx_log_append(gui->label_log, txt_buf);
 			manual_system_maintenance(true);
 
 			sdmmc_storage_set_mmc_partition(&emmc_storage, i + 1);
@@ -822,7 +1065,7 @@ void dump_emmc_selected(emmcPartType_t dumpType, emmc_tool_gui_t *gui)
 			else
 				s_printf(txt_buf, "Done!\n");
 
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+			nyx_log_append(gui->label_log, txt_buf);
 			manual_system_maintenance(true);
 		}
 	}
@@ -850,7 +1093,7 @@ void dump_emmc_selected(emmcPartType_t dumpType, emmc_tool_gui_t *gui)
 					i, part->name, part->lba_start, part->lba_end);
 				lv_label_set_text(gui->label_info, txt_buf);
 				s_printf(txt_buf, "%02d: %s... ", i, part->name);
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				nyx_log_append(gui->label_log, txt_buf);
 				manual_system_maintenance(true);
 				i++;
 
@@ -860,13 +1103,13 @@ void dump_emmc_selected(emmcPartType_t dumpType, emmc_tool_gui_t *gui)
 				if (!res)
 				{
 					s_printf(txt_buf, "#FFDD00 Failed!#\n");
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+					nyx_log_append(gui->label_log, txt_buf);
 					break;
 				}
 				else
 					s_printf(txt_buf, "Done!\n");
 
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				nyx_log_append(gui->label_log, txt_buf);
 				manual_system_maintenance(true);
 			}
 			emmc_gpt_free(&gpt);
@@ -887,7 +1130,7 @@ void dump_emmc_selected(emmcPartType_t dumpType, emmc_tool_gui_t *gui)
 					i, rawPart.name, rawPart.lba_start, rawPart.lba_end);
 				lv_label_set_text(gui->label_info, txt_buf);
 				s_printf(txt_buf, "%02d: %s... ", i, rawPart.name);
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				nyx_log_append(gui->label_log, txt_buf);
 				manual_system_maintenance(true);
 
 				i++;
@@ -905,7 +1148,7 @@ void dump_emmc_selected(emmcPartType_t dumpType, emmc_tool_gui_t *gui)
 				else
 					s_printf(txt_buf, "Done!\n");
 
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				nyx_log_append(gui->label_log, txt_buf);
 				manual_system_maintenance(true);
 			}
 		}
@@ -970,7 +1213,7 @@ static int _restore_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_pa
 	{
 		// If not, check if there are partial files and the total size matches.
 		s_printf(gui->txt_buf, "\nNo single file, checking for part files...\n");
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		outFilename[sdPathLen++] = '.';
@@ -996,7 +1239,7 @@ static int _restore_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_pa
 			if ((u32)((u64)totalCheckFileSize >> (u64)9) > totalSectors)
 			{
 				s_printf(gui->txt_buf, "#FF8000 Size of SD Card split backup exceeds#\n#FF8000 eMMC's selected part size!#\n#FFDD00 Aborting...#");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				return 0;
@@ -1006,7 +1249,7 @@ static int _restore_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_pa
 				if (!gui->raw_emummc)
 				{
 					s_printf(gui->txt_buf, "#FFDD00 Error (%d) file not found#\n#FFDD00 %s.#\n\n", res, outFilename);
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					nyx_log_append(gui->label_log, gui->txt_buf);
 					manual_system_maintenance(true);
 
 					// Attempt a smaller restore.
@@ -1024,7 +1267,7 @@ static int _restore_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_pa
 				if (!numSplitParts)
 				{
 					s_printf(gui->txt_buf, "#FFDD00 Restore folder is empty.#\n\n");
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					nyx_log_append(gui->label_log, gui->txt_buf);
 					manual_system_maintenance(true);
 
 					return 0;
@@ -1037,7 +1280,7 @@ static int _restore_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_pa
 				if (check_4MB_aligned && (((u64)fno.fsize) % SZ_4M))
 				{
 					s_printf(gui->txt_buf, "#FFDD00 The split file must be a#\n#FFDD00 multiple of 4 MiB.#\n#FFDD00 Aborting...#");
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					nyx_log_append(gui->label_log, gui->txt_buf);
 					manual_system_maintenance(true);
 
 					return 0;
@@ -1050,7 +1293,7 @@ static int _restore_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_pa
 		}
 
 		s_printf(gui->txt_buf, "%X sectors total.\n", (u32)((u64)totalCheckFileSize >> (u64)9));
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		if ((u32)((u64)totalCheckFileSize >> (u64)9) != totalSectors)
@@ -1065,7 +1308,7 @@ static int _restore_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_pa
 			{
 				lv_obj_del(warn_mbox_bg);
 				s_printf(gui->txt_buf, "#FF0000 Size of SD Card split backup does not match#\n#FF0000 eMMC's selected part size!#\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				return 0;
@@ -1103,13 +1346,13 @@ multipart_not_allowed:
 		if (res != FR_NO_FILE)
 		{
 			s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while opening file. Continuing...#\n", res);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 		}
 		else
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 Error (%d) file not found. Continuing...#\n", res);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 		}
 
@@ -1120,7 +1363,7 @@ multipart_not_allowed:
 		if (((u32)((u64)f_size(&fp) >> (u64)9)) > totalSectors)
 		{
 			s_printf(gui->txt_buf, "#FF8000 Size of SD Card backup exceeds#\n#FF8000 eMMC's selected part size!#\n#FFDD00 Aborting...#");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			f_close(&fp);
@@ -1139,7 +1382,7 @@ multipart_not_allowed:
 			{
 				lv_obj_del(warn_mbox_bg);
 				s_printf(gui->txt_buf, "\n#FF0000 Size of the SD Card backup does not match#\n#FF0000 eMMC's selected part size.#\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				f_close(&fp);
@@ -1157,7 +1400,7 @@ multipart_not_allowed:
 		fileSize = (u64)f_size(&fp);
 		s_printf(gui->txt_buf, "\nTotal restore size: %d MiB.\n",
 			(u32)((use_multipart ? (u64)totalCheckFileSize : fileSize) >> (u64)9) >> SECTORS_TO_MIB_COEFF);
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 	}
 
@@ -1165,11 +1408,9 @@ multipart_not_allowed:
 
 	u32 lba_curr = part->lba_start;
 	u32 bytesWritten = 0;
-	u32 prevPct = 200;
 	int retryCount = 0;
 
 	u32 num = 0;
-	u32 pct = 0;
 
 	DWORD *clmt = f_expand_cltbl(&fp, SZ_4M, 0);
 
@@ -1183,7 +1424,7 @@ multipart_not_allowed:
 		if (!part_idx || !sector_size)
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 Failed to find a partition...#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			return 0;
@@ -1191,6 +1432,27 @@ multipart_not_allowed:
 		sd_sector_off = sector_start + (0x2000 * active_part);
 	}
 
+	// Hash the written data per chunk, so it can be verified by only reading back the eMMC.
+	// Raw emuMMC restores are not verified at all, so they are not hashed either.
+	bool readback = n_cfg.verification && n_cfg.restore_readback && !gui->raw_emummc;
+	u8 *hashes = NULL;
+	u32 hashIdx = 0;
+	if (readback)
+	{
+		hashes = (u8 *)malloc(((totalSectors + NUM_SECTORS_PER_ITER - 1) / NUM_SECTORS_PER_ITER) * SE_SHA_256_SIZE);
+
+		// Fall back to the full verification.
+		if (!hashes)
+			readback = false;
+	}
+
+	// Files that have a CRC32 file are checked against it once fully read.
+	u32 crc32 = 0, crc32Expected = 0;
+	bool crc32Check = _emmc_crc32_sidecar_read(outFilename, &crc32Expected);
+
+	nyx_progress_t prog;
+	nyx_progress_init(&prog, gui->bar, gui->label_pct, gui->txt_buf, part->lba_start, lba_end, lba_curr);
+
 	lv_obj_set_opa_scale(gui->bar, LV_OPA_COVER);
 	lv_obj_set_opa_scale(gui->label_pct, LV_OPA_COVER);
 	while (totalSectors > 0)
@@ -1204,17 +1466,38 @@ multipart_not_allowed:
 			memset(&fp, 0, sizeof(fp));
 			currPartIdx++;
 
+			if (crc32Check && crc32 != crc32Expected)
+			{
+				_emmc_crc32_sidecar_mismatch(gui, outFilename, crc32Expected, crc32);
+				s_printf(gui->txt_buf, "#FFDD00 The backup is corrupted! Aborting...#\n");
+				nyx_log_append(gui->label_log, gui->txt_buf);
+				manual_system_maintenance(true);
+
+				free(hashes);
+				return 0;
+			}
+
 			if (n_cfg.verification && !gui->raw_emummc)
 			{
 				// Verify part.
-				if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part))
+				if (readback)
+					res = _restore_emmc_verify(gui, storage, lbaStartPart, lba_curr, hashes, outFilename, part);
+				else
+					res = _dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part);
+
+				if (res)
 				{
 					s_printf(gui->txt_buf, "\n#FFDD00 Please try again...#\n");
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					nyx_log_append(gui->label_log, gui->txt_buf);
 					manual_system_maintenance(true);
 
+					free(hashes);
 					return 0;
 				}
+				hashIdx = 0;
+
+				// Restart rate tracking after verification.
+				nyx_progress_init(&prog, gui->bar, gui->label_pct, gui->txt_buf, part->lba_start, lba_end, lba_curr);
 			}
 
 			_update_filename(outFilename, sdPathLen, currPartIdx);
@@ -1234,14 +1517,18 @@ multipart_not_allowed:
 			if (res)
 			{
 				s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while opening file#\n#FFDD00 %s!#\n", res, outFilename);
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
+				free(hashes);
 				return 0;
 			}
 			fileSize = (u64)f_size(&fp);
 			bytesWritten = 0;
 			clmt = f_expand_cltbl(&fp, SZ_4M, 0);
+
+			crc32 = 0;
+			crc32Check = _emmc_crc32_sidecar_read(outFilename, &crc32Expected);
 		}
 
 		retryCount = 0;
@@ -1256,13 +1543,20 @@ multipart_not_allowed:
 				"\n#FF0000 Fatal error (%d) when reading from SD!#\n"
 				"#FF0000 This device may be in an inoperative state!#\n"
 				"#FFDD00 Please try again now!#\n", res);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			f_close(&fp);
 			free(clmt);
+			free(hashes);
 			return 0;
 		}
+
+		if (readback)
+			se_calc_sha256_oneshot(hashes + (hashIdx++ * SE_SHA_256_SIZE), buf, num << 9);
+		if (crc32Check)
+			crc32 = crc32_calc(crc32, buf, num << 9);
+
 		if (!gui->raw_emummc)
 			res = !sdmmc_storage_write(storage, lba_curr, num, buf);
 		else
@@ -1276,7 +1570,7 @@ multipart_not_allowed:
 				"\n#FFDD00 Error writing %d blocks @ LBA %08X,#\n"
 				"#FFDD00 from eMMC (try %d). #",
 				num, lba_curr, ++retryCount);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			msleep(150);
@@ -1285,17 +1579,18 @@ multipart_not_allowed:
 				s_printf(gui->txt_buf, "#FF0000 Aborting...#\n"
 					"#FF0000 This device may be in an inoperative state!#\n"
 					"#FFDD00 Please try again now!#\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				f_close(&fp);
 				free(clmt);
+				free(hashes);
 				return 0;
 			}
 			else
 			{
 				s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 			}
 			if (!gui->raw_emummc)
@@ -1304,35 +1599,43 @@ multipart_not_allowed:
 				res = !sdmmc_storage_write(&sd_storage, lba_curr + sd_sector_off, num, buf);
 			manual_system_maintenance(false);
 		}
-		pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(lba_end - part->lba_start);
-		if (pct != prevPct)
-		{
-			lv_bar_set_value(gui->bar, pct);
-			s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
-			lv_label_set_text(gui->label_pct, gui->txt_buf);
-			manual_system_maintenance(true);
-			prevPct = pct;
-		}
 
 		lba_curr += num;
 		totalSectors -= num;
 		bytesWritten += num * EMMC_BLOCKSIZE;
+
+		nyx_progress_update(&prog, lba_curr);
 	}
-	lv_bar_set_value(gui->bar, 100);
-	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
-	manual_system_maintenance(true);
+	nyx_progress_set(&prog, 100);
 
 	// Restore operation ended successfully.
 	f_close(&fp);
 	free(clmt);
 
+	if (crc32Check && crc32 != crc32Expected)
+	{
+		_emmc_crc32_sidecar_mismatch(gui, outFilename, crc32Expected, crc32);
+		s_printf(gui->txt_buf, "#FFDD00 The backup is corrupted!#\n");
+		nyx_log_append(gui->label_log, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		free(hashes);
+		return 0;
+	}
+
 	if (n_cfg.verification && !gui->raw_emummc)
 	{
 		// Verify restored data.
-		if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part))
+		if (readback)
+			res = _restore_emmc_verify(gui, storage, lbaStartPart, lba_curr, hashes, outFilename, part);
+		else
+			res = _dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part);
+		free(hashes);
+
+		if (res)
 		{
 			s_printf(gui->txt_buf, "#FFDD00 Please try again...#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			return 0;
@@ -1371,7 +1674,7 @@ void restore_emmc_selected(emmcPartType_t restoreType, emmc_tool_gui_t *gui)
 	gui->txt_buf = txt_buf;
 
 	txt_buf[0] = 0;
-	lv_label_set_text(gui->label_log, txt_buf);
+	nyx_log_set_text(gui->label_log, txt_buf);
 
 	manual_system_maintenance(true);
 
@@ -1451,7 +1754,7 @@ void restore_emmc_selected(emmcPartType_t restoreType, emmc_tool_gui_t *gui)
 				i, bootPart.name, bootPart.lba_start, bootPart.lba_end);
 			lv_label_set_text(gui->label_info, txt_buf);
 			s_printf(txt_buf, "%02d: %s... ", i, bootPart.name);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+			nyx_log_append(gui->label_log, txt_buf);
 			manual_system_maintenance(true);
 
 			sdmmc_storage_set_mmc_partition(&emmc_storage, i + 1);
@@ -1464,7 +1767,7 @@ void restore_emmc_selected(emmcPartType_t restoreType, emmc_tool_gui_t *gui)
 			else
 				s_printf(txt_buf, "Done!\n");
 
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+			nyx_log_append(gui->label_log, txt_buf);
 			manual_system_maintenance(true);
 		}
 	}
@@ -1485,7 +1788,7 @@ void restore_emmc_selected(emmcPartType_t restoreType, emmc_tool_gui_t *gui)
 				i, part->name, part->lba_start, part->lba_end);
 			lv_label_set_text(gui->label_info, txt_buf);
 			s_printf(txt_buf, "%02d: %s... ", i, part->name);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+			nyx_log_append(gui->label_log, txt_buf);
 			manual_system_maintenance(true);
 			i++;
 
@@ -1497,7 +1800,7 @@ void restore_emmc_selected(emmcPartType_t restoreType, emmc_tool_gui_t *gui)
 			else
 				s_printf(txt_buf, "Done!\n");
 
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+			nyx_log_append(gui->label_log, txt_buf);
 			manual_system_maintenance(true);
 		}
 		emmc_gpt_free(&gpt);
@@ -1518,7 +1821,7 @@ void restore_emmc_selected(emmcPartType_t restoreType, emmc_tool_gui_t *gui)
 				i, rawPart.name, rawPart.lba_start, rawPart.lba_end);
 			lv_label_set_text(gui->label_info, txt_buf);
 			s_printf(txt_buf, "%02d: %s... ", i, rawPart.name);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+			nyx_log_append(gui->label_log, txt_buf);
 			manual_system_maintenance(true);
 			i++;
 
@@ -1530,7 +1833,7 @@ void restore_emmc_selected(emmcPartType_t restoreType, emmc_tool_gui_t *gui)
 			else
 				s_printf(txt_buf, "Done!\n");
 
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+			nyx_log_append(gui->label_log, txt_buf);
 			manual_system_maintenance(true);
 		}
 	}
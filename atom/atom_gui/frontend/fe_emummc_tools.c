@@ -24,6 +24,8 @@
 #include <bdk.h>
 
 #include "gui.h"
+#include "gui_log.h"
+#include "gui_progress.h"
 #include "fe_emummc_tools.h"
 #include "../config.h"
 #include <libs/fatfs/diskio.h>
@@ -164,7 +166,7 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 	if (totalSectors > (sd_fs.free_clst * sd_fs.csize))
 	{
 		s_printf(gui->txt_buf, "\n#FFDD00 Not enough free space for Partial Backup!#\n");
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		return 0;
@@ -190,7 +192,7 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 	if (res)
 	{
 		s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while creating#\n#FFDD00 %s#\n", res, outFilename);
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		return 0;
@@ -200,7 +202,6 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 
 	u32 lba_curr = part->lba_start;
 	u32 bytesWritten = 0;
-	u32 prevPct = 200;
 	int retryCount = 0;
 	DWORD *clmt = NULL;
 
@@ -211,7 +212,9 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 		clmt = f_expand_cltbl(&fp, SZ_4M, MIN(totalSize, multipartSplitSize));
 
 	u32 num = 0;
-	u32 pct = 0;
+
+	nyx_progress_t prog;
+	nyx_progress_init(&prog, gui->bar, gui->label_pct, gui->txt_buf, part->lba_start, part->lba_end, lba_curr);
 
 	lv_obj_set_opa_scale(gui->bar, LV_OPA_COVER);
 	lv_obj_set_opa_scale(gui->label_pct, LV_OPA_COVER);
@@ -236,7 +239,7 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 			if (res)
 			{
 				s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while creating#\n#FFDD00 %s#\n", res, outFilename);
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				return 0;
@@ -252,7 +255,7 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 The emuMMC was cancelled!#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			f_close(&fp);
@@ -273,14 +276,14 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 				"\n#FFDD00 Error reading %d blocks @ LBA %08X,#\n"
 				"#FFDD00 from eMMC (try %d). #",
 				num, lba_curr, ++retryCount);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			msleep(150);
 			if (retryCount >= 3)
 			{
 				s_printf(gui->txt_buf, "#FF0000 Aborting...#\nPlease try again...\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				f_close(&fp);
@@ -292,7 +295,7 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 			else
 			{
 				s_printf(gui->txt_buf, "#FFDD00 Retrying...#");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 			}
 		}
@@ -306,7 +309,7 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 		if (res)
 		{
 			s_printf(gui->txt_buf, "\n#FF0000 Fatal error (%d) when writing to SD Card#\nPlease try again...\n", res);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			f_close(&fp);
@@ -315,21 +318,13 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 
 			return 0;
 		}
-		pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(part->lba_end - part->lba_start);
-		if (pct != prevPct)
-		{
-			lv_bar_set_value(gui->bar, pct);
-			s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
-			lv_label_set_text(gui->label_pct, gui->txt_buf);
-			manual_system_maintenance(true);
-
-			prevPct = pct;
-		}
 
 		lba_curr += num;
 		totalSectors -= num;
 		bytesWritten += num * EMMC_BLOCKSIZE;
 
+		nyx_progress_update(&prog, lba_curr);
+
 		// Force a flush after a lot of data if not splitting.
 		if (numSplitParts == 0 && bytesWritten >= multipartSplitSize)
 		{
@@ -339,9 +334,7 @@ static int _dump_emummc_file_part(emmc_tool_gui_t *gui, char *sd_path, sdmmc_sto
 
 		manual_system_maintenance(false);
 	}
-	lv_bar_set_value(gui->bar, 100);
-	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
-	manual_system_maintenance(true);
+	nyx_progress_set(&prog, 100);
 
 	// Backup operation ended successfully.
 	f_close(&fp);
@@ -361,7 +354,7 @@ void dump_emummc_file(emmc_tool_gui_t *gui)
 	gui->txt_buf = txt_buf;
 
 	txt_buf[0] = 0;
-	lv_label_set_text(gui->label_log, txt_buf);
+	nyx_log_set_text(gui->label_log, txt_buf);
 
 	manual_system_maintenance(true);
 
@@ -421,7 +414,7 @@ void dump_emummc_file(emmc_tool_gui_t *gui)
 			i, bootPart.name, bootPart.lba_start, bootPart.lba_end);
 		lv_label_set_text(gui->label_info, txt_buf);
 		s_printf(txt_buf, "%02d: %s... ", i, bootPart.name);
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+		nyx_log_append(gui->label_log, txt_buf);
 		manual_system_maintenance(true);
 
 		sdmmc_storage_set_mmc_partition(&emmc_storage, i + 1);
@@ -437,7 +430,7 @@ void dump_emummc_file(emmc_tool_gui_t *gui)
 		else
 			s_printf(txt_buf, "Done!\n");
 
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+		nyx_log_append(gui->label_log, txt_buf);
 		manual_system_maintenance(true);
 
 		strcpy(sdPath, gui->base_path);
@@ -459,7 +452,7 @@ void dump_emummc_file(emmc_tool_gui_t *gui)
 		i, rawPart.name, rawPart.lba_start, rawPart.lba_end);
 	lv_label_set_text(gui->label_info, txt_buf);
 	s_printf(txt_buf, "%02d: %s... ", i, rawPart.name);
-	lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+	nyx_log_append(gui->label_log, txt_buf);
 	manual_system_maintenance(true);
 
 	res = _dump_emummc_file_part(gui, sdPath, &emmc_storage, &rawPart);
@@ -469,7 +462,7 @@ void dump_emummc_file(emmc_tool_gui_t *gui)
 	else
 		s_printf(txt_buf, "Done!\n");
 
-	lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+	nyx_log_append(gui->label_log, txt_buf);
 	manual_system_maintenance(true);
 
 out_failed:
@@ -503,8 +496,6 @@ out:
 static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part_idx, u32 sd_part_off, emmc_part_t *part, u32 resized_count)
 {
 	u32 num = 0;
-	u32 pct = 0;
-	u32 prevPct = 200;
 	int retryCount = 0;
 	u32 sd_sector_off = sd_part_off + (0x2000 * active_part);
 	u32 lba_curr = part->lba_start;
@@ -537,7 +528,7 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 		if (!user_part)
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 USER partition not found!#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			return 0;
@@ -548,6 +539,9 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 		emmc_gpt_free(&gpt_parsed);
 	}
 
+	nyx_progress_t prog;
+	nyx_progress_init(&prog, gui->bar, gui->label_pct, gui->txt_buf, part->lba_start, part->lba_end, lba_curr);
+
 	u32 totalSectors = part->lba_end - part->lba_start + 1;
 	while (totalSectors > 0)
 	{
@@ -555,7 +549,7 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 The emuMMC was cancelled!#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			msleep(1000);
@@ -573,14 +567,14 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 				"\n#FFDD00 Error reading %d blocks @LBA %08X,#\n"
 				"#FFDD00 from eMMC (try %d). #",
 				num, lba_curr, ++retryCount);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			msleep(150);
 			if (retryCount >= 3)
 			{
 				s_printf(gui->txt_buf, "#FF0000 Aborting...#\nPlease try again...\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				return 0;
@@ -588,7 +582,7 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 			else
 			{
 				s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 			}
 		}
@@ -603,14 +597,14 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 				"\n#FFDD00 Error writing %d blocks @LBA %08X,#\n"
 				"#FFDD00 to SD (try %d). #",
 				num, lba_curr, ++retryCount);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			manual_system_maintenance(true);
 
 			msleep(150);
 			if (retryCount >= 3)
 			{
 				s_printf(gui->txt_buf, "#FF0000 Aborting...#\nPlease try again...\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 
 				return 0;
@@ -618,30 +612,19 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 			else
 			{
 				s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				nyx_log_append(gui->label_log, gui->txt_buf);
 				manual_system_maintenance(true);
 			}
 		}
 
 		manual_system_maintenance(false);
 
-		pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(part->lba_end - part->lba_start);
-		if (pct != prevPct)
-		{
-			lv_bar_set_value(gui->bar, pct);
-			s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
-			lv_label_set_text(gui->label_pct, gui->txt_buf);
-			manual_system_maintenance(true);
-
-			prevPct = pct;
-		}
-
 		lba_curr += num;
 		totalSectors -= num;
+
+		nyx_progress_update(&prog, lba_curr);
 	}
-	lv_bar_set_value(gui->bar, 100);
-	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
-	manual_system_maintenance(true);
+	nyx_progress_set(&prog, 100);
 
 	// Set partition type to emuMMC (0xE0).
 	if (active_part == 2)
@@ -654,7 +637,7 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 
 	if (resized_count)
 	{
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, "Done!\n");
+		nyx_log_append(gui->label_log, "Done!\n");
 
 		// Calculate USER size and set it for FatFS.
 		u32 user_sectors = resized_count - user_offset - 33;
@@ -669,7 +652,7 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 		nx_emmc_bis_init(&user_part, true, sd_sector_off);
 
 		s_printf(gui->txt_buf, "Formatting USER... \n");
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		// Format USER partition.
@@ -683,18 +666,26 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 		if (mkfs_error)
 		{
 			s_printf(gui->txt_buf, "#FF0000 Failed (%d)!#\nPlease try again...\n", mkfs_error);
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 
 			return 0;
 		}
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, "Done!\n");
 
 		// Flush BIS cache, deinit, clear BIS keys slots and reinstate SBK.
-		nx_emmc_bis_end();
+		int bis_res = nx_emmc_bis_end();
 		hos_bis_keys_clear();
 
+		if (bis_res)
+		{
+			s_printf(gui->txt_buf, "#FF0000 Failed to write USER!#\nPlease try again...\n");
+			nyx_log_append(gui->label_log, gui->txt_buf);
+
+			return 0;
+		}
+		nyx_log_append(gui->label_log, "Done!\n");
+
 		s_printf(gui->txt_buf, "Writing new GPT... ");
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		manual_system_maintenance(true);
 
 		// Read MBR, GPT and backup GPT.
@@ -714,7 +705,7 @@ static int _dump_emummc_raw_part(emmc_tool_gui_t *gui, int active_part, int part
 		if (gpt_entry_idx >= gpt->header.num_part_ents)
 		{
 			s_printf(gui->txt_buf, "\n#FF0000 No USER partition...#\nPlease try again...\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			nyx_log_append(gui->label_log, gui->txt_buf);
 			free(gpt);
 
 			return 0;
@@ -844,7 +835,7 @@ void dump_emummc_raw(emmc_tool_gui_t *gui, int part_idx, u32 sector_start, u32 r
 	gui->txt_buf = txt_buf;
 
 	txt_buf[0] = 0;
-	lv_label_set_text(gui->label_log, txt_buf);
+	nyx_log_set_text(gui->label_log, txt_buf);
 
 	manual_system_maintenance(true);
 
@@ -863,7 +854,7 @@ void dump_emummc_raw(emmc_tool_gui_t *gui, int part_idx, u32 sector_start, u32 r
 	if (!_emummc_raw_derive_bis_keys(gui, resized_count))
 	{
 		s_printf(gui->txt_buf, "#FFDD00 For formatting USER partition,#\n#FFDD00 BIS keys are needed!#\n");
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		nyx_log_append(gui->label_log, gui->txt_buf);
 		sdmmc_storage_end(&emmc_storage);
 		goto out;
 	}
@@ -899,7 +890,7 @@ void dump_emummc_raw(emmc_tool_gui_t *gui, int part_idx, u32 sector_start, u32 r
 			i, bootPart.name, bootPart.lba_start, bootPart.lba_end);
 		lv_label_set_text(gui->label_info, txt_buf);
 		s_printf(txt_buf, "%02d: %s... ", i, bootPart.name);
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+		nyx_log_append(gui->label_log, txt_buf);
 		manual_system_maintenance(true);
 
 		sdmmc_storage_set_mmc_partition(&emmc_storage, i + 1);
@@ -915,7 +906,7 @@ void dump_emummc_raw(emmc_tool_gui_t *gui, int part_idx, u32 sector_start, u32 r
 		else
 			s_printf(txt_buf, "Done!\n");
 
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+		nyx_log_append(gui->label_log, txt_buf);
 		manual_system_maintenance(true);
 
 		strcpy(sdPath, gui->base_path);
@@ -936,7 +927,7 @@ void dump_emummc_raw(emmc_tool_gui_t *gui, int part_idx, u32 sector_start, u32 r
 			i, rawPart.name, rawPart.lba_start, rawPart.lba_end);
 		lv_label_set_text(gui->label_info, txt_buf);
 		s_printf(txt_buf, "%02d: %s... ", i, rawPart.name);
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+		nyx_log_append(gui->label_log, txt_buf);
 		manual_system_maintenance(true);
 
 		res = _dump_emummc_raw_part(gui, 2, part_idx, sector_start, &rawPart, resized_count);
@@ -946,7 +937,7 @@ void dump_emummc_raw(emmc_tool_gui_t *gui, int part_idx, u32 sector_start, u32 r
 		else
 			s_printf(txt_buf, "Done!\n");
 
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+		nyx_log_append(gui->label_log, txt_buf);
 		manual_system_maintenance(true);
 	}
 
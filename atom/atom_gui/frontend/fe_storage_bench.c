@@ -0,0 +1,172 @@
+/*
+ * Storage benchmark runner and latency statistics
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <bdk.h>
+
+#include "fe_storage_bench.h"
+
+const bench_ops_t bench_sdmmc_ops = {
+	.read  = sdmmc_storage_read,
+	.write = sdmmc_storage_write,
+};
+
+/*
+ * Latency histogram buckets.
+ * Latencies under 8us get their own bucket. Above that, every power of two is
+ * split into 4 buckets, which keeps percentiles within 25% of the real value.
+ */
+static u32 _bench_lat_bucket(u32 us)
+{
+	if (us < 8)
+		return us;
+
+	u32 msb = 3;
+	for (u32 v = us >> 4; v; v >>= 1)
+		msb++;
+
+	return 8 + (msb - 3) * 4 + ((us >> (msb - 2)) & 3);
+}
+
+u32 bench_lat_bucket_max(u32 idx)
+{
+	if (idx < 8)
+		return idx;
+
+	u32 shift = (idx - 8) / 4 + 1;
+	u32 sub = (idx - 8) % 4;
+
+	return ((5 + sub) << shift) - 1;
+}
+
+void bench_lat_add(bench_lat_t *lat, u32 us)
+{
+	lat->hist[_bench_lat_bucket(us)]++;
+	lat->count++;
+	lat->total_us += us;
+	if (us > lat->max_us)
+		lat->max_us = us;
+}
+
+u32 bench_lat_percentile(const bench_lat_t *lat, u32 pct)
+{
+	if (!lat->count)
+		return 0;
+
+	// Rank of the percentile sample, rounded up.
+	u32 rank = ((u64)lat->count * pct + 99) / 100;
+	if (!rank)
+		rank = 1;
+
+	u32 seen = 0;
+	for (u32 i = 0; i < BENCH_LAT_BUCKETS; i++)
+	{
+		seen += lat->hist[i];
+		if (seen >= rank)
+			return MIN(bench_lat_bucket_max(i), lat->max_us);
+	}
+
+	return lat->max_us;
+}
+
+u32 bench_rate_1k(const bench_res_t *res)
+{
+	if (!res->time_us)
+		return 0;
+
+	// MiB/s * 1000.
+	return ((u64)res->sectors * 1000 * 1000 * 1000 / 2048) / res->time_us;
+}
+
+u32 bench_iops(const bench_res_t *res)
+{
+	if (!res->time_us)
+		return 0;
+
+	return ((u64)res->ios * 1000 * 1000) / res->time_us;
+}
+
+u32 bench_maint_ops_per_mb(const bench_res_t *res)
+{
+	if (!res->sectors)
+		return 0;
+
+	return ((u64)res->maint_ops * 2048) / res->sectors;
+}
+
+void bench_gen_pattern(u32 *pattern, u32 io_cnt, u32 sector_num, u32 range, u32 align, u32 write_pct)
+{
+	// Every I/O stays in range.
+	u32 slots = (range - sector_num) / align + 1;
+	u32 random_numbers[4];
+
+	for (u32 i = 0; i < io_cnt; i++)
+	{
+		// Generate new random numbers. Two per I/O, offset and operation.
+		if (!(i & 1))
+		{
+			while (!se_gen_prng128(random_numbers))
+				;
+		}
+
+		u32 *rnd = &random_numbers[(i & 1) * 2];
+		pattern[i] = (rnd[0] % slots) * align;
+		if ((rnd[1] % 100) < write_pct)
+			pattern[i] |= BENCH_IO_WRITE;
+	}
+}
+
+int bench_run(const bench_ops_t *ops, sdmmc_storage_t *storage, u32 sector, const u32 *pattern, u32 io_cnt, u32 sector_num, u8 *buf,
+	bench_res_t *res, bench_progress_cb_t progress, void *param)
+{
+	memset(res, 0, sizeof(bench_res_t));
+
+	u32 maint_ops = bpmp_mmu_maint_stats.way_ops + bpmp_mmu_maint_stats.line_ops;
+
+	for (u32 i = 0; i < io_cnt; i++)
+	{
+		// Sequential reads if no pattern.
+		u32 lba = sector + i * sector_num;
+		bool write = false;
+		if (pattern)
+		{
+			lba = sector + (pattern[i] & BENCH_IO_OFF_MASK);
+			write = pattern[i] & BENCH_IO_WRITE;
+		}
+
+		u32 time_taken = get_tmr_us();
+		int ok = write ? ops->write(storage, lba, sector_num, buf) :
+						 ops->read(storage, lba, sector_num, buf);
+		time_taken = get_tmr_us() - time_taken;
+
+		if (!ok)
+			return 1;
+
+		res->ios++;
+		res->sectors += sector_num;
+		res->time_us += time_taken;
+		res->maint_ops = bpmp_mmu_maint_stats.way_ops + bpmp_mmu_maint_stats.line_ops - maint_ops;
+		bench_lat_add(&res->lat, time_taken);
+
+		if (progress && !progress(((i + 1) * 100) / io_cnt, param))
+			return BENCH_ABORTED;
+	}
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * Storage benchmark runner and latency statistics
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FE_STORAGE_BENCH_H_
+#define _FE_STORAGE_BENCH_H_
+
+#include <storage/sdmmc.h>
+#include <utils/types.h>
+
+#define BENCH_LAT_BUCKETS 124
+
+#define BENCH_IO_WRITE    BIT(31)
+#define BENCH_IO_OFF_MASK (BENCH_IO_WRITE - 1)
+
+#define BENCH_ABORTED -1
+
+typedef struct _bench_lat_t
+{
+	u32 hist[BENCH_LAT_BUCKETS];
+	u32 count;
+	u32 max_us;
+	u64 total_us;
+} bench_lat_t;
+
+typedef struct _bench_res_t
+{
+	u32 ios;
+	u32 sectors;
+	u32 time_us;
+	u32 maint_ops; // BPMP cache maintenance operations.
+	bench_lat_t lat;
+} bench_res_t;
+
+// Called after every I/O with the current percentage. Returning false aborts the test.
+typedef bool (*bench_progress_cb_t)(u32 pct, void *param);
+
+// I/O backend of the runner.
+typedef struct _bench_ops_t
+{
+	int (*read)(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf);
+	int (*write)(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf);
+} bench_ops_t;
+
+extern const bench_ops_t bench_sdmmc_ops;
+
+void bench_lat_add(bench_lat_t *lat, u32 us);
+u32  bench_lat_bucket_max(u32 idx);
+u32  bench_lat_percentile(const bench_lat_t *lat, u32 pct);
+
+u32  bench_rate_1k(const bench_res_t *res);
+u32  bench_iops(const bench_res_t *res);
+u32  bench_maint_ops_per_mb(const bench_res_t *res);
+
+// align: Offsets are multiples of it, in sectors. 1 for any sector.
+void bench_gen_pattern(u32 *pattern, u32 io_cnt, u32 sector_num, u32 range, u32 align, u32 write_pct);
+int  bench_run(const bench_ops_t *ops, sdmmc_storage_t *storage, u32 sector, const u32 *pattern, u32 io_cnt, u32 sector_num, u8 *buf,
+	bench_res_t *res, bench_progress_cb_t progress, void *param);
+
+#endif
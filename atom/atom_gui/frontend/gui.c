@@ -25,6 +25,7 @@
 #include "gui_emummc_tools.h"
 #include "gui_tools.h"
 #include "gui_info.h"
+#include "gui_loop.h"
 #include "gui_options.h"
 #include <libs/lvgl/lvgl.h>
 #include <libs/lvgl/lv_objx/lv_kb.c>
@@ -183,7 +184,7 @@ static void _save_log_to_bmp(char *fname)
 
 	char path[0x80];
 	strcpy(path, "AtomNX/screenshots");
-	s_printf(path + strlen(path), "/atom%s_log.bmp", fname);
+	s_snprintf(path + strlen(path), sizeof(path) - strlen(path), "/atom%s_log.bmp", fname);
 	sd_save_to_file(bitmap, file_size, path);
 
 	free(bitmap);
@@ -283,7 +284,7 @@ static void _save_fb_to_bmp()
 		max77620_rtc_epoch_to_date(epoch, &time);
 	}
 	s_printf(fname, "%04d%02d%02d_%02d%02d%02d", time.year, time.month, time.day, time.hour, time.min, time.sec);
-	s_printf(path + strlen(path), "/atom%s.bmp", fname);
+	s_snprintf(path + strlen(path), sizeof(path) - strlen(path), "/atom%s.bmp", fname);
 
 	// Save screenshot and log.
 	int res = sd_save_to_file(bitmap, file_size, path);
@@ -665,91 +666,6 @@ void manual_system_maintenance(bool refresh)
 		lv_refr_now();
 }
 
-lv_img_dsc_t *bmp_to_lvimg_obj(const char *path)
-{
-	u32 fsize;
-	u8 *bitmap = sd_file_read(path, &fsize);
-	if (!bitmap)
-		return NULL;
-
-	struct _bmp_data
-	{
-		u32 size;
-		u32 size_x;
-		u32 size_y;
-		u32 offset;
-	};
-
-	struct _bmp_data bmpData;
-
-	// Get values manually to avoid unaligned access.
-	bmpData.size = bitmap[2] | bitmap[3] << 8 |
-		bitmap[4] << 16 | bitmap[5] << 24;
-	bmpData.offset = bitmap[10] | bitmap[11] << 8 |
-		bitmap[12] << 16 | bitmap[13] << 24;
-	bmpData.size_x = bitmap[18] | bitmap[19] << 8 |
-		bitmap[20] << 16 | bitmap[21] << 24;
-	bmpData.size_y = bitmap[22] | bitmap[23] << 8 |
-		bitmap[24] << 16 | bitmap[25] << 24;
-	// Sanity check.
-	if (bitmap[0] == 'B' &&
-		bitmap[1] == 'M' &&
-		bitmap[28] == 32 && // Only 32 bit BMPs allowed.
-		bmpData.size <= fsize)
-	{
-		// Check if non-default Bottom-Top.
-		bool flipped = false;
-		if (bmpData.size_y & 0x80000000)
-		{
-			bmpData.size_y = ~(bmpData.size_y) + 1;
-			flipped = true;
-		}
-
-		lv_img_dsc_t *img_desc = (lv_img_dsc_t *)bitmap;
-		u32 offset_copy = ALIGN((u32)bitmap + sizeof(lv_img_dsc_t), 0x10);
-
-		img_desc->header.always_zero = 0;
-		img_desc->header.w = bmpData.size_x;
-		img_desc->header.h = bmpData.size_y;
-		img_desc->header.cf = (bitmap[28] == 32) ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
-		img_desc->data_size = bmpData.size - bmpData.offset;
-		img_desc->data = (u8 *)offset_copy;
-
-		u32 *tmp = malloc(bmpData.size);
-		u32 *tmp2 = (u32 *)offset_copy;
-
-		// Copy the unaligned data to an aligned buffer.
-		memcpy((u8 *)tmp, bitmap + bmpData.offset, img_desc->data_size);
-		u32 j = 0;
-
-		if (!flipped)
-		{
-			for (u32 y = 0; y < bmpData.size_y; y++)
-			{
-				for (u32 x = 0; x < bmpData.size_x; x++)
-					tmp2[j++] = tmp[(bmpData.size_y - 1 - y ) * bmpData.size_x + x];
-			}
-		}
-		else
-		{
-			for (u32 y = 0; y < bmpData.size_y; y++)
-			{
-				for (u32 x = 0; x < bmpData.size_x; x++)
-					tmp2[j++] = tmp[y * bmpData.size_x + x];
-			}
-		}
-
-		free(tmp);
-	}
-	else
-	{
-		free(bitmap);
-		return NULL;
-	}
-
-	return (lv_img_dsc_t *)bitmap;
-}
-
 lv_res_t nyx_generic_onoff_toggle(lv_obj_t *btn)
 {
 	lv_obj_t *label_btn = lv_obj_get_child(btn, NULL);
@@ -768,7 +684,7 @@ lv_res_t nyx_generic_onoff_toggle(lv_obj_t *btn)
 		}
 		else
 		{
-			s_printf(label_text, "%s%s%s", label_text, text_color, "    ON #");
+			s_snprintf(label_text + strlen(label_text), sizeof(label_text) - strlen(label_text), "%s    ON #", text_color);
 			lv_label_set_text(label_btn, label_text);
 		}
 	}
@@ -778,7 +694,7 @@ lv_res_t nyx_generic_onoff_toggle(lv_obj_t *btn)
 			lv_label_set_text(label_btn, "#D0D0D0 OFF#");
 		else
 		{
-			s_printf(label_text, "%s%s", text_color, " ON #");
+			s_snprintf(label_text, sizeof(label_text), "%s ON #", text_color);
 			lv_label_set_text(label_btn, label_text);
 		}
 	}
@@ -1017,7 +933,7 @@ static lv_res_t _removed_sd_action(lv_obj_t *btns, const char *txt)
 	return mbox_action(btns, txt);
 }
 
-static void _check_sd_card_removed(void *params)
+static void _check_sd_card_removed()
 {
 	// The following checks if SDMMC_1 is initialized.
 	// If yes and card was removed, shows a message box,
@@ -1048,14 +964,10 @@ static void _check_sd_card_removed(void *params)
 		reload_nyx();
 }
 
-lv_task_t *task_emmc_errors;
-static void _nyx_emmc_issues(void *params)
+static void _nyx_emmc_issues()
 {
 	if (emmc_get_mode() < EMMC_MMC_HS400)
 	{
-		// Remove task.
-		lv_task_del(task_emmc_errors);
-
 		lv_obj_t *dark_bg = lv_obj_create(lv_scr_act(), NULL);
 		lv_obj_set_style(dark_bg, &mbox_darken);
 		lv_obj_set_size(dark_bg, LV_HOR_RES, LV_VER_RES);
@@ -1692,47 +1604,111 @@ static lv_res_t ctrl_rtctime(lv_obj_t *btn)
 	return LV_RES_OK;
 }
 
-// Tasks refresh definition
-static void update_status(void *params)
+// Status bar monitor. Caches readings and displayed values, so labels are only touched on changes.
+typedef struct _nyx_monitor_t
 {
-	// Read and display date and time
-	char *times = (char*)malloc(64);
-
+	// Cached readings.
 	rtc_time_t time;
+	int batt_soc;
+	int batt_volt;
+	int batt_curr;
+	u16 soc_temp;
+
+	// Displayed values.
+	char time_txt[24];
+	char batt_pct_txt[8];
+	char batt_curr_txt[16];
+	char batt_volt_txt[16];
+	char temp_txt[16];
+	const char *batt_sym;
+	lv_style_t *batt_pct_style;
+	lv_style_t *batt_curr_style;
+
+	// Storage state for change events.
+	bool sd_removed;
+	bool emmc_checked;
+
+	// I2C transactions statistics.
+	u32 i2c_xfers;
+	u32 i2c_time;
+} nyx_monitor_t;
+
+static nyx_monitor_t monitor;
+
+static void _nyx_monitor_set_text(lv_obj_t *label, char *cache, const char *text)
+{
+	if (!strcmp(cache, text))
+		return;
 
-	// Get sensor data Clock
-	u8 val = 0;
+	strcpy(cache, text);
+	lv_label_set_text(label, text);
+}
 
-	// Update RTC regs from RTC clock.
-	i2c_send_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_UPDATE0_REG, MAX77620_RTC_READ_UPDATE);
+static void _nyx_monitor_set_style(lv_obj_t *label, lv_style_t **cache, lv_style_t *style)
+{
+	if (*cache == style)
+		return;
 
-	// Get control reg config.
-	val = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_CONTROL_REG);
+	*cache = style;
+	lv_label_set_style(label, style);
+}
 
-	// Get time.
-	time.sec = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_SEC_REG) & 0x7F;
-	time.min = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_MIN_REG) & 0x7F;
+static void _nyx_monitor_read_sensors()
+{
+	// 5 transactions for time, 1 for battery and 4 for temperature.
+	max77620_rtc_get_time(&monitor.time);
+	monitor.time.month++;
 
-	time.hour = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_HOUR_REG) & 0x1F;
+	// Keep the last readings if the fuel gauge did not answer.
+	int batt_soc, batt_volt, batt_curr;
+	if (!max17050_get_batt_status(&batt_soc, &batt_volt, &batt_curr))
+	{
+		monitor.batt_soc = batt_soc;
+		monitor.batt_volt = batt_volt;
+		monitor.batt_curr = batt_curr;
+	}
 
-	if (!(val & MAX77620_RTC_24H) && time.hour & MAX77620_RTC_HOUR_PM_MASK)
-		time.hour = (time.hour & 0xF) + 12;
+	monitor.soc_temp = tmp451_get_soc_temp(false);
 
-	// Get day of week. 1: Monday to 7: Sunday.
-	time.weekday = 0;
-	val = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_WEEKDAY_REG);
-	for (int i = 0; i < 8; i++)
+	// Update I2C transactions per minute.
+	u32 elapsed = get_tmr_ms() - monitor.i2c_time;
+	if (elapsed >= 60000)
 	{
-		time.weekday++;
-		if (val & 1)
-			break;
-		val >>= 1;
+		u32 xfers = i2c_get_xfer_count();
+		gui_loop_stats.i2c_xfers = ((u64)(xfers - monitor.i2c_xfers) * 60000) / elapsed;
+
+		monitor.i2c_xfers = xfers;
+		monitor.i2c_time += elapsed;
 	}
+}
 
-	// Get date.
-	time.day = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_DATE_REG) & 0x1f;
-	time.year = (i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_YEAR_REG) & 0x7F) + 2000;
-	time.month = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_MONTH_REG) & 0xF;
+static void _nyx_storage_monitor(void *params)
+{
+	// Only act on card detect changes.
+	bool sd_removed = sd_get_card_removed();
+	if (sd_removed != monitor.sd_removed)
+	{
+		monitor.sd_removed = sd_removed;
+		_check_sd_card_removed();
+	}
+
+	// Check eMMC mode only once. Mode is lowered on init errors.
+	if (!monitor.emmc_checked)
+	{
+		monitor.emmc_checked = true;
+		_nyx_emmc_issues();
+	}
+}
+
+// Tasks refresh definition
+static void update_status(void *params)
+{
+	char txt[32];
+
+	_nyx_monitor_read_sensors();
+
+	// Read and display date and time
+	rtc_time_t time = monitor.time;
 
 	// Time zone CET+1
 	if (time.hour == 23) time.hour = 0;
@@ -1760,133 +1736,57 @@ static void update_status(void *params)
 		else time.hour += 1;
 	}
 
-
-	// Set time and Date                                                                   
-	s_printf(times, "%02d.%02d.%02d "" %02d:%02d:%02d",
+	// Set time and Date
+	s_printf(txt, "%02d.%02d.%02d "" %02d:%02d:%02d",
 		time.day, time.month, time.year, time.hour, time.min, time.sec);
-
-	lv_label_set_array_text(status_bar.time_date, times, 64);
-
-	free(times);																						//******************************************************************** END OF RTC *******
-
+	_nyx_monitor_set_text(status_bar.time_date, monitor.time_txt, txt);
 
 	// Read out the battery and display the symbol depending on the level
-	u32 battPercent = 0;
-	max17050_get_property(MAX17050_RepSOC, (int*)&battPercent);
-
-	int per1 = (battPercent >> 8) & 0xFF;
-	int per2 = (battPercent & 0xFF) / 25.5001; //exact to 4 decimal places
-	if (per2 >= 0)
-		per1 = per1 + 1; // keep value the same as the switch main screen
+	int per1 = (monitor.batt_soc >> 8) & 0xFF;
+	per1 = per1 + 1; // keep value the same as the switch main screen
 
 	if (per1 >= 101)// Correction battery 101%
 		per1 = per1 - 1;
 
-
 	// Battery Icon
-	if (per1 > 0) {
-		lv_label_set_array_text(status_bar.batterysym, SYMBOL_BATTERY_EMPTY, 64);
-	}
-
-	if (per1 > 17) {
-		lv_label_set_array_text(status_bar.batterysym, SYMBOL_BATTERY_1, 64);
-	}
-
-	if (per1 > 34) {
-		lv_label_set_array_text(status_bar.batterysym, SYMBOL_BATTERY_1, 64);
-	}
-
-	if (per1 > 51) {
-		lv_label_set_array_text(status_bar.batterysym, SYMBOL_BATTERY_2, 64);
-	}
-
-	if (per1 > 68) {
-		lv_label_set_array_text(status_bar.batterysym, SYMBOL_BATTERY_3, 64);
-	}
-
-	if (per1 > 84) {
-		lv_label_set_array_text(status_bar.batterysym, SYMBOL_BATTERY_FULL, 64);
-	}
-
-	if (per1 <= 5) {
-		lv_label_set_array_text(status_bar.batterysym, SYMBOL_BATTERY_EMPTY"\nWarning, battery almost empty! Please connect charger!", 64);
+	const char *batt_sym = SYMBOL_BATTERY_EMPTY;
+	if (per1 <= 5)
+		batt_sym = SYMBOL_BATTERY_EMPTY"\nWarning, battery almost empty! Please connect charger!";
+	else if (per1 > 84)
+		batt_sym = SYMBOL_BATTERY_FULL;
+	else if (per1 > 68)
+		batt_sym = SYMBOL_BATTERY_3;
+	else if (per1 > 51)
+		batt_sym = SYMBOL_BATTERY_2;
+	else if (per1 > 17)
+		batt_sym = SYMBOL_BATTERY_1;
+
+	if (monitor.batt_sym != batt_sym)
+	{
+		monitor.batt_sym = batt_sym;
+		lv_label_set_text(status_bar.batterysym, batt_sym);
 	}
 
 	// Show info text battery percent
-	if (per1 < 20) {
-
-		char *battery = (char*)malloc(0x1000);
-		s_printf(battery, "%d %%", per1);
-
-		lv_label_set_array_text(status_bar.charging, battery, 64);
-		lv_label_set_style(status_bar.charging, &font20red_style);
-
-		free(battery);
-
-	}
-
-	else {
-
-		char *battery = (char*)malloc(0x1000);
-		s_printf(battery, "%d %%", per1);
-
-		lv_label_set_array_text(status_bar.charging, battery, 64);
-		lv_label_set_style(status_bar.charging, &font20_style);
-
-		free(battery);
-
-	}
-
-	// Power consumption and volt display
-	char *amp = (char*)malloc(64);
-	char *volt = (char*)malloc(64);
-	int batt_volt;
-	int batt_curr;
-
-	// Get sensor data.
-	max17050_get_property(MAX17050_VCELL, &batt_volt);
-	max17050_get_property(MAX17050_Current, &batt_curr);
+	s_printf(txt, "%d %%", per1);
+	_nyx_monitor_set_text(status_bar.charging, monitor.batt_pct_txt, txt);
+	_nyx_monitor_set_style(status_bar.charging, &monitor.batt_pct_style, per1 < 20 ? &font20red_style : &font20_style);
 
 	// Set battery current draw
-	if (batt_curr >= 0) {
-
-		s_printf(amp, "+%d mA", batt_curr / 1000);
-
-		lv_label_set_array_text(status_bar.battery_more, amp, 64);
-		lv_label_set_style(status_bar.battery_more, &font20green_style);
-
-		free(amp);
-	}
-
-	else {
-
-		s_printf(amp, "-%d mA", (~batt_curr + 1) / 1000);
-
-		lv_label_set_array_text(status_bar.battery_more, amp, 64);
-		lv_label_set_style(status_bar.battery_more, &font20red_style);
-
-		free(amp);
-	}
-
-	char *mvolt = (char*)malloc(64);
-	s_printf(volt, "%d V", batt_volt);
-	s_printf(mvolt, "%d V", batt_volt);
-	mvolt[0] = '.';
-	volt[strlen(volt) - 5] = '\0';
-	strcat(volt, mvolt);
-
-	lv_label_set_array_text(status_bar.battery_more_volt, volt, 64);
-	lv_label_set_style(status_bar.battery_more_volt, &font20_style);
+	if (monitor.batt_curr >= 0)
+		s_printf(txt, "+%d mA", monitor.batt_curr / 1000);
+	else
+		s_printf(txt, "-%d mA", (~monitor.batt_curr + 1) / 1000);
+	_nyx_monitor_set_text(status_bar.battery_more, monitor.batt_curr_txt, txt);
+	_nyx_monitor_set_style(status_bar.battery_more, &monitor.batt_curr_style,
+		monitor.batt_curr >= 0 ? &font20green_style : &font20red_style);
 
-	free(volt);
-	free(mvolt);
+	// Set battery voltage
+	s_printf(txt, "%d.%03d V", monitor.batt_volt / 1000, monitor.batt_volt % 1000);
+	_nyx_monitor_set_text(status_bar.battery_more_volt, monitor.batt_volt_txt, txt);
 
 	// Read and display temperature
-	char *temp = (char*)malloc(64);
-
-	u16 soc_temp = 0;
-
-	soc_temp = tmp451_get_soc_temp(false);
+	u16 soc_temp = monitor.soc_temp;
 
 	// Enable fan if more than 46 oC.
 	u32 soc_temp_dec = (soc_temp >> 8);
@@ -1896,21 +1796,10 @@ static void update_status(void *params)
 		set_fan_duty(51);
 	else if (soc_temp_dec < 40)
 		set_fan_duty(0);
-	
-	// Create SoC temperature label
-	if (soc_temp_dec > 51)
-		s_printf(temp, "CPU %02d.%d#", soc_temp_dec, (soc_temp & 0xFF) / 10);
-	else if (soc_temp_dec > 41)
-		s_printf(temp, "CPU %02d.%d#", soc_temp_dec, (soc_temp & 0xFF) / 10);
-	else if (soc_temp_dec < 40)
-		s_printf(temp, "CPU %02d.%d#", soc_temp_dec, (soc_temp & 0xFF) / 10);
-
-
-	lv_label_set_array_text(status_bar.temperature, temp, 64);
-	lv_label_set_style(status_bar.temperature, &font20_style);
-
-	free(temp);
 
+	// Create SoC temperature label
+	s_printf(txt, "CPU %02d.%d#", soc_temp_dec, (soc_temp & 0xFF) / 10);
+	_nyx_monitor_set_text(status_bar.temperature, monitor.temp_txt, txt);
 }
 
 // Static features brightness
@@ -1964,12 +1853,14 @@ static void create_title(lv_theme_t *th)
 	lv_obj_t *label_volt = lv_label_create(lv_scr_act(), NULL);
 	lv_label_set_static_text(label_volt, "0.000 V");
 	lv_obj_set_pos(label_volt, 1050, 620);
+	lv_label_set_style(label_volt, &font20_style);
 	status_bar.battery_more_volt = label_volt;
 
 	// Create label for task update Temperature
 	lv_obj_t *label_temp = lv_label_create(lv_scr_act(), NULL);
 	lv_label_set_static_text(label_temp, "CPU 00.0");
 	lv_obj_set_pos(label_temp, 900, 620);
+	lv_label_set_style(label_temp, &font20_style);
 	status_bar.temperature = label_temp;
 
 	// Label degree signs ° and C
@@ -2540,14 +2431,23 @@ static void load_main_menu(lv_theme_t *th)
 	lv_task_ready(system_tasks.task.dram_periodic_comp);
 
 	// Create Task Updates
+	monitor.i2c_time = get_tmr_ms();
+	monitor.i2c_xfers = i2c_get_xfer_count();
 	system_tasks.task.status_bar = lv_task_create(update_status, 5000, LV_TASK_PRIO_LOW, NULL);
 	lv_task_ready(system_tasks.task.status_bar);
 
-	lv_task_create(_check_sd_card_removed, 2000, LV_TASK_PRIO_LOWEST, NULL);
-	 
-	task_emmc_errors = lv_task_create(_nyx_emmc_issues, 2000, LV_TASK_PRIO_LOWEST, NULL);		// May Cause Error !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-	lv_task_ready(task_emmc_errors);
+	// Check for SD card and eMMC changes.
+	lv_task_t *task_storage = lv_task_create(_nyx_storage_monitor, 2000, LV_TASK_PRIO_LOWEST, NULL);
+	lv_task_ready(task_storage);
+
+}
+
+static void _gui_loop(bool dram_scaling)
+{
+	gui_loop_init();
 
+	while (true)
+		gui_loop_step(dram_scaling);
 }
 
 // Initialize GUI
@@ -2611,23 +2511,6 @@ void gui_load_and_run()
 		lv_task_once(task_run_sd_errors);
 	}
 
-	// Gui loop.
-	if (h_cfg.t210b01)
-	{
-		// Minerva not supported on T210B01 yet. No power saving.
-		while (true)
-			lv_task_handler();
-	}
-	else
-	{
-		// Alternate DRAM frequencies. Saves 280 mW.
-		while (true)
-		{
-			minerva_change_freq(FREQ_1600);  // Takes 295 us.
-
-			lv_task_handler();
-
-			minerva_change_freq(FREQ_800);   // Takes 80 us.
-		}
-	}
+	// Gui loop. Minerva not supported on T210B01 yet, so no DRAM power saving there.
+	_gui_loop(!h_cfg.t210b01);
 }
@@ -0,0 +1,107 @@
+/*
+ * BMP to LVGL image conversion
+ *
+ * Copyright (c) 2018-2022 CTCaer
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include <bdk.h>
+
+#include "gui.h"
+
+lv_img_dsc_t *bmp_to_lvimg_obj(const char *path)
+{
+	u32 fsize;
+	u8 *bitmap = sd_file_read(path, &fsize);
+	if (!bitmap)
+		return NULL;
+
+	struct _bmp_data
+	{
+		u32 size;
+		u32 size_x;
+		u32 size_y;
+		u32 offset;
+	};
+
+	struct _bmp_data bmpData;
+
+	// Get values manually to avoid unaligned access.
+	bmpData.size = bitmap[2] | bitmap[3] << 8 |
+		bitmap[4] << 16 | bitmap[5] << 24;
+	bmpData.offset = bitmap[10] | bitmap[11] << 8 |
+		bitmap[12] << 16 | bitmap[13] << 24;
+	bmpData.size_x = bitmap[18] | bitmap[19] << 8 |
+		bitmap[20] << 16 | bitmap[21] << 24;
+	bmpData.size_y = bitmap[22] | bitmap[23] << 8 |
+		bitmap[24] << 16 | bitmap[25] << 24;
+
+	// Check if non-default Bottom-Top.
+	bool flipped = false;
+	if (bmpData.size_y & 0x80000000)
+	{
+		bmpData.size_y = ~(bmpData.size_y) + 1;
+		flipped = true;
+	}
+
+	// Image is converted in place, after the descriptor.
+	u32 data_offset = ALIGN((uptr)bitmap + sizeof(lv_img_dsc_t), 0x10) - (uptr)bitmap;
+	u32 row_size = bmpData.size_x * sizeof(u32);
+	u64 data_size = (u64)row_size * bmpData.size_y;
+
+	// Sanity check.
+	if (bitmap[0] != 'B' ||
+		bitmap[1] != 'M' ||
+		bitmap[28] != 32 || // Only 32 bit BMPs allowed.
+		bmpData.size > fsize ||
+		bmpData.offset > fsize || bmpData.size_x > (fsize / sizeof(u32)) ||
+		data_size > (fsize - bmpData.offset) || data_size > (fsize - data_offset))
+	{
+		free(bitmap);
+		return NULL;
+	}
+
+	lv_img_dsc_t *img_desc = (lv_img_dsc_t *)bitmap;
+	u8 *data = bitmap + data_offset;
+
+	// Move the unaligned data to the aligned image buffer.
+	memmove(data, bitmap + bmpData.offset, data_size);
+
+	// Default Bottom-Top images get their rows swapped.
+	if (!flipped && bmpData.size_y > 1)
+	{
+		u8 *row = malloc(row_size);
+		u8 *top = data;
+		u8 *bottom = data + (bmpData.size_y - 1) * row_size;
+		for (; top < bottom; top += row_size, bottom -= row_size)
+		{
+			memcpy(row, top, row_size);
+			memcpy(top, bottom, row_size);
+			memcpy(bottom, row, row_size);
+		}
+		free(row);
+	}
+
+	img_desc->header.always_zero = 0;
+	img_desc->header.w = bmpData.size_x;
+	img_desc->header.h = bmpData.size_y;
+	img_desc->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+	img_desc->data_size = data_size;
+	img_desc->data = data;
+
+	return img_desc;
+}
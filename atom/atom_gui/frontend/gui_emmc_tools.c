@@ -19,6 +19,7 @@
 #include <bdk.h>
 
 #include "gui.h"
+#include "gui_log.h"
 #include "gui_emmc_tools.h"
 #include "gui_tools.h"
 #include "fe_emmc_tools.h"
@@ -90,6 +91,7 @@ static void _create_window_backup_restore(emmcPartType_t type, const char* win_l
 	lv_label_set_static_text(label_log, "");
 	lv_obj_set_width(label_log, lv_obj_get_width(h2));
 	lv_obj_align(label_log, h2, LV_ALIGN_IN_TOP_LEFT, LV_DPI / 10, LV_DPI / 10);
+	nyx_log_attach(label_log, 0);
 	emmc_tool_gui_ctxt.label_log = label_log;
 
 	lv_obj_t *label_sep = lv_label_create(h1, NULL);
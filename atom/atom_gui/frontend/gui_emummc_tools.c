@@ -19,6 +19,7 @@
 #include <bdk.h>
 
 #include "gui.h"
+#include "gui_log.h"
 #include "fe_emummc_tools.h"
 #include "gui_tools_partition_manager.h"
 #include <libs/fatfs/ff.h>
@@ -93,6 +94,7 @@ static void _create_window_emummc()
 	lv_label_set_static_text(label_log, "");
 	lv_obj_set_width(label_log, lv_obj_get_width(h2));
 	lv_obj_align(label_log, h2, LV_ALIGN_IN_TOP_LEFT, LV_DPI / 10, LV_DPI / 10);
+	nyx_log_attach(label_log, 0);
 	emmc_tool_gui_ctxt.label_log = label_log;
 
 	// Create elements for info container.
@@ -521,18 +523,18 @@ static void _migrate_sd_backup_file_based()
 	emmcsn_path_impl(backup_path, "", "", NULL);
 
 	// Move BOOT0.
-	s_printf(backup_file_path, "%s/BOOT0", backup_path);
+	s_snprintf(backup_file_path, 128, "%s/BOOT0", backup_path);
 	strcpy(emu_path + base_len, "/eMMC/BOOT0");
 	f_rename(backup_file_path, emu_path);
 
 	// Move BOOT1.
-	s_printf(backup_file_path, "%s/BOOT1", backup_path);
+	s_snprintf(backup_file_path, 128, "%s/BOOT1", backup_path);
 	strcpy(emu_path + base_len, "/eMMC/BOOT1");
 	f_rename(backup_file_path, emu_path);
 
 	// Move raw GPP.
 	bool multipart = false;
-	s_printf(backup_file_path, "%s/rawnand.bin", backup_path);
+	s_snprintf(backup_file_path, 128, "%s/rawnand.bin", backup_path);
 
 	if(f_stat(backup_file_path, NULL))
 		multipart = true;
@@ -547,8 +549,8 @@ static void _migrate_sd_backup_file_based()
 		emu_path[base_len] = 0;
 		for (int i = 0; i < 32; i++)
 		{
-			s_printf(backup_file_path, "%s/rawnand.bin.%02d", backup_path, i);
-			s_printf(parts_path, "%s/eMMC/%02d", emu_path, i);
+			s_snprintf(backup_file_path, 128, "%s/rawnand.bin.%02d", backup_path, i);
+			s_snprintf(parts_path, 128, "%s/eMMC/%02d", emu_path, i);
 			if (f_rename(backup_file_path, parts_path))
 				break;
 		}
@@ -981,7 +983,7 @@ static lv_res_t _create_change_emummc_window(lv_obj_t *btn_caller)
 	// Check for sd raw partitions, based on the folders in /emuMMC.
 	while (emummc_img->dirlist[emummc_idx * 256])
 	{
-		s_printf(path, "emuMMC/%s/raw_based", &emummc_img->dirlist[emummc_idx * 256]);
+		s_snprintf(path, 512, "emuMMC/%s/raw_based", &emummc_img->dirlist[emummc_idx * 256]);
 
 		if(!f_stat(path, NULL))
 		{
@@ -994,21 +996,21 @@ static lv_res_t _create_change_emummc_window(lv_obj_t *btn_caller)
 			if ((curr_list_sector == 2) || (emummc_img->part_sector[0] && curr_list_sector >= emummc_img->part_sector[0] &&
 				curr_list_sector < emummc_img->part_end[0] && emummc_img->part_type[0] != 0x83))
 			{
-				s_printf(&emummc_img->part_path[0], "emuMMC/%s", &emummc_img->dirlist[emummc_idx * 256]);
+				s_snprintf(&emummc_img->part_path[0], 128, "emuMMC/%s", &emummc_img->dirlist[emummc_idx * 256]);
 				emummc_img->part_sector[0] = curr_list_sector;
 				emummc_img->part_end[0] = 0;
 			}
 			else if (emummc_img->part_sector[1] && curr_list_sector >= emummc_img->part_sector[1] &&
 				curr_list_sector < emummc_img->part_end[1] && emummc_img->part_type[1] != 0x83)
 			{
-				s_printf(&emummc_img->part_path[1 * 128], "emuMMC/%s", &emummc_img->dirlist[emummc_idx * 256]);
+				s_snprintf(&emummc_img->part_path[1 * 128], 128, "emuMMC/%s", &emummc_img->dirlist[emummc_idx * 256]);
 				emummc_img->part_sector[1] = curr_list_sector;
 				emummc_img->part_end[1] = 0;
 			}
 			else if (emummc_img->part_sector[2] && curr_list_sector >= emummc_img->part_sector[2] &&
 				curr_list_sector < emummc_img->part_end[2] && emummc_img->part_type[2] != 0x83)
 			{
-				s_printf(&emummc_img->part_path[2 * 128], "emuMMC/%s", &emummc_img->dirlist[emummc_idx * 256]);
+				s_snprintf(&emummc_img->part_path[2 * 128], 128, "emuMMC/%s", &emummc_img->dirlist[emummc_idx * 256]);
 				emummc_img->part_sector[2] = curr_list_sector;
 				emummc_img->part_end[2] = 0;
 			}
@@ -1022,7 +1024,7 @@ static lv_res_t _create_change_emummc_window(lv_obj_t *btn_caller)
 	// Sanitize the directory list with sd file based ones.
 	while (emummc_img->dirlist[emummc_idx * 256])
 	{
-		s_printf(path, "emuMMC/%s/file_based", &emummc_img->dirlist[emummc_idx * 256]);
+		s_snprintf(path, 512, "emuMMC/%s/file_based", &emummc_img->dirlist[emummc_idx * 256]);
 
 		if(!f_stat(path, NULL))
 		{
@@ -1151,7 +1153,7 @@ out0:;
 	// Add file based to the list.
 	while (emummc_img->dirlist[emummc_idx * 256])
 	{
-		s_printf(path, "emuMMC/%s", &emummc_img->dirlist[emummc_idx * 256]);
+		s_snprintf(path, 512, "emuMMC/%s", &emummc_img->dirlist[emummc_idx * 256]);
 
 		lv_list_add(list_sd_based, NULL, path, _save_file_emummc_cfg_action);
 
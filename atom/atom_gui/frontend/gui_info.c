@@ -21,6 +21,8 @@
 #include <bdk.h>
 
 #include "gui.h"
+#include "fe_storage_bench.h"
+#include "gui_loop.h"
 #include "../config.h"
 #include "../hos/hos.h"
 #include "../hos/pkg1.h"
@@ -1277,6 +1279,133 @@ out:
 	return LV_RES_OK;
 }
 
+#define BENCH_SCRATCH_PATH "AtomNX/sys/bench.tmp"
+#define BENCH_SCRATCH_SCT  0x80000 // 256MB.
+#define BENCH_RND_IOS      0x20000 // 512MB of 4KB reads.
+#define BENCH_RND_W_IOS    0x1000  // 16MB of 4KB writes.
+
+typedef struct _bench_gui_t
+{
+	lv_obj_t *bar;
+	u32 prev_pct;
+	u32 iter;
+	u32 sector;
+	char *txt_buf;
+	char *csv_buf;
+	char *hist_buf;
+} bench_gui_t;
+
+static bool _bench_progress(u32 pct, void *param)
+{
+	bench_gui_t *bench = (bench_gui_t *)param;
+
+	manual_system_maintenance(false);
+
+	if (pct != bench->prev_pct)
+	{
+		lv_bar_set_value(bench->bar, pct);
+		manual_system_maintenance(true);
+
+		bench->prev_pct = pct;
+
+		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
+			return false;
+	}
+
+	return true;
+}
+
+static int _bench_test(bench_gui_t *bench, sdmmc_storage_t *storage, const char *name, const char *csv_name,
+	const u32 *pattern, u32 io_cnt, u32 sector_num, bool show_iops)
+{
+	bench_res_t res;
+
+	bench->prev_pct = 200;
+	int error = bench_run(&bench_sdmmc_ops, storage, bench->sector, pattern, io_cnt, sector_num, (u8 *)MIXD_BUF_ALIGNED,
+		&res, _bench_progress, bench);
+	if (error)
+		return error;
+
+	lv_bar_set_value(bench->bar, 100);
+
+	u32 rate_1k = bench_rate_1k(&res);
+	u32 p50 = bench_lat_percentile(&res.lat, 50);
+	u32 p99 = bench_lat_percentile(&res.lat, 99);
+
+	s_printf(bench->txt_buf + strlen(bench->txt_buf), " %s - Rate: #C7EA46 %3d.%02d MiB/s#",
+		name, rate_1k / 1000, (rate_1k % 1000) / 10);
+	if (show_iops)
+		s_printf(bench->txt_buf + strlen(bench->txt_buf), ", IOPS: #C7EA46 %4d#, p99: #C7EA46 %d# us",
+			bench_iops(&res), p99);
+	strcat(bench->txt_buf, "\n");
+
+	s_printf(bench->csv_buf + strlen(bench->csv_buf), "%d,%08X,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+		bench->iter, bench->sector, csv_name, res.ios, res.sectors * 512, res.time_us,
+		res.time_us ? (u32)((u64)res.sectors * 500000 / res.time_us) : 0, bench_iops(&res), (u32)(res.lat.total_us / res.lat.count), p50, p99, res.lat.max_us,
+		bench_maint_ops_per_mb(&res));
+
+	for (u32 i = 0; i < BENCH_LAT_BUCKETS; i++)
+	{
+		if (res.lat.hist[i])
+			s_printf(bench->hist_buf + strlen(bench->hist_buf), "%d,%s,%d,%d\n",
+				bench->iter, csv_name, bench_lat_bucket_max(i), res.lat.hist[i]);
+	}
+
+	return 0;
+}
+
+static int _bench_write_tests(bench_gui_t *bench, lv_obj_t *lbl_status, u32 *pattern)
+{
+	FIL fp;
+
+	// Writes go to a contiguous scratch file, so no data gets destroyed.
+	if (f_open(&fp, BENCH_SCRATCH_PATH, FA_CREATE_ALWAYS | FA_WRITE))
+	{
+		s_printf(bench->txt_buf + strlen(bench->txt_buf), "#FFDD00 Can't create scratch file, write tests skipped!#\n");
+
+		return 0;
+	}
+
+	if (f_expand(&fp, (u64)BENCH_SCRATCH_SCT * 512, 1))
+	{
+		f_close(&fp);
+		f_unlink(BENCH_SCRATCH_PATH);
+		s_printf(bench->txt_buf + strlen(bench->txt_buf), "#FFDD00 No space for write tests!#\n");
+
+		return 0;
+	}
+
+	bench->iter = 0;
+	bench->sector = sd_fs.database + (fp.obj.sclust - 2) * sd_fs.csize;
+
+	s_printf(bench->txt_buf + strlen(bench->txt_buf), "#C7EA46 Writes# - Sector Offset #C7EA46 %08X#:\n", bench->sector);
+	lv_label_set_text(lbl_status, bench->txt_buf);
+	manual_system_maintenance(true);
+
+	memset((u8 *)MIXD_BUF_ALIGNED, 0xA5, SZ_16M);
+
+	int error;
+	for (u32 i = 0; i < BENCH_SCRATCH_SCT / 0x8000; i++)
+		pattern[i] = (i * 0x8000) | BENCH_IO_WRITE;
+	error = _bench_test(bench, &sd_storage, "Seq. Write 16MiB", "seq_write_16m", pattern, BENCH_SCRATCH_SCT / 0x8000, 0x8000, false);
+	if (error)
+		goto out;
+
+	bench_gen_pattern(pattern, BENCH_RND_W_IOS, 8, BENCH_SCRATCH_SCT, 8, 100);
+	error = _bench_test(bench, &sd_storage, "Rand Write  4KiB", "rnd_write_4k", pattern, BENCH_RND_W_IOS, 8, true);
+	if (error)
+		goto out;
+
+	bench_gen_pattern(pattern, BENCH_RND_W_IOS, 8, BENCH_SCRATCH_SCT, 8, 30);
+	error = _bench_test(bench, &sd_storage, "Mixed 70/30 4KiB", "mixed_70r30w_4k", pattern, BENCH_RND_W_IOS, 8, true);
+
+out:
+	f_close(&fp);
+	f_unlink(BENCH_SCRATCH_PATH);
+
+	return error;
+}
+
 // MBOX SD Benchmark  (AtomNX Version) 
 static lv_res_t _create_mbox_benchmark(bool sd_bench)
 {
@@ -1308,13 +1437,19 @@ static lv_res_t _create_mbox_benchmark(bool sd_bench)
 	lv_mbox_set_style(mbox, LV_MBOX_STYLE_BG, &mbox_bg);// MBOX Run Background Style
 	
 	char *txt_buf = (char*)malloc(SZ_16K);
-	
-	s_printf(txt_buf, "#FF8000 %s Benchmark#\n[Raw Reads] Abort: VOL- & VOL+",
-		sd_bench ? "SD Card" : "eMMC");
+	char *csv_buf = (char *)malloc(SZ_4K + SZ_64K); // Also fits histograms on export.
+	char *hist_buf = (char *)malloc(SZ_64K);
+	u32 *pattern = (u32 *)malloc(BENCH_RND_IOS * sizeof(u32));
+
+	s_printf(txt_buf, "#FF8000 %s Benchmark#\n[%s] Abort: VOL- & VOL+",
+		sd_bench ? "SD Card" : "eMMC", sd_bench ? "Raw Reads/Writes" : "Raw Reads");
 
 	lv_mbox_set_text(mbox, txt_buf);
 	txt_buf[0] = 0;
 
+	strcpy(csv_buf, "iteration,sector,test,ios,bytes,time_us,rate_kib_s,iops,lat_avg_us,lat_p50_us,lat_p99_us,lat_max_us,cache_ops_per_mb\n");
+	strcpy(hist_buf, "\niteration,test,lat_bucket_max_us,count\n");
+
 	lv_obj_t *h1 = lv_cont_create(mbox, NULL);
 	lv_cont_set_fit(h1, false, true);
 	lv_cont_set_style(h1, &lv_style_transp_tight);
@@ -1358,7 +1493,13 @@ static lv_res_t _create_mbox_benchmark(bool sd_bench)
 		lv_mbox_set_text(mbox, "#FFDD00 Failed to init Storage!#");
 		goto out;
 	}
-	
+
+	bench_gui_t bench;
+	bench.bar = bar;
+	bench.txt_buf = txt_buf;
+	bench.csv_buf = csv_buf;
+	bench.hist_buf = hist_buf;
+
 	int error = 0;
 	u32 iters = 3;
 	u32 offset_chunk_start = ALIGN_DOWN(storage->sec_cnt / 3, 0x8000); // Align to 16MB.
@@ -1367,169 +1508,75 @@ static lv_res_t _create_mbox_benchmark(bool sd_bench)
 
 	for (u32 iter_curr = 0; iter_curr < iters; iter_curr++)
 	{
-		u32 pct = 0;
-		u32 prevPct = 200;
-		u32 timer = 0;
-		u32 lba_curr = 0;
-		u32 sector = offset_chunk_start * iter_curr;
-		u32 sector_num = 0x8000;       // 16MB chunks.
-		u32 data_remaining = 0x200000; // 1GB.
-
-		s_printf(txt_buf + strlen(txt_buf), "#C7EA46 %d/3# - Sector Offset #C7EA46 %08X#:\n", iter_curr + 1, sector);
-		lv_mbox_set_text(mbox, txt_buf);
-
-		while (data_remaining)
-		{
-			u32 time_taken = get_tmr_us();
-			error = !sdmmc_storage_read(storage, sector + lba_curr, sector_num, (u8*)MIXD_BUF_ALIGNED);
-			time_taken = get_tmr_us() - time_taken;
-			timer += time_taken;
-
-			manual_system_maintenance(false);
-			data_remaining -= sector_num;
-			lba_curr += sector_num;
-
-			pct = (lba_curr * 100) / 0x200000;
-			if (pct != prevPct)
-			{
-				lv_bar_set_value(bar, pct);
-				manual_system_maintenance(true);
-
-				prevPct = pct;
+		bench.iter = iter_curr + 1;
+		bench.sector = offset_chunk_start * iter_curr;
 
-				if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
-					error = -1;
-			}
+		s_printf(txt_buf + strlen(txt_buf), "#C7EA46 %d/3# - Sector Offset #C7EA46 %08X#:\n", iter_curr + 1, bench.sector);
+		lv_mbox_set_text(mbox, txt_buf);
 
-			if (error)
-				goto error;
-		}	
-		lv_bar_set_value(bar, 100);
+		// 1GB in 16MB chunks.
+		error = _bench_test(&bench, storage, "Sequential 16MiB", "seq_read_16m", NULL, 0x40, 0x8000, false);
+		if (error)
+			goto error;
 
-		u32 rate_1k = ((u64)1024 * 1000 * 1000 * 1000) / timer;
-			s_printf(txt_buf + strlen(txt_buf),
-			" Sequential 16MiB - Rate: #C7EA46 %3d.%02d MiB/s#\n",
-		rate_1k / 1000, (rate_1k % 1000) / 10);
 		lv_label_set_text(lbl_status, txt_buf);
 		lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
 		lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
 		manual_system_maintenance(true);
 
-		pct = 0;
-		prevPct = 200;
-		timer = 0;
-		lba_curr = 0;
-		sector_num = 8;            // 4KB chunks.
-		data_remaining = 0x100000; // 512MB.
-
-		while (data_remaining)
-		{
-			u32 time_taken = get_tmr_us();
-			error = !sdmmc_storage_read(storage, sector + lba_curr, sector_num, (u8*)MIXD_BUF_ALIGNED);
-			time_taken = get_tmr_us() - time_taken;
-			timer += time_taken;
-
-			manual_system_maintenance(false);
-			data_remaining -= sector_num;
-			lba_curr += sector_num;
+		// 512MB in 4KB chunks.
+		error = _bench_test(&bench, storage, "Sequential  4KiB", "seq_read_4k", NULL, BENCH_RND_IOS, 8, true);
+		if (error)
+			goto error;
 
-			pct = (lba_curr * 100) / 0x100000;
-			if (pct != prevPct)
-			{
-				lv_bar_set_value(bar, pct);
-				manual_system_maintenance(true);
-
-				prevPct = pct;
-
-				if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
-					error = -1;
-			}
+		lv_label_set_text(lbl_status, txt_buf);
+		lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
+		lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
+		manual_system_maintenance(true);
 
-			if (error)
-				goto error;
-		}
-		lv_bar_set_value(bar, 100);
+		// 512MB in 4KB chunks at any sector, in a 512MB range.
+		bench_gen_pattern(pattern, BENCH_RND_IOS, 8, 0x100000, 1, 0);
+		error = _bench_test(&bench, storage, "Random      4KiB", "rnd_read_4k", pattern, BENCH_RND_IOS, 8, true);
+		if (error)
+			goto error;
 
-		rate_1k = ((u64)512 * 1000 * 1000 * 1000) / timer;
-		u32 iops_1k = ((u64)512 * 1024 * 1000 * 1000 * 1000) / (4096 / 1024) / timer / 1000;
-		s_printf(txt_buf + strlen(txt_buf),
-			" Sequential  4KiB - Rate: #C7EA46 %3d.%02d MiB/s#, IOPS: #C7EA46 %4d#\n",
-			rate_1k / 1000, (rate_1k % 1000) / 10, iops_1k);
 		lv_label_set_text(lbl_status, txt_buf);
 		lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
 		lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
 		manual_system_maintenance(true);
+	}
 
-			u32 lba_idx = 0;
-			u32* random_offsets = malloc(0x20000 * sizeof(u32));
-			u32  random_numbers[4];
-			for (u32 i = 0; i < 0x20000; i += 4)
-			{
-				// Generate new random numbers.
-				while (!se_gen_prng128(random_numbers))
-					;
-				// Clamp offsets to 512MB range.
-				random_offsets[i + 0] = random_numbers[0] % 0x100000;
-				random_offsets[i + 1] = random_numbers[1] % 0x100000;
-				random_offsets[i + 2] = random_numbers[2] % 0x100000;
-				random_offsets[i + 3] = random_numbers[3] % 0x100000;
-			}
-
-			pct = 0;
-			prevPct = 200;
-			timer = 0;
-			data_remaining = 0x100000; // 512MB.
+	if (sd_bench)
+	{
+		error = _bench_write_tests(&bench, lbl_status, pattern);
+		if (error)
+			goto error;
+	}
 
-			while (data_remaining)
-			{
-				u32 time_taken = get_tmr_us();
-				error = !sdmmc_storage_read(storage, sector + random_offsets[lba_idx], sector_num, (u8*)MIXD_BUF_ALIGNED);
-				time_taken = get_tmr_us() - time_taken;
-				timer += time_taken;
-
-				manual_system_maintenance(false);
-				data_remaining -= sector_num;
-				lba_idx++;
-
-				pct = (lba_idx * 100) / 0x20000;
-				if (pct != prevPct)
-				{
-					lv_bar_set_value(bar, pct);
-					manual_system_maintenance(true);
-
-					prevPct = pct;
-
-					if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
-						error = -1;
-				}
-
-				if (error)
-				{
-					free(random_offsets);
-					goto error;
-				}
-			}
-			lv_bar_set_value(bar, 100);
-
-			// Calculate rate and IOPS for 512MB transfer.
-			rate_1k = ((u64)512 * 1000 * 1000 * 1000) / timer;
-			iops_1k = ((u64)512 * 1024 * 1000 * 1000 * 1000) / (4096 / 1024) / timer / 1000;
-			s_printf(txt_buf + strlen(txt_buf),
-				" Random      4KiB - Rate: #C7EA46 %3d.%02d MiB/s#, IOPS: #C7EA46 %4d#\n",
-				rate_1k / 1000, (rate_1k % 1000) / 10, iops_1k);
-			if (iter_curr == iters - 1)
-				txt_buf[strlen(txt_buf) - 1] = 0; // Cut off last line change.
-			lv_label_set_text(lbl_status, txt_buf);
-			lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
-			lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
-			manual_system_maintenance(true);
-			free(random_offsets);
+	// Export results.
+	char path[64];
+	if (!sd_bench)
+	{
+		emmcsn_path_impl(NULL, NULL, NULL, storage);
+		sd_mount();
 	}
+	emmcsn_path_impl(path, "/dumps", sd_bench ? "sd_bench.csv" : "emmc_bench.csv", NULL);
+	strcat(csv_buf, hist_buf);
+	if (!sd_save_to_file(csv_buf, strlen(csv_buf), path))
+		s_printf(txt_buf + strlen(txt_buf), "Results: #C7EA46 %s#", path);
+	else
+		txt_buf[strlen(txt_buf) - 1] = 0; // Cut off last line change.
+	if (!sd_bench)
+		sd_unmount();
+
+	lv_label_set_text(lbl_status, txt_buf);
+	lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
+	lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
 
 error:
 	if (error)
 	{
-		if (error == -1)
+		if (error == BENCH_ABORTED)
 			s_printf(txt_buf + strlen(txt_buf), "\n#FFDD00 Aborted!#");
 		else
 			s_printf(txt_buf + strlen(txt_buf), "\n#FFDD00 IO Error occurred!#");
@@ -1547,6 +1594,9 @@ error:
 
 out:
 	free(txt_buf);
+	free(csv_buf);
+	free(hist_buf);
+	free(pattern);
 
 	lv_mbox_add_btns(mbox, mbox_btn_map, mbox_action); // Important. After set_text.
 
@@ -2390,6 +2440,143 @@ static lv_res_t _create_window_battery_status(lv_obj_t *btn)
 	return LV_RES_OK;
 }
 
+static const char *_boot_prof_names[BOOT_PROF_PHASE_MAX] = {
+	"HW init",
+	"SD mount",
+	"Minerva init",
+	"INI parse",
+	"Bootlogo",
+	"Pkg1 read",
+	"Keygen",
+	"Pkg2 decrypt",
+	"KIP patching",
+	"Pkg2 build",
+	"Handoff",
+	"Pkg2 cache"
+};
+
+static const char *_boot_prof_name(u32 phase)
+{
+	return phase < BOOT_PROF_PHASE_MAX ? _boot_prof_names[phase] : "Unknown";
+}
+
+static volatile boot_prof_entry_t *_boot_prof_get(u32 pos)
+{
+	volatile boot_prof_t *prof = &nyx_str->info.boot_prof;
+
+	// Oldest entry first.
+	u32 first = (prof->idx + BOOT_PROF_ENTRIES - prof->count) % BOOT_PROF_ENTRIES;
+
+	return &prof->entries[(first + pos) % BOOT_PROF_ENTRIES];
+}
+
+static lv_res_t _boot_prof_dump_window_action(lv_obj_t * btn)
+{
+	volatile boot_prof_t *prof = &nyx_str->info.boot_prof;
+	int error = !sd_mount();
+
+	if (!error)
+	{
+		char path[64];
+		char *buf = (char *)malloc(SZ_16K);
+
+		strcpy(buf, "session,phase,start_us,end_us,duration_us,sha256_bytes\n");
+		for (u32 i = 0; i < prof->count; i++)
+		{
+			volatile boot_prof_entry_t *entry = _boot_prof_get(i);
+			s_printf(buf + strlen(buf), "%d,%s,%d,%d,%d,%d\n", entry->session, _boot_prof_name(entry->phase),
+				entry->start, entry->end, entry->end - entry->start, entry->sha_bytes);
+		}
+
+		emmcsn_path_impl(path, "/dumps", "boot_timeline.csv", NULL);
+		error = sd_save_to_file((u8 *)buf, strlen(buf), path);
+
+		free(buf);
+		sd_unmount();
+	}
+
+	_create_window_dump_done(error, "boot_timeline.csv");
+
+	return LV_RES_OK;
+}
+
+static lv_res_t _create_window_boot_timeline(lv_obj_t *btn)
+{
+	volatile boot_prof_t *prof = &nyx_str->info.boot_prof;
+
+	lv_obj_t *win = gui_create_standard_window(SYMBOL_CLOCK" Boot Timeline");
+	lv_win_add_btn(win, NULL, SYMBOL_DOWNLOAD" Save CSV", _boot_prof_dump_window_action);
+
+	lv_obj_t *desc = lv_cont_create(win, NULL);
+	lv_obj_set_size(desc, LV_HOR_RES / 2 / 4 * 2, LV_VER_RES - (LV_DPI * 11 / 7) - 5);
+
+	lv_obj_t * lb_desc = lv_label_create(desc, NULL);
+	lv_label_set_long_mode(lb_desc, LV_LABEL_LONG_BREAK);
+	lv_label_set_recolor(lb_desc, true);
+	lv_obj_set_width(lb_desc, lv_obj_get_width(desc));
+
+	lv_obj_t *val = lv_cont_create(win, NULL);
+	lv_obj_set_size(val, LV_HOR_RES / 5 * 3, LV_VER_RES - (LV_DPI * 11 / 7));
+
+	lv_obj_t * lb_val = lv_label_create(val, lb_desc);
+	lv_obj_set_width(lb_val, lv_obj_get_width(val));
+
+	char *txt_buf = (char *)malloc(SZ_16K);
+	char *txt_buf2 = (char *)malloc(SZ_16K);
+	txt_buf[0] = 0;
+	txt_buf2[0] = 0;
+
+	if (prof->magic != BOOT_PROF_MAGIC || !prof->count)
+		strcpy(txt_buf, "#FFDD00 No boot timeline recorded!#");
+
+	u32 session = 0;
+	u32 session_start = 0;
+	for (u32 i = 0; i < prof->count; i++)
+	{
+		volatile boot_prof_entry_t *entry = _boot_prof_get(i);
+
+		// New session header. Offsets are relative to its first phase.
+		if (!i || entry->session != session)
+		{
+			session = entry->session;
+			session_start = entry->start;
+			s_printf(txt_buf + strlen(txt_buf), "%s#00DDFF Session %d:#\n", i ? "\n" : "", session);
+			strcat(txt_buf2, i ? "\n\n" : "\n");
+		}
+
+		u32 duration = entry->end - entry->start;
+		u32 offset = entry->start - session_start;
+
+		s_printf(txt_buf + strlen(txt_buf), "%s\n", _boot_prof_name(entry->phase));
+		s_printf(txt_buf2 + strlen(txt_buf2), "+%d.%03d s   #C7EA46 %d.%03d ms#   ",
+			offset / 1000000, (offset / 1000) % 1000, duration / 1000, duration % 1000);
+
+		// SE SHA256 work done in this phase.
+		if (entry->sha_bytes)
+			s_printf(txt_buf2 + strlen(txt_buf2), "#FF8000 SHA %d KiB#   ", entry->sha_bytes >> 10);
+
+		// Bar with one block per 20ms, capped to keep it on screen.
+		u32 blocks = MIN(duration / 20000 + 1, 40);
+		for (u32 j = 0; j < blocks; j++)
+			strcat(txt_buf2, "|");
+		strcat(txt_buf2, "\n");
+	}
+
+	// Idle behavior of the GUI loop.
+	s_printf(txt_buf + strlen(txt_buf), "\n\n#00DDFF GUI Loop:#\nWakeups\nBusy\nI2C");
+	s_printf(txt_buf2 + strlen(txt_buf2), "\n\n\n%d/s\n%d%%\n%d/min",
+		gui_loop_stats.wakeups, gui_loop_stats.busy_pct, gui_loop_stats.i2c_xfers);
+
+	lv_label_set_text(lb_desc, txt_buf);
+	lv_label_set_text(lb_val, txt_buf2);
+	lv_obj_align(val, desc, LV_ALIGN_OUT_RIGHT_TOP, 0, 0);
+
+	free(txt_buf);
+	free(txt_buf2);
+
+	return LV_RES_OK;
+}
+
 static bool _lockpick_exists_check()
 {
 	#define LOCKPICK_MAGIC_OFFSET   0x118
@@ -2620,10 +2807,18 @@ lv_res_t create_win_info(lv_obj_t *btn)
 	lv_label_set_recolor(label_txt6, true);
 	lv_label_set_static_text(label_txt6,
 		"View battery and battery charger related info.\n"
-		"Additionally you can dump battery charger's registers.\n");
+		"Additionally you can dump battery charger's registers\n"
+		"or view how long each #C7EA46 boot phase# took.");
 	lv_obj_set_style(label_txt6, &hint_small_style);
 	lv_obj_align(label_txt6, btn7, LV_ALIGN_OUT_BOTTOM_LEFT, 0, LV_DPI / 3);
 
+	// Create Boot Timeline button.
+	lv_obj_t *btn8 = lv_btn_create(h2, btn7);
+	label_btn = lv_label_create(btn8, NULL);
+	lv_label_set_static_text(label_btn, SYMBOL_CLOCK"  Boot Timeline");
+	lv_obj_align(btn8, btn7, LV_ALIGN_OUT_RIGHT_TOP, LV_DPI * 3 / 4, 0);
+	lv_btn_set_action(btn8, LV_BTN_ACTION_CLICK, _create_window_boot_timeline);
+
 	return LV_RES_OK;
 }
 	
\ No newline at end of file
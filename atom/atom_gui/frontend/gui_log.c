@@ -0,0 +1,262 @@
+/*
+ * Log view with scrollback for long running tools
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <bdk.h>
+
+#include "gui_log.h"
+
+/*
+ * History is kept in a byte ring with a ring of line start positions. Both are
+ * indexed by running counts, so lines never move and the oldest ones are
+ * dropped by advancing a counter. The label references a small view buffer
+ * statically, that only holds the visible lines. So appending costs the same
+ * no matter how long the history is.
+ */
+
+typedef struct _nyx_log_t
+{
+	char *hist;
+	u32 *starts;    // Line start byte counts, indexed by line number.
+	u32 head;       // Bytes written.
+	u32 first;      // Oldest line kept.
+	u32 next;       // Line number of the open last line.
+	u32 back;       // Lines scrolled back from the last one.
+	u32 view_top;   // Oldest line in view.
+	u32 rows;
+	char *view;
+	lv_coord_t line_h;
+	lv_coord_t drag;
+	lv_signal_func_t ancestor_signal;
+} nyx_log_t;
+
+static u32 _nyx_log_line_end(nyx_log_t *log, u32 line)
+{
+	return (line == log->next) ? log->head : log->starts[(line + 1) % NYX_LOG_HIST_LINES];
+}
+
+// Last line with text. An empty open line after a newline is not shown.
+static u32 _nyx_log_last(nyx_log_t *log)
+{
+	if (log->next != log->first && log->starts[log->next % NYX_LOG_HIST_LINES] == log->head)
+		return log->next - 1;
+
+	return log->next;
+}
+
+// Scrolling back stops when the oldest line is at the top.
+static u32 _nyx_log_max_back(nyx_log_t *log)
+{
+	u32 lines = _nyx_log_last(log) - log->first + 1;
+
+	return lines > log->rows ? lines - log->rows : 0;
+}
+
+static void _nyx_log_refresh(lv_obj_t *label, nyx_log_t *log)
+{
+	u32 last = _nyx_log_last(log);
+
+	log->back = MIN(log->back, _nyx_log_max_back(log));
+
+	u32 bottom = last - log->back;
+	u32 top = (bottom - log->first + 1 > log->rows) ? bottom - log->rows + 1 : log->first;
+
+	// Lines are at most NYX_LOG_LINE_MAX long, so the view always fits.
+	u32 pos = 0;
+	for (u32 line = top; line <= bottom; line++)
+	{
+		u32 start = log->starts[line % NYX_LOG_HIST_LINES];
+		u32 len = _nyx_log_line_end(log, line) - start;
+		u32 ofs = start % NYX_LOG_HIST_SIZE;
+		u32 part = MIN(len, NYX_LOG_HIST_SIZE - ofs);
+
+		memcpy(log->view + pos, log->hist + ofs, part);
+		memcpy(log->view + pos + part, log->hist, len - part);
+		pos += len;
+	}
+	log->view[pos] = 0;
+	log->view_top = top;
+
+	lv_label_set_static_text(label, log->view);
+}
+
+static void _nyx_log_putc(nyx_log_t *log, char c)
+{
+	// Drop the oldest lines to make room. The open line is shorter than the ring.
+	while (log->head + 1 - log->starts[log->first % NYX_LOG_HIST_LINES] > NYX_LOG_HIST_SIZE)
+		log->first++;
+
+	// A new line is shown once it has text. Keep a scrolled back view on the same lines.
+	if (log->back && log->next != log->first && log->head == log->starts[log->next % NYX_LOG_HIST_LINES])
+		log->back++;
+
+	log->hist[log->head % NYX_LOG_HIST_SIZE] = c;
+	log->head++;
+
+	if (c == '\n')
+	{
+		if (log->next + 1 - log->first >= NYX_LOG_HIST_LINES)
+			log->first++;
+
+		log->next++;
+		log->starts[log->next % NYX_LOG_HIST_LINES] = log->head;
+	}
+}
+
+static void _nyx_log_reset(nyx_log_t *log)
+{
+	log->head = 0;
+	log->first = 0;
+	log->next = 0;
+	log->back = 0;
+	log->view_top = 0;
+	log->starts[0] = 0;
+}
+
+static lv_res_t _nyx_log_signal(lv_obj_t *label, lv_signal_t sign, void *param)
+{
+	nyx_log_t *log = (nyx_log_t *)lv_obj_get_free_ptr(label);
+
+	lv_res_t res = log->ancestor_signal(label, sign, param);
+	if (res != LV_RES_OK)
+		return res;
+
+	switch (sign)
+	{
+	case LV_SIGNAL_PRESSING:
+	{
+		// Dragging down shows older lines.
+		lv_point_t vect;
+		lv_indev_get_vect(lv_indev_get_act(), &vect);
+		log->drag += vect.y;
+
+		int lines = log->drag / log->line_h;
+		if (lines)
+		{
+			log->drag -= lines * log->line_h;
+			nyx_log_scroll(label, lines);
+		}
+		break;
+	}
+	case LV_SIGNAL_RELEASED:
+	case LV_SIGNAL_PRESS_LOST:
+		log->drag = 0;
+		break;
+	case LV_SIGNAL_CLEANUP:
+		lv_obj_set_free_ptr(label, NULL);
+		free(log->hist);
+		free(log->starts);
+		free(log->view);
+		free(log);
+		break;
+	default:
+		break;
+	}
+
+	return res;
+}
+
+void nyx_log_attach(lv_obj_t *label, u32 rows)
+{
+	nyx_log_t *log = (nyx_log_t *)calloc(sizeof(nyx_log_t), 1);
+
+	lv_style_t *style = lv_obj_get_style(label);
+	log->line_h = lv_font_get_height(style->text.font) + style->text.line_space;
+
+	// Show only as many lines as fit in the parent container.
+	if (!rows)
+	{
+		lv_coord_t avail_h = lv_obj_get_height(lv_obj_get_parent(label)) - (lv_obj_get_y(label) * 2);
+		rows = avail_h > log->line_h ? (avail_h / log->line_h) - 1 : 1;
+	}
+	log->rows = rows;
+
+	log->hist = (char *)malloc(NYX_LOG_HIST_SIZE);
+	log->starts = (u32 *)malloc(NYX_LOG_HIST_LINES * sizeof(u32));
+	log->view = (char *)malloc(rows * NYX_LOG_LINE_MAX + 1);
+	_nyx_log_reset(log);
+
+	log->ancestor_signal = lv_obj_get_signal_func(label);
+	lv_obj_set_free_ptr(label, log);
+	lv_obj_set_signal_func(label, _nyx_log_signal);
+	lv_obj_set_click(label, true);
+
+	_nyx_log_refresh(label, log);
+}
+
+void nyx_log_append(lv_obj_t *label, const char *text)
+{
+	nyx_log_t *log = (nyx_log_t *)lv_obj_get_free_ptr(label);
+
+	// Fallback for labels without a log.
+	if (!log)
+	{
+		lv_label_ins_text(label, LV_LABEL_POS_LAST, text);
+		return;
+	}
+
+	for (; *text; text++)
+	{
+		// Break overlong lines.
+		if (log->head - log->starts[log->next % NYX_LOG_HIST_LINES] == NYX_LOG_LINE_MAX - 1 && *text != '\n')
+			_nyx_log_putc(log, '\n');
+
+		_nyx_log_putc(log, *text);
+	}
+
+	// A view scrolled back stays as is, unless its lines were dropped.
+	if (!log->back || log->view_top < log->first)
+		_nyx_log_refresh(label, log);
+}
+
+void nyx_log_set_text(lv_obj_t *label, const char *text)
+{
+	nyx_log_t *log = (nyx_log_t *)lv_obj_get_free_ptr(label);
+
+	if (!log)
+	{
+		lv_label_set_text(label, text);
+		return;
+	}
+
+	_nyx_log_reset(log);
+
+	nyx_log_append(label, text);
+}
+
+void nyx_log_scroll(lv_obj_t *label, int lines)
+{
+	nyx_log_t *log = (nyx_log_t *)lv_obj_get_free_ptr(label);
+
+	if (!log)
+		return;
+
+	u32 back;
+	if (lines < 0)
+		back = (u32)-lines > log->back ? 0 : log->back + lines;
+	else
+		back = MIN(log->back + lines, _nyx_log_max_back(log));
+
+	if (back == log->back)
+		return;
+
+	log->back = back;
+	_nyx_log_refresh(label, log);
+}
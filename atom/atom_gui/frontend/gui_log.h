@@ -0,0 +1,35 @@
+/*
+ * Log view with scrollback for long running tools
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GUI_LOG_H_
+#define _GUI_LOG_H_
+
+#include <libs/lvgl/lvgl.h>
+
+#define NYX_LOG_HIST_SIZE  0x10000 // Scrollback bytes.
+#define NYX_LOG_HIST_LINES 2048    // Scrollback lines.
+#define NYX_LOG_LINE_MAX   0x200   // Longer lines are broken.
+
+// rows: Visible lines. 0 for as many as fit in the parent.
+void nyx_log_attach(lv_obj_t *label, u32 rows);
+void nyx_log_append(lv_obj_t *label, const char *text);
+void nyx_log_set_text(lv_obj_t *label, const char *text);
+// lines: Positive scrolls back to older lines. Scrolling to the end follows new lines again.
+void nyx_log_scroll(lv_obj_t *label, int lines);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * GUI main loop with idle sleep
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bdk.h>
+
+#include "gui_loop.h"
+
+gui_loop_stats_t gui_loop_stats;
+
+static u32 stats_start;
+static u32 wakeups;
+static u32 busy_us;
+
+void gui_loop_init()
+{
+	memset(&gui_loop_stats, 0, sizeof(gui_loop_stats_t));
+
+	stats_start = get_tmr_us();
+	wakeups = 0;
+	busy_us = 0;
+}
+
+void gui_loop_step(bool dram_scaling)
+{
+	// Sleep until the next task is due. Input reading and display refresh are tasks too.
+	u32 wait_ms = MIN(lv_task_time_till_next(), GUI_LOOP_MAX_SLEEP_MS);
+	if (wait_ms)
+		bpmp_usleep(wait_ms * 1000);
+
+	u32 start = get_tmr_us();
+
+	// Alternate DRAM frequencies only when there's work to do. Saves 280 mW.
+	if (dram_scaling)
+		minerva_change_freq(FREQ_1600);  // Takes 295 us.
+
+	lv_task_handler();
+
+	if (dram_scaling)
+		minerva_change_freq(FREQ_800);   // Takes 80 us.
+
+	u32 end = get_tmr_us();
+	busy_us += end - start;
+	wakeups++;
+
+	// Update loop statistics every second.
+	u32 elapsed = end - stats_start;
+	if (elapsed >= 1000000)
+	{
+		gui_loop_stats.wakeups = ((u64)wakeups * 1000000) / elapsed;
+		gui_loop_stats.busy_pct = ((u64)busy_us * 100) / elapsed;
+
+		stats_start = end;
+		wakeups = 0;
+		busy_us = 0;
+	}
+}
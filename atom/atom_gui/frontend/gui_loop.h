@@ -0,0 +1,41 @@
+/*
+ * GUI main loop with idle sleep
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GUI_LOOP_H_
+#define _GUI_LOOP_H_
+
+#include <libs/lvgl/lvgl.h>
+#include <utils/types.h>
+
+// Longest sleep between task passes. Keeps input responsive even without input tasks.
+#define GUI_LOOP_MAX_SLEEP_MS LV_INDEV_READ_PERIOD
+
+typedef struct _gui_loop_stats_t
+{
+	u32 wakeups;  // Per second.
+	u32 busy_pct;
+	u32 i2c_xfers; // Per minute.
+} gui_loop_stats_t;
+
+extern gui_loop_stats_t gui_loop_stats;
+
+void gui_loop_init();
+// Sleeps until the next task is due and runs the due tasks.
+void gui_loop_step(bool dram_scaling);
+
+#endif
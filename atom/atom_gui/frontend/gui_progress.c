@@ -0,0 +1,95 @@
+/*
+ * Rate limited progress for long storage operations
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bdk.h>
+
+#include "gui.h"
+#include "gui_progress.h"
+
+/*
+ * Rate limited progress for long storage operations.
+ *
+ * I/O loops post their position after every chunk. That is only a timer read,
+ * unless a redraw is due. Redraws happen at most every NYX_PROGRESS_PERIOD_MS
+ * and only if the percentage changed, or every NYX_PROGRESS_STATS_PERIOD_MS to
+ * refresh speed and time left. So refresh count depends on time, not chunk count.
+ */
+
+static void _nyx_progress_draw(nyx_progress_t *prog, u32 lba_curr)
+{
+	lv_bar_set_value(prog->bar, prog->pct);
+
+	if (prog->rate && prog->pct < 100)
+	{
+		u32 left = ((prog->lba_end - lba_curr) >> 1) / prog->rate;
+
+		s_printf(prog->txt_buf, " "SYMBOL_DOT" %d%%  %d.%d MB/s, %dm %02ds left", prog->pct,
+			prog->rate >> 10, ((prog->rate & 0x3FF) * 10) >> 10, left / 60, left % 60);
+	}
+	else
+		s_printf(prog->txt_buf, " "SYMBOL_DOT" %d%%", prog->pct);
+
+	lv_label_set_text(prog->label, prog->txt_buf);
+	manual_system_maintenance(true);
+
+	prog->refreshes++;
+}
+
+void nyx_progress_init(nyx_progress_t *prog, lv_obj_t *bar, lv_obj_t *label, char *txt_buf, u32 lba_start, u32 lba_end, u32 lba_curr)
+{
+	prog->bar = bar;
+	prog->label = label;
+	prog->txt_buf = txt_buf;
+	prog->lba_start = lba_start;
+	prog->lba_end = lba_end;
+	prog->lba_last = lba_curr;
+	prog->time_last = get_tmr_ms();
+	prog->pct = 200;
+	prog->rate = 0;
+	prog->refreshes = 0;
+}
+
+void nyx_progress_update(nyx_progress_t *prog, u32 lba_curr)
+{
+	u32 elapsed = get_tmr_ms() - prog->time_last;
+	if (elapsed < NYX_PROGRESS_PERIOD_MS)
+		return;
+
+	u32 pct = (u64)((u64)(lba_curr - prog->lba_start) * 100u) / (u64)MAX(prog->lba_end - prog->lba_start, 1);
+	if (pct == prog->pct && elapsed < NYX_PROGRESS_STATS_PERIOD_MS)
+		return;
+
+	// Exponential moving average of the rate over the redraw intervals.
+	u32 rate = (u64)((u64)((lba_curr - prog->lba_last) >> 1) * 1000u) / elapsed;
+	prog->rate = prog->rate ? (prog->rate * 3 + rate) / 4 : rate;
+
+	prog->pct = pct;
+	prog->lba_last = lba_curr;
+	prog->time_last += elapsed;
+
+	_nyx_progress_draw(prog, lba_curr);
+}
+
+void nyx_progress_set(nyx_progress_t *prog, u32 pct)
+{
+	prog->pct = pct;
+	prog->rate = 0;
+	prog->time_last = get_tmr_ms();
+
+	_nyx_progress_draw(prog, prog->lba_end);
+}
@@ -0,0 +1,46 @@
+/*
+ * Rate limited progress for long storage operations
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GUI_PROGRESS_H_
+#define _GUI_PROGRESS_H_
+
+#include <libs/lvgl/lvgl.h>
+#include <utils/types.h>
+
+#define NYX_PROGRESS_PERIOD_MS       200  // Minimum time between redraws.
+#define NYX_PROGRESS_STATS_PERIOD_MS 1000 // Minimum time between redraws without percentage change.
+
+typedef struct _nyx_progress_t
+{
+	lv_obj_t *bar;
+	lv_obj_t *label;
+	char *txt_buf;
+	u32 lba_start;
+	u32 lba_end;
+	u32 lba_last;  // Position at last redraw.
+	u32 time_last; // Time of last redraw in ms.
+	u32 pct;
+	u32 rate;      // Smoothed rate in KiB/s.
+	u32 refreshes;
+} nyx_progress_t;
+
+void nyx_progress_init(nyx_progress_t *prog, lv_obj_t *bar, lv_obj_t *label, char *txt_buf, u32 lba_start, u32 lba_end, u32 lba_curr);
+void nyx_progress_update(nyx_progress_t *prog, u32 lba_curr);
+void nyx_progress_set(nyx_progress_t *prog, u32 pct);
+
+#endif
@@ -1368,7 +1368,7 @@ static lv_res_t _create_window_dump_pk12_tool(lv_obj_t *btn)
 		pkg2_kip1_t *kip1 = (pkg2_kip1_t *)ptr;
 		u32 kip1_size = pkg2_calc_kip1_size(kip1);
 
-		s_printf(filename, "%s.kip1", kip1->name);
+		s_snprintf(filename, sizeof(filename), "%.12s.kip1", kip1->name);
 		if ((u32)kip1 % 8)
 		{
 			memcpy(kip_buffer, kip1, kip1_size);
@@ -1382,7 +1382,7 @@ static lv_res_t _create_window_dump_pk12_tool(lv_obj_t *btn)
 			goto out;
 		}
 
-		s_printf(txt_buf + strlen(txt_buf), "%s kip dumped to %s.kip1\n", kip1->name, kip1->name);
+		s_printf(txt_buf + strlen(txt_buf), "%.12s kip dumped to %s\n", kip1->name, filename);
 		lv_label_set_text(lb_desc, txt_buf);
 		manual_system_maintenance(true);
 
@@ -19,6 +19,7 @@
 #include <bdk.h>
 
 #include "gui.h"
+#include "gui_log.h"
 #include "gui_tools.h"
 #include "gui_tools_partition_manager.h"
 #include <libs/fatfs/diskio.h>
@@ -83,25 +84,136 @@ l4t_flasher_ctxt_t l4t_flash_ctxt;
 lv_obj_t *btn_flash_l4t;
 lv_obj_t *btn_flash_android;
 
-static int _stat_and_copy_files(const char *src, const char *dst, char *path, u32 *total_files, u32 *total_size, lv_obj_t **labels)
+#define COPY_SMALL_FILE_SZ  SZ_1M  // Files up to this size are packed into shared read batches.
+#define COPY_BUF_SZ         SZ_16M // Size of SDXC_BUF_ALIGNED.
+#define COPY_PROGRESS_MS    100    // Progress refresh period.
+
+typedef struct _copy_entry_t
+{
+	u32 size;
+	u32 path_off;
+	u8  attrib;
+} copy_entry_t;
+
+typedef struct _copy_list_t
+{
+	copy_entry_t *dirs;
+	u32 dirs_num;
+	u32 dirs_max;
+
+	copy_entry_t *files;
+	u32 files_num;
+	u32 files_max;
+
+	char *paths;
+	u32 paths_len;
+	u32 paths_max;
+} copy_list_t;
+
+static void *_copy_list_grow(void *buf, u32 used_size, u32 new_size)
+{
+	void *new_buf = malloc(new_size);
+	if (buf)
+	{
+		memcpy(new_buf, buf, used_size);
+		free(buf);
+	}
+
+	return new_buf;
+}
+
+static void _copy_list_add(copy_list_t *list, bool is_dir, const char *path, u32 size, u8 attrib)
+{
+	u32 path_len = strlen(path) + 1;
+
+	if (list->paths_len + path_len > list->paths_max)
+	{
+		list->paths_max = MAX(list->paths_max * 2, list->paths_len + path_len + SZ_64K);
+		list->paths = _copy_list_grow(list->paths, list->paths_len, list->paths_max);
+	}
+
+	copy_entry_t **entries = is_dir ? &list->dirs : &list->files;
+	u32 *num = is_dir ? &list->dirs_num : &list->files_num;
+	u32 *max = is_dir ? &list->dirs_max : &list->files_max;
+
+	if (*num == *max)
+	{
+		*max = *max ? *max * 2 : 1024;
+		*entries = _copy_list_grow(*entries, *num * sizeof(copy_entry_t), *max * sizeof(copy_entry_t));
+	}
+
+	copy_entry_t *entry = &(*entries)[*num];
+	entry->size = size;
+	entry->path_off = list->paths_len;
+	entry->attrib = attrib;
+	(*num)++;
+
+	memcpy(&list->paths[list->paths_len], path, path_len);
+	list->paths_len += path_len;
+}
+
+static void _copy_list_free(copy_list_t *list)
+{
+	free(list->dirs);
+	free(list->files);
+	free(list->paths);
+	memset(list, 0, sizeof(copy_list_t));
+}
+
+static void _copy_list_sort_by_size(copy_list_t *list)
+{
+	copy_entry_t tmp;
+	copy_entry_t *files = list->files;
+	u32 num = list->files_num;
+
+	// Shell sort. Not stable, but the copy order of equal sizes does not matter
+	// and it needs no extra memory.
+	for (u32 gap = num / 2; gap > 0; gap /= 2)
+	{
+		for (u32 i = gap; i < num; i++)
+		{
+			tmp = files[i];
+			u32 j = i;
+			for (; j >= gap && files[j - gap].size > tmp.size; j -= gap)
+				files[j] = files[j - gap];
+			files[j] = tmp;
+		}
+	}
+}
+
+static bool _copy_progress_due(u32 *timer)
+{
+	u32 now = get_tmr_ms();
+	if ((now - *timer) < COPY_PROGRESS_MS)
+		return false;
+
+	*timer = now;
+
+	return true;
+}
+
+static void _copy_progress_update(lv_obj_t **labels, const char *path, u32 files_done, u32 files_total, u32 size_done, u32 size_total)
+{
+	char txt_buf[64];
+
+	lv_label_set_text(labels[0], path);
+	s_printf(txt_buf, "Files: %d/%d, %d/%d MiB", files_done, files_total, size_done >> 20, size_total >> 20);
+	lv_label_set_text(labels[1], txt_buf);
+	manual_system_maintenance(true);
+}
+
+static int _stat_files(char *path, u32 *total_files, u32 *total_size, copy_list_t *list, lv_obj_t **labels, u32 *timer)
 {
 	FRESULT res;
-	FIL fp_src;
-	FIL fp_dst;
 	DIR dir;
 	u32 dirLength = 0;
 	static FILINFO fno;
 
-	f_chdrive(src);
-
 	// Open directory.
 	res = f_opendir(&dir, path);
 	if (res != FR_OK)
 		return res;
 
-	if (labels)
-		lv_label_set_text(labels[0], path);
-
 	dirLength = strlen(path);
 
 	// Hard limit path to 1024 characters. Do not result to error.
@@ -124,13 +236,13 @@ static int _stat_and_copy_files(const char *src, const char *dst, char *path, u3
 		memcpy(&path[dirLength], "/", 1);
 		strcpy(&path[dirLength + 1], fno.fname);
 
-		if (labels)
+		if (labels && _copy_progress_due(timer))
 		{
-			lv_label_set_text(labels[1], fno.fname);
+			lv_label_set_text(labels[0], path);
 			manual_system_maintenance(true);
 		}
 
-		// Copy file to destination disk.
+		// Add file to copy list.
 		if (!(fno.fattrib & AM_DIR))
 		{
 			u32 file_size = fno.fsize > RAMDISK_CLUSTER_SZ ? fno.fsize : RAMDISK_CLUSTER_SZ; // Ramdisk cluster size.
@@ -147,41 +259,8 @@ static int _stat_and_copy_files(const char *src, const char *dst, char *path, u3
 			*total_size += file_size;
 			*total_files += 1;
 
-			if (dst)
-			{
-				u32 file_size = fno.fsize;
-
-				// Open file for writing.
-				f_chdrive(dst);
-				f_open(&fp_dst, path, FA_CREATE_ALWAYS | FA_WRITE);
-				f_lseek(&fp_dst, fno.fsize);
-				f_lseek(&fp_dst, 0);
-
-				// Open file for reading.
-				f_chdrive(src);
-				f_open(&fp_src, path, FA_READ);
-
-				while (file_size)
-				{
-					u32 chunk_size = MIN(file_size, SZ_4M); // 4MB chunks.
-					file_size -= chunk_size;
-
-					// Copy file to buffer.
-					f_read(&fp_src, (void *)SDXC_BUF_ALIGNED, chunk_size, NULL);
-					manual_system_maintenance(true);
-
-					// Write file to disk.
-					f_write(&fp_dst, (void *)SDXC_BUF_ALIGNED, chunk_size, NULL);
-				}
-				f_close(&fp_src);
-
-				// Finalize copied file.
-				f_close(&fp_dst);
-				f_chdrive(dst);
-				f_chmod(path, fno.fattrib, 0xFF);
-
-				f_chdrive(src);
-			}
+			if (list)
+				_copy_list_add(list, false, path, fno.fsize, fno.fattrib);
 
 			// If total is > 1GB exit.
 			if (*total_size > (RAM_DISK_SZ - SZ_16M)) // 0x2400000.
@@ -196,25 +275,14 @@ static int _stat_and_copy_files(const char *src, const char *dst, char *path, u3
 			if (!memcmp("System Volume Information", fno.fname, 25))
 				continue;
 
-			// Create folder to destination.
-			if (dst)
-			{
-				f_chdrive(dst);
-				f_mkdir(path);
-				f_chmod(path, fno.fattrib, 0xFF);
-			}
+			// Folders are stored before their contents, so they can be created in order.
+			if (list)
+				_copy_list_add(list, true, path, 0, fno.fattrib);
 
 			// Enter the directory.
-			res = _stat_and_copy_files(src, dst, path, total_files, total_size, labels);
+			res = _stat_files(path, total_files, total_size, list, labels, timer);
 			if (res != FR_OK)
 				break;
-
-			if (labels)
-			{
-				// Clear folder path.
-				path[dirLength] = 0;
-				lv_label_set_text(labels[0], path);
-			}
 		}
 	}
 
@@ -224,6 +292,153 @@ out:
 	return res;
 }
 
+static int _copy_files(const char *src, const char *dst, copy_list_t *list, lv_obj_t **labels)
+{
+	FRESULT res = FR_OK;
+	FIL fp_src;
+	FIL fp_dst;
+	u8 *buf = (u8 *)SDXC_BUF_ALIGNED;
+	char *src_path = malloc(0x1000);
+	char *dst_path = malloc(0x1000);
+	u32 src_len = strlen(src);
+	u32 dst_len = strlen(dst);
+	u32 files_done = 0;
+	u32 size_done = 0;
+	u32 total_size = 0;
+	u32 timer = get_tmr_ms();
+
+	for (u32 i = 0; i < list->files_num; i++)
+		total_size += list->files[i].size;
+
+	// Paths are prefixed with the drive, so no drive switching is needed.
+	strcpy(src_path, src);
+	strcpy(dst_path, dst);
+
+	// Create all folders first. They are stored in parent first order.
+	for (u32 i = 0; i < list->dirs_num; i++)
+	{
+		copy_entry_t *dir = &list->dirs[i];
+		strcpy(&dst_path[dst_len], &list->paths[dir->path_off]);
+		f_mkdir(dst_path);
+		f_chmod(dst_path, dir->attrib, 0xFF);
+	}
+
+	// Copy smaller files first, so that they can be batched.
+	_copy_list_sort_by_size(list);
+
+	u32 idx = 0;
+	while (idx < list->files_num && list->files[idx].size <= COPY_SMALL_FILE_SZ)
+	{
+		// Read as many small files as they fit in the buffer.
+		u32 batch_start = idx;
+		u32 buf_off = 0;
+		while (idx < list->files_num && list->files[idx].size <= COPY_SMALL_FILE_SZ)
+		{
+			copy_entry_t *file = &list->files[idx];
+			if ((buf_off + file->size) > COPY_BUF_SZ)
+				break;
+
+			strcpy(&src_path[src_len], &list->paths[file->path_off]);
+			res = f_open(&fp_src, src_path, FA_READ);
+			if (res)
+				goto out;
+
+			res = f_read(&fp_src, &buf[buf_off], file->size, NULL);
+			f_close(&fp_src);
+			if (res)
+				goto out;
+
+			buf_off += ALIGN(file->size, 8);
+			idx++;
+		}
+
+		// Write out the whole batch.
+		buf_off = 0;
+		for (u32 i = batch_start; i < idx; i++)
+		{
+			copy_entry_t *file = &list->files[i];
+
+			strcpy(&dst_path[dst_len], &list->paths[file->path_off]);
+			res = f_open(&fp_dst, dst_path, FA_CREATE_ALWAYS | FA_WRITE);
+			if (res)
+				goto out;
+
+			res = f_write(&fp_dst, &buf[buf_off], file->size, NULL);
+			f_close(&fp_dst);
+			if (res)
+				goto out;
+
+			f_chmod(dst_path, file->attrib, 0xFF);
+
+			buf_off += ALIGN(file->size, 8);
+			size_done += file->size;
+			files_done++;
+
+			if (labels && _copy_progress_due(&timer))
+				_copy_progress_update(labels, dst_path, files_done, list->files_num, size_done, total_size);
+		}
+	}
+
+	// Copy large files in buffer sized chunks to pre-expanded destinations.
+	for (; idx < list->files_num; idx++)
+	{
+		copy_entry_t *file = &list->files[idx];
+		u32 file_size = file->size;
+
+		strcpy(&src_path[src_len], &list->paths[file->path_off]);
+		strcpy(&dst_path[dst_len], &list->paths[file->path_off]);
+
+		res = f_open(&fp_src, src_path, FA_READ);
+		if (res)
+			goto out;
+
+		res = f_open(&fp_dst, dst_path, FA_CREATE_ALWAYS | FA_WRITE);
+		if (res)
+		{
+			f_close(&fp_src);
+			goto out;
+		}
+
+		// Allocate the whole file once and map its clusters.
+		DWORD *clmt = f_expand_cltbl(&fp_dst, SZ_4M, file_size);
+
+		while (file_size)
+		{
+			u32 chunk_size = MIN(file_size, COPY_BUF_SZ);
+
+			res = f_read(&fp_src, buf, chunk_size, NULL);
+			if (!res)
+				res = f_write(&fp_dst, buf, chunk_size, NULL);
+			if (res)
+				break;
+
+			file_size -= chunk_size;
+			size_done += chunk_size;
+
+			if (labels && _copy_progress_due(&timer))
+				_copy_progress_update(labels, dst_path, files_done, list->files_num, size_done, total_size);
+		}
+
+		f_close(&fp_src);
+		f_close(&fp_dst);
+		free(clmt);
+		if (res)
+			goto out;
+
+		f_chmod(dst_path, file->attrib, 0xFF);
+		files_done++;
+	}
+
+	if (labels)
+		_copy_progress_update(labels, dst_path, files_done, list->files_num, size_done, total_size);
+
+out:
+	free(src_path);
+	free(dst_path);
+
+	return res;
+}
+
 static void _create_gpt_partition(gpt_t *gpt, u8 *gpt_idx, u32 *curr_part_lba, u32 size_lba, char *name, int name_size)
 {
 	const u8 linux_part_guid[] = { 0xAF, 0x3D, 0xC6, 0x0F,  0x83, 0x84,  0x72, 0x47,  0x8E, 0x79,  0x3D, 0x69, 0xD8, 0x47, 0x7D, 0xE4 };
@@ -953,7 +1168,8 @@ static lv_res_t _action_flash_android_data(lv_obj_t * btns, const char * txt)
 
 	lv_obj_t *lbl_status = lv_label_create(mbox, NULL);
 	lv_label_set_recolor(lbl_status, true);
-	lv_label_set_text(lbl_status, "#C7EA46 Status:# Searching for files and partitions...");
+	nyx_log_attach(lbl_status, 8);
+	nyx_log_set_text(lbl_status, "#C7EA46 Status:# Searching for files and partitions...");
 
 	lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
 	lv_obj_set_top(mbox, true);
@@ -968,7 +1184,7 @@ static lv_res_t _action_flash_android_data(lv_obj_t * btns, const char * txt)
 	// Validate GPT header.
 	if (memcmp(&gpt->header.signature, "EFI PART", 8) || gpt->header.num_part_ents > 128)
 	{
-		lv_label_set_text(lbl_status, "#FFDD00 Error:# No Android GPT was found!");
+		nyx_log_set_text(lbl_status, "#FFDD00 Error:# No Android GPT was found!");
 		goto error;
 	}
 
@@ -1028,14 +1244,14 @@ static lv_res_t _action_flash_android_data(lv_obj_t * btns, const char * txt)
 		s_printf(txt_buf, "#FF8000 Warning:# Kernel partition not found!\n");
 
 boot_img_not_found:
-	lv_label_set_text(lbl_status, txt_buf);
+	nyx_log_set_text(lbl_status, txt_buf);
 	manual_system_maintenance(true);
 
 	// Check if TWRP should be flashed.
 	strcpy(path, "switchroot/install/twrp.img");
 	if (f_stat(path, NULL))
 	{
-		strcat(txt_buf, "#FF8000 Warning:# TWRP image not found!\n");
+		s_printf(txt_buf, "#FF8000 Warning:# TWRP image not found!\n");
 		goto twrp_not_found;
 	}
 
@@ -1072,28 +1288,28 @@ boot_img_not_found:
 		}
 
 		if ((file_size >> 9) > size_sct)
-			strcat(txt_buf, "#FF8000 Warning:# TWRP image too big!\n");
+			s_printf(txt_buf, "#FF8000 Warning:# TWRP image too big!\n");
 		else
 		{
 			sdmmc_storage_write(&sd_storage, offset_sct, file_size >> 9, buf);
-			strcat(txt_buf, "#C7EA46 Success:# TWRP image flashed!\n");
+			s_printf(txt_buf, "#C7EA46 Success:# TWRP image flashed!\n");
 			f_unlink(path);
 		}
 
 		free(buf);
 	}
 	else
-		strcat(txt_buf, "#FF8000 Warning:# TWRP partition not found!\n");
+		s_printf(txt_buf, "#FF8000 Warning:# TWRP partition not found!\n");
 
 twrp_not_found:
-	lv_label_set_text(lbl_status, txt_buf);
+	nyx_log_append(lbl_status, txt_buf);
 	manual_system_maintenance(true);
 
 	// Check if Device Tree should be flashed.
 	strcpy(path, "switchroot/install/tegra210-icosa.dtb");
 	if (f_stat(path, NULL))
 	{
-		strcat(txt_buf, "#FF8000 Warning:# DTB image not found!");
+		s_printf(txt_buf, "#FF8000 Warning:# DTB image not found!");
 
 		goto dtb_not_found;
 	}
@@ -1131,21 +1347,21 @@ twrp_not_found:
 		}
 
 		if ((file_size >> 9) > size_sct)
-			strcat(txt_buf, "#FF8000 Warning:# DTB image too big!");
+			s_printf(txt_buf, "#FF8000 Warning:# DTB image too big!");
 		else
 		{
 			sdmmc_storage_write(&sd_storage, offset_sct, file_size >> 9, buf);
-			strcat(txt_buf, "#C7EA46 Success:# DTB image flashed!");
+			s_printf(txt_buf, "#C7EA46 Success:# DTB image flashed!");
 			f_unlink(path);
 		}
 
 		free(buf);
 	}
 	else
-		strcat(txt_buf, "#FF8000 Warning:# DTB partition not found!");
+		s_printf(txt_buf, "#FF8000 Warning:# DTB partition not found!");
 
 dtb_not_found:
-	lv_label_set_text(lbl_status, txt_buf);
+	nyx_log_append(lbl_status, txt_buf);
 
 	// Check if TWRP is flashed unconditionally.
 	for (u32 i = 0; i < gpt->header.num_part_ents; i++)
@@ -1168,8 +1384,7 @@ error:
 	if (boot_twrp)
 	{
 		// If a TWRP partition was found, ask user if rebooting into it is wanted.
-		strcat(txt_buf,"\n\nDo you want to reboot into TWRP\nto finish Android installation?");
-		lv_label_set_text(lbl_status, txt_buf);
+		nyx_log_append(lbl_status, "\n\nDo you want to reboot into TWRP\nto finish Android installation?");
 		lv_mbox_add_btns(mbox, mbox_btn_map2, _action_reboot_twrp);
 	}
 	else
@@ -1306,16 +1521,26 @@ static int _backup_and_restore_files(bool backup, lv_obj_t **labels)
 			f_mkdir("warmboot_mariko");
 	}
 
-	// Copy all or hekate/Nyx files.
-	res = _stat_and_copy_files(src_drv, dst_drv, path, &total_files, &total_size, labels);
+	// Collect all or hekate/Nyx files.
+	copy_list_t list = {0};
+	u32 timer = get_tmr_ms();
+	if (labels)
+		lv_label_set_text(labels[1], " ");
+	f_chdrive(src_drv);
+	res = _stat_files(path, &total_files, &total_size, &list, labels, &timer);
 
-	// If incomplete backup mode, copy MWS also.
+	// If incomplete backup mode, collect MWS also.
 	if (!res && backup_mws)
 	{
 		strcpy(path, "warmboot_mariko");
-		res = _stat_and_copy_files(src_drv, dst_drv, path, &total_files, &total_size, labels);
+		res = _stat_files(path, &total_files, &total_size, &list, labels, &timer);
 	}
 
+	// Copy everything in one pass.
+	if (!res)
+		res = _copy_files(src_drv, dst_drv, &list, labels);
+
+	_copy_list_free(&list);
 	free(path);
 
 	return res;
@@ -1951,7 +2176,8 @@ static void _create_mbox_check_files_total_size()
 	path[0] = 0;
 
 	// Check total size of files.
-	int res = _stat_and_copy_files("sd:", NULL, path, &total_files, &total_size, NULL);
+	f_chdrive("sd:");
+	int res = _stat_files(path, &total_files, &total_size, NULL, NULL, NULL);
 
 	// Not more than 1.0GB.
 	part_info.backup_possible = !res && !(total_size > (RAM_DISK_SZ - SZ_16M));
@@ -357,6 +357,10 @@ skip_main_cfg_parse:
 					n_cfg.jc_force_right = atoi(kv->val) == 1;
 				else if (!strcmp("bpmpclock", kv->key))
 					n_cfg.bpmp_clock = strtol(kv->val, NULL, 10);
+				else if (!strcmp("crc32sidecar", kv->key))
+					n_cfg.crc32_sidecar = atoi(kv->val) == 1;
+				else if (!strcmp("restorereadback", kv->key))
+					n_cfg.restore_readback = atoi(kv->val) == 1;
 			}
 
 			break;
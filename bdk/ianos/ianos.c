@@ -20,8 +20,10 @@
 #include "ianos.h"
 #include "elfload/elfload.h"
 #include <module.h>
+#include <libs/fatfs/ff.h>
 #include <mem/heap.h>
 #include <power/max7762x.h>
+#include <sec/se.h>
 #include <storage/sd.h>
 #include <utils/types.h>
 
@@ -30,6 +32,31 @@
 #define IRAM_LIB_ADDR 0x4002B000
 #define DRAM_LIB_ADDR 0xE0000000
 
+#define IANOS_PL_MAGIC   0x4C504149 // "IAPL".
+#define IANOS_PL_VERSION 2
+#define IANOS_PL_EXT     ".bsl"
+
+#define R_ARM_RELATIVE 23
+
+/*
+ * Pre-linked module image.
+ * Holds the loaded segments, already relocated for load_addr, and the offsets of
+ * all relative relocations so the image can be rebased if the load address changes.
+ */
+typedef struct _ianos_pl_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u32 elf_size;
+	u32 load_addr;
+	u32 entry;
+	u32 mem_size;
+	u32 img_size;
+	u32 rel_cnt;
+	u8  elf_hash[SE_SHA_256_SIZE]; // Module the image was made from.
+	u8  hash[SE_SHA_256_SIZE];     // Image and relocations.
+} ianos_pl_hdr_t;
+
 extern heap_t _heap;
 
 void *elfBuf = NULL;
@@ -68,18 +95,166 @@ static bool _ianos_read_cb(el_ctx *ctx, void *dest, size_t numberBytes, size_t o
 	return true;
 }
 
+static char *_ianos_pl_path(const char *path)
+{
+	u32 len = strlen(path);
+	char *ext = strrchr(path, '.');
+	if (ext && !strchr(ext, '/'))
+		len = ext - path;
+
+	char *pl_path = (char *)malloc(len + sizeof(IANOS_PL_EXT));
+	memcpy(pl_path, path, len);
+	strcpy(pl_path + len, IANOS_PL_EXT);
+
+	return pl_path;
+}
+
+static uintptr_t _ianos_pl_load(const char *pl_path, const u8 *elf_hash, u32 elf_size)
+{
+	u32 size = 0;
+	ianos_pl_hdr_t *hdr = (ianos_pl_hdr_t *)sd_file_read(pl_path, &size);
+	if (!hdr)
+		return 0;
+
+	u8 *img = (u8 *)hdr + sizeof(ianos_pl_hdr_t);
+	u32 *rels = (u32 *)(img + ALIGN(hdr->img_size, 4));
+
+	// Validate image against the module it was made from.
+	if (size < sizeof(ianos_pl_hdr_t) ||
+		hdr->magic != IANOS_PL_MAGIC || hdr->version != IANOS_PL_VERSION ||
+		hdr->elf_size != elf_size || memcmp(hdr->elf_hash, elf_hash, SE_SHA_256_SIZE) ||
+		hdr->img_size < sizeof(u32) || hdr->img_size > hdr->mem_size || hdr->entry >= hdr->mem_size || hdr->rel_cnt > (size >> 2) ||
+		size != sizeof(ianos_pl_hdr_t) + ALIGN(hdr->img_size, 4) + hdr->rel_cnt * sizeof(u32))
+		goto invalid;
+
+	u8 hash[SE_SHA_256_SIZE];
+	se_calc_sha256_oneshot(hash, img, size - sizeof(ianos_pl_hdr_t));
+	if (memcmp(hash, hdr->hash, SE_SHA_256_SIZE))
+		goto invalid;
+
+	elfBuf = malloc(hdr->mem_size);
+	if (!elfBuf)
+		goto out;
+
+	memcpy(elfBuf, img, hdr->img_size);
+	memset(elfBuf + hdr->img_size, 0, hdr->mem_size - hdr->img_size);
+
+	// Rebase if the library did not land at the same address.
+	u32 delta = (u32)elfBuf - hdr->load_addr;
+	if (delta)
+	{
+		for (u32 i = 0; i < hdr->rel_cnt; i++)
+		{
+			if ((rels[i] & 3) || rels[i] > hdr->img_size - sizeof(u32))
+			{
+				free(elfBuf);
+				elfBuf = NULL;
+				goto invalid;
+			}
+
+			*(u32 *)(elfBuf + rels[i]) += delta;
+		}
+	}
+
+	uintptr_t epaddr = (uintptr_t)elfBuf + hdr->entry;
+	free(hdr);
+
+	return epaddr;
+
+invalid:
+	f_unlink(pl_path);
+out:
+	free(hdr);
+
+	return 0;
+}
+
+static void _ianos_pl_save(const char *pl_path, el_ctx *ctx, const u8 *elf_hash, u32 elf_size)
+{
+	// Only position independent libraries have their relocations available.
+	if (ctx->ehdr.e_type != ET_DYN)
+		return;
+
+	// Get the size of file backed data. The rest is zeroed on load.
+	Elf_Phdr ph;
+	u32 img_size = 0;
+	for (unsigned i = 0;; i++)
+	{
+		if (el_findphdr(ctx, &ph, PT_LOAD, &i) || i == (unsigned)-1)
+			break;
+
+		if (ph.p_vaddr + ph.p_filesz > img_size)
+			img_size = ph.p_vaddr + ph.p_filesz;
+	}
+
+	el_relocinfo ri;
+	if (!img_size || img_size > ctx->memsz || el_findrelocs(ctx, &ri, DT_REL))
+		return;
+
+	// Relocation table is part of the loaded image.
+	u32 rel_cnt = 0;
+	u32 rel_tbl_cnt = ri.tablesize / sizeof(Elf_Rel);
+	Elf_Rel *reltab = (Elf_Rel *)(elfBuf + ri.tableoff);
+	for (u32 i = 0; i < rel_tbl_cnt; i++)
+		if (ELF_R_TYPE(reltab[i].r_info) == R_ARM_RELATIVE)
+			rel_cnt++;
+
+	u32 size = sizeof(ianos_pl_hdr_t) + ALIGN(img_size, 4) + rel_cnt * sizeof(u32);
+	ianos_pl_hdr_t *hdr = (ianos_pl_hdr_t *)calloc(size, 1);
+	u8 *img = (u8 *)hdr + sizeof(ianos_pl_hdr_t);
+	u32 *rels = (u32 *)(img + ALIGN(img_size, 4));
+
+	hdr->magic     = IANOS_PL_MAGIC;
+	hdr->version   = IANOS_PL_VERSION;
+	hdr->elf_size  = elf_size;
+	hdr->load_addr = (u32)elfBuf;
+	hdr->entry     = ctx->ehdr.e_entry;
+	hdr->mem_size  = ctx->memsz;
+	hdr->img_size  = img_size;
+	hdr->rel_cnt   = rel_cnt;
+	memcpy(hdr->elf_hash, elf_hash, SE_SHA_256_SIZE);
+
+	memcpy(img, elfBuf, img_size);
+	for (u32 i = 0; i < rel_tbl_cnt; i++)
+		if (ELF_R_TYPE(reltab[i].r_info) == R_ARM_RELATIVE)
+			*rels++ = reltab[i].r_offset;
+
+	se_calc_sha256_oneshot(hdr->hash, img, size - sizeof(ianos_pl_hdr_t));
+
+	sd_save_to_file(hdr, size, pl_path);
+
+	free(hdr);
+}
+
 //TODO: Support shared libraries.
 uintptr_t ianos_loader(char *path, elfType_t type, void *moduleConfig)
 {
 	el_ctx ctx;
 	uintptr_t epaddr = 0;
+	char *pl_path = NULL;
+	u8 elf_hash[SE_SHA_256_SIZE];
+	u32 elf_size = 0;
 
 	// Read library.
-	fileBuf = sd_file_read(path, NULL);
+	fileBuf = sd_file_read(path, &elf_size);
 
 	if (!fileBuf)
 		goto out;
 
+	// Use pre-linked image for relocatable DRAM libraries if it was made from this exact module.
+	// Reading the module is cheap. Parsing and relocating it is what the image saves.
+	if ((type & 0xFFFF) == DRAM_LIB)
+	{
+		se_calc_sha256_oneshot(elf_hash, fileBuf, elf_size);
+		pl_path = _ianos_pl_path(path);
+		epaddr = _ianos_pl_load(pl_path, elf_hash, elf_size);
+		if (epaddr)
+		{
+			_ianos_call_ep((moduleEntrypoint_t)epaddr, moduleConfig);
+			goto out_free;
+		}
+	}
+
 	ctx.pread = _ianos_read_cb;
 
 	if (el_init(&ctx))
@@ -107,6 +282,10 @@ uintptr_t ianos_loader(char *path, elfType_t type, void *moduleConfig)
 	if (el_relocate(&ctx))
 		goto out_free;
 
+	// Save pre-linked image before the library touches its data.
+	if (pl_path)
+		_ianos_pl_save(pl_path, &ctx, elf_hash, elf_size);
+
 	// Launch.
 	epaddr = ctx.ehdr.e_entry + (uintptr_t)elfBuf;
 	moduleEntrypoint_t ep = (moduleEntrypoint_t)epaddr;
@@ -119,5 +298,7 @@ out_free:
 	fileBuf = NULL;
 
 out:
+	free(pl_path);
+
 	return epaddr;
 }
\ No newline at end of file
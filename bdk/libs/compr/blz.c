@@ -32,6 +32,13 @@ const blz_footer *blz_get_footer(const unsigned char *compData, unsigned int com
 	return srcFooter;
 }
 
+static inline void _blz_copy_match(u8 *dst, const u8 *src, u32 size)
+{
+	// Bytewise and forward. Matches are short and mostly not mutually aligned, so word copies do not pay off.
+	while (size--)
+		*dst++ = *src++;
+}
+
 // From https://github.com/SciresM/hactool/blob/master/kip.c which is exactly how kernel does it, thanks SciresM!
 int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const blz_footer *footer)
 {
@@ -39,12 +46,60 @@ int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const
 	u32 header_size = footer->header_size;
 	u32 cmp_and_hdr_size = footer->cmp_and_hdr_size;
 
+	// Validate footer.
+	if (cmp_and_hdr_size > compSize || header_size > cmp_and_hdr_size)
+		return 0;
+
 	unsigned char* cmp_start = &dataBuf[compSize] - cmp_and_hdr_size;
 	u32 cmp_ofs = cmp_and_hdr_size - header_size;
-	u32 out_ofs = cmp_and_hdr_size + addl_size;
+	u32 out_size = cmp_and_hdr_size + addl_size;
+	u32 out_ofs = out_size;
 
 	while (out_ofs)
 	{
+		// Fast path. A control block needs at most 17 input bytes and produces at most 8 * 18 bytes.
+		if (cmp_ofs > (1 + 8 * 2) && out_ofs > (8 * 18))
+		{
+			unsigned char control = cmp_start[--cmp_ofs];
+
+			// Literal run.
+			if (!control)
+			{
+				cmp_ofs -= 8;
+				out_ofs -= 8;
+				for (int j = 7; j >= 0; j--)
+					cmp_start[out_ofs + j] = cmp_start[cmp_ofs + j];
+
+				continue;
+			}
+
+			for (unsigned int i = 0; i < 8; i++)
+			{
+				if (control & 0x80)
+				{
+					cmp_ofs -= 2;
+					u16 seg_val = ((unsigned int)(cmp_start[cmp_ofs + 1]) << 8) | cmp_start[cmp_ofs];
+					u32 seg_size = ((seg_val >> 12) & 0xF) + 3;
+					u32 seg_ofs = (seg_val & 0x0FFF) + 3;
+
+					out_ofs -= seg_size;
+					if ((out_ofs + seg_ofs + seg_size) > out_size)
+						return 0; // Out of bounds.
+
+					_blz_copy_match(&cmp_start[out_ofs], &cmp_start[out_ofs + seg_ofs], seg_size);
+				}
+				else
+					cmp_start[--out_ofs] = cmp_start[--cmp_ofs];
+
+				control <<= 1;
+			}
+
+			continue;
+		}
+
+		if (cmp_ofs < 1)
+			return 0; // Out of bounds.
+
 		unsigned char control = cmp_start[--cmp_ofs];
 		for (unsigned int i=0; i<8; i++)
 		{
@@ -62,8 +117,10 @@ int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const
 
 				out_ofs -= seg_size;
 
-				for (unsigned int j = 0; j < seg_size; j++)
-					cmp_start[out_ofs + j] = cmp_start[out_ofs + j + seg_ofs];
+				if ((out_ofs + seg_ofs + seg_size) > out_size)
+					return 0; // Out of bounds.
+
+				_blz_copy_match(&cmp_start[out_ofs], &cmp_start[out_ofs + seg_ofs], seg_size);
 			}
 			else
 			{
@@ -76,8 +133,8 @@ int blz_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const
 			control <<= 1;
 			if (out_ofs == 0) // Blz works backwards, so if it reaches byte 0, it's done.
 				return 1;
-			}
 		}
+	}
 
 	return 1;
 }
@@ -89,7 +146,13 @@ int blz_uncompress_srcdest(const unsigned char *compData, unsigned int compDataL
 	if (compFooterPtr == NULL)
 		return 0;
 
+	// Check that decompressed data fits.
+	unsigned int outSize = compDataLen + footer.addl_size;
+	if (outSize > dstSize || outSize < compDataLen)
+		return 0;
+
 	// Decompression must be done in-place, so need to copy the relevant compressed data first.
+	// The rest must be cleared, because matches can read output bytes that are not decoded yet.
 	unsigned int numCompBytes = (const unsigned char*)(compFooterPtr)-compData;
 	memcpy(dstData, compData, numCompBytes);
 	memset(&dstData[numCompBytes], 0, dstSize - numCompBytes);
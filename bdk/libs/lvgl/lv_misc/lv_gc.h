@@ -23,13 +23,14 @@ extern "C" {
 #include <stdint.h>
 #include "lv_mem.h"
 #include "lv_ll.h"
+#include "lv_task.h"
 
 /*********************
  *      DEFINES
  *********************/
 
 #define LV_GC_ROOTS(prefix) \
-    prefix lv_ll_t _lv_task_ll;      /*Linked list to store the lv_tasks*/ \
+    prefix lv_ll_t _lv_task_ll[LV_TASK_PRIO_NUM]; /*Linked lists to store the lv_tasks of each priority*/ \
     prefix lv_ll_t _lv_scr_ll;          /*Linked list of screens*/ \
     prefix lv_ll_t _lv_drv_ll;\
     prefix lv_ll_t _lv_file_ll;\
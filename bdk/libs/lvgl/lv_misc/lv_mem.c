@@ -38,6 +38,12 @@
  *********************/
 #define LV_MEM_ADD_JUNK     0   /*Add memory junk on alloc (0xaa) and free(0xbb) (just for testing purposes)*/
 
+/* Free entries are kept in segregated lists by their size.
+ * The first bins hold a single size each (32 to 256 bytes),
+ * the rest hold the power of 2 ranges above them (bin = msb of size).*/
+#define LV_MEM_BIN_EXACT    8
+#define LV_MEM_BIN_NUM      32
+
 
 #ifdef LV_MEM_ENV64
 # define MEM_UNIT uint64_t
@@ -52,11 +58,16 @@
 
 #if LV_ENABLE_GC == 0 /*gc custom allocations must not include header*/
 
+struct _lv_mem_ent_t;
+
 /*The size of this union must be 32 bytes (uint32_t * 8)*/
 typedef union {
     struct {
         MEM_UNIT used: 1;       //1: if the entry is used
         MEM_UNIT d_size: 31;    //Size of the data
+        MEM_UNIT prev_size;     //Size of the data of the previous entry in memory. 0 for the first entry
+        struct _lv_mem_ent_t * next_free; //Links of the free list of the bin. Only valid for free entries
+        struct _lv_mem_ent_t * prev_free;
     };
     MEM_UNIT header;            //The header (used + d_size)
     MEM_UNIT align[8];          //Align header size to MEM_UNIT * 8 bytes
@@ -64,7 +75,7 @@ typedef union {
 
 static_assert(sizeof(lv_mem_header_t) == 32, "Node header must be 32 bytes!");
 
-typedef struct {
+typedef struct _lv_mem_ent_t {
     lv_mem_header_t header;
     uint8_t first_data;        /*First data byte in the allocated data (Just for easily create a pointer)*/
 } lv_mem_ent_t;
@@ -76,8 +87,14 @@ typedef struct {
  **********************/
 #if LV_MEM_CUSTOM == 0
 static lv_mem_ent_t  * ent_get_next(lv_mem_ent_t * act_e);
+static lv_mem_ent_t  * ent_get_prev(lv_mem_ent_t * act_e);
+static lv_mem_ent_t  * ent_find(uint32_t size);
 static void * ent_alloc(lv_mem_ent_t * e, uint32_t size);
 static void ent_trunc(lv_mem_ent_t * e, uint32_t size);
+static void ent_release(lv_mem_ent_t * e);
+static uint32_t ent_bin(uint32_t size);
+static void ent_list_ins(lv_mem_ent_t * e);
+static void ent_list_rem(lv_mem_ent_t * e);
 #endif
 
 /**********************
@@ -85,6 +102,11 @@ static void ent_trunc(lv_mem_ent_t * e, uint32_t size);
  **********************/
 #if LV_MEM_CUSTOM == 0
 static uint8_t * work_mem;
+static lv_mem_ent_t * free_bins[LV_MEM_BIN_NUM];
+static uint32_t free_bin_map;   /*A bit is set for every non-empty bin*/
+static uint32_t free_cnt;
+static uint32_t free_size;
+static uint32_t used_cnt;
 #endif
 
 static uint32_t zero_mem;       /*Give the address of this variable if 0 byte should be allocated*/
@@ -112,10 +134,18 @@ void lv_mem_init(void)
     work_mem = (uint8_t *) LV_MEM_ADR;
 #endif
 
+    memset(free_bins, 0, sizeof(free_bins));
+    free_bin_map = 0;
+    free_cnt = 0;
+    free_size = 0;
+    used_cnt = 0;
+
     lv_mem_ent_t * full = (lv_mem_ent_t *)work_mem;
     full->header.used = 0;
     /*The total mem size id reduced by the first header and the close patterns */
     full->header.d_size = LV_MEM_SIZE - sizeof(lv_mem_header_t);
+    full->header.prev_size = 0;
+    ent_list_ins(full);
 #endif
 }
 
@@ -139,19 +169,8 @@ void * lv_mem_alloc(uint32_t size)
     void * alloc = NULL;
 
 #if LV_MEM_CUSTOM == 0 /*Use the allocation from dyn_mem*/
-    lv_mem_ent_t * e = NULL;
-
-    //Search for a appropriate entry
-    do {
-        //Get the next entry
-        e = ent_get_next(e);
-
-        /*If there is next entry then try to allocate there*/
-        if(e != NULL) {
-            alloc = ent_alloc(e, size);
-        }
-        //End if there is not next entry OR the alloc. is successful
-    } while(e != NULL && alloc == NULL);
+    lv_mem_ent_t * e = ent_find(size);
+    if(e != NULL) alloc = ent_alloc(e, size);
 
 
 #else  /*Use custom, user defined malloc function*/
@@ -198,20 +217,9 @@ void lv_mem_free(const void * data)
 #endif
 
 #if LV_MEM_CUSTOM == 0
-#if LV_MEM_AUTO_DEFRAG
-    /* Make a simple defrag.
-     * Join the following free entries after this*/
-    lv_mem_ent_t * e_next;
-    e_next = ent_get_next(e);
-    while(e_next != NULL) {
-        if(e_next->header.used == 0) {
-            e->header.d_size += e_next->header.d_size + sizeof(e->header);
-        } else {
-            break;
-        }
-        e_next = ent_get_next(e_next);
-    }
-#endif
+    /*Join it with the free neighbours and put it back to a free list*/
+    used_cnt--;
+    ent_release(e);
 #else /*Use custom, user defined free function*/
 #if LV_ENABLE_GC==0
     LV_MEM_CUSTOM_FREE(e);
@@ -233,11 +241,8 @@ void lv_mem_free(const void * data)
 
 void * lv_mem_realloc(void * data_p, uint32_t new_size)
 {
-    /*Round the size to lv_mem_header_t*/
-    if(new_size & (sizeof(lv_mem_header_t) - 1)) {
-        new_size = new_size & (~(sizeof(lv_mem_header_t) - 1));
-        new_size += sizeof(lv_mem_header_t);
-    }
+    /*A 0 byte memory has no entry*/
+    if(data_p == &zero_mem) data_p = NULL;
 
     /*data_p could be previously freed pointer (in this case it is invalid)*/
     if(data_p != NULL) {
@@ -247,6 +252,18 @@ void * lv_mem_realloc(void * data_p, uint32_t new_size)
         }
     }
 
+    /*Entries can't be truncated to 0 bytes. Free it and give a 0 byte memory like 'lv_mem_alloc'*/
+    if(new_size == 0) {
+        lv_mem_free(data_p);
+        return &zero_mem;
+    }
+
+    /*Round the size to lv_mem_header_t*/
+    if(new_size & (sizeof(lv_mem_header_t) - 1)) {
+        new_size = new_size & (~(sizeof(lv_mem_header_t) - 1));
+        new_size += sizeof(lv_mem_header_t);
+    }
+
     uint32_t old_size = lv_mem_get_size(data_p);
     if(old_size == new_size) return data_p;     /*Also avoid reallocating the same memory*/
 
@@ -258,6 +275,23 @@ void * lv_mem_realloc(void * data_p, uint32_t new_size)
         ent_trunc(e, new_size);
         return &e->first_data;
     }
+
+    /*Grow in place if the next entry is free and big enough*/
+    if(data_p != NULL) {
+        lv_mem_ent_t * e = (lv_mem_ent_t *)((uint8_t *) data_p - sizeof(lv_mem_header_t));
+        lv_mem_ent_t * e_next = ent_get_next(e);
+        if(e_next != NULL && e_next->header.used == 0 &&
+           old_size + sizeof(lv_mem_header_t) + e_next->header.d_size >= new_size) {
+            ent_list_rem(e_next);
+            e->header.d_size += sizeof(lv_mem_header_t) + e_next->header.d_size;
+
+            e_next = ent_get_next(e);
+            if(e_next != NULL) e_next->header.prev_size = e->header.d_size;
+
+            ent_trunc(e, new_size);
+            return data_p;
+        }
+    }
 #endif
 
     void * new_p;
@@ -293,41 +327,7 @@ void * lv_mem_realloc(void * data_p, uint32_t new_size)
  */
 void lv_mem_defrag(void)
 {
-#if LV_MEM_CUSTOM == 0
-    lv_mem_ent_t * e_free;
-    lv_mem_ent_t * e_next;
-    e_free = ent_get_next(NULL);
-
-    while(1) {
-        /*Search the next free entry*/
-        while(e_free != NULL) {
-            if(e_free->header.used != 0) {
-                e_free = ent_get_next(e_free);
-            } else {
-                break;
-            }
-        }
-
-        if(e_free == NULL) return;
-
-        /*Joint the following free entries to the free*/
-        e_next = ent_get_next(e_free);
-        while(e_next != NULL) {
-            if(e_next->header.used == 0) {
-                e_free->header.d_size += e_next->header.d_size + sizeof(e_next->header);
-            } else {
-                break;
-            }
-
-            e_next = ent_get_next(e_next);
-        }
-
-        if(e_next == NULL) return;
-
-        /*Continue from the lastly checked entry*/
-        e_free = e_next;
-    }
-#endif
+    /*Nothing to do. Free entries are always joined with their free neighbours on free*/
 }
 
 /**
@@ -340,28 +340,27 @@ void lv_mem_monitor(lv_mem_monitor_t * mon_p)
     /*Init the data*/
     memset(mon_p, 0, sizeof(lv_mem_monitor_t));
 #if LV_MEM_CUSTOM == 0
-    lv_mem_ent_t * e;
-    e = NULL;
-
-    e = ent_get_next(e);
-
-    while(e != NULL)  {
-        if(e->header.used == 0) {
-            mon_p->free_cnt++;
-            mon_p->free_size += e->header.d_size;
+    mon_p->free_cnt = free_cnt;
+    mon_p->free_size = free_size;
+    mon_p->used_cnt = used_cnt;
+
+    /*The biggest free entry is in the highest non-empty bin*/
+    if(free_bin_map) {
+        lv_mem_ent_t * e = free_bins[31 - __builtin_clz(free_bin_map)];
+        while(e != NULL) {
             if(e->header.d_size > mon_p->free_biggest_size) {
                 mon_p->free_biggest_size = e->header.d_size;
             }
-        } else {
-            mon_p->used_cnt++;
+            e = e->header.next_free;
         }
-
-        e = ent_get_next(e);
     }
+
     mon_p->total_size = LV_MEM_SIZE;
     mon_p->used_pct = 100 - ((uint64_t)100U * mon_p->free_size) / mon_p->total_size;
-    mon_p->frag_pct = (uint32_t)mon_p->free_biggest_size * 100U / mon_p->free_size;
-    mon_p->frag_pct = 100 - mon_p->frag_pct;
+    if(mon_p->free_size) {
+        mon_p->frag_pct = ((uint64_t)100U * mon_p->free_biggest_size) / mon_p->free_size;
+        mon_p->frag_pct = 100 - mon_p->frag_pct;
+    }
 #endif
 }
 
@@ -420,31 +419,64 @@ static lv_mem_ent_t * ent_get_next(lv_mem_ent_t * act_e)
 
 
 /**
- * Try to do the real allocation with a given size
- * @param e try to allocate to this entry
- * @param size size of the new memory in bytes
- * @return pointer to the allocated memory or NULL if not enough memory in the entry
+ * Give the previous entry before 'act_e'
+ * @param act_e pointer to an entry
+ * @return pointer to an entry before 'act_e' or NULL if it's the first
  */
-static void * ent_alloc(lv_mem_ent_t * e, uint32_t size)
+static lv_mem_ent_t * ent_get_prev(lv_mem_ent_t * act_e)
 {
-    void * alloc = NULL;
+    if(act_e->header.prev_size == 0) return NULL;
 
-    /*If the memory is free and big enough then use it */
-    if(e->header.used == 0 && e->header.d_size >= size) {
-        /*Truncate the entry to the desired size */
-        ent_trunc(e, size),
-
-                  e->header.used = 1;
+    return (lv_mem_ent_t *)((uint8_t *)act_e - act_e->header.prev_size - sizeof(lv_mem_header_t));
+}
 
-        /*Save the allocated data*/
-        alloc = &e->first_data;
+/**
+ * Find a free entry which can hold the given size
+ * @param size size of the new memory in bytes (rounded to header size)
+ * @return pointer to a free entry or NULL if there is no such entry
+ */
+static lv_mem_ent_t * ent_find(uint32_t size)
+{
+    uint32_t bin = ent_bin(size);
+
+    /*The entries of a range bin might be smaller. Take the first fit from it.*/
+    if(bin >= LV_MEM_BIN_EXACT) {
+        lv_mem_ent_t * e = free_bins[bin];
+        while(e != NULL) {
+            if(e->header.d_size >= size) return e;
+            e = e->header.next_free;
+        }
+        bin++;
     }
 
-    return alloc;
+    /*Any entry of the next non-empty bin is big enough*/
+    uint32_t map = bin < LV_MEM_BIN_NUM ? free_bin_map & (0xFFFFFFFF << bin) : 0;
+    if(map == 0) return NULL;
+
+    return free_bins[__builtin_ctz(map)];
+}
+
+/**
+ * Do the real allocation with a given size
+ * @param e a free entry, big enough for size
+ * @param size size of the new memory in bytes
+ * @return pointer to the allocated memory
+ */
+static void * ent_alloc(lv_mem_ent_t * e, uint32_t size)
+{
+    ent_list_rem(e);
+    e->header.used = 1;
+    used_cnt++;
+
+    /*Truncate the entry to the desired size */
+    ent_trunc(e, size);
+
+    /*Save the allocated data*/
+    return &e->first_data;
 }
 
 /**
- * Truncate the data of entry to the given size
+ * Truncate the data of a used entry to the given size
  * @param e Pointer to an entry
  * @param size new size in bytes
  */
@@ -461,10 +493,85 @@ static void ent_trunc(lv_mem_ent_t * e, uint32_t size)
         lv_mem_ent_t * after_new_e = (lv_mem_ent_t *)&e_data[size];
         after_new_e->header.used = 0;
         after_new_e->header.d_size = e->header.d_size - size - sizeof(lv_mem_header_t);
+        after_new_e->header.prev_size = size;
+
+        /* Set the new size for the original entry */
+        e->header.d_size = size;
+
+        ent_release(after_new_e);
+    }
+}
+
+/**
+ * Join a free entry with its free neighbours and add the result to its free list
+ * @param e Pointer to an entry which is not in a free list
+ */
+static void ent_release(lv_mem_ent_t * e)
+{
+    lv_mem_ent_t * e_next = ent_get_next(e);
+    if(e_next != NULL && e_next->header.used == 0) {
+        ent_list_rem(e_next);
+        e->header.d_size += sizeof(lv_mem_header_t) + e_next->header.d_size;
     }
 
-    /* Set the new size for the original entry */
-    e->header.d_size = size;
+    lv_mem_ent_t * e_prev = ent_get_prev(e);
+    if(e_prev != NULL && e_prev->header.used == 0) {
+        ent_list_rem(e_prev);
+        e_prev->header.d_size += sizeof(lv_mem_header_t) + e->header.d_size;
+        e = e_prev;
+    }
+
+    e_next = ent_get_next(e);
+    if(e_next != NULL) e_next->header.prev_size = e->header.d_size;
+
+    ent_list_ins(e);
+}
+
+/**
+ * Give the free list bin of a size
+ * @param size size in bytes (rounded to header size)
+ * @return index of the bin
+ */
+static uint32_t ent_bin(uint32_t size)
+{
+    if(size <= LV_MEM_BIN_EXACT * sizeof(lv_mem_header_t)) return size / sizeof(lv_mem_header_t) - 1;
+
+    return 31 - __builtin_clz(size);
+}
+
+/**
+ * Add a free entry to the head of its free list
+ * @param e Pointer to an entry
+ */
+static void ent_list_ins(lv_mem_ent_t * e)
+{
+    uint32_t bin = ent_bin(e->header.d_size);
+
+    e->header.prev_free = NULL;
+    e->header.next_free = free_bins[bin];
+    if(free_bins[bin] != NULL) free_bins[bin]->header.prev_free = e;
+    free_bins[bin] = e;
+    free_bin_map |= 1u << bin;
+
+    free_cnt++;
+    free_size += e->header.d_size;
+}
+
+/**
+ * Remove a free entry from its free list
+ * @param e Pointer to an entry
+ */
+static void ent_list_rem(lv_mem_ent_t * e)
+{
+    uint32_t bin = ent_bin(e->header.d_size);
+
+    if(e->header.prev_free != NULL) e->header.prev_free->header.next_free = e->header.next_free;
+    else free_bins[bin] = e->header.next_free;
+    if(e->header.next_free != NULL) e->header.next_free->header.prev_free = e->header.prev_free;
+    if(free_bins[bin] == NULL) free_bin_map &= ~(1u << bin);
+
+    free_cnt--;
+    free_size -= e->header.d_size;
 }
 
 #endif
@@ -28,7 +28,9 @@
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-static bool lv_task_exec(lv_task_t * lv_task_p);
+static void lv_task_exec(lv_task_t * lv_task_p);
+static void lv_task_sort(lv_task_t * lv_task_p);
+static uint32_t lv_task_time_remaining(const lv_task_t * lv_task_p);
 
 /**********************
  *  STATIC VARIABLES
@@ -36,11 +38,13 @@ static bool lv_task_exec(lv_task_t * lv_task_p);
 static bool lv_task_run = false;
 static uint8_t idle_last = 0;
 static bool task_deleted;
-static bool task_created;
+static uint32_t task_pass;
+static lv_task_t * task_next;
 
 /**********************
  *      MACROS
  **********************/
+#define LV_TASK_LL(prio) (&LV_GC_ROOT(_lv_task_ll)[prio])
 
 /**********************
  *   GLOBAL FUNCTIONS
@@ -51,7 +55,9 @@ static bool task_created;
  */
 void lv_task_init(void)
 {
-    lv_ll_init(&LV_GC_ROOT(_lv_task_ll), sizeof(lv_task_t));
+    for(uint32_t prio = 0; prio < LV_TASK_PRIO_NUM; prio++) {
+        lv_ll_init(LV_TASK_LL(prio), sizeof(lv_task_t));
+    }
 
     /*Initially enable the lv_task handling*/
     lv_task_enable(true);
@@ -67,7 +73,6 @@ LV_ATTRIBUTE_TASK_HANDLER void lv_task_handler(void)
     /*Avoid concurrent running of the task handler*/
     static bool task_handler_mutex = false;
     if(task_handler_mutex) return;
-    task_handler_mutex = true;
 
     static uint32_t idle_period_start = 0;
     static uint32_t handler_start = 0;
@@ -75,66 +80,31 @@ LV_ATTRIBUTE_TASK_HANDLER void lv_task_handler(void)
 
     if(lv_task_run == false) return;
 
+    task_handler_mutex = true;
+
     handler_start = lv_tick_get();
 
-    /* Run all task from the highest to the lowest priority
-     * If a lower priority task is executed check task again from the highest priority
-     * but on the priority of executed tasks don't run tasks before the executed*/
-    lv_task_t * task_interrupter = NULL;
-    lv_task_t * next;
-    bool end_flag;
-    do {
-        end_flag = true;
-        task_deleted = false;
-        task_created = false;
-        LV_GC_ROOT(_lv_task_act) = lv_ll_get_head(&LV_GC_ROOT(_lv_task_ll));
-        while(LV_GC_ROOT(_lv_task_act)) {
-            /* The task might be deleted if it runs only once ('once = 1')
-             * So get next element until the current is surely valid*/
-            next = lv_ll_get_next(&LV_GC_ROOT(_lv_task_ll), LV_GC_ROOT(_lv_task_act));
-
-            /*We reach priority of the turned off task. There is nothing more to do.*/
-            if(((lv_task_t *)LV_GC_ROOT(_lv_task_act))->prio == LV_TASK_PRIO_OFF) {
-                break;
-            }
+    /* Run the due tasks from the highest to the lowest priority, each at most once per pass.
+     * Every priority list is sorted by due time, so the first task which is not due ends that list.
+     * Tasks created or already executed in this pass carry the pass number and are skipped.
+     * 'task_next' is advanced by lv_task_del and friends if they touch it, so the walk never restarts*/
+    task_pass++;
+    for(int32_t prio = LV_TASK_PRIO_HIGHEST; prio > LV_TASK_PRIO_OFF; prio--) {
+        lv_task_t * task = lv_ll_get_head(LV_TASK_LL(prio));
+        while(task) {
+            task_next = lv_ll_get_next(LV_TASK_LL(prio), task);
 
-            /*Here is the interrupter task. Don't execute it again.*/
-            if(LV_GC_ROOT(_lv_task_act) == task_interrupter) {
-                task_interrupter = NULL;     /*From this point only task after the interrupter comes, so the interrupter is not interesting anymore*/
-                LV_GC_ROOT(_lv_task_act) = next;
-                continue;                   /*Load the next task*/
-            }
+            if(task->pass != task_pass) {
+                if(lv_task_time_remaining(task)) break;
 
-            /*Just try to run the tasks with highest priority.*/
-            if(((lv_task_t *)LV_GC_ROOT(_lv_task_act))->prio == LV_TASK_PRIO_HIGHEST) {
-                lv_task_exec(LV_GC_ROOT(_lv_task_act));
-            }
-            /*Tasks with higher priority then the interrupted shall be run in every case*/
-            else if(task_interrupter) {
-                if(((lv_task_t *)LV_GC_ROOT(_lv_task_act))->prio > task_interrupter->prio) {
-                    if(lv_task_exec(LV_GC_ROOT(_lv_task_act))) {
-                        task_interrupter = LV_GC_ROOT(_lv_task_act);  /*Check all tasks again from the highest priority */
-                        end_flag = false;
-                        break;
-                    }
-                }
+                lv_task_exec(task);
             }
-            /* It is no interrupter task or we already reached it earlier.
-             * Just run the remaining tasks*/
-            else {
-                if(lv_task_exec(LV_GC_ROOT(_lv_task_act))) {
-                    task_interrupter = LV_GC_ROOT(_lv_task_act);  /*Check all tasks again from the highest priority */
-                    end_flag = false;
-                    break;
-                }
-            }
-
-            if(task_deleted) break;     /*If a task was deleted then this or the next item might be corrupted*/
-            if(task_created) break;     /*If a task was deleted then this or the next item might be corrupted*/
 
-            LV_GC_ROOT(_lv_task_act) = next;         /*Load the next task*/
+            task = task_next;
         }
-    } while(!end_flag);
+    }
+    task_next = NULL;
+    LV_GC_ROOT(_lv_task_act) = NULL;
 
     busy_time += lv_tick_elaps(handler_start);
     uint32_t idle_period_time = lv_tick_elaps(idle_period_start);
@@ -163,32 +133,9 @@ LV_ATTRIBUTE_TASK_HANDLER void lv_task_handler(void)
  */
 lv_task_t * lv_task_create(void (*task)(void *), uint32_t period, lv_task_prio_t prio, void * param)
 {
-    lv_task_t * new_lv_task = NULL;
-    lv_task_t * tmp;
-
-    /*Create task lists in order of priority from high to low*/
-    tmp = lv_ll_get_head(&LV_GC_ROOT(_lv_task_ll));
-    if(NULL == tmp) {                               /*First task*/
-        new_lv_task = lv_ll_ins_head(&LV_GC_ROOT(_lv_task_ll));
-        lv_mem_assert(new_lv_task);
-        if(new_lv_task == NULL) return NULL;
-    } else {
-        do {
-            if(tmp->prio <= prio) {
-                new_lv_task = lv_ll_ins_prev(&LV_GC_ROOT(_lv_task_ll), tmp);
-                lv_mem_assert(new_lv_task);
-                if(new_lv_task == NULL) return NULL;
-                break;
-            }
-            tmp = lv_ll_get_next(&LV_GC_ROOT(_lv_task_ll), tmp);
-        } while(tmp != NULL);
-
-        if(tmp == NULL) {   /*Only too high priority tasks were found*/
-            new_lv_task = lv_ll_ins_tail(&LV_GC_ROOT(_lv_task_ll));
-            lv_mem_assert(new_lv_task);
-            if(new_lv_task == NULL) return NULL;
-        }
-    }
+    lv_task_t * new_lv_task = lv_ll_ins_tail(LV_TASK_LL(prio));
+    lv_mem_assert(new_lv_task);
+    if(new_lv_task == NULL) return NULL;
 
     new_lv_task->period = period;
     new_lv_task->task = task;
@@ -196,8 +143,9 @@ lv_task_t * lv_task_create(void (*task)(void *), uint32_t period, lv_task_prio_t
     new_lv_task->param = param;
     new_lv_task->once = 0;
     new_lv_task->last_run = lv_tick_get();
+    new_lv_task->pass = task_pass;      /*Don't run it in the current pass*/
 
-    task_created = true;
+    lv_task_sort(new_lv_task);
 
     return new_lv_task;
 }
@@ -208,7 +156,11 @@ lv_task_t * lv_task_create(void (*task)(void *), uint32_t period, lv_task_prio_t
  */
 void lv_task_del(lv_task_t * lv_task_p)
 {
-    lv_ll_rem(&LV_GC_ROOT(_lv_task_ll), lv_task_p);
+    lv_ll_t * ll = LV_TASK_LL(lv_task_p->prio);
+
+    if(task_next == lv_task_p) task_next = lv_ll_get_next(ll, lv_task_p);
+
+    lv_ll_rem(ll, lv_task_p);
 
     lv_mem_free(lv_task_p);
 
@@ -222,22 +174,16 @@ void lv_task_del(lv_task_t * lv_task_p)
  */
 void lv_task_set_prio(lv_task_t * lv_task_p, lv_task_prio_t prio)
 {
-    /*Find the tasks with new priority*/
-    lv_task_t * i;
-    LL_READ(LV_GC_ROOT(_lv_task_ll), i) {
-        if(i->prio <= prio) {
-            if(i != lv_task_p) lv_ll_move_before(&LV_GC_ROOT(_lv_task_ll), lv_task_p, i);
-            break;
-        }
-    }
+    if(lv_task_p->prio == prio) return;
 
-    /*There was no such a low priority so far then add the node to the tail*/
-    if(i == NULL) {
-        lv_ll_move_before(&LV_GC_ROOT(_lv_task_ll), lv_task_p, NULL);
-    }
+    lv_ll_t * ll = LV_TASK_LL(lv_task_p->prio);
 
+    if(task_next == lv_task_p) task_next = lv_ll_get_next(ll, lv_task_p);
 
+    lv_ll_chg_list(ll, LV_TASK_LL(prio), lv_task_p);
     lv_task_p->prio = prio;
+
+    lv_task_sort(lv_task_p);
 }
 
 /**
@@ -248,6 +194,7 @@ void lv_task_set_prio(lv_task_t * lv_task_p, lv_task_prio_t prio)
 void lv_task_set_period(lv_task_t * lv_task_p, uint32_t period)
 {
     lv_task_p->period = period;
+    lv_task_sort(lv_task_p);
 }
 
 /**
@@ -257,6 +204,7 @@ void lv_task_set_period(lv_task_t * lv_task_p, uint32_t period)
 void lv_task_ready(lv_task_t * lv_task_p)
 {
     lv_task_p->last_run = lv_tick_get() - lv_task_p->period - 1;
+    lv_task_sort(lv_task_p);
 }
 
 /**
@@ -276,6 +224,7 @@ void lv_task_once(lv_task_t * lv_task_p)
 void lv_task_reset(lv_task_t * lv_task_p)
 {
     lv_task_p->last_run = lv_tick_get();
+    lv_task_sort(lv_task_p);
 }
 
 /**
@@ -296,37 +245,84 @@ uint8_t lv_task_get_idle(void)
     return idle_last;
 }
 
+/**
+ * Get the time until the next lv_task is due
+ * @return time in ms until the earliest enabled task has to run. 0 if one is already due.
+ */
+uint32_t lv_task_time_till_next(void)
+{
+    uint32_t till_next = UINT32_MAX;
+
+    /*The head of every priority list is the task which is due first*/
+    for(uint32_t prio = LV_TASK_PRIO_LOWEST; prio < LV_TASK_PRIO_NUM; prio++) {
+        lv_task_t * task = lv_ll_get_head(LV_TASK_LL(prio));
+        if(task == NULL) continue;
+
+        uint32_t remaining = lv_task_time_remaining(task);
+        if(remaining == 0) return 0;
+
+        if(remaining < till_next) till_next = remaining;
+    }
+
+    return till_next;
+}
+
 
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
 /**
- * Execute task if its the priority is appropriate
+ * Execute a task and put it back to its place in the priority list
  * @param lv_task_p pointer to lv_task
- * @return true: execute, false: not executed
  */
-static bool lv_task_exec(lv_task_t * lv_task_p)
+static void lv_task_exec(lv_task_t * lv_task_p)
 {
-    bool exec = false;
+    lv_task_p->last_run = lv_tick_get();
+    lv_task_p->pass = task_pass;
+    task_deleted = false;
+    LV_GC_ROOT(_lv_task_act) = lv_task_p;
+    lv_task_p->task(lv_task_p->param);
 
-    /*Execute if at least 'period' time elapsed*/
-    uint32_t elp = lv_tick_elaps(lv_task_p->last_run);
-    if(elp >= lv_task_p->period) {
-        lv_task_p->last_run = lv_tick_get();
-        task_deleted = false;
-        task_created = false;
-        lv_task_p->task(lv_task_p->param);
-
-        /*Delete if it was a one shot lv_task*/
-        if(task_deleted == false) {			/*The task might be deleted by itself as well*/
-        	if(lv_task_p->once != 0) {
-        	    lv_task_del(lv_task_p);
-        	}
-        }
-        exec = true;
+    /*The task might be deleted by itself as well*/
+    if(task_deleted) return;
+
+    /*Delete if it was a one shot lv_task*/
+    if(lv_task_p->once != 0) lv_task_del(lv_task_p);
+    else lv_task_sort(lv_task_p);
+}
+
+/**
+ * Move a task to its place in its priority list, after the tasks which are due earlier or at the same time
+ * @param lv_task_p pointer to lv_task
+ */
+static void lv_task_sort(lv_task_t * lv_task_p)
+{
+    lv_ll_t * ll = LV_TASK_LL(lv_task_p->prio);
+    uint32_t remaining = lv_task_time_remaining(lv_task_p);
+
+    /*Search from the tail. A task which just ran is usually due last.*/
+    lv_task_t * prev = lv_ll_get_tail(ll);
+    while(prev && (prev == lv_task_p || lv_task_time_remaining(prev) > remaining)) {
+        prev = lv_ll_get_prev(ll, prev);
     }
 
-    return exec;
+    lv_task_t * after = prev ? lv_ll_get_next(ll, prev) : lv_ll_get_head(ll);
+    if(after == lv_task_p) return;      /*Already in place*/
+
+    if(task_next == lv_task_p) task_next = lv_ll_get_next(ll, lv_task_p);
+
+    lv_ll_move_before(ll, lv_task_p, after);
 }
 
+/**
+ * Get the time until a task is due
+ * @param lv_task_p pointer to lv_task
+ * @return time in ms until the task has to run. 0 if it's already due.
+ */
+static uint32_t lv_task_time_remaining(const lv_task_t * lv_task_p)
+{
+    uint32_t elp = lv_tick_elaps(lv_task_p->last_run);
+
+    return elp >= lv_task_p->period ? 0 : lv_task_p->period - elp;
+}
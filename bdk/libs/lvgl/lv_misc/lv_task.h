@@ -58,6 +58,7 @@ typedef struct
     uint32_t last_run;
     void (*task) (void*);
     void * param;
+    uint32_t pass;      /*Handler pass the task was last run or created in*/
     uint8_t prio:3;
     uint8_t once:1;
 } lv_task_t;
@@ -138,6 +139,12 @@ void lv_task_enable(bool en);
  */
 uint8_t lv_task_get_idle(void);
 
+/**
+ * Get the time until the next lv_task is due
+ * @return time in ms until the earliest enabled task has to run. 0 if one is already due.
+ */
+uint32_t lv_task_time_till_next(void);
+
 /**********************
  *      MACROS
  **********************/
@@ -134,6 +134,25 @@ int max17050_get_property(enum MAX17050_reg reg, int *value)
 	return 0;
 }
 
+int max17050_get_batt_status(int *soc, int *volt, int *curr)
+{
+	// RepSOC to Current in one transaction. Address auto-increments.
+	u16 regs[MAX17050_Current - MAX17050_RepSOC + 1];
+
+	if (i2c_recv_buf_big((u8 *)regs, sizeof(regs), I2C_1, MAXIM17050_I2C_ADDR, MAX17050_RepSOC))
+		return -1;
+
+	*soc = regs[MAX17050_RepSOC - MAX17050_RepSOC];
+
+	*volt = (regs[MAX17050_VCELL - MAX17050_RepSOC] >> 3) * 625 / 1000; /* Units of LSB = 0.625mV */
+	battery_voltage = *volt;
+
+	*curr = (s16)regs[MAX17050_Current - MAX17050_RepSOC];
+	*curr *= 1562500 / (MAX17050_BOARD_SNS_RESISTOR_UOHM * MAX17050_BOARD_CGAIN);
+
+	return 0;
+}
+
 static int _max17050_write_verify_reg(u8 reg, u16 value)
 {
 	int retries = 8;
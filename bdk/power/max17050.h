@@ -131,6 +131,7 @@ enum MAX17050_reg {
 };
 
 int max17050_get_property(enum MAX17050_reg reg, int *value);
+int max17050_get_batt_status(int *soc, int *volt, int *curr);
 int max17050_fix_configuration();
 u32 max17050_get_cached_batt_volt();
 
@@ -24,6 +24,7 @@
 void max77620_rtc_get_time(rtc_time_t *time)
 {
 	u8 val = 0;
+	u8 regs[MAX77620_RTC_NR_TIME_REGS];
 
 	// Update RTC regs from RTC clock.
 	i2c_send_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_UPDATE0_REG, MAX77620_RTC_READ_UPDATE);
@@ -32,10 +33,13 @@ void max77620_rtc_get_time(rtc_time_t *time)
 	val = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_CONTROL_REG);
 	// TODO: Check for binary format also?
 
+	// Get all time regs in one transaction. Address auto-increments from SEC to DATE.
+	i2c_recv_buf_small(regs, MAX77620_RTC_NR_TIME_REGS, I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_SEC_REG);
+
 	// Get time.
-	time->sec  = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_SEC_REG) & 0x7F;
-	time->min  = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_MIN_REG) & 0x7F;
-	u8 hour = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_HOUR_REG);
+	time->sec  = regs[MAX77620_RTC_SEC_REG - MAX77620_RTC_SEC_REG] & 0x7F;
+	time->min  = regs[MAX77620_RTC_MIN_REG - MAX77620_RTC_SEC_REG] & 0x7F;
+	u8 hour = regs[MAX77620_RTC_HOUR_REG - MAX77620_RTC_SEC_REG];
 	time->hour = hour & 0x1F;
 
 	if (!(val & MAX77620_RTC_24H) && (hour & MAX77620_RTC_HOUR_PM_MASK))
@@ -43,7 +47,7 @@ void max77620_rtc_get_time(rtc_time_t *time)
 
 	// Get day of week. 1: Monday to 7: Sunday.
 	time->weekday = 0;
-	val = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_WEEKDAY_REG);
+	val = regs[MAX77620_RTC_WEEKDAY_REG - MAX77620_RTC_SEC_REG];
 	for (int i = 0; i < 8; i++)
 	{
 		time->weekday++;
@@ -53,9 +57,9 @@ void max77620_rtc_get_time(rtc_time_t *time)
 	}
 
 	// Get date.
-	time->day  = i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_DATE_REG) & 0x1f;
-	time->month = (i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_MONTH_REG) & 0xF) - 1;
-	time->year  = (i2c_recv_byte(I2C_5, MAX77620_RTC_I2C_ADDR, MAX77620_RTC_YEAR_REG) & 0x7F) + 2000;
+	time->day  = regs[MAX77620_RTC_DATE_REG - MAX77620_RTC_SEC_REG] & 0x1f;
+	time->month = (regs[MAX77620_RTC_MONTH_REG - MAX77620_RTC_SEC_REG] & 0xF) - 1;
+	time->year  = (regs[MAX77620_RTC_YEAR_REG - MAX77620_RTC_SEC_REG] & 0x7F) + 2000;
 }
 
 void max77620_rtc_stop_alarm()
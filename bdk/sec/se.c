@@ -36,6 +36,8 @@ typedef struct _se_ll_t
 se_ll_t ll_src, ll_dst;
 se_ll_t *ll_src_ptr, *ll_dst_ptr; // Must be u32 aligned.
 
+static u32 _se_sha256_bytes = 0; // Total bytes hashed. Used for profiling.
+
 static void _gf256_mul_x(void *block)
 {
 	u8 *pdata = (u8 *)block;
@@ -502,6 +504,7 @@ int se_calc_sha256(void *hash, u32 *msg_left, const void *src, u32 src_size, u64
 
 	// Trigger the operation.
 	res = _se_execute(SE_OP_START, NULL, 0, src, src_size, is_oneshot);
+	_se_sha256_bytes += src_size;
 
 	if (is_oneshot)
 	{
@@ -526,6 +529,11 @@ int se_calc_sha256_oneshot(void *hash, const void *src, u32 src_size)
 	return se_calc_sha256(hash, NULL, src, src_size, 0, SHA_INIT_HASH, true);
 }
 
+u32 se_calc_sha256_get_bytes()
+{
+	return _se_sha256_bytes;
+}
+
 int se_calc_sha256_finalize(void *hash, u32 *msg_left)
 {
 	u32 hash32[SE_SHA_256_SIZE / 4];
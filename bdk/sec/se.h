@@ -41,6 +41,7 @@ int  se_aes_crypt_ctr(u32 ks, void *dst, u32 dst_size, const void *src, u32 src_
 int  se_calc_sha256(void *hash, u32 *msg_left, const void *src, u32 src_size, u64 total_size, u32 sha_cfg, bool is_oneshot);
 int  se_calc_sha256_oneshot(void *hash, const void *src, u32 src_size);
 int  se_calc_sha256_finalize(void *hash, u32 *msg_left);
+u32  se_calc_sha256_get_bytes();
 int  se_gen_prng128(void *dst);
 
 #endif
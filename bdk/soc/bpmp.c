@@ -23,6 +23,7 @@
 #include <memory_map.h>
 
 #define BPMP_MMU_CACHE_LINE_SIZE        0x20
+#define BPMP_MMU_MAINT_RANGE_MAX        SZ_4K // Above that, whole cache maintenance is faster.
 
 #define BPMP_CACHE_CONFIG               0x0
 #define  CFG_ENABLE_CACHE               BIT(0)
@@ -124,11 +125,10 @@ bpmp_mmu_entry_t mmu_entries[] =
 	{ IRAM_BASE,  0x4003FFFF, MMU_EN_READ | MMU_EN_WRITE | MMU_EN_EXEC | MMU_EN_CACHED, true }
 };
 
-void bpmp_mmu_maintenance(u32 op, bool force)
-{
-	if (!force && !(BPMP_CACHE_CTRL(BPMP_CACHE_CONFIG) & CFG_ENABLE_CACHE))
-		return;
+bpmp_mmu_maint_stats_t bpmp_mmu_maint_stats;
 
+static void _bpmp_mmu_maintenance_req(u32 op)
+{
 	BPMP_CACHE_CTRL(BPMP_CACHE_INT_CLEAR) = INT_MAINT_DONE;
 
 	// This is a blocking operation.
@@ -140,6 +140,52 @@ void bpmp_mmu_maintenance(u32 op, bool force)
 	BPMP_CACHE_CTRL(BPMP_CACHE_INT_CLEAR) = BPMP_CACHE_CTRL(BPMP_CACHE_INT_RAW_EVENT);
 }
 
+void bpmp_mmu_maintenance(u32 op, bool force)
+{
+	if (!force && !(BPMP_CACHE_CTRL(BPMP_CACHE_CONFIG) & CFG_ENABLE_CACHE))
+		return;
+
+	_bpmp_mmu_maintenance_req(op);
+
+	bpmp_mmu_maint_stats.way_ops++;
+}
+
+void bpmp_mmu_maintenance_range(u32 op, const void *buf, u32 size)
+{
+	if (!size || !(BPMP_CACHE_CTRL(BPMP_CACHE_CONFIG) & CFG_ENABLE_CACHE))
+		return;
+
+	bpmp_mmu_maint_stats.bytes += size;
+
+	u32 start = (u32)buf;
+	u32 end   = start + size;
+	u32 line_start = ALIGN_DOWN(start, BPMP_MMU_CACHE_LINE_SIZE);
+	u32 line_end   = ALIGN(end, BPMP_MMU_CACHE_LINE_SIZE);
+
+	// Doing the whole cache is faster for big ranges.
+	if (line_end - line_start > BPMP_MMU_MAINT_RANGE_MAX)
+	{
+		bpmp_mmu_maintenance(op, false);
+		return;
+	}
+
+	// Convert way operation to its physical address one.
+	u32 line_op = op - BPMP_MMU_MAINT_CLEAN_WAY + BPMP_MMU_MAINT_CLEAN_PHY;
+
+	/*
+	 * Partial lines are invalidated too. Cleaning them here would write stale
+	 * CPU data over what the DMA wrote. They are clean since the range was
+	 * cleaned before the DMA started.
+	 */
+	for (u32 line = line_start; line < line_end; line += BPMP_MMU_CACHE_LINE_SIZE)
+	{
+		BPMP_CACHE_CTRL(BPMP_CACHE_MAINT_ADDR) = line;
+		_bpmp_mmu_maintenance_req(line_op);
+
+		bpmp_mmu_maint_stats.line_ops++;
+	}
+}
+
 void bpmp_mmu_set_entry(int idx, bpmp_mmu_entry_t *entry, bool apply)
 {
 	if (idx > 31)
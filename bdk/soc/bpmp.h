@@ -43,6 +43,15 @@ typedef struct _bpmp_mmu_entry_t
 	u32 enable;
 } bpmp_mmu_entry_t;
 
+typedef struct _bpmp_mmu_maint_stats_t
+{
+	u32 way_ops;
+	u32 line_ops;
+	u64 bytes; // Bytes passed to range maintenance.
+} bpmp_mmu_maint_stats_t;
+
+extern bpmp_mmu_maint_stats_t bpmp_mmu_maint_stats;
+
 typedef enum
 {
 	BPMP_CLK_NORMAL,      // 408MHz  0% - 136MHz APB.
@@ -57,6 +66,13 @@ typedef enum
 #define BPMP_CLK_DEFAULT_BOOST BPMP_CLK_HYPER_BOOST
 
 void bpmp_mmu_maintenance(u32 op, bool force);
+/*
+ * Cache maintenance of the lines a buffer covers. Takes a way operation.
+ * DMA buffers must be cleaned before the transfer and, if the device writes
+ * them, invalidated after it. Lines that are shared with data outside of the
+ * buffer must not be written by the CPU while the transfer runs.
+ */
+void bpmp_mmu_maintenance_range(u32 op, const void *buf, u32 size);
 void bpmp_mmu_set_entry(int idx, bpmp_mmu_entry_t *entry, bool apply);
 void bpmp_mmu_enable();
 void bpmp_mmu_disable();
@@ -81,6 +81,8 @@
 #define  MSTR_CONFIG_LOAD     BIT(0)
 #define  TIMEOUT_CONFIG_LOAD  BIT(2)
 
+static u32 i2c_xfers = 0;
+
 static const u32 i2c_addrs[] = {
 	0x7000C000, // I2C_1.
 	0x7000C400, // I2C_2.
@@ -106,6 +108,8 @@ static int _i2c_send_single(u32 i2c_idx, u32 dev_addr, u8 *buf, u32 size)
 	if (size > 8)
 		return 0;
 
+	i2c_xfers++;
+
 	u32 tmp = 0;
 
 	vu32 *base = (vu32 *)i2c_addrs[i2c_idx];
@@ -154,6 +158,8 @@ static int _i2c_recv_single(u32 i2c_idx, u8 *buf, u32 size, u32 dev_addr)
 	if (size > 8)
 		return 0;
 
+	i2c_xfers++;
+
 	vu32 *base = (vu32 *)i2c_addrs[i2c_idx];
 
 	// Set device address and recv mode.
@@ -196,6 +202,8 @@ static int _i2c_send_pkt(u32 i2c_idx, u8 *buf, u32 size, u32 dev_addr)
 	if (size > 32)
 		return 0;
 
+	i2c_xfers++;
+
 	int res = 0;
 
 	vu32 *base = (vu32 *)i2c_addrs[i2c_idx];
@@ -268,6 +276,8 @@ static int _i2c_recv_pkt(u32 i2c_idx, u8 *buf, u32 size, u32 dev_addr, u32 reg)
 	if (size > 32)
 		return 0;
 
+	i2c_xfers++;
+
 	int res = 0;
 
 	vu32 *base = (vu32 *)i2c_addrs[i2c_idx];
@@ -422,3 +432,8 @@ u8 i2c_recv_byte(u32 i2c_idx, u32 dev_addr, u32 reg)
 	return tmp;
 }
 
+u32 i2c_get_xfer_count()
+{
+	return i2c_xfers;
+}
+
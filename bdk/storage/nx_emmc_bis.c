@@ -126,20 +126,26 @@ static void _nx_emmc_bis_cluster_cache_init(bool enable_cache)
 	bis_cache->enabled = enable_cache;
 }
 
-static void _nx_emmc_bis_flush_cache()
+static int _nx_emmc_bis_flush_cache()
 {
+	int res = 0;
+
 	if (!bis_cache->enabled || !bis_cache->dirty_cnt)
-		return;
+		return 0;
 
+	// Dirty count is decreased by the write itself, only if it succeeds.
 	for (u32 i = 0; i < bis_cache->top_idx && bis_cache->dirty_cnt; i++)
 	{
-		if (bis_cache->clusters[i].dirty) {
-			nx_emmc_bis_write_block(bis_cache->clusters[i].cluster_idx * BIS_CLUSTER_SECTORS, BIS_CLUSTER_SECTORS, NULL, true);
-			bis_cache->dirty_cnt--;
+		if (bis_cache->clusters[i].dirty &&
+			nx_emmc_bis_write_block(bis_cache->clusters[i].cluster_idx * BIS_CLUSTER_SECTORS, BIS_CLUSTER_SECTORS, NULL, true))
+		{
+			res = 1; // R/W error.
 		}
 	}
 
 	_nx_emmc_bis_cluster_cache_init(true);
+
+	return res;
 }
 
 static int nx_emmc_bis_read_block_normal(u32 sector, u32 count, void *buff)
@@ -202,14 +208,9 @@ static int nx_emmc_bis_read_block_cached(u32 sector, u32 count, void *buff)
 		return 0; // Success.
 	}
 
-	// Flush cache if full.
-	if (bis_cache->top_idx >= BIS_CACHE_MAX_ENTRIES)
-		_nx_emmc_bis_flush_cache();
-
-	// Set new cached cluster parameters.
-	bis_cache->clusters[bis_cache->top_idx].cluster_idx = cluster;
-	bis_cache->clusters[bis_cache->top_idx].dirty = false;
-	cache_lookup_tbl[cluster] = bis_cache->top_idx;
+	// Flush cache if full. Cached writes would be lost otherwise.
+	if (bis_cache->top_idx >= BIS_CACHE_MAX_ENTRIES && _nx_emmc_bis_flush_cache())
+		return 1; // R/W error.
 
 	// Read the whole cluster the sector resides in.
 	if (!emu_offset)
@@ -223,6 +224,11 @@ static int nx_emmc_bis_read_block_cached(u32 sector, u32 count, void *buff)
 	if (!se_aes_xts_crypt_sec_nx(ks_tweak, ks_crypt, DECRYPT, cluster, cache_tweak, true, 0, bis_cache->dma_buff, bis_cache->dma_buff, BIS_CLUSTER_SIZE))
 		return 1; // Decryption error.
 
+	// Set new cached cluster parameters. Only done on success, so a failed read is never served from cache.
+	bis_cache->clusters[bis_cache->top_idx].cluster_idx = cluster;
+	bis_cache->clusters[bis_cache->top_idx].dirty = false;
+	cache_lookup_tbl[cluster] = bis_cache->top_idx;
+
 	// Copy to cluster cache.
 	memcpy(bis_cache->clusters[bis_cache->top_idx].data, bis_cache->dma_buff, BIS_CLUSTER_SIZE);
 	memcpy(buff, bis_cache->dma_buff + sector_in_cluster * EMMC_BLOCKSIZE, count * EMMC_BLOCKSIZE);
@@ -318,8 +324,13 @@ void nx_emmc_bis_init(emmc_part_t *part, bool enable_cache, u32 emummc_offset)
 		system_part = NULL;
 }
 
-void nx_emmc_bis_end()
+int nx_emmc_bis_end()
 {
-	_nx_emmc_bis_flush_cache();
+	int res = 0;
+
+	if (system_part)
+		res = _nx_emmc_bis_flush_cache();
 	system_part = NULL;
+
+	return res;
 }
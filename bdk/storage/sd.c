@@ -249,8 +249,11 @@ int sd_save_to_file(void *buf, u32 size, const char *filename)
 		return res;
 	}
 
-	f_write(&fp, buf, size, NULL);
-	f_close(&fp);
+	res = f_write(&fp, buf, size, NULL);
+	if (!res)
+		res = f_close(&fp);
+	else
+		f_close(&fp);
 
-	return 0;
+	return res;
 }
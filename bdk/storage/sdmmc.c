@@ -199,12 +199,125 @@ int sdmmc_storage_vendor_sandisk_report(sdmmc_storage_t *storage, void *buf)
 	return 1;
 }
 
+#ifdef BDK_SDMMC_FAULT_INJECT
+typedef struct _sdmmc_fault_t
+{
+	u32 sdmmc_id;
+	u32 type;
+	u32 sector;
+	u32 count; // Times to trigger. 0: Always.
+	u32 hits;
+} sdmmc_fault_t;
+
+static sdmmc_fault_t sdmmc_faults[SDMMC_FAULT_SLOTS] = {0};
+
+static int _sdmmc_storage_readwrite_ex(sdmmc_storage_t *storage, u32 *blkcnt_out, u32 sector, u32 num_sectors, void *buf, u32 is_write);
+
+int sdmmc_fault_add(u32 sdmmc_id, u32 type, u32 sector, u32 count)
+{
+	for (u32 i = 0; i < SDMMC_FAULT_SLOTS; i++)
+	{
+		sdmmc_fault_t *fault = &sdmmc_faults[i];
+		if (!fault->type)
+		{
+			fault->sdmmc_id = sdmmc_id;
+			fault->type = type;
+			fault->sector = sector;
+			fault->count = count;
+			fault->hits = 0;
+
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+u32 sdmmc_fault_get_hits(u32 slot)
+{
+	return sdmmc_faults[slot].hits;
+}
+
+void sdmmc_fault_clear()
+{
+	memset(sdmmc_faults, 0, sizeof(sdmmc_faults));
+}
+
+static bool _sdmmc_fault_removed(sdmmc_storage_t *storage)
+{
+	for (u32 i = 0; i < SDMMC_FAULT_SLOTS; i++)
+	{
+		sdmmc_fault_t *fault = &sdmmc_faults[i];
+		if (fault->type == SDMMC_FAULT_REMOVED && fault->hits && fault->sdmmc_id == storage->sdmmc->id)
+			return true;
+	}
+
+	return false;
+}
+
+static sdmmc_fault_t *_sdmmc_fault_find(sdmmc_storage_t *storage, u32 sector, u32 num_sectors)
+{
+	for (u32 i = 0; i < SDMMC_FAULT_SLOTS; i++)
+	{
+		sdmmc_fault_t *fault = &sdmmc_faults[i];
+		if (!fault->type || fault->sdmmc_id != storage->sdmmc->id)
+			continue;
+
+		// Removed card fails everything after the first hit.
+		if (fault->type == SDMMC_FAULT_REMOVED && fault->hits)
+			return fault;
+
+		if (fault->count && fault->hits >= fault->count)
+			continue;
+
+		if (fault->sector >= sector && fault->sector < sector + num_sectors)
+			return fault;
+	}
+
+	return NULL;
+}
+
+static int _sdmmc_fault_inject(sdmmc_storage_t *storage, sdmmc_fault_t *fault, u32 *blkcnt_out, u32 sector, u32 num_sectors, void *buf, u32 is_write)
+{
+	u32 good_sectors = fault->sector >= sector ? fault->sector - sector : 0;
+
+	fault->hits++;
+
+	switch (fault->type)
+	{
+	case SDMMC_FAULT_CRC:
+	case SDMMC_FAULT_TIMEOUT:
+		// Sectors before the faulty one still get transferred.
+		if (good_sectors && !_sdmmc_storage_readwrite_ex(storage, blkcnt_out, sector, good_sectors, buf, is_write))
+			return 0;
+
+		// Data with a bad CRC still lands in the buffer.
+		if (fault->type == SDMMC_FAULT_CRC && !is_write)
+			memset((u8 *)buf + good_sectors * 512, 0xA5, 512);
+		break;
+
+	case SDMMC_FAULT_BUSY:
+	case SDMMC_FAULT_REMOVED:
+	default:
+		break;
+	}
+
+	return 0;
+}
+#endif
+
 static int _sdmmc_storage_readwrite_ex(sdmmc_storage_t *storage, u32 *blkcnt_out, u32 sector, u32 num_sectors, void *buf, u32 is_write)
 {
 	u32 tmp = 0;
 	sdmmc_cmd_t cmdbuf;
 	sdmmc_req_t reqbuf;
 
+#ifdef BDK_SDMMC_FAULT_INJECT
+	sdmmc_fault_t *fault = _sdmmc_fault_find(storage, sector, num_sectors);
+	if (fault)
+		return _sdmmc_fault_inject(storage, fault, blkcnt_out, sector, num_sectors, buf, is_write);
+#endif
+
 	// If SDSC convert block address to byte address.
 	if (!storage->has_sector_access)
 		sector <<= 9;
@@ -246,6 +359,7 @@ static int _sdmmc_storage_readwrite(sdmmc_storage_t *storage, u32 sector, u32 nu
 	u8 *bbuf = (u8 *)buf;
 	u32 sct_off = sector;
 	u32 sct_total = num_sectors;
+	u32 partition = storage->partition;
 	bool first_reinit = true;
 
 	// Exit if not initialized.
@@ -270,6 +384,12 @@ reinit_try:
 			msleep(50);
 		} while (retries);
 
+#ifdef BDK_SDMMC_FAULT_INJECT
+		// Card is gone. Reinit can't succeed.
+		if (_sdmmc_fault_removed(storage))
+			return 0;
+#endif
+
 		// Disk IO failure! Reinit SD/EMMC to a lower speed.
 		if (storage->sdmmc->id == SDMMC_1 || storage->sdmmc->id == SDMMC_4)
 		{
@@ -310,6 +430,10 @@ reinit_try:
 			// If successful reinit, restart xfer.
 			if (res)
 			{
+				// Reinit selects the eMMC user partition. Switch back, or the xfer hits the wrong partition.
+				if (partition && !sdmmc_storage_set_mmc_partition(storage, partition))
+					return 0;
+
 				bbuf = (u8 *)buf;
 				sct_off = sector;
 				sct_total = num_sectors;
@@ -215,4 +215,20 @@ int  sd_storage_get_scr(sdmmc_storage_t *storage, u8 *buf);
 int  sd_storage_get_ssr(sdmmc_storage_t *storage, u8 *buf);
 u32  sd_storage_get_ssr_au(sdmmc_storage_t *storage);
 
+#ifdef BDK_SDMMC_FAULT_INJECT
+#define SDMMC_FAULT_SLOTS 4
+
+typedef enum _sdmmc_fault_type_t
+{
+	SDMMC_FAULT_CRC     = 1, // Read data is corrupted. Write fails after the prior sectors.
+	SDMMC_FAULT_TIMEOUT = 2, // Xfer stops at the sector.
+	SDMMC_FAULT_BUSY    = 3, // Card stays busy. Nothing is transferred.
+	SDMMC_FAULT_REMOVED = 4  // Card is gone after reaching the sector. Xfers and reinit fail.
+} sdmmc_fault_type_t;
+
+int  sdmmc_fault_add(u32 sdmmc_id, u32 type, u32 sector, u32 count);
+u32  sdmmc_fault_get_hits(u32 slot);
+void sdmmc_fault_clear();
+#endif
+
 #endif
@@ -1019,7 +1019,7 @@ static int _sdmmc_execute_cmd_inner(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_
 		}
 
 		// Flush cache before starting the transfer.
-		bpmp_mmu_maintenance(BPMP_MMU_MAINT_CLEAN_WAY, false);
+		bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, req->buf, req->blksize * blkcnt);
 
 		is_data_present = true;
 	}
@@ -1068,8 +1068,9 @@ DPRINTF("rsp(%d): %08X, %08X, %08X, %08X\n", result,
 	{
 		if (req)
 		{
-			// Invalidate cache after transfer.
-			bpmp_mmu_maintenance(BPMP_MMU_MAINT_INVALID_WAY, false);
+			// Invalidate cache after read transfer.
+			if (!req->is_write)
+				bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, req->buf, req->blksize * blkcnt);
 
 			if (blkcnt_out)
 				*blkcnt_out = blkcnt;
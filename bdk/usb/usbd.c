@@ -85,6 +85,7 @@ typedef struct _usbd_t
 	volatile dQH_t *qhs;
 	int ep_configured[4];
 	int ep_bytes_requested[4];
+	u8 *ep_buf[4];
 } usbd_t;
 
 typedef struct _usbd_controller_t
@@ -733,6 +734,14 @@ static usb_ep_status_t _usbd_get_ep_status(usb_ep_t endpoint)
 	return USB_EP_STATUS_IDLE;
 }
 
+static void _usbd_ep_cache_maintenance(usb_ep_t endpoint, u32 op)
+{
+	// Only the EP buffer and its dTDs/dQH are accessed by the controller.
+	bpmp_mmu_maintenance_range(op, usbdaemon->ep_buf[endpoint], usbdaemon->ep_bytes_requested[endpoint]);
+	bpmp_mmu_maintenance_range(op, (void *)&usbdaemon->dtds[endpoint * 4], sizeof(dTD_t) * 4);
+	bpmp_mmu_maintenance_range(op, (void *)&usbdaemon->qhs[endpoint], sizeof(dQH_t));
+}
+
 static int _usbd_ep_operation(usb_ep_t endpoint, u8 *buf, u32 len, u32 sync_timeout)
 {
 	if (!buf)
@@ -756,6 +765,7 @@ static int _usbd_ep_operation(usb_ep_t endpoint, u8 *buf, u32 len, u32 sync_time
 
 	usbdaemon->ep_configured[endpoint] = 1;
 	usbdaemon->ep_bytes_requested[endpoint] = len;
+	usbdaemon->ep_buf[endpoint] = buf;
 
 	// Configure dTD.
 	u32 dtd_idx = 0;
@@ -799,7 +809,7 @@ static int _usbd_ep_operation(usb_ep_t endpoint, u8 *buf, u32 len, u32 sync_time
 		prime_bit = USB2D_ENDPT_STATUS_RX_OFFSET << actual_ep;
 
 	// Flush data before priming EP.
-	bpmp_mmu_maintenance(BPMP_MMU_MAINT_CLEAN_WAY, false);
+	_usbd_ep_cache_maintenance(endpoint, BPMP_MMU_MAINT_CLEAN_WAY);
 
 	// Prime endpoint.
 	usbd_otg->regs->endptprime |= prime_bit; // USB2_CONTROLLER_USB2D_ENDPTPRIME.
@@ -836,7 +846,7 @@ out:
 
 		// Invalidate data after OP is done.
 		if (direction == USB_DIR_OUT)
-			bpmp_mmu_maintenance(BPMP_MMU_MAINT_INVALID_WAY, false);
+			_usbd_ep_cache_maintenance(endpoint, BPMP_MMU_MAINT_INVALID_WAY);
 	}
 
 	return res;
@@ -1490,7 +1500,7 @@ int usb_device_ep1_out_reading_finish(u32 *pending_bytes, u32 sync_timeout)
 
 	*pending_bytes = _usbd_get_ep1_out_bytes_read();
 
-	bpmp_mmu_maintenance(BPMP_MMU_MAINT_INVALID_WAY, false);
+	_usbd_ep_cache_maintenance(USB_EP_BULK_OUT, BPMP_MMU_MAINT_INVALID_WAY);
 
 	if (ep_status == USB_EP_STATUS_IDLE)
 		return USB_RES_OK;
@@ -37,6 +37,7 @@
 #define XUSB_TRB_SLOTS 16 //! TODO: Consider upping it.
 #define XUSB_LINK_TRB_IDX (XUSB_TRB_SLOTS - 1)
 #define XUSB_LAST_TRB_IDX (XUSB_TRB_SLOTS - 1)
+#define XUSB_BULK_TRB_MAX (XUSB_TRB_SLOTS - 2) // Max queued bulk TRBs. Excludes Link TRB and a free slot.
 
 #define EP_DONT_RING     0
 #define EP_RING_DOORBELL 1
@@ -370,6 +371,9 @@ typedef struct _xusbd_controller_t
 	u32 device_state;
 	u32 tx_bytes[2];
 	u32 tx_count[2];
+	u8 *tx_buf[2];
+	u32 tx_len[2];
+	u32 tx_trb_queued[2]; // Bitmap of queued bulk TRB ring slots.
 	u32 ctrl_seq_num;
 	u32 config_num;
 	u32 interface_num;
@@ -409,6 +413,12 @@ xusbd_event_queues_t *xusb_evtq = (xusbd_event_queues_t *)XUSB_RING_ADDR;
 xusbd_controller_t *usbd_xotg;
 xusbd_controller_t usbd_xotg_controller_ctxt;
 
+// EP contexts are in cached IRAM. CPU writes must reach the controller before it reloads them.
+static void _xusb_ep_ctx_clean()
+{
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, (void *)xusb_evtq->xusb_ep_ctxt, sizeof(xusb_evtq->xusb_ep_ctxt));
+}
+
 static int _xusb_xhci_mask_wait(u32 reg, u32 mask, u32 val, u32 retries)
 {
 	do
@@ -692,6 +702,7 @@ static int _xusb_ep_init_context(u32 ep_idx)
 		break;
 
 	case USB_EP_BULK_OUT:
+		usbd_xotg->tx_trb_queued[USB_DIR_OUT] = 0;
 		usbd_xotg->bulkout_producer_cycle = 1;
 		usbd_xotg->bulkout_epenqueue_ptr = xusb_evtq->xusb_bulkout_event_queue;
 		usbd_xotg->bulkout_epdequeue_ptr = xusb_evtq->xusb_bulkout_event_queue;
@@ -709,6 +720,7 @@ static int _xusb_ep_init_context(u32 ep_idx)
 		break;
 
 	case USB_EP_BULK_IN:
+		usbd_xotg->tx_trb_queued[USB_DIR_IN] = 0;
 		usbd_xotg->bulkin_producer_cycle = 1;
 		usbd_xotg->bulkin_epenqueue_ptr = xusb_evtq->xusb_bulkin_event_queue;
 		usbd_xotg->bulkin_epdequeue_ptr = xusb_evtq->xusb_bulkin_event_queue;
@@ -726,6 +738,10 @@ static int _xusb_ep_init_context(u32 ep_idx)
 		break;
 	}
 
+	// Flush context and Link TRB.
+	_xusb_ep_ctx_clean();
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, link_trb, sizeof(link_trb_t));
+
 	return USB_RES_OK;
 }
 
@@ -762,6 +778,7 @@ static void _xusbd_ep1_disable(u32 ep_idx)
 	case USB_EP_BULK_OUT:
 	case USB_EP_BULK_IN:
 		// Skip if already disabled.
+		bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, (void *)ep_ctxt, sizeof(xusb_ep_ctx_t));
 		if (!ep_ctxt->ep_state)
 			return;
 
@@ -772,6 +789,7 @@ static void _xusbd_ep1_disable(u32 ep_idx)
 
 		// Clear EP context.
 		memset((void *)ep_ctxt, 0, sizeof(xusb_ep_ctx_t));
+		_xusb_ep_ctx_clean();
 
 		// Wait for EP status to change.
 		_xusb_xhci_mask_wait(XUSB_DEV_XHCI_EP_STCHG, ep_mask, ep_mask, 1000);
@@ -999,6 +1017,7 @@ static void _xusb_device_power_down()
 static int _xusb_queue_trb(u32 ep_idx, void *trb, bool ring_doorbell)
 {
 	int res = USB_RES_OK;
+	data_trb_t *enq_trb = NULL;
 	data_trb_t *next_trb;
 	link_trb_t *link_trb;
 
@@ -1006,7 +1025,8 @@ static int _xusb_queue_trb(u32 ep_idx, void *trb, bool ring_doorbell)
 	switch (ep_idx)
 	{
 	case XUSB_EP_CTRL_IN:
-		memcpy(usbd_xotg->cntrl_epenqueue_ptr, trb, sizeof(data_trb_t));
+		enq_trb = usbd_xotg->cntrl_epenqueue_ptr;
+		memcpy(enq_trb, trb, sizeof(data_trb_t));
 
 		// Advance queue and if Link TRB set index to 0 and toggle cycle bit.
 		next_trb = &usbd_xotg->cntrl_epenqueue_ptr[1];
@@ -1022,7 +1042,9 @@ static int _xusb_queue_trb(u32 ep_idx, void *trb, bool ring_doorbell)
 		break;
 
 	case USB_EP_BULK_OUT:
-		memcpy(usbd_xotg->bulkout_epenqueue_ptr, trb, sizeof(data_trb_t));
+		enq_trb = usbd_xotg->bulkout_epenqueue_ptr;
+		memcpy(enq_trb, trb, sizeof(data_trb_t));
+		usbd_xotg->tx_trb_queued[USB_DIR_OUT] |= BIT(enq_trb - xusb_evtq->xusb_bulkout_event_queue);
 
 		// Advance queue and if Link TRB set index to 0 and toggle cycle bit.
 		next_trb = &usbd_xotg->bulkout_epenqueue_ptr[1];
@@ -1038,7 +1060,9 @@ static int _xusb_queue_trb(u32 ep_idx, void *trb, bool ring_doorbell)
 		break;
 
 	case USB_EP_BULK_IN:
-		memcpy(usbd_xotg->bulkin_epenqueue_ptr, trb, sizeof(data_trb_t));
+		enq_trb = usbd_xotg->bulkin_epenqueue_ptr;
+		memcpy(enq_trb, trb, sizeof(data_trb_t));
+		usbd_xotg->tx_trb_queued[USB_DIR_IN] |= BIT(enq_trb - xusb_evtq->xusb_bulkin_event_queue);
 
 		// Advance queue and if Link TRB set index to 0 and toggle cycle bit.
 		next_trb = &usbd_xotg->bulkin_epenqueue_ptr[1];
@@ -1062,8 +1086,14 @@ static int _xusb_queue_trb(u32 ep_idx, void *trb, bool ring_doorbell)
 	// Ring doorbell.
 	if (ring_doorbell)
 	{
-		// Flush data before transfer.
-		bpmp_mmu_maintenance(BPMP_MMU_MAINT_CLEAN_WAY, false);
+		// Flush TRB, next TRB in case of Link and data before transfer.
+		if (enq_trb)
+		{
+			data_trb_t *data_trb = (data_trb_t *)trb;
+			bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, enq_trb, sizeof(data_trb_t) * 2);
+			bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, (void *)data_trb->databufptr_lo, data_trb->trb_tx_len);
+		}
+
 		u32 target_id = (ep_idx << 8) & 0xFFFF;
 		if (ep_idx == XUSB_EP_CTRL_IN)
 			target_id |= usbd_xotg->ctrl_seq_num << 16;
@@ -1200,29 +1230,128 @@ static int _xusb_wait_ep_stopped(u32 endpoint)
 	return USB_RES_OK;
 }
 
+static data_trb_t *_xusb_next_trb(data_trb_t *trb)
+{
+	data_trb_t *next_trb = &trb[1];
+	if (next_trb->trb_type == XUSB_TRB_LINK)
+		next_trb = (data_trb_t *)(next_trb->databufptr_lo & 0xFFFFFFF0);
+
+	return next_trb;
+}
+
+static bool _xusb_bulk_trb_complete(usb_dir_t direction, data_trb_t *ring, data_trb_t *trb)
+{
+	u32 slot = trb - ring;
+	if (slot >= XUSB_LINK_TRB_IDX || !(usbd_xotg->tx_trb_queued[direction] & BIT(slot)))
+		return false;
+
+	usbd_xotg->tx_trb_queued[direction] &= ~BIT(slot);
+
+	return true;
+}
+
+static bool _xusb_bulk_ring_full(usb_dir_t direction)
+{
+	u32 slot;
+	if (direction == USB_DIR_IN)
+		slot = usbd_xotg->bulkin_epenqueue_ptr - xusb_evtq->xusb_bulkin_event_queue;
+	else
+		slot = usbd_xotg->bulkout_epenqueue_ptr - xusb_evtq->xusb_bulkout_event_queue;
+
+	// Completions might not be in order, so also check that the enqueue slot is done.
+	return usbd_xotg->tx_count[direction] >= XUSB_BULK_TRB_MAX ||
+		   (usbd_xotg->tx_trb_queued[direction] & BIT(slot));
+}
+
+// Drops the TRBs that did not complete and rewinds the ring to the oldest one, where the controller stopped.
+static void _xusb_bulk_ring_abort(usb_dir_t direction)
+{
+	data_trb_t *ring;
+	data_trb_t **enqueue_ptr;
+	data_trb_t **dequeue_ptr;
+	u32 *producer_cycle;
+	if (direction == USB_DIR_IN)
+	{
+		ring = xusb_evtq->xusb_bulkin_event_queue;
+		enqueue_ptr = &usbd_xotg->bulkin_epenqueue_ptr;
+		dequeue_ptr = &usbd_xotg->bulkin_epdequeue_ptr;
+		producer_cycle = &usbd_xotg->bulkin_producer_cycle;
+	}
+	else
+	{
+		ring = xusb_evtq->xusb_bulkout_event_queue;
+		enqueue_ptr = &usbd_xotg->bulkout_epenqueue_ptr;
+		dequeue_ptr = &usbd_xotg->bulkout_epdequeue_ptr;
+		producer_cycle = &usbd_xotg->bulkout_producer_cycle;
+	}
+
+	// Find the oldest queued TRB. Completions might not be in order, so check all slots behind enqueue.
+	u32 slot = *enqueue_ptr - ring;
+	u32 cycle = *producer_cycle & 1;
+	u32 first_slot = slot;
+	u32 first_cycle = cycle;
+	for (u32 i = 0; i < XUSB_LINK_TRB_IDX - 1; i++)
+	{
+		// Going back over the Link TRB.
+		if (!slot)
+		{
+			slot = XUSB_LINK_TRB_IDX;
+			cycle ^= 1;
+		}
+		slot--;
+
+		if (usbd_xotg->tx_trb_queued[direction] & BIT(slot))
+		{
+			first_slot = slot;
+			first_cycle = cycle;
+		}
+	}
+
+	// Give the TRBs from there to enqueue back to software.
+	slot = first_slot;
+	cycle = first_cycle;
+	while (&ring[slot] != *enqueue_ptr)
+	{
+		memset(&ring[slot], 0, sizeof(data_trb_t));
+		ring[slot].cycle = cycle ^ 1;
+
+		slot++;
+		if (slot == XUSB_LINK_TRB_IDX)
+		{
+			slot = 0;
+			cycle ^= 1;
+		}
+	}
+
+	usbd_xotg->tx_trb_queued[direction] = 0;
+	usbd_xotg->tx_count[direction] = 0;
+	usbd_xotg->tx_bytes[direction] = 0;
+	*producer_cycle = first_cycle;
+	*enqueue_ptr = &ring[first_slot];
+	*dequeue_ptr = &ring[first_slot];
+
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, ring, sizeof(data_trb_t) * XUSB_TRB_SLOTS);
+}
+
 static int _xusb_handle_transfer_event(transfer_event_trb_t *trb)
 {
-	// Advance dequeue list.
-	data_trb_t *next_trb;
+	// Advance dequeue list. Bulk ones follow the completed TRB, since multiple can be queued.
+	data_trb_t *evt_trb = (data_trb_t *)(trb->trb_pointer_lo & 0xFFFFFFF0);
+	bool bulk_trb_queued = false;
 	switch (trb->ep_id)
 	{
 	case XUSB_EP_CTRL_IN:
-		next_trb = &usbd_xotg->cntrl_epdequeue_ptr[1];
-		if (next_trb->trb_type == XUSB_TRB_LINK)
-			next_trb = (data_trb_t *)(next_trb->databufptr_lo & 0xFFFFFFF0);
-		usbd_xotg->cntrl_epdequeue_ptr = next_trb;
+		usbd_xotg->cntrl_epdequeue_ptr = _xusb_next_trb(usbd_xotg->cntrl_epdequeue_ptr);
 		break;
 	case USB_EP_BULK_OUT:
-		next_trb = &usbd_xotg->bulkout_epdequeue_ptr[1];
-		if (next_trb->trb_type == XUSB_TRB_LINK)
-			next_trb = (data_trb_t *)(next_trb->databufptr_lo & 0xFFFFFFF0);
-		usbd_xotg->bulkout_epdequeue_ptr = next_trb;
+		bulk_trb_queued = _xusb_bulk_trb_complete(USB_DIR_OUT, xusb_evtq->xusb_bulkout_event_queue, evt_trb);
+		if (bulk_trb_queued)
+			usbd_xotg->bulkout_epdequeue_ptr = _xusb_next_trb(evt_trb);
 		break;
 	case USB_EP_BULK_IN:
-		next_trb = &usbd_xotg->bulkin_epdequeue_ptr[1];
-		if (next_trb->trb_type == XUSB_TRB_LINK)
-			next_trb = (data_trb_t *)(next_trb->databufptr_lo & 0xFFFFFFF0);
-		usbd_xotg->bulkin_epdequeue_ptr = next_trb;
+		bulk_trb_queued = _xusb_bulk_trb_complete(USB_DIR_IN, xusb_evtq->xusb_bulkin_event_queue, evt_trb);
+		if (bulk_trb_queued)
+			usbd_xotg->bulkin_epdequeue_ptr = _xusb_next_trb(evt_trb);
 		break;
 	default:
 		// Should never happen.
@@ -1260,6 +1389,10 @@ static int _xusb_handle_transfer_event(transfer_event_trb_t *trb)
 			break;
 
 		case USB_EP_BULK_IN:
+			// Skip events of TRBs not queued anymore.
+			if (!bulk_trb_queued)
+				break;
+
 			usbd_xotg->tx_bytes[USB_DIR_IN] -= trb->trb_tx_len;
 			if (usbd_xotg->tx_count[USB_DIR_IN])
 				usbd_xotg->tx_count[USB_DIR_IN]--;
@@ -1270,6 +1403,10 @@ static int _xusb_handle_transfer_event(transfer_event_trb_t *trb)
 			break;
 
 		case USB_EP_BULK_OUT:
+			// Skip events of TRBs not queued anymore.
+			if (!bulk_trb_queued)
+				break;
+
 			// If short packet and Bulk OUT, it's not an error because we prime EP for 4KB.
 			usbd_xotg->tx_bytes[USB_DIR_OUT] -= trb->trb_tx_len;
 			if (usbd_xotg->tx_count[USB_DIR_OUT])
@@ -1374,6 +1511,7 @@ static int _xusb_handle_port_change()
 			volatile xusb_ep_ctx_t *ep_ctxt = &xusb_evtq->xusb_ep_ctxt[XUSB_EP_CTRL_IN];
 			ep_ctxt->avg_trb_len = 8;
 			ep_ctxt->max_packet_size = 64;
+			_xusb_ep_ctx_clean();
 			//! TODO: If super speed is supported, ep context reload, unpause and unhalt must happen.
 		}
 
@@ -1600,6 +1738,7 @@ static void _xusb_handle_set_request_dev_address(usb_ctrl_setup_t *ctrl_setup)
 
 	XUSB_DEV_XHCI(XUSB_DEV_XHCI_CTRL) = (XUSB_DEV_XHCI(XUSB_DEV_XHCI_CTRL) & 0x80FFFFFF) | (addr << 24);
 	xusb_evtq->xusb_ep_ctxt[XUSB_EP_CTRL_IN].device_addr = addr;
+	_xusb_ep_ctx_clean();
 
 	_xusb_issue_status_trb(USB_DIR_IN);
 
@@ -1855,6 +1994,11 @@ static int _xusb_ep_operation(u32 tries)
 	// Clear interrupt status.
 	XUSB_DEV_XHCI(XUSB_DEV_XHCI_ST) |= XHCI_ST_IP;
 
+	// Event ring and EP contexts are in cached IRAM and written by the controller.
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, xusb_evtq->xusb_event_ring_seg0,
+		sizeof(xusb_evtq->xusb_event_ring_seg0) + sizeof(xusb_evtq->xusb_event_ring_seg1));
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, (void *)xusb_evtq->xusb_ep_ctxt, sizeof(xusb_evtq->xusb_ep_ctxt));
+
 	usbd_xotg->event_enqueue_ptr = (event_trb_t *)(XUSB_DEV_XHCI(XUSB_DEV_XHCI_EREPLO) & 0xFFFFFFF0);
 	event_trb = usbd_xotg->event_dequeue_ptr;
 
@@ -2014,6 +2158,8 @@ int xusb_device_ep1_out_read(u8 *buf, u32 len, u32 *bytes_read, u32 sync_tries)
 	int res = USB_RES_OK;
 	usbd_xotg->tx_count[USB_DIR_OUT] = 0;
 	usbd_xotg->tx_bytes[USB_DIR_OUT] = len;
+	usbd_xotg->tx_buf[USB_DIR_OUT] = buf;
+	usbd_xotg->tx_len[USB_DIR_OUT] = len;
 	_xusb_issue_normal_trb(buf, len, USB_DIR_OUT);
 	usbd_xotg->tx_count[USB_DIR_OUT]++;
 
@@ -2027,7 +2173,7 @@ int xusb_device_ep1_out_read(u8 *buf, u32 len, u32 *bytes_read, u32 sync_tries)
 	}
 
 	// Invalidate data after transfer.
-	bpmp_mmu_maintenance(BPMP_MMU_MAINT_INVALID_WAY, false);
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, usbd_xotg->tx_buf[USB_DIR_OUT], usbd_xotg->tx_len[USB_DIR_OUT]);
 
 	return res;
 }
@@ -2037,24 +2183,45 @@ int xusb_device_ep1_out_read_big(u8 *buf, u32 len, u32 *bytes_read)
 	if (len > USB_EP_BULK_OUT_MAX_XFER)
 		len = USB_EP_BULK_OUT_MAX_XFER;
 
-	u32 bytes = 0;
+	int res = USB_RES_OK;
 	*bytes_read = 0;
 	u8 *buf_curr = buf;
+	u32 len_left = len;
+
+	usbd_xotg->tx_count[USB_DIR_OUT] = 0;
+	usbd_xotg->tx_bytes[USB_DIR_OUT] = len;
+	usbd_xotg->tx_buf[USB_DIR_OUT] = buf;
+	usbd_xotg->tx_len[USB_DIR_OUT] = len;
 
-	while (len)
+	// Keep the EP busy by queueing the next TRBs while previous ones are in flight.
+	while (!res && (len_left || usbd_xotg->tx_count[USB_DIR_OUT]))
 	{
-		u32 len_ep = MIN(len, USB_EP_BUFFER_MAX_SIZE);
+		if (len_left && !_xusb_bulk_ring_full(USB_DIR_OUT))
+		{
+			u32 len_ep = MIN(len_left, USB_EP_BUFFER_MAX_SIZE);
 
-		int res = xusb_device_ep1_out_read(buf_curr, len_ep, &bytes, USB_XFER_SYNCED_DATA);
-		if (res)
-			return res;
+			_xusb_issue_normal_trb(buf_curr, len_ep, USB_DIR_OUT);
+			usbd_xotg->tx_count[USB_DIR_OUT]++;
+
+			len_left -= len_ep;
+			buf_curr += len_ep;
+			continue;
+		}
 
-		len -= len_ep;
-		buf_curr += len_ep;
-		*bytes_read = *bytes_read + bytes;
+		res = _xusb_ep_operation(USB_XFER_SYNCED_DATA);
 	}
 
-	return USB_RES_OK;
+	// Do not leave TRBs queued on errors. Their slots would stay busy and they would still write to buf.
+	if (res)
+		_xusb_bulk_ring_abort(USB_DIR_OUT);
+
+	// Invalidate data after transfer.
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, buf, len);
+
+	if (!res)
+		*bytes_read = usbd_xotg->tx_bytes[USB_DIR_OUT];
+
+	return res;
 }
 
 int xusb_device_ep1_out_reading_finish(u32 *pending_bytes, u32 sync_tries)
@@ -2067,7 +2234,7 @@ int xusb_device_ep1_out_reading_finish(u32 *pending_bytes, u32 sync_tries)
 		*pending_bytes = res ? 0 : usbd_xotg->tx_bytes[USB_DIR_OUT];
 
 	// Invalidate data after transfer.
-	bpmp_mmu_maintenance(BPMP_MMU_MAINT_INVALID_WAY, false);
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, usbd_xotg->tx_buf[USB_DIR_OUT], usbd_xotg->tx_len[USB_DIR_OUT]);
 
 	return res;
 }
@@ -2077,9 +2244,6 @@ int xusb_device_ep1_in_write(u8 *buf, u32 len, u32 *bytes_written, u32 sync_trie
 	if (len > USB_EP_BUFFER_MAX_SIZE)
 		len = USB_EP_BUFFER_MAX_SIZE;
 
-	// Flush data before transfer.
-	bpmp_mmu_maintenance(BPMP_MMU_MAINT_CLEAN_WAY, false);
-
 	int res = USB_RES_OK;
 	usbd_xotg->tx_count[USB_DIR_IN] = 0;
 	usbd_xotg->tx_bytes[USB_DIR_IN] = len;
@@ -20,195 +20,348 @@
 
 #include <utils/types.h>
 
-char **sout_buf;
+#define FMT_LEFT  BIT(0)
+#define FMT_ZERO  BIT(1)
+#define FMT_PLUS  BIT(2)
+#define FMT_ALT   BIT(3)
 
-static void _s_putc(char c)
+typedef struct _sprintf_out_t
 {
-	**sout_buf = c;
-	*sout_buf += 1;
+	char *buf;
+	u32 len;  // Characters produced, including the ones that did not fit.
+	u32 size; // Buffer size, including null terminator.
+} sprintf_out_t;
+
+static const char _dec_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static void _s_putc(sprintf_out_t *o, char c)
+{
+	if (o->len + 1 < o->size)
+		o->buf[o->len] = c;
+	o->len++;
 }
 
-static void _s_puts(char *s)
+static void _s_putcn(sprintf_out_t *o, char c, int cnt)
 {
-	for (; *s; s++)
-		_s_putc(*s);
+	for (; cnt > 0; cnt--)
+		_s_putc(o, c);
 }
 
-static void _s_putn(u32 v, int base, char fill, int fcnt)
+static void _s_puts(sprintf_out_t *o, const char *s, int len)
 {
-	static const char digits[] = "0123456789ABCDEF";
+	for (; len > 0; len--, s++)
+		_s_putc(o, *s);
+}
 
-	char *p;
-	char buf[65];
-	int c = fcnt;
-	bool negative = false;
+// Converts backwards from p, 2 digits at a time. Division by 100 is done with a reciprocal multiply.
+static char *_s_u32_dec(char *p, u32 v)
+{
+	while (v >= 100)
+	{
+		u32 q = ((u64)v * 0x51EB851F) >> 37;
+		u32 r = (v - q * 100) * 2;
+		*--p = _dec_pairs[r + 1];
+		*--p = _dec_pairs[r];
+		v = q;
+	}
 
-	if (base != 10 && base != 16)
-		return;
+	if (v >= 10)
+	{
+		*--p = _dec_pairs[v * 2 + 1];
+		*--p = _dec_pairs[v * 2];
+	}
+	else
+		*--p = '0' + v;
+
+	return p;
+}
 
-	// Account for negative numbers.
-	if (base == 10 && v & 0x80000000)
+static char *_s_u64_dec(char *p, u64 v)
+{
+	// Split into 9 digit chunks. Only up to 2 64-bit divisions are needed.
+	while (v > 0xFFFFFFFF)
 	{
-		negative = true;
-		v = (int)v * -1;
-		c--;
+		u64 q = v / 1000000000;
+		char *chunk_end = p;
+
+		p = _s_u32_dec(p, v - q * 1000000000);
+		while (p > chunk_end - 9)
+			*--p = '0';
+
+		v = q;
 	}
 
-	p = buf + 64;
-	*p = 0;
+	return _s_u32_dec(p, v);
+}
+
+static char *_s_u64_hex(char *p, u64 v)
+{
+	static const char digits[] = "0123456789ABCDEF";
+
 	do
 	{
-		c--;
-		*--p = digits[v % base];
-		v /= base;
+		*--p = digits[v & 0xF];
+		v >>= 4;
 	} while (v);
 
-	if (negative)
-		*--p = '-';
+	return p;
+}
 
-	if (fill != 0)
+static void _s_putn(sprintf_out_t *o, u64 v, bool negative, int base, u32 flags, int width, int prec)
+{
+	char buf[24];
+	char *end = buf + sizeof(buf);
+	char *p = end;
+	char prefix[2];
+	int prefix_len = 0;
+
+	// A zero precision with a zero value prints no digits.
+	if (v || prec)
+		p = (base == 10) ? _s_u64_dec(end, v) : _s_u64_hex(end, v);
+
+	if (negative)
+		prefix[prefix_len++] = '-';
+	else if (flags & FMT_PLUS)
+		prefix[prefix_len++] = '+';
+	else if (base == 16 && (flags & FMT_ALT) && v)
 	{
-		while (c > 0 && p > buf)
-		{
-			*--p = fill;
-			c--;
-		}
+		prefix[prefix_len++] = '0';
+		prefix[prefix_len++] = 'X';
 	}
 
-	_s_puts(p);
-}
+	int digits = end - p;
+	int zeros = prec > digits ? prec - digits : 0;
 
-void s_printf(char *out_buf, const char *fmt, ...)
-{
-	va_list ap;
-	int fill, fcnt;
+	// Zero flag pads up to width, unless a precision is given.
+	if ((flags & (FMT_ZERO | FMT_LEFT)) == FMT_ZERO && prec < 0)
+		zeros = width - prefix_len - digits;
 
-	sout_buf = &out_buf;
+	int pad = width - prefix_len - zeros - digits;
 
-	va_start(ap, fmt);
+	if (!(flags & FMT_LEFT))
+		_s_putcn(o, ' ', pad);
+	_s_puts(o, prefix, prefix_len);
+	_s_putcn(o, '0', zeros);
+	_s_puts(o, p, digits);
+	if (flags & FMT_LEFT)
+		_s_putcn(o, ' ', pad);
+}
+
+static void _s_vprintf(sprintf_out_t *o, const char *fmt, va_list ap)
+{
 	while (*fmt)
 	{
-		if (*fmt == '%')
+		if (*fmt != '%')
+		{
+			_s_putc(o, *fmt++);
+			continue;
+		}
+		fmt++;
+
+		// Flags.
+		u32 flags = 0;
+		for (;; fmt++)
+		{
+			if (*fmt == '-')
+				flags |= FMT_LEFT;
+			else if (*fmt == '0')
+				flags |= FMT_ZERO;
+			else if (*fmt == '+')
+				flags |= FMT_PLUS;
+			else if (*fmt == '#')
+				flags |= FMT_ALT;
+			else if (*fmt != ' ') // Space only pads, like the width alone. No sign space is added.
+				break;
+		}
+
+		// Width.
+		int width = 0;
+		if (*fmt == '*')
+		{
+			width = va_arg(ap, int);
+			if (width < 0)
+			{
+				flags |= FMT_LEFT;
+				width = -width;
+			}
+			fmt++;
+		}
+		else
+		{
+			for (; *fmt >= '0' && *fmt <= '9'; fmt++)
+				width = width * 10 + *fmt - '0';
+		}
+
+		// Precision.
+		int prec = -1;
+		if (*fmt == '.')
 		{
 			fmt++;
-			fill = 0;
-			fcnt = 0;
-			if ((*fmt >= '0' && *fmt <= '9') || *fmt == ' ')
+			prec = 0;
+			if (*fmt == '*')
 			{
-				fcnt = *fmt;
+				prec = va_arg(ap, int);
 				fmt++;
-				if (*fmt >= '0' && *fmt <= '9')
-				{
-					fill = fcnt;
-					fcnt = *fmt - '0';
-					fmt++;
-				}
-				else
-				{
-					fill = ' ';
-					fcnt -= '0';
-				}
 			}
-			switch (*fmt)
+			else
 			{
-			case 'c':
-				_s_putc(va_arg(ap, u32));
-				break;
-			case 's':
-				_s_puts(va_arg(ap, char *));
-				break;
-			case 'd':
-				_s_putn(va_arg(ap, u32), 10, fill, fcnt);
-				break;
-			case 'p':
-			case 'P':
-			case 'x':
-			case 'X':
-				_s_putn(va_arg(ap, u32), 16, fill, fcnt);
-				break;
-			case '%':
-				_s_putc('%');
-				break;
-			case '\0':
-				goto out;
-			default:
-				_s_putc('%');
-				_s_putc(*fmt);
-				break;
+				for (; *fmt >= '0' && *fmt <= '9'; fmt++)
+					prec = prec * 10 + *fmt - '0';
 			}
 		}
-		else
-			_s_putc(*fmt);
+
+		// Length. Anything shorter than int is promoted to int and cut back to its size.
+		int lng = 0;
+		for (;; fmt++)
+		{
+			if (*fmt == 'l')
+				lng++;
+			else if (*fmt == 'h')
+				lng--;
+			else if (*fmt == 'j')
+				lng = 2;
+			else if (*fmt == 'z')
+				lng = 1;
+			else
+				break;
+		}
+
+		u64 v;
+		bool negative = false;
+		switch (*fmt)
+		{
+		case 'c':
+			if (!(flags & FMT_LEFT))
+				_s_putcn(o, ' ', width - 1);
+			_s_putc(o, va_arg(ap, int));
+			if (flags & FMT_LEFT)
+				_s_putcn(o, ' ', width - 1);
+			break;
+
+		case 's':;
+			const char *s = va_arg(ap, const char *);
+			if (!s)
+				s = "(null)";
+
+			int len = 0;
+			while (s[len] && (prec < 0 || len < prec))
+				len++;
+
+			if (!(flags & FMT_LEFT))
+				_s_putcn(o, ' ', width - len);
+			_s_puts(o, s, len);
+			if (flags & FMT_LEFT)
+				_s_putcn(o, ' ', width - len);
+			break;
+
+		case 'd':
+		case 'i':;
+			s64 sv;
+			if (lng >= 2)
+				sv = va_arg(ap, long long);
+			else if (lng == 1)
+				sv = va_arg(ap, long);
+			else
+				sv = va_arg(ap, int);
+
+			if (lng == -1)
+				sv = (s16)sv;
+			else if (lng < -1)
+				sv = (s8)sv;
+
+			negative = sv < 0;
+			v = negative ? -(u64)sv : (u64)sv;
+			_s_putn(o, v, negative, 10, flags, width, prec);
+			break;
+
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'p':
+		case 'P':
+			if (*fmt == 'p' || *fmt == 'P')
+				v = (uptr)va_arg(ap, void *);
+			else if (lng >= 2)
+				v = va_arg(ap, unsigned long long);
+			else if (lng == 1)
+				v = va_arg(ap, unsigned long);
+			else
+				v = va_arg(ap, unsigned int);
+
+			if (lng == -1)
+				v = (u16)v;
+			else if (lng < -1)
+				v = (u8)v;
+
+			flags &= ~FMT_PLUS;
+			_s_putn(o, v, false, *fmt == 'u' ? 10 : 16, flags, width, prec);
+			break;
+
+		case '%':
+			_s_putc(o, '%');
+			break;
+
+		case '\0':
+			return;
+
+		default:
+			_s_putc(o, '%');
+			_s_putc(o, *fmt);
+			break;
+		}
 		fmt++;
 	}
+}
+
+static int _s_vsnprintf(char *out_buf, u32 size, const char *fmt, va_list ap)
+{
+	sprintf_out_t o = { out_buf, 0, size };
 
-out:
-	**sout_buf = '\0';
+	_s_vprintf(&o, fmt, ap);
+
+	// Null terminate, even if truncated.
+	if (size)
+		out_buf[o.len < size ? o.len : size - 1] = '\0';
+
+	return o.len;
+}
+
+void s_printf(char *out_buf, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	_s_vsnprintf(out_buf, 0xFFFFFFFF, fmt, ap);
 	va_end(ap);
 }
 
 void s_vprintf(char *out_buf, const char *fmt, va_list ap)
 {
-	int fill, fcnt;
+	_s_vsnprintf(out_buf, 0xFFFFFFFF, fmt, ap);
+}
 
-	sout_buf = &out_buf;
+int s_snprintf(char *out_buf, u32 size, const char *fmt, ...)
+{
+	va_list ap;
 
-	while (*fmt)
-	{
-		if (*fmt == '%')
-		{
-			fmt++;
-			fill = 0;
-			fcnt = 0;
-			if ((*fmt >= '0' && *fmt <= '9') || *fmt == ' ')
-			{
-				fcnt = *fmt;
-				fmt++;
-				if (*fmt >= '0' && *fmt <= '9')
-				{
-					fill = fcnt;
-					fcnt = *fmt - '0';
-					fmt++;
-				}
-				else
-				{
-					fill = ' ';
-					fcnt -= '0';
-				}
-			}
-			switch(*fmt)
-			{
-			case 'c':
-				_s_putc(va_arg(ap, u32));
-				break;
-			case 's':
-				_s_puts(va_arg(ap, char *));
-				break;
-			case 'd':
-				_s_putn(va_arg(ap, u32), 10, fill, fcnt);
-				break;
-			case 'p':
-			case 'P':
-			case 'x':
-			case 'X':
-				_s_putn(va_arg(ap, u32), 16, fill, fcnt);
-				break;
-			case '%':
-				_s_putc('%');
-				break;
-			case '\0':
-				goto out;
-			default:
-				_s_putc('%');
-				_s_putc(*fmt);
-				break;
-			}
-		}
-		else
-			_s_putc(*fmt);
-		fmt++;
-	}
+	va_start(ap, fmt);
+	int len = _s_vsnprintf(out_buf, size, fmt, ap);
+	va_end(ap);
 
-out:
-	**sout_buf = '\0';
+	return len;
+}
+
+int s_vsnprintf(char *out_buf, u32 size, const char *fmt, va_list ap)
+{
+	return _s_vsnprintf(out_buf, size, fmt, ap);
 }
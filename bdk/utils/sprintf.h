@@ -21,7 +21,14 @@
 
 #include <utils/types.h>
 
+/*
+ * Supports %c %s %d %i %u %x %X %p %P and %%, with flags, width, precision and
+ * h/l/ll/j/z length modifiers. Unlike C, hex is always upper case and the space
+ * flag does not add a sign space, so '% 4d' is the same as '%4d'.
+ */
 void s_printf(char *out_buf, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
 void s_vprintf(char *out_buf, const char *fmt, va_list ap);
+int  s_snprintf(char *out_buf, u32 size, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+int  s_vsnprintf(char *out_buf, u32 size, const char *fmt, va_list ap);
 
 #endif
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include <mem/heap.h>
 #include <power/max77620.h>
 #include <rtc/max77620-rtc.h>
+#include <sec/se.h>
 #include <soc/bpmp.h>
 #include <soc/hw_init.h>
 #include <soc/i2c.h>
@@ -33,6 +34,8 @@
 
 #define USE_RTC_TIMER
 
+extern volatile nyx_storage_t *nyx_str;
+
 u8 bit_count(u32 val)
 {
 	u8 cnt = 0;
@@ -110,15 +113,18 @@ void exec_cfg(u32 *base, const cfg_op_t *ops, u32 num_ops)
 		base[ops[i].off] = ops[i].val;
 }
 
+/*
+ * Slice-by-8 CRC32 (IEEE 802.3).
+ * Calls can be chained to checksum data in parts, by passing the previous result as crc.
+ */
 u32 crc32_calc(u32 crc, const u8 *buf, u32 len)
 {
-	const u8 *p, *q;
 	static u32 *table = NULL;
 
-	// Calculate CRC table.
+	// Calculate CRC tables.
 	if (!table)
 	{
-		table = calloc(256, sizeof(u32));
+		table = calloc(256 * 8, sizeof(u32));
 		for (u32 i = 0; i < 256; i++)
 		{
 			u32 rem = i;
@@ -134,19 +140,76 @@ u32 crc32_calc(u32 crc, const u8 *buf, u32 len)
 			}
 			table[i] = rem;
 		}
+
+		for (u32 i = 0; i < 256; i++)
+			for (u32 k = 1; k < 8; k++)
+				table[k * 256 + i] = (table[(k - 1) * 256 + i] >> 8) ^ table[table[(k - 1) * 256 + i] & 0xFF];
 	}
 
 	crc = ~crc;
-	q = buf + len;
-	for (p = buf; p < q; p++)
+
+	// Align source for word accesses.
+	while (len && ((u32)buf & 3))
+	{
+		crc = (crc >> 8) ^ table[(crc ^ *buf++) & 0xFF];
+		len--;
+	}
+
+	const u32 *buf32 = (const u32 *)buf;
+	for (; len >= 8; len -= 8)
 	{
-		u8 oct = *p;
-		crc = (crc >> 8) ^ table[(crc & 0xff) ^ oct];
+		u32 one = *buf32++ ^ crc;
+		u32 two = *buf32++;
+		crc = table[7 * 256 + (one & 0xFF)]         ^ table[6 * 256 + ((one >> 8) & 0xFF)] ^
+			  table[5 * 256 + ((one >> 16) & 0xFF)] ^ table[4 * 256 + (one >> 24)]        ^
+			  table[3 * 256 + (two & 0xFF)]         ^ table[2 * 256 + ((two >> 8) & 0xFF)] ^
+			  table[1 * 256 + ((two >> 16) & 0xFF)] ^ table[0 * 256 + (two >> 24)];
 	}
 
+	buf = (const u8 *)buf32;
+	while (len--)
+		crc = (crc >> 8) ^ table[(crc ^ *buf++) & 0xFF];
+
 	return ~crc;
 }
 
+void boot_prof_init()
+{
+	volatile boot_prof_t *prof = &nyx_str->info.boot_prof;
+
+	// Keep older sessions if they survived a reload.
+	if (prof->magic != BOOT_PROF_MAGIC || prof->idx >= BOOT_PROF_ENTRIES || prof->count > BOOT_PROF_ENTRIES)
+	{
+		memset((void *)prof, 0, sizeof(boot_prof_t));
+		prof->magic = BOOT_PROF_MAGIC;
+	}
+
+	prof->session++;
+	prof->sha_mark = se_calc_sha256_get_bytes();
+}
+
+void boot_prof_add(boot_prof_phase_t phase, u32 start)
+{
+	volatile boot_prof_t *prof = &nyx_str->info.boot_prof;
+
+	if (prof->magic != BOOT_PROF_MAGIC)
+		return;
+
+	volatile boot_prof_entry_t *entry = &prof->entries[prof->idx];
+	entry->phase   = phase;
+	entry->session = prof->session;
+	entry->start   = start;
+	entry->end     = get_tmr_us();
+
+	u32 sha_bytes = se_calc_sha256_get_bytes();
+	entry->sha_bytes = sha_bytes - prof->sha_mark;
+	prof->sha_mark = sha_bytes;
+
+	prof->idx = (prof->idx + 1) % BOOT_PROF_ENTRIES;
+	if (prof->count < BOOT_PROF_ENTRIES)
+		prof->count++;
+}
+
 void panic(u32 val)
 {
 	// Set panic code.
@@ -61,12 +61,53 @@ typedef struct _cfg_op_t
 	u32 val;
 } cfg_op_t;
 
+typedef enum
+{
+	BOOT_PROF_HW_INIT      = 0,
+	BOOT_PROF_SD_MOUNT     = 1,
+	BOOT_PROF_MINERVA_INIT = 2,
+	BOOT_PROF_INI_PARSE    = 3,
+	BOOT_PROF_BOOTLOGO     = 4,
+	BOOT_PROF_PKG1_READ    = 5,
+	BOOT_PROF_KEYGEN       = 6,
+	BOOT_PROF_PKG2_DECRYPT = 7,
+	BOOT_PROF_KIP_PATCH    = 8,
+	BOOT_PROF_PKG2_BUILD   = 9,
+	BOOT_PROF_HANDOFF      = 10,
+	BOOT_PROF_PKG2_CACHE   = 11,
+
+	BOOT_PROF_PHASE_MAX
+} boot_prof_phase_t;
+
+#define BOOT_PROF_MAGIC   0x32465250 // "PRF2".
+#define BOOT_PROF_ENTRIES 64
+
+typedef struct _boot_prof_entry_t
+{
+	u16 phase;
+	u16 session;
+	u32 start;     // us.
+	u32 end;       // us.
+	u32 sha_bytes; // SE SHA256 bytes hashed since previous entry.
+} boot_prof_entry_t;
+
+typedef struct _boot_prof_t
+{
+	u32 magic;
+	u32 session;
+	u32 idx;      // Next slot to write.
+	u32 count;
+	u32 sha_mark; // SE SHA256 bytes at last entry.
+	boot_prof_entry_t entries[BOOT_PROF_ENTRIES];
+} boot_prof_t;
+
 typedef struct _nyx_info_t
 {
 	u32 magic;
 	u32 sd_init;
 	u32 sd_errors[3];
-	u8  rsvd[0x1000];
+	boot_prof_t boot_prof;
+	u8  rsvd[0x1000 - sizeof(boot_prof_t)];
 	u32 disp_id;
 	u32 errors;
 } nyx_info_t;
@@ -91,6 +132,9 @@ u64  sqrt64(u64 num);
 void exec_cfg(u32 *base, const cfg_op_t *ops, u32 num_ops);
 u32  crc32_calc(u32 crc, const u8 *buf, u32 len);
 
+void boot_prof_init();
+void boot_prof_add(boot_prof_phase_t phase, u32 start);
+
 // AtomNX
 u32  get_tmr_us();
 u32  get_tmr_ms();
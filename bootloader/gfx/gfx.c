@@ -123,20 +123,143 @@ static const u8 _gfx_font[] = {
 	0x00, 0x00, 0x00, 0x4C, 0x32, 0x00, 0x00, 0x00  // Char 126 (~)
 };
 
+/*
+ * Console history. Text drawn in the scroll region is also kept as cells of
+ * 8x8 pixels, in a ring of rows. Scrolling and clearing only move the row
+ * where the region starts, so rows that leave the screen stay in the ring and
+ * can be drawn again by gfx_con_scrollback.
+ */
+#define GFX_CON_HIST_ROWS 640 // 8px rows kept, including the visible ones.
+#define GFX_CON_PAL_SIZE  32
+#define GFX_CON_BG_NONE   0xFF
+#define GFX_CON_CELL_BIG  0x80 // 16px glyph.
+
+typedef struct _gfx_con_cell_t
+{
+	u8 c;
+	u8 fg;
+	u8 bg;
+} gfx_con_cell_t;
+
+typedef struct _gfx_con_hist_t
+{
+	gfx_con_cell_t *cells;
+	u32 cols;
+	u32 top;  // Ring row of the first region row.
+	u32 used; // Region rows drawn to since the last scroll or clear.
+	u32 back; // Pixel rows currently scrolled back.
+	u32 *live; // Region contents while scrolled back.
+	u32 pal[GFX_CON_PAL_SIZE];
+	u32 pal_cnt;
+	u32 pal_last;
+} gfx_con_hist_t;
+
+static gfx_con_hist_t gfx_con_hist;
+
+static gfx_con_cell_t *_gfx_con_hist_row(u32 row)
+{
+	return gfx_con_hist.cells + ((gfx_con_hist.top + row) % GFX_CON_HIST_ROWS) * gfx_con_hist.cols;
+}
+
+static void _gfx_con_hist_clear(u32 row, u32 rows)
+{
+	for (u32 i = 0; i < rows; i++)
+		memset(_gfx_con_hist_row(row + i), 0, gfx_con_hist.cols * sizeof(gfx_con_cell_t));
+}
+
+// Moves the region start by rows. The rows that enter the region are cleared.
+static void _gfx_con_hist_shift(u32 rows)
+{
+	if (!gfx_con_hist.cells)
+		return;
+
+	u32 region_rows = gfx_con.scroll_end / 8;
+	rows = MIN(rows, GFX_CON_HIST_ROWS - region_rows);
+
+	gfx_con_hist.top += rows;
+	_gfx_con_hist_clear(region_rows - MIN(rows, region_rows), MIN(rows, region_rows));
+	gfx_con_hist.used = gfx_con_hist.used > rows ? gfx_con_hist.used - rows : 0;
+}
+
+// Rows that were scrolled out of the region and can be shown again.
+static u32 _gfx_con_hist_avail()
+{
+	return MIN(gfx_con_hist.top, GFX_CON_HIST_ROWS - gfx_con.scroll_end / 8);
+}
+
+static u8 _gfx_con_pal_idx(u32 color)
+{
+	if (gfx_con_hist.pal[gfx_con_hist.pal_last] == color && gfx_con_hist.pal_cnt)
+		return gfx_con_hist.pal_last;
+
+	for (u32 i = 0; i < gfx_con_hist.pal_cnt; i++)
+	{
+		if (gfx_con_hist.pal[i] == color)
+		{
+			gfx_con_hist.pal_last = i;
+			return i;
+		}
+	}
+
+	// Colors past the palette are shown with the first one.
+	if (gfx_con_hist.pal_cnt == GFX_CON_PAL_SIZE)
+		return 0;
+
+	gfx_con_hist.pal[gfx_con_hist.pal_cnt] = color;
+	gfx_con_hist.pal_last = gfx_con_hist.pal_cnt;
+
+	return gfx_con_hist.pal_cnt++;
+}
+
+static void _gfx_con_hist_put(char c, u32 fntsz)
+{
+	u32 row = gfx_con.y / 8;
+	u32 col = gfx_con.x / 8;
+
+	if (!gfx_con_hist.cells || gfx_con.y + fntsz > gfx_con.scroll_end || col + fntsz / 8 > gfx_con_hist.cols)
+		return;
+
+	gfx_con_cell_t *cell = _gfx_con_hist_row(row) + col;
+	cell->c = c | (fntsz == 16 ? GFX_CON_CELL_BIG : 0);
+	cell->fg = _gfx_con_pal_idx(gfx_con.fgcol);
+	cell->bg = gfx_con.fillbg ? _gfx_con_pal_idx(gfx_con.bgcol) : GFX_CON_BG_NONE;
+
+	// A 16px glyph covers 2x2 cells.
+	if (fntsz == 16)
+	{
+		cell[1].c = 0;
+		cell = _gfx_con_hist_row(row + 1) + col;
+		cell[0].c = 0;
+		cell[1].c = 0;
+	}
+
+	gfx_con_hist.used = MAX(gfx_con_hist.used, row + fntsz / 8);
+}
+
 void gfx_clear_grey(u8 color)
 {
 	memset(gfx_ctxt.fb, color, gfx_ctxt.width * gfx_ctxt.height * 4);
+	_gfx_con_hist_shift(gfx_con_hist.used);
 }
 
 void gfx_clear_partial_grey(u8 color, u32 pos_x, u32 height)
 {
 	memset(gfx_ctxt.fb + pos_x * gfx_ctxt.stride, color, height * 4 * gfx_ctxt.stride);
+
+	// Clearing the whole region keeps its text in history.
+	u32 region_rows = gfx_con.scroll_end / 8;
+	u32 row = pos_x / 8;
+	if (!pos_x && height >= gfx_con.scroll_end)
+		_gfx_con_hist_shift(gfx_con_hist.used);
+	else if (gfx_con_hist.cells && row < region_rows)
+		_gfx_con_hist_clear(row, MIN(ALIGN(pos_x + height, 8) / 8, region_rows) - row);
 }
 
 void gfx_clear_color(u32 color)
 {
 	for (u32 i = 0; i < gfx_ctxt.width * gfx_ctxt.height; i++)
 		gfx_ctxt.fb[i] = color;
+	_gfx_con_hist_shift(gfx_con_hist.used);
 }
 
 void gfx_init_ctxt(u32 *fb, u32 width, u32 height, u32 stride)
@@ -159,6 +282,13 @@ void gfx_con_init()
 	gfx_con.fillbg = 1;
 	gfx_con.bgcol = TXT_CLR_BG;
 	gfx_con.mute = 0;
+	gfx_con.scroll_end = gfx_ctxt.height;
+
+	free(gfx_con_hist.cells);
+	free(gfx_con_hist.live);
+	memset(&gfx_con_hist, 0, sizeof(gfx_con_hist));
+	gfx_con_hist.cols = gfx_ctxt.width / 8;
+	gfx_con_hist.cells = (gfx_con_cell_t *)calloc(GFX_CON_HIST_ROWS * gfx_con_hist.cols, sizeof(gfx_con_cell_t));
 
 	gfx_con_init_done = true;
 }
@@ -170,6 +300,11 @@ void gfx_con_setcol(u32 fgcol, int fillbg, u32 bgcol)
 	gfx_con.bgcol = bgcol;
 }
 
+void gfx_con_set_scroll_end(u32 y)
+{
+	gfx_con.scroll_end = MIN(y, gfx_ctxt.height);
+}
+
 void gfx_con_getpos(u32 *x, u32 *y)
 {
 	*x = gfx_con.x;
@@ -182,87 +317,209 @@ void gfx_con_setpos(u32 x, u32 y)
 	gfx_con.y = y;
 }
 
-void gfx_putc(char c)
+static void _gfx_con_glyph(char c, u32 fntsz)
 {
 	// Duplicate code for performance reasons.
-	switch (gfx_con.fntsz)
+	const u8 *cbuf = &_gfx_font[8 * (c - 32)];
+	u32 stride = gfx_ctxt.stride;
+	u32 *fb = gfx_ctxt.fb + gfx_con.x + gfx_con.y * stride;
+
+	if (fntsz == 16)
 	{
-	case 16:
-		if (c >= 32 && c <= 126)
+		if (gfx_con.fillbg)
 		{
-			u8 *cbuf = (u8 *)&_gfx_font[8 * (c - 32)];
-			u32 *fb = gfx_ctxt.fb + gfx_con.x + gfx_con.y * gfx_ctxt.stride;
-
-			for (u32 i = 0; i < 16; i += 2)
+			// Select colors by glyph bit, so every pixel is a plain store.
+			const u32 col[2] = { gfx_con.bgcol, gfx_con.fgcol };
+			for (u32 i = 0; i < 8; i++)
+			{
+				u32 v = cbuf[i];
+				u32 *row = fb;
+				for (u32 j = 0; j < 8; j++)
+				{
+					u32 pix = col[v & 1];
+					row[0] = pix;
+					row[1] = pix;
+					row[stride] = pix;
+					row[stride + 1] = pix;
+					row += 2;
+					v >>= 1;
+				}
+				fb += stride * 2;
+			}
+		}
+		else
+		{
+			u32 fgcol = gfx_con.fgcol;
+			for (u32 i = 0; i < 8; i++)
 			{
-				u8 v = *cbuf;
-				for (u32 k = 0; k < 2; k++)
+				u32 v = cbuf[i];
+				u32 *row = fb;
+				while (v)
 				{
-					for (u32 j = 0; j < 8; j++)
+					if (v & 1)
 					{
-						if (v & 1)
-						{
-							*fb = gfx_con.fgcol;
-							fb++;
-							*fb = gfx_con.fgcol;
-						}
-						else if (gfx_con.fillbg)
-						{
-							*fb = gfx_con.bgcol;
-							fb++;
-							*fb = gfx_con.bgcol;
-						}
-						else
-							fb++;
-						v >>= 1;
-						fb++;
+						row[0] = fgcol;
+						row[1] = fgcol;
+						row[stride] = fgcol;
+						row[stride + 1] = fgcol;
 					}
-					fb += gfx_ctxt.stride - 16;
-					v = *cbuf;
+					row += 2;
+					v >>= 1;
 				}
-				cbuf++;
+				fb += stride * 2;
 			}
-			gfx_con.x += 16;
 		}
-		else if (c == '\n')
+	}
+	else
+	{
+		if (gfx_con.fillbg)
 		{
-			gfx_con.x = 0;
-			gfx_con.y += 16;
-			if (gfx_con.y > gfx_ctxt.height - 16)
-				gfx_con.y = 0;
+			const u32 col[2] = { gfx_con.bgcol, gfx_con.fgcol };
+			for (u32 i = 0; i < 8; i++)
+			{
+				u32 v = cbuf[i];
+				for (u32 j = 0; j < 8; j++)
+				{
+					fb[j] = col[v & 1];
+					v >>= 1;
+				}
+				fb += stride;
+			}
 		}
-		break;
-	case 8:
-	default:
-		if (c >= 32 && c <= 126)
+		else
 		{
-			u8 *cbuf = (u8 *)&_gfx_font[8 * (c - 32)];
-			u32 *fb = gfx_ctxt.fb + gfx_con.x + gfx_con.y * gfx_ctxt.stride;
+			u32 fgcol = gfx_con.fgcol;
 			for (u32 i = 0; i < 8; i++)
 			{
-				u8 v = *cbuf++;
-				for (u32 j = 0; j < 8; j++)
+				u32 v = cbuf[i];
+				for (u32 j = 0; v; j++)
 				{
 					if (v & 1)
-						*fb = gfx_con.fgcol;
-					else if (gfx_con.fillbg)
-						*fb = gfx_con.bgcol;
+						fb[j] = fgcol;
 					v >>= 1;
-					fb++;
 				}
-				fb += gfx_ctxt.stride - 8;
+				fb += stride;
 			}
-			gfx_con.x += 8;
 		}
-		else if (c == '\n')
+	}
+}
+
+static void _gfx_con_fill_region(u32 row, u32 rows, u32 color)
+{
+	u32 *fb = gfx_ctxt.fb + row * gfx_ctxt.stride;
+	for (u32 i = 0; i < rows * gfx_ctxt.stride; i++)
+		fb[i] = color;
+}
+
+static void _gfx_con_scroll(u32 rows)
+{
+	u32 stride = gfx_ctxt.stride;
+	u32 end = gfx_con.scroll_end;
+
+	// Move the console region up and clear the freed rows.
+	memmove(gfx_ctxt.fb, gfx_ctxt.fb + rows * stride, (end - rows) * stride * 4);
+	_gfx_con_fill_region(end - rows, rows, gfx_con.bgcol);
+	_gfx_con_hist_shift(rows / 8);
+}
+
+static void _gfx_con_newline(u32 fntsz)
+{
+	u32 y = gfx_con.y + fntsz;
+
+	gfx_con.x = 0;
+
+	// Scroll when console text reaches the end of the scroll region, so older output is kept.
+	if (gfx_con.y < gfx_con.scroll_end && (y + fntsz) > gfx_con.scroll_end)
+	{
+		// Scroll a quarter of the region at once, so it is moved once every few lines and not on every one.
+		u32 rows = ALIGN(y + fntsz - gfx_con.scroll_end, 8);
+		rows = MIN(MAX(rows, (gfx_con.scroll_end / 4) & ~15), y);
+		_gfx_con_scroll(rows);
+		y -= rows;
+	}
+	else if (y > gfx_ctxt.height - fntsz)
+		y = 0;
+
+	gfx_con.y = y;
+}
+
+void gfx_putc(char c)
+{
+	u32 fntsz = gfx_con.fntsz == 16 ? 16 : 8;
+
+	if (gfx_con_hist.live)
+		gfx_con_scrollback(0);
+
+	if (c >= 32 && c <= 126)
+	{
+		_gfx_con_hist_put(c, fntsz);
+		_gfx_con_glyph(c, fntsz);
+		gfx_con.x += fntsz;
+	}
+	else if (c == '\n')
+		_gfx_con_newline(fntsz);
+}
+
+u32 gfx_con_scrollback(u32 back)
+{
+	u32 end = gfx_con.scroll_end;
+	u32 region_rows = end / 8;
+
+	if (!gfx_con_hist.cells)
+		return 0;
+
+	back = MIN(back / 8, _gfx_con_hist_avail()) * 8;
+	if (back == gfx_con_hist.back)
+		return back;
+
+	// Restore the live region.
+	if (!back)
+	{
+		memcpy(gfx_ctxt.fb, gfx_con_hist.live, end * gfx_ctxt.stride * 4);
+		free(gfx_con_hist.live);
+		gfx_con_hist.live = NULL;
+		gfx_con_hist.back = 0;
+
+		return 0;
+	}
+
+	// Keep the live region, since not everything in it is text.
+	if (!gfx_con_hist.live)
+	{
+		gfx_con_hist.live = (u32 *)malloc(end * gfx_ctxt.stride * 4);
+		memcpy(gfx_con_hist.live, gfx_ctxt.fb, end * gfx_ctxt.stride * 4);
+	}
+	gfx_con_hist.back = back;
+
+	// Draw the region from history. Con state is borrowed to draw the glyphs.
+	gfx_con_t con = gfx_con;
+	_gfx_con_fill_region(0, end, con.bgcol);
+
+	u32 top = gfx_con_hist.top - back / 8;
+	for (u32 row = 0; row < region_rows; row++)
+	{
+		gfx_con_cell_t *cells = gfx_con_hist.cells + ((top + row) % GFX_CON_HIST_ROWS) * gfx_con_hist.cols;
+		for (u32 col = 0; col < gfx_con_hist.cols; col++)
 		{
-			gfx_con.x = 0;
-			gfx_con.y += 8;
-			if (gfx_con.y > gfx_ctxt.height - 8)
-				gfx_con.y = 0;
+			gfx_con_cell_t *cell = &cells[col];
+			if (!cell->c)
+				continue;
+
+			u32 fntsz = (cell->c & GFX_CON_CELL_BIG) ? 16 : 8;
+			if (row * 8 + fntsz > end)
+				continue;
+
+			gfx_con.x = col * 8;
+			gfx_con.y = row * 8;
+			gfx_con.fgcol = gfx_con_hist.pal[cell->fg];
+			gfx_con.fillbg = cell->bg != GFX_CON_BG_NONE;
+			gfx_con.bgcol = gfx_con.fillbg ? gfx_con_hist.pal[cell->bg] : 0;
+			_gfx_con_glyph(cell->c & ~GFX_CON_CELL_BIG, fntsz);
 		}
-		break;
 	}
+	gfx_con = con;
+
+	return back;
 }
 
 void gfx_puts(const char *s)
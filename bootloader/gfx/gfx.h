@@ -61,6 +61,7 @@ typedef struct _gfx_con_t
 	int fillbg;
 	u32 bgcol;
 	bool mute;
+	u32 scroll_end;
 } gfx_con_t;
 
 // Global gfx console and context.
@@ -73,6 +74,9 @@ void gfx_clear_partial_grey(u8 color, u32 pos_x, u32 height);
 void gfx_clear_color(u32 color);
 void gfx_con_init();
 void gfx_con_setcol(u32 fgcol, int fillbg, u32 bgcol);
+void gfx_con_set_scroll_end(u32 y);
+// Shows the console as it was back pixel rows ago. 0 shows the live console. Returns the rows shown back.
+u32  gfx_con_scrollback(u32 back);
 void gfx_con_getpos(u32 *x, u32 *y);
 void gfx_con_setpos(u32 x, u32 y);
 void gfx_putc(char c);
@@ -84,6 +84,37 @@ void tui_pbar(int x, int y, u32 val, u32 fgcol, u32 bgcol)
 	tui_sbar(false);
 }
 
+// Waits for a button. VOL+ pages back through console history and VOL- forward.
+u32 tui_pager_wait()
+{
+	u32 page = (gfx_con.scroll_end * 3 / 4) & ~15;
+	u32 back = 0;
+
+	while (true)
+	{
+		u32 btn = btn_wait();
+
+		if (btn & BTN_VOL_UP)
+		{
+			u32 shown = gfx_con_scrollback(back + page);
+			if (shown)
+			{
+				back = shown;
+				continue;
+			}
+		}
+		else if (btn & BTN_VOL_DOWN && back)
+		{
+			back = gfx_con_scrollback(back - MIN(back, page));
+			continue;
+		}
+
+		gfx_con_scrollback(0);
+
+		return btn;
+	}
+}
+
 void *tui_do_menu(menu_t *menu)
 {
 	int idx = 0, prev_idx = 0, cnt = 0x7FFFFFFF;
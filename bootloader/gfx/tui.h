@@ -61,5 +61,6 @@ typedef struct _menu_t
 void tui_sbar(bool force_update);
 void tui_pbar(int x, int y, u32 val, u32 fgcol, u32 bgcol);
 void *tui_do_menu(menu_t *menu);
+u32 tui_pager_wait();
 
 #endif
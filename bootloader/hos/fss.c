@@ -38,6 +38,10 @@ extern bool is_ipl_updated(void *buf, char *path, bool force);
 #define FSS0_META_OFFSET 0x4
 #define FSS0_VERSION_0_17_0 0x110000
 
+#define FSS0_HDR_SIZE      0x400
+#define FSS0_MAX_CONTENTS  (FSS0_HDR_SIZE / sizeof(fss_content_t))
+#define FSS0_CLMT_SIZE     SZ_4K
+
 // FSS0 Content Types.
 #define CNT_TYPE_FSP 0
 #define CNT_TYPE_EXO 1  // Exosphere (Secure Monitor).
@@ -112,6 +116,69 @@ static void _set_fss_path_and_update_r2p(launch_ctxt_t *ctxt, const char *path)
 	free(r2p_path);
 }
 
+static bool _fss_content_needed(fss_content_t *cnt, bool stock, bool experimental)
+{
+	// If content is experimental and experimental config is not enabled, skip it.
+	if ((cnt->flags0 & CNT_FLAG0_EXPERIMENTAL) && !experimental)
+		return false;
+
+	switch (cnt->type)
+	{
+	case CNT_TYPE_KIP:
+	case CNT_TYPE_KRN:
+		return !stock;
+
+	case CNT_TYPE_EXO:
+	case CNT_TYPE_EXF:
+		return true;
+
+	case CNT_TYPE_WBT:
+		return !h_cfg.t210b01;
+
+	default:
+		return false;
+	}
+}
+
+static bool _fss_read_contents(FIL *fp, fss_content_t **cnts, u32 *dst_off, u32 cnt_num, u8 *buf)
+{
+	// Create cluster link map table, so that every seek is cheap.
+	DWORD *clmt = (DWORD *)malloc(FSS0_CLMT_SIZE);
+	clmt[0] = FSS0_CLMT_SIZE / sizeof(DWORD);
+	fp->cltbl = clmt;
+	if (f_lseek(fp, CREATE_LINKMAP))
+		fp->cltbl = NULL; // Too fragmented. Fallback to normal seeking.
+
+	// Read contents in ascending order and merge adjacent or overlapping ones into a single read.
+	bool res = true;
+	u32 i = 0;
+	while (i < cnt_num)
+	{
+		u32 run_off = cnts[i]->offset;
+		u32 run_end = cnts[i]->offset + cnts[i]->size;
+		u32 run_dst = dst_off[i];
+
+		for (i++; i < cnt_num && cnts[i]->offset <= run_end; i++)
+			run_end = MAX(run_end, cnts[i]->offset + cnts[i]->size);
+
+		if (f_lseek(fp, run_off) || f_read(fp, buf + run_dst, run_end - run_off, NULL))
+		{
+			res = false;
+			break;
+		}
+	}
+
+	fp->cltbl = NULL;
+	free(clmt);
+
+	return res;
+}
+
+bool fss_is_content(launch_ctxt_t *ctxt, void *buf)
+{
+	return ctxt->fss0 && (u8 *)buf >= (u8 *)ctxt->fss0 && (u8 *)buf < ((u8 *)ctxt->fss0 + ctxt->fss0_size);
+}
+
 int parse_fss(launch_ctxt_t *ctxt, const char *path)
 {
 	FIL fp;
@@ -146,98 +213,148 @@ int parse_fss(launch_ctxt_t *ctxt, const char *path)
 	if (f_open(&fp, path, FA_READ) != FR_OK)
 		return 0;
 
-	void *fss = malloc(f_size(&fp));
+	u8 *fss_hdr = malloc(FSS0_HDR_SIZE);
+	u32 fss_size = f_size(&fp);
 
 	// Read first 1024 bytes of the FSS0 file.
-	f_read(&fp, fss, 1024, NULL);
+	if (f_read(&fp, fss_hdr, FSS0_HDR_SIZE, NULL))
+		goto out;
 
 	// Get FSS0 Meta header offset.
-	u32 fss_meta_addr = *(u32 *)(fss + FSS0_META_OFFSET);
-	fss_meta_t *fss_meta = (fss_meta_t *)(fss + fss_meta_addr);
+	u32 fss_meta_addr = *(u32 *)(fss_hdr + FSS0_META_OFFSET);
+	if (fss_meta_addr > (FSS0_HDR_SIZE - sizeof(fss_meta_t)))
+		goto out;
+
+	fss_meta_t *fss_meta = (fss_meta_t *)(fss_hdr + fss_meta_addr);
 
 	// Check if valid FSS0 and parse it.
-	if (fss_meta->magic == FSS0_MAGIC)
+	if (fss_meta->magic != FSS0_MAGIC || fss_meta->cnt_off > (FSS0_HDR_SIZE - sizeof(fss_content_t)))
+		goto out;
+
+	gfx_printf("Found FSS/PK3, Atmosphere %d.%d.%d-%08x\n"
+		"Max HOS: %d.%d.%d\n"
+		"Unpacking..  ",
+		fss_meta->version >> 24, (fss_meta->version >> 16) & 0xFF, (fss_meta->version >> 8) & 0xFF, fss_meta->git_rev,
+		fss_meta->hos_ver >> 24, (fss_meta->hos_ver >> 16) & 0xFF, (fss_meta->hos_ver >> 8) & 0xFF);
+
+	// Select needed contents.
+	fss_content_t *curr_fss_cnt = (fss_content_t *)(fss_hdr + fss_meta->cnt_off);
+	u32 cnt_count = MIN(fss_meta->cnt_count, (FSS0_HDR_SIZE - fss_meta->cnt_off) / sizeof(fss_content_t));
+	fss_content_t *cnts[FSS0_MAX_CONTENTS];
+	u32 dst_off[FSS0_MAX_CONTENTS];
+	u32 cnt_num = 0;
+	for (u32 i = 0; i < cnt_count; i++)
 	{
-		gfx_printf("Found FSS/PK3, Atmosphere %d.%d.%d-%08x\n"
-			"Max HOS: %d.%d.%d\n"
-			"Unpacking..  ",
-			fss_meta->version >> 24, (fss_meta->version >> 16) & 0xFF, (fss_meta->version >> 8) & 0xFF, fss_meta->git_rev,
-			fss_meta->hos_ver >> 24, (fss_meta->hos_ver >> 16) & 0xFF, (fss_meta->hos_ver >> 8) & 0xFF);
-
-		ctxt->atmosphere = true;
-		ctxt->fss0_hosver = fss_meta->hos_ver;
-
-		// Parse FSS0 contents.
-		fss_content_t *curr_fss_cnt = (fss_content_t *)(fss + fss_meta->cnt_off);
-		void *content;
-		for (u32 i = 0; i < fss_meta->cnt_count; i++)
+		// Check if offset is inside limits.
+		if ((curr_fss_cnt[i].offset + curr_fss_cnt[i].size) > MIN(fss_meta->size, fss_size) ||
+			(curr_fss_cnt[i].offset + curr_fss_cnt[i].size) < curr_fss_cnt[i].offset)
+			continue;
+
+		if (!_fss_content_needed(&curr_fss_cnt[i], stock, experimental))
+			continue;
+
+		// Insert sorted by offset.
+		u32 pos = cnt_num;
+		while (pos && cnts[pos - 1]->offset > curr_fss_cnt[i].offset)
 		{
-			content = (void *)(fss + curr_fss_cnt[i].offset);
-
-			// Check if offset is inside limits.
-			if ((curr_fss_cnt[i].offset + curr_fss_cnt[i].size) > fss_meta->size)
-				continue;
-
-			// If content is experimental and experimental config is not enabled, skip it.
-			if ((curr_fss_cnt[i].flags0 & CNT_FLAG0_EXPERIMENTAL) && !experimental)
-				continue;
-
-			// Prepare content.
-			switch (curr_fss_cnt[i].type)
-			{
-			case CNT_TYPE_KIP:
-				if (stock)
-					continue;
-				merge_kip_t *mkip1 = (merge_kip_t *)malloc(sizeof(merge_kip_t));
-				mkip1->kip1 = content;
-				list_append(&ctxt->kip1_list, &mkip1->link);
-				DPRINTF("Loaded %s.kip1 from FSS0 (size %08X)\n", curr_fss_cnt[i].name, curr_fss_cnt[i].size);
-				break;
+			cnts[pos] = cnts[pos - 1];
+			pos--;
+		}
+		cnts[pos] = &curr_fss_cnt[i];
+		cnt_num++;
+	}
 
-			case CNT_TYPE_KRN:
-				if (stock)
-					continue;
-				ctxt->kernel_size = curr_fss_cnt[i].size;
-				ctxt->kernel = content;
-				break;
+	// Pack selected contents. Merged ones keep their layout and every run keeps its 16B file alignment.
+	u32 buf_size = 0;
+	u32 run_off = 0;
+	u32 run_end = 0;
+	u32 run_dst = 0;
+	for (u32 i = 0; i < cnt_num; i++)
+	{
+		if (!i || cnts[i]->offset > run_end)
+		{
+			run_off = cnts[i]->offset;
+			run_end = run_off;
+			run_dst = ALIGN(buf_size, 0x10) + (run_off & 0xF);
+		}
 
-			case CNT_TYPE_EXO:
-				ctxt->secmon_size = curr_fss_cnt[i].size;
-				ctxt->secmon = content;
-				break;
+		dst_off[i] = run_dst + (cnts[i]->offset - run_off);
+		run_end = MAX(run_end, cnts[i]->offset + cnts[i]->size);
+		buf_size = run_dst + (run_end - run_off);
+	}
 
-			case CNT_TYPE_EXF:
-				ctxt->exofatal_size = curr_fss_cnt[i].size;
-				ctxt->exofatal = content;
-				break;
+	u8 *fss = NULL;
+	if (buf_size)
+	{
+		fss = malloc(buf_size);
+		if (!_fss_read_contents(&fp, cnts, dst_off, cnt_num, fss))
+		{
+			free(fss);
+			gfx_printf("Failed!\n");
+			goto out;
+		}
+	}
+
+	ctxt->atmosphere = true;
+	ctxt->fss0_hosver = fss_meta->hos_ver;
+	ctxt->fss0 = fss;
+	ctxt->fss0_size = buf_size;
 
-			case CNT_TYPE_WBT:
-				if (h_cfg.t210b01)
-					continue;
-				ctxt->warmboot_size = curr_fss_cnt[i].size;
-				ctxt->warmboot = content;
+	// Load contents to launch context in file order.
+	for (u32 i = 0; i < cnt_count; i++)
+	{
+		u32 idx;
+		for (idx = 0; idx < cnt_num; idx++)
+			if (cnts[idx] == &curr_fss_cnt[i])
 				break;
 
-			default:
-				continue;
-			}
+		if (idx == cnt_num)
+			continue;
 
-			// Load content to launch context.
-			f_lseek(&fp, curr_fss_cnt[i].offset);
-			f_read(&fp, content, curr_fss_cnt[i].size, NULL);
+		void *content = fss + dst_off[idx];
+		switch (curr_fss_cnt[i].type)
+		{
+		case CNT_TYPE_KIP:
+			DPRINTF("Loaded %s.kip1 from FSS0 (size %08X)\n", curr_fss_cnt[i].name, curr_fss_cnt[i].size);
+			merge_kip_t *mkip1 = (merge_kip_t *)malloc(sizeof(merge_kip_t));
+			mkip1->kip1 = content;
+			list_append(&ctxt->kip1_list, &mkip1->link);
+			break;
+
+		case CNT_TYPE_KRN:
+			ctxt->kernel_size = curr_fss_cnt[i].size;
+			ctxt->kernel = content;
+			break;
+
+		case CNT_TYPE_EXO:
+			ctxt->secmon_size = curr_fss_cnt[i].size;
+			ctxt->secmon = content;
+			break;
+
+		case CNT_TYPE_EXF:
+			ctxt->exofatal_size = curr_fss_cnt[i].size;
+			ctxt->exofatal = content;
+			break;
+
+		case CNT_TYPE_WBT:
+			ctxt->warmboot_size = curr_fss_cnt[i].size;
+			ctxt->warmboot = content;
+			break;
 		}
+	}
 
-		gfx_printf("Done!\n");
-		f_close(&fp);
+	gfx_printf("Done!\n");
+	f_close(&fp);
+	free(fss_hdr);
 
-		// Set FSS0 path and update r2p if needed.
-		_set_fss_path_and_update_r2p(ctxt, path);
+	// Set FSS0 path and update r2p if needed.
+	_set_fss_path_and_update_r2p(ctxt, path);
 
-		return 1;
-	}
+	return 1;
 
+out:
 	f_close(&fp);
-	free(fss);
+	free(fss_hdr);
 
 	return 0;
 }
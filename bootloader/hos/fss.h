@@ -19,6 +19,7 @@
 
 #include "hos.h"
 
-int parse_fss(launch_ctxt_t *ctxt, const char *path);
+int  parse_fss(launch_ctxt_t *ctxt, const char *path);
+bool fss_is_content(launch_ctxt_t *ctxt, void *buf);
 
 #endif
@@ -24,6 +24,8 @@
 
 #include "hos.h"
 #include "hos_config.h"
+#include "fss.h"
+#include "pkg2_cache.h"
 #include "secmon_exo.h"
 #include "../config.h"
 #include "../storage/emummc.h"
@@ -687,21 +689,28 @@ out:
 	return bctBuf;
 }
 
+static void _free_launch_component(launch_ctxt_t *ctxt, void *buf)
+{
+	// FSS0 contents are freed as a whole.
+	if (!fss_is_content(ctxt, buf))
+		free(buf);
+}
+
 static void _free_launch_components(launch_ctxt_t *ctxt)
 {
 	free(ctxt->keyblob);
 	free(ctxt->pkg1);
 	free(ctxt->pkg2);
-	free(ctxt->warmboot);
-	free(ctxt->secmon);
-	free(ctxt->kernel);
+	_free_launch_component(ctxt, ctxt->warmboot);
+	_free_launch_component(ctxt, ctxt->secmon);
+	_free_launch_component(ctxt, ctxt->kernel);
+	free(ctxt->fss0);
 	free(ctxt->kip1_patches);
 }
 
 static bool _get_fs_exfat_compatible(link_t *info, u32 *hos_revision)
 {
 	u32 fs_ids_cnt;
-	u32 sha_buf[32 / sizeof(u32)];
 	kip1_id_t *kip_ids;
 
 	LIST_FOREACH_ENTRY(pkg2_kip1_info_t, ki, info, link)
@@ -709,7 +718,9 @@ static bool _get_fs_exfat_compatible(link_t *info, u32 *hos_revision)
 		if (strncmp((const char*)ki->kip1->name, "FS", sizeof(ki->kip1->name)))
 			continue;
 
-		if (!se_calc_sha256_oneshot(sha_buf, ki->kip1, ki->size))
+		// Hash is reused when patching kips.
+		u8 *sha_buf = pkg2_get_kip_hash(ki);
+		if (!sha_buf)
 			break;
 
 		pkg2_get_ids(&kip_ids, &fs_ids_cnt);
@@ -761,6 +772,8 @@ int hos_launch(ini_sec_t *cfg)
 
 	gfx_puts("Initializing...\n\n");
 
+	u32 prof_start = get_tmr_us();
+
 	// Initialize eMMC/emuMMC.
 	int res = emummc_storage_init_mmc();
 	if (res)
@@ -784,6 +797,8 @@ int hos_launch(ini_sec_t *cfg)
 	if (!_read_emmc_pkg1(&ctxt))
 		goto error;
 
+	boot_prof_add(BOOT_PROF_PKG1_READ, prof_start);
+
 	kb = ctxt.pkg1_id->kb;
 
 	// Try to parse config if present.
@@ -849,6 +864,7 @@ int hos_launch(ini_sec_t *cfg)
 	warmboot_base = is_exo ? pk1_latest->warmboot_base : ctxt.pkg1_id->warmboot_base;
 
 	// Generate keys.
+	prof_start = get_tmr_us();
 	tsec_ctxt.fw = (u8 *)ctxt.pkg1 + ctxt.pkg1_id->tsec_off;
 	tsec_ctxt.pkg1 = ctxt.pkg1;
 	tsec_ctxt.pkg11_off = ctxt.pkg1_id->pkg11_off;
@@ -858,6 +874,8 @@ int hos_launch(ini_sec_t *cfg)
 		goto error;
 	gfx_puts("Generated keys\n");
 
+	boot_prof_add(BOOT_PROF_KEYGEN, prof_start);
+
 	// Decrypt and unpack package1 if we require parts of it.
 	if (!ctxt.warmboot || !ctxt.secmon)
 	{
@@ -940,6 +958,7 @@ int hos_launch(ini_sec_t *cfg)
 	gfx_puts("Loaded warmboot and secmon\n");
 
 	// Read package2.
+	prof_start = get_tmr_us();
 	u8 *bootConfigBuf = _read_emmc_pkg2(&ctxt);
 	if (!bootConfigBuf)
 	{
@@ -949,6 +968,33 @@ int hos_launch(ini_sec_t *cfg)
 
 	gfx_puts("Read pkg2\n");
 
+	// Try to reuse the patched kernel and KIP1s of a previous identical launch.
+	LIST_INIT(kip1_info);
+	u8 cache_key[SE_SHA_256_SIZE];
+	pkg2_cache_state_t cache_state = { 0, true };
+	if (ctxt.pkg2_cache)
+	{
+		pkg2_cache_calc_key(cache_key, &ctxt, kb, emummc_enabled);
+		if (pkg2_cache_load(cache_key, &ctxt, &kip1_info, &cache_state))
+		{
+			if (!ctxt.stock && sd_fs.fs_type == FS_EXFAT && !cache_state.exfat_compat)
+			{
+				_hos_crit_error("SD Card is exFAT but installed HOS driver\nonly supports FAT32!");
+
+				_free_launch_components(&ctxt);
+				goto error;
+			}
+
+			emu_cfg.fs_ver = cache_state.fs_ver;
+
+			gfx_puts("Loaded pkg2 cache\n");
+
+			// Covers what pkg2 decrypt and KIP patching take on a miss.
+			boot_prof_add(BOOT_PROF_PKG2_CACHE, prof_start);
+			goto build_pkg2;
+		}
+	}
+
 	// Decrypt package2 and parse KIP1 blobs in INI1 section.
 	pkg2_hdr_t *pkg2_hdr = pkg2_decrypt(ctxt.pkg2, kb, is_exo);
 	if (!pkg2_hdr)
@@ -960,7 +1006,6 @@ int hos_launch(ini_sec_t *cfg)
 		goto error;
 	}
 
-	LIST_INIT(kip1_info);
 	if (!pkg2_parse_kips(&kip1_info, pkg2_hdr, &ctxt.new_pkg2))
 	{
 		_hos_crit_error("INI1 parsing failed!");
@@ -969,6 +1014,9 @@ int hos_launch(ini_sec_t *cfg)
 
 	gfx_puts("Parsed ini1\n");
 
+	boot_prof_add(BOOT_PROF_PKG2_DECRYPT, prof_start);
+	prof_start = get_tmr_us();
+
 	// Use the kernel included in package2 in case we didn't load one already.
 	if (!ctxt.kernel)
 	{
@@ -1025,9 +1073,9 @@ int hos_launch(ini_sec_t *cfg)
 	// Check if FS is compatible with exFAT and if 5.1.0.
 	if (!ctxt.stock && (sd_fs.fs_type == FS_EXFAT || kb == KB_FIRMWARE_VERSION_500))
 	{
-		bool exfat_compat = _get_fs_exfat_compatible(&kip1_info, &ctxt.exo_ctx.hos_revision);
+		cache_state.exfat_compat = _get_fs_exfat_compatible(&kip1_info, &ctxt.exo_ctx.hos_revision);
 
-		if (sd_fs.fs_type == FS_EXFAT && !exfat_compat)
+		if (sd_fs.fs_type == FS_EXFAT && !cache_state.exfat_compat)
 		{
 			_hos_crit_error("SD Card is exFAT but installed HOS driver\nonly supports FAT32!");
 
@@ -1058,13 +1106,29 @@ int hos_launch(ini_sec_t *cfg)
 		}
 	}
 
+	// Save patched components only if all patches were applied.
+	boot_prof_add(BOOT_PROF_KIP_PATCH, prof_start);
+
+	if (ctxt.pkg2_cache && !unappliedPatch)
+	{
+		prof_start = get_tmr_us();
+		cache_state.fs_ver = emu_cfg.fs_ver;
+		pkg2_cache_save(cache_key, &ctxt, &kip1_info, &cache_state);
+		boot_prof_add(BOOT_PROF_PKG2_CACHE, prof_start);
+	}
+
+build_pkg2:
 	// Rebuild and encrypt package2.
+	prof_start = get_tmr_us();
 	pkg2_build_encrypt((void *)PKG2_LOAD_ADDR, &ctxt, &kip1_info, is_exo);
 
 	// Configure Exosphere if secmon is replaced.
 	if (is_exo)
 		config_exosphere(&ctxt, warmboot_base);
 
+	boot_prof_add(BOOT_PROF_PKG2_BUILD, prof_start);
+	prof_start = get_tmr_us();
+
 	// Unmount SD card and eMMC.
 	sd_end();
 	sdmmc_storage_end(&emmc_storage);
@@ -1161,6 +1225,9 @@ int hos_launch(ini_sec_t *cfg)
 	if (ctxt.stock)
 		minerva_prep_boot_freq();
 
+	// Last timeline entry. It gets flushed to DRAM with the cache below.
+	boot_prof_add(BOOT_PROF_HANDOFF, prof_start);
+
 	// Flush cache and disable MMU.
 	bpmp_mmu_disable();
 	bpmp_clk_rate_set(BPMP_CLK_NORMAL);
@@ -102,7 +102,10 @@ typedef struct _launch_ctxt_t
 	bool debugmode;
 	bool stock;
 	bool emummc_forced;
+	bool pkg2_cache;
 
+	void *fss0;
+	u32   fss0_size;
 	char *fss0_main_path;
 	u32   fss0_hosver;
 	bool  atmosphere;
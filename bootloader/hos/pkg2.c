@@ -60,12 +60,40 @@ enum kip_offset_section
 static kip1_id_t *_kip_id_sets = _kip_ids;
 static u32 _kip_id_sets_cnt = ARRAY_SIZE(_kip_ids);
 
+typedef struct _kip1_id_bucket_t
+{
+	const char *name;
+	u16 start;
+	u16 count;
+} kip1_id_bucket_t;
+
+// KIP ids grouped by name. Order inside a group is the same as in the id sets.
+static kip1_id_bucket_t *_kip_id_buckets = NULL;
+static u16 *_kip_id_order = NULL;
+static u32 _kip_id_buckets_cnt = 0;
+static u32 _kip_id_indexed_cnt = 0;
+
 void pkg2_get_ids(kip1_id_t **ids, u32 *entries)
 {
 	*ids = _kip_id_sets;
 	*entries = _kip_id_sets_cnt;
 }
 
+static kip1_patch_t *_pkg2_ext_patches_alloc(link_t *pts, ini_patchset_t *first_pt)
+{
+	// Count patches with the same name. Plus one for the terminator.
+	u32 patches_cnt = 1;
+	for (link_t *l = &first_pt->link; l != pts; l = l->next)
+	{
+		ini_patchset_t *pt = CONTAINER_OF(l, ini_patchset_t, link);
+		if (strcmp(pt->name, first_pt->name))
+			break;
+		patches_cnt++;
+	}
+
+	return (kip1_patch_t *)calloc(sizeof(kip1_patch_t), patches_cnt);
+}
+
 static void parse_external_kip_patches()
 {
 	static bool ext_patches_parsed = false;
@@ -74,10 +102,14 @@ static void parse_external_kip_patches()
 		return;
 
 	LIST_INIT(ini_kip_sections);
-	if (ini_patch_parse(&ini_kip_sections, "bootloader/patches.ini"))
+	if (ini_patch_parse_cached(&ini_kip_sections, "bootloader/patches.ini", "bootloader/sys/patches.bin"))
 	{
-		// Copy ids into a new patchset.
-		_kip_id_sets = calloc(sizeof(kip1_id_t), 256); // Max 256 kip ids.
+		// Copy ids into a new patchset, sized for the worst case of all sections being new ids.
+		u32 sec_cnt = 0;
+		LIST_FOREACH_ENTRY(ini_kip_sec_t, ini_psec, &ini_kip_sections, link)
+			sec_cnt++;
+
+		_kip_id_sets = calloc(sizeof(kip1_id_t), ARRAY_SIZE(_kip_ids) + sec_cnt + 1);
 		memcpy(_kip_id_sets, _kip_ids, sizeof(_kip_ids));
 
 		// Parse patchsets and glue them together.
@@ -114,7 +146,20 @@ static void parse_external_kip_patches()
 				_kip_id_sets_cnt++;
 			}
 
-			kip1_patchset_t *patchsets = (kip1_patchset_t *)calloc(sizeof(kip1_patchset_t), 16); // Max 16 patchsets per kip.
+			// Count patchsets. Each new name in the section is a new set.
+			u32 patchsets_cnt = 0;
+			for (; curr_kip->patchset[patchsets_cnt].name != NULL; patchsets_cnt++)
+				;
+
+			const char *prev_name = NULL;
+			LIST_FOREACH_ENTRY(ini_patchset_t, pt, &ini_psec->pts, link)
+			{
+				if (!prev_name || strcmp(pt->name, prev_name))
+					patchsets_cnt++;
+				prev_name = pt->name;
+			}
+
+			kip1_patchset_t *patchsets = (kip1_patchset_t *)calloc(sizeof(kip1_patchset_t), patchsets_cnt + 2); // Plus terminator. Empty sections skip one.
 
 			u32 curr_patchset_idx;
 			for(curr_patchset_idx = 0; curr_kip->patchset[curr_patchset_idx].name != NULL; curr_patchset_idx++)
@@ -128,21 +173,17 @@ static void parse_external_kip_patches()
 			u32 curr_patch_idx = 0;
 
 			// Parse patches and glue them together to a patchset.
-			kip1_patch_t *patches = calloc(sizeof(kip1_patch_t), 32); // Max 32 patches per set.
+			kip1_patch_t *patches = NULL;
 			LIST_FOREACH_ENTRY(ini_patchset_t, pt, &ini_psec->pts, link)
 			{
-				if (first_ext_patch)
-				{
-					first_ext_patch = false;
-					patchsets[curr_patchset_idx].name = pt->name;
-					patchsets[curr_patchset_idx].patches = patches;
-				}
-				else if (strcmp(pt->name, patchsets[curr_patchset_idx].name))
+				if (first_ext_patch || strcmp(pt->name, patchsets[curr_patchset_idx].name))
 				{
 					// New patchset name found, create a new set.
-					curr_patchset_idx++;
+					if (!first_ext_patch)
+						curr_patchset_idx++;
+					first_ext_patch = false;
 					curr_patch_idx = 0;
-					patches = calloc(sizeof(kip1_patch_t), 32); // Max 32 patches per set.
+					patches = _pkg2_ext_patches_alloc(&ini_psec->pts, pt);
 
 					patchsets[curr_patchset_idx].name = pt->name;
 					patchsets[curr_patchset_idx].patches = patches;
@@ -170,6 +211,72 @@ static void parse_external_kip_patches()
 	ext_patches_parsed = true;
 }
 
+static void _pkg2_kip_ids_index()
+{
+	// Rebuild only if external patches added new ids.
+	if (_kip_id_buckets && _kip_id_indexed_cnt == _kip_id_sets_cnt)
+		return;
+
+	free(_kip_id_buckets);
+	free(_kip_id_order);
+	_kip_id_buckets = (kip1_id_bucket_t *)malloc(sizeof(kip1_id_bucket_t) * _kip_id_sets_cnt);
+	_kip_id_order = (u16 *)malloc(sizeof(u16) * _kip_id_sets_cnt);
+
+	_kip_id_buckets_cnt = 0;
+	u32 order_idx = 0;
+	for (u32 i = 0; i < _kip_id_sets_cnt; i++)
+	{
+		// Skip ids already added by a previous one with the same name.
+		u32 bucket_idx;
+		for (bucket_idx = 0; bucket_idx < _kip_id_buckets_cnt; bucket_idx++)
+			if (!strcmp(_kip_id_buckets[bucket_idx].name, _kip_id_sets[i].name))
+				break;
+
+		if (bucket_idx != _kip_id_buckets_cnt)
+			continue;
+
+		kip1_id_bucket_t *bucket = &_kip_id_buckets[_kip_id_buckets_cnt++];
+		bucket->name = _kip_id_sets[i].name;
+		bucket->start = order_idx;
+		bucket->count = 0;
+		for (u32 j = i; j < _kip_id_sets_cnt; j++)
+		{
+			if (!strcmp(_kip_id_sets[j].name, bucket->name))
+			{
+				_kip_id_order[order_idx++] = j;
+				bucket->count++;
+			}
+		}
+	}
+
+	_kip_id_indexed_cnt = _kip_id_sets_cnt;
+}
+
+static kip1_id_bucket_t *_pkg2_kip_ids_find(pkg2_kip1_t *kip1)
+{
+	for (u32 i = 0; i < _kip_id_buckets_cnt; i++)
+		if (!strncmp((const char *)kip1->name, _kip_id_buckets[i].name, sizeof(kip1->name)))
+			return &_kip_id_buckets[i];
+
+	return NULL;
+}
+
+u8 *pkg2_get_kip_hash(pkg2_kip1_info_t *ki)
+{
+	// Hash is calculated once per loaded KIP1 and reused by all identifications.
+	if (!ki->hashed)
+	{
+		u32 sha_buf[SE_SHA_256_SIZE / sizeof(u32)];
+		if (!se_calc_sha256_oneshot(sha_buf, ki->kip1, ki->size))
+			return NULL;
+
+		memcpy(ki->hash, sha_buf, sizeof(ki->hash));
+		ki->hashed = true;
+	}
+
+	return ki->hash;
+}
+
 const pkg2_kernel_id_t *pkg2_identify(u8 *hash)
 {
 	for (u32 i = 0; i < ARRAY_SIZE(_pkg2_kernel_ids); i++)
@@ -180,7 +287,74 @@ const pkg2_kernel_id_t *pkg2_identify(u8 *hash)
 	return NULL;
 }
 
-static u32 _pkg2_calc_kip1_size(pkg2_kip1_t *kip1)
+static u32 _pkg2_patches_put(u8 *buf, u32 pos, const void *src, u32 size)
+{
+	if (buf)
+		memcpy(buf + pos, src, size);
+
+	return pos + size;
+}
+
+// Writes the contents of the built-in patch tables. Returns the size, and only counts it if buf is NULL.
+static u32 _pkg2_patches_serialize(u8 *buf)
+{
+	const u32 end = 0;
+	u32 pos = 0;
+
+	// FS patches.
+	for (u32 i = 0; i < ARRAY_SIZE(_kip_ids); i++)
+	{
+		const kip1_id_t *kip_id = &_kip_ids[i];
+		pos = _pkg2_patches_put(buf, pos, kip_id->name, strlen(kip_id->name) + 1);
+		pos = _pkg2_patches_put(buf, pos, kip_id->hash, sizeof(kip_id->hash));
+
+		for (const kip1_patchset_t *ps = kip_id->patchset; ps && ps->name; ps++)
+		{
+			pos = _pkg2_patches_put(buf, pos, ps->name, strlen(ps->name) + 1);
+			for (const kip1_patch_t *p = ps->patches; p && p->length; p++)
+			{
+				pos = _pkg2_patches_put(buf, pos, &p->offset, sizeof(p->offset));
+				pos = _pkg2_patches_put(buf, pos, &p->length, sizeof(p->length));
+				pos = _pkg2_patches_put(buf, pos, p->srcData, p->length);
+				pos = _pkg2_patches_put(buf, pos, p->dstData, p->length);
+			}
+			pos = _pkg2_patches_put(buf, pos, &end, sizeof(end));
+		}
+		pos = _pkg2_patches_put(buf, pos, &end, sizeof(end));
+	}
+
+	// Kernel patches.
+	for (u32 i = 0; i < ARRAY_SIZE(_pkg2_kernel_ids); i++)
+	{
+		const pkg2_kernel_id_t *kern_id = &_pkg2_kernel_ids[i];
+		pos = _pkg2_patches_put(buf, pos, kern_id->hash, sizeof(kern_id->hash));
+
+		for (const kernel_patch_t *kp = kern_id->kernel_patchset; kp && kp->id != 0xFFFFFFFF; kp++)
+		{
+			pos = _pkg2_patches_put(buf, pos, &kp->id, sizeof(kp->id));
+			pos = _pkg2_patches_put(buf, pos, &kp->off, sizeof(kp->off));
+			pos = _pkg2_patches_put(buf, pos, &kp->val, sizeof(kp->val));
+			if (kp->id == ATM_ARR_PATCH)
+				pos = _pkg2_patches_put(buf, pos, kp->ptr, kp->val << 2);
+		}
+		pos = _pkg2_patches_put(buf, pos, &end, sizeof(end));
+	}
+
+	return pos;
+}
+
+void pkg2_calc_patches_hash(u8 *hash)
+{
+	u32 size = _pkg2_patches_serialize(NULL);
+	u8 *buf = (u8 *)malloc(size);
+
+	_pkg2_patches_serialize(buf);
+	se_calc_sha256_oneshot(hash, buf, size);
+
+	free(buf);
+}
+
+u32 pkg2_calc_kip1_size(pkg2_kip1_t *kip1)
 {
 	u32 size = sizeof(pkg2_kip1_t);
 	for (u32 j = 0; j < KIP1_NUM_SECTIONS; j++)
@@ -242,7 +416,8 @@ bool pkg2_parse_kips(link_t *info, pkg2_hdr_t *pkg2, bool *new_pkg2)
 		pkg2_kip1_t *kip1 = (pkg2_kip1_t *)ptr;
 		pkg2_kip1_info_t *ki = (pkg2_kip1_info_t *)malloc(sizeof(pkg2_kip1_info_t));
 		ki->kip1 = kip1;
-		ki->size = _pkg2_calc_kip1_size(kip1);
+		ki->size = pkg2_calc_kip1_size(kip1);
+		ki->hashed = false;
 		list_append(info, &ki->link);
 		ptr += ki->size;
 DPRINTF(" kip1 %d:%s @ %08X (%08X)\n", i, kip1->name, (u32)kip1, ki->size);
@@ -266,7 +441,8 @@ void pkg2_replace_kip(link_t *info, u64 tid, pkg2_kip1_t *kip1)
 		if (ki->kip1->tid == tid)
 		{
 			ki->kip1 = kip1;
-			ki->size = _pkg2_calc_kip1_size(kip1);
+			ki->size = pkg2_calc_kip1_size(kip1);
+			ki->hashed = false;
 DPRINTF("replaced kip %s (new size %08X)\n", kip1->name, ki->size);
 			return;
 		}
@@ -277,7 +453,8 @@ void pkg2_add_kip(link_t *info, pkg2_kip1_t *kip1)
 {
 	pkg2_kip1_info_t *ki = (pkg2_kip1_info_t *)malloc(sizeof(pkg2_kip1_info_t));
 	ki->kip1 = kip1;
-	ki->size = _pkg2_calc_kip1_size(kip1);
+	ki->size = pkg2_calc_kip1_size(kip1);
+	ki->hashed = false;
 DPRINTF("added kip %s (size %08X)\n", kip1->name, ki->size);
 	list_append(info, &ki->link);
 }
@@ -487,14 +664,18 @@ const char* pkg2_patch_kips(link_t *info, char* patchNames)
 		}
 	}
 
-	u32 shaBuf[SE_SHA_256_SIZE / sizeof(u32)];
+	_pkg2_kip_ids_index();
+
 	LIST_FOREACH_ENTRY(pkg2_kip1_info_t, ki, info, link)
 	{
-		shaBuf[0] = 0; // sha256 for this kip not yet calculated.
-		for (u32 currKipIdx = 0; currKipIdx < _kip_id_sets_cnt; currKipIdx++)
+		// Get ids with the same name.
+		kip1_id_bucket_t *bucket = _pkg2_kip_ids_find(ki->kip1);
+		if (!bucket)
+			continue;
+
+		for (u32 bucketIdx = 0; bucketIdx < bucket->count; bucketIdx++)
 		{
-			if (strncmp((const char*)ki->kip1->name, _kip_id_sets[currKipIdx].name, sizeof(ki->kip1->name)) != 0)
-				continue;
+			u32 currKipIdx = _kip_id_order[bucket->start + bucketIdx];
 
 			u32 bitsAffected = 0;
 			kip1_patchset_t* currPatchset = _kip_id_sets[currKipIdx].patchset;
@@ -516,13 +697,8 @@ const char* pkg2_patch_kips(link_t *info, char* patchNames)
 			if (bitsAffected == 0)
 				continue;
 
-			if (shaBuf[0] == 0)
-			{
-				if (!se_calc_sha256_oneshot(shaBuf, ki->kip1, ki->size))
-					memset(shaBuf, 0, sizeof(shaBuf));
-			}
-
-			if (memcmp(shaBuf, _kip_id_sets[currKipIdx].hash, sizeof(_kip_id_sets[0].hash)) != 0)
+			u8 *kip_hash = pkg2_get_kip_hash(ki);
+			if (!kip_hash || memcmp(kip_hash, _kip_id_sets[currKipIdx].hash, sizeof(_kip_id_sets[0].hash)) != 0)
 				continue;
 
 			// Find out which sections are affected by the enabled patches, to know which to decompress.
@@ -702,6 +878,18 @@ DPRINTF("sec %d has size %08X\n", i, hdr->sec_size[i]);
 	return hdr;
 }
 
+static void _pkg2_ctr_add(u8 *dst, const u8 *ctr, u32 blocks)
+{
+	// Big endian 128-bit add.
+	u32 carry = blocks;
+	for (int i = SE_AES_IV_SIZE - 1; i >= 0; i--)
+	{
+		carry += ctr[i];
+		dst[i] = carry & 0xFF;
+		carry >>= 8;
+	}
+}
+
 static u32 _pkg2_ini1_build(u8 *pdst, pkg2_hdr_t *hdr, link_t *kips_info, bool new_pkg2)
 {
 	u32 ini1_size = sizeof(pkg2_ini1_t);
@@ -783,21 +971,39 @@ DPRINTF("%s @ %08X (%08X)\n", is_meso ? "Mesosphere": "kernel",(u32)ctxt->kernel
 
 	pdst += sizeof(pkg2_hdr_t);
 
-	// Kernel.
-	memcpy(pdst, ctxt->kernel, kernel_size);
+	// Kernel. Encrypted straight from its buffer into its final offset.
+	u8 *kernel_ctr = &hdr->sec_ctr[PKG2_SEC_KERNEL * SE_AES_IV_SIZE];
 	if (!ctxt->new_pkg2)
+	{
 		hdr->sec_off[PKG2_SEC_KERNEL] = 0x10000000;
+		se_aes_crypt_ctr(pkg2_keyslot, pdst, kernel_size, ctxt->kernel, kernel_size, kernel_ctr);
+	}
 	else
 	{
-		// Set new INI1 offset to kernel.
-		*(u32 *)(pdst + (is_meso ? 8 : pkg2_newkern_ini1_val)) = kernel_size;
+		// Encrypt the block aligned part. The rest is encrypted together with INI1.
+		u32 kernel_size_aligned = kernel_size & ~(SE_AES_BLOCK_SIZE - 1);
+		se_aes_crypt_ctr(pkg2_keyslot, pdst, kernel_size_aligned, ctxt->kernel, kernel_size_aligned, kernel_ctr);
+		memcpy(pdst + kernel_size_aligned, ctxt->kernel + kernel_size_aligned, kernel_size - kernel_size_aligned);
+
+		// Set new INI1 offset to kernel. If it is already encrypted, XOR in the change, since CTR is a XOR stream.
+		u32 ini1_off = is_meso ? 8 : pkg2_newkern_ini1_val;
+		u32 *ini1_val = (u32 *)(pdst + ini1_off);
+		if (ini1_off < kernel_size_aligned)
+			*ini1_val ^= *(u32 *)(ctxt->kernel + ini1_off) ^ kernel_size;
+		else
+			*ini1_val = kernel_size;
 
 		// Build INI1 for new Package2.
 		kernel_size += _pkg2_ini1_build(pdst + kernel_size, hdr, kips_info, ctxt->new_pkg2);
 		hdr->sec_off[PKG2_SEC_KERNEL] = 0x60000;
+
+		// Continue the kernel CTR stream over the remaining kernel and INI1.
+		u8 ctr[SE_AES_IV_SIZE];
+		u32 tail_size = kernel_size - kernel_size_aligned;
+		_pkg2_ctr_add(ctr, kernel_ctr, kernel_size_aligned / SE_AES_BLOCK_SIZE);
+		se_aes_crypt_ctr(pkg2_keyslot, pdst + kernel_size_aligned, tail_size, pdst + kernel_size_aligned, tail_size, ctr);
 	}
 	hdr->sec_size[PKG2_SEC_KERNEL] = kernel_size;
-	se_aes_crypt_ctr(pkg2_keyslot, pdst, kernel_size, pdst, kernel_size, &hdr->sec_ctr[PKG2_SEC_KERNEL * SE_AES_IV_SIZE]);
 	pdst += kernel_size;
 DPRINTF("kernel encrypted\n");
 
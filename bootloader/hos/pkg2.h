@@ -115,6 +115,8 @@ typedef struct _pkg2_kip1_info_t
 {
 	pkg2_kip1_t *kip1;
 	u32 size;
+	u8  hash[8]; // Hash of the KIP1 as loaded, before any patching.
+	bool hashed;
 	link_t link;
 } pkg2_kip1_info_t;
 
@@ -145,6 +147,7 @@ typedef struct _kip1_id_t
 	kip1_patchset_t* patchset;
 } kip1_id_t;
 
+u32  pkg2_calc_kip1_size(pkg2_kip1_t *kip1);
 void pkg2_get_newkern_info(u8 *kern_data);
 bool pkg2_parse_kips(link_t *info, pkg2_hdr_t *pkg2, bool *new_pkg2);
 int  pkg2_has_kip(link_t *info, u64 tid);
@@ -152,9 +155,11 @@ void pkg2_replace_kip(link_t *info, u64 tid, pkg2_kip1_t *kip1);
 void pkg2_add_kip(link_t *info, pkg2_kip1_t *kip1);
 void pkg2_merge_kip(link_t *info, pkg2_kip1_t *kip1);
 void pkg2_get_ids(kip1_id_t **ids, u32 *entries);
+u8  *pkg2_get_kip_hash(pkg2_kip1_info_t *ki);
 const char* pkg2_patch_kips(link_t *info, char* patchNames);
 
 const pkg2_kernel_id_t *pkg2_identify(u8 *hash);
+void pkg2_calc_patches_hash(u8 *hash);
 pkg2_hdr_t *pkg2_decrypt(void *data, u8 kb, bool is_exo);
 void pkg2_build_encrypt(void *dst, void *hos_ctxt, link_t *kips_info, bool is_exo);
 
@@ -0,0 +1,284 @@
+/*
+ * Package2 launch artifact cache
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <bdk.h>
+
+#include "fss.h"
+#include "hos.h"
+#include "pkg2.h"
+#include "pkg2_cache.h"
+
+#include "../config.h"
+#include <libs/fatfs/ff.h>
+
+//#define DPRINTF(...) gfx_printf(__VA_ARGS__)
+#define DPRINTF(...)
+
+#define PKG2_CACHE_MAX_DATA (SZ_16M - 1) // SE SHA256 oneshot limit.
+#define PKG2_CACHE_MAX_KIPS 64
+
+extern hekate_config h_cfg;
+extern u8 pkg2_keyslot;
+
+enum
+{
+	PKG2_CACHE_KEY_SVCPERM   = BIT(0),
+	PKG2_CACHE_KEY_DEBUGMODE = BIT(1),
+	PKG2_CACHE_KEY_STOCK     = BIT(2),
+	PKG2_CACHE_KEY_ATMOS     = BIT(3),
+	PKG2_CACHE_KEY_EMUMMC    = BIT(4),
+	PKG2_CACHE_KEY_T210B01   = BIT(5),
+	PKG2_CACHE_KEY_EXFAT     = BIT(6),
+	PKG2_CACHE_KEY_SECMON    = BIT(7),
+};
+
+typedef struct _pkg2_cache_key_t
+{
+	u8  pkg2_hash[SE_SHA_256_SIZE];    // Encrypted package2 signature and header.
+	u8  kernel_hash[SE_SHA_256_SIZE];  // Custom kernel. Zero if the package2 one is used.
+	u8  kips_hash[SE_SHA_256_SIZE];    // Hash of all extra KIP1 hashes.
+	u8  patches_hash[SE_SHA_256_SIZE]; // Requested kip1patch list.
+	u8  builtin_hash[SE_SHA_256_SIZE]; // Built-in FS and kernel patches.
+	u32 ipl_ver;
+	u32 kb;
+	u32 fss0_hosver;
+	u32 flags;
+	u32 patches_ini_size;
+	u32 patches_ini_time;
+	u32 kipm_size;
+	u32 kipm_time;
+} pkg2_cache_key_t;
+
+static void _pkg2_cache_file_stamp(const char *path, u32 *size, u32 *time)
+{
+	FILINFO fno;
+
+	*size = 0;
+	*time = 0;
+	if (!f_stat(path, &fno))
+	{
+		*size = fno.fsize;
+		*time = (fno.fdate << 16) | fno.ftime;
+	}
+}
+
+void pkg2_cache_calc_key(u8 *key, launch_ctxt_t *ctxt, u32 kb, bool emummc_enabled)
+{
+	pkg2_cache_key_t *ckey = (pkg2_cache_key_t *)calloc(sizeof(pkg2_cache_key_t), 1);
+
+	// The signed header holds the size and hash of every section, so it identifies the whole package2.
+	se_calc_sha256_oneshot(ckey->pkg2_hash, ctxt->pkg2, MIN(ctxt->pkg2_size, 0x100 + sizeof(pkg2_hdr_t)));
+
+	if (ctxt->kernel)
+		se_calc_sha256_oneshot(ckey->kernel_hash, ctxt->kernel, ctxt->kernel_size);
+
+	// Hash every extra KIP1 in merge order.
+	u32 kip_num = 0;
+	LIST_FOREACH_ENTRY(merge_kip_t, mki, &ctxt->kip1_list, link)
+		kip_num++;
+
+	if (kip_num)
+	{
+		u8 *kip_hashes = (u8 *)malloc(kip_num * SE_SHA_256_SIZE);
+		u32 idx = 0;
+		LIST_FOREACH_ENTRY(merge_kip_t, mki, &ctxt->kip1_list, link)
+		{
+			pkg2_kip1_t *kip1 = (pkg2_kip1_t *)mki->kip1;
+			se_calc_sha256_oneshot(&kip_hashes[idx * SE_SHA_256_SIZE], kip1, pkg2_calc_kip1_size(kip1));
+			idx++;
+		}
+		se_calc_sha256_oneshot(ckey->kips_hash, kip_hashes, kip_num * SE_SHA_256_SIZE);
+		free(kip_hashes);
+	}
+
+	if (ctxt->kip1_patches)
+		se_calc_sha256_oneshot(ckey->patches_hash, ctxt->kip1_patches, strlen(ctxt->kip1_patches));
+
+	// A bootloader update can add or fix patches for an already cached firmware.
+	pkg2_calc_patches_hash(ckey->builtin_hash);
+	ckey->ipl_ver = (BL_VER_MJ << 16) | (BL_VER_MN << 8) | BL_VER_HF;
+
+	ckey->kb = kb;
+	ckey->fss0_hosver = ctxt->fss0_hosver;
+	ckey->flags = (ctxt->svcperm    ? PKG2_CACHE_KEY_SVCPERM   : 0) |
+				  (ctxt->debugmode  ? PKG2_CACHE_KEY_DEBUGMODE : 0) |
+				  (ctxt->stock      ? PKG2_CACHE_KEY_STOCK     : 0) |
+				  (ctxt->atmosphere ? PKG2_CACHE_KEY_ATMOS     : 0) |
+				  (emummc_enabled   ? PKG2_CACHE_KEY_EMUMMC    : 0) |
+				  (ctxt->secmon     ? PKG2_CACHE_KEY_SECMON    : 0) |
+				  (h_cfg.t210b01    ? PKG2_CACHE_KEY_T210B01   : 0) |
+				  (sd_fs.fs_type == FS_EXFAT ? PKG2_CACHE_KEY_EXFAT : 0);
+
+	// External patches and emuMMC FS injection are read from SD.
+	_pkg2_cache_file_stamp("bootloader/patches.ini", &ckey->patches_ini_size, &ckey->patches_ini_time);
+	_pkg2_cache_file_stamp("/bootloader/sys/emummc.kipm", &ckey->kipm_size, &ckey->kipm_time);
+
+	se_calc_sha256_oneshot(key, ckey, sizeof(pkg2_cache_key_t));
+	free(ckey);
+}
+
+static bool _pkg2_cache_validate(const u8 *key, u8 *buf, u32 size)
+{
+	pkg2_cache_hdr_t *hdr = (pkg2_cache_hdr_t *)buf;
+	u8 hash[SE_SHA_256_SIZE];
+
+	if (size < sizeof(pkg2_cache_hdr_t))
+		return false;
+
+	if (hdr->magic != PKG2_CACHE_MAGIC || hdr->version != PKG2_CACHE_VERSION)
+		return false;
+
+	if (memcmp(hdr->key, key, SE_SHA_256_SIZE))
+		return false;
+
+	if (hdr->data_size != (size - sizeof(pkg2_cache_hdr_t)) || hdr->data_size > PKG2_CACHE_MAX_DATA)
+		return false;
+
+	if (!hdr->kernel_size || !hdr->kip_num || hdr->kip_num > PKG2_CACHE_MAX_KIPS)
+		return false;
+
+	// The size table must be in the data before it is read.
+	if (hdr->kernel_size > hdr->data_size ||
+		hdr->data_size < hdr->kip_num * sizeof(u32) + ALIGN(hdr->kernel_size, 4))
+		return false;
+
+	// Check that all sizes fit in the data.
+	u32 *kip_sizes = (u32 *)(buf + sizeof(pkg2_cache_hdr_t));
+	u32 total = hdr->kip_num * sizeof(u32) + ALIGN(hdr->kernel_size, 4);
+	for (u32 i = 0; i < hdr->kip_num; i++)
+	{
+		if (kip_sizes[i] < sizeof(pkg2_kip1_t) || kip_sizes[i] > hdr->data_size)
+			return false;
+		total += ALIGN(kip_sizes[i], 4);
+	}
+
+	if (total != hdr->data_size)
+		return false;
+
+	if (!se_calc_sha256_oneshot(hash, buf + sizeof(pkg2_cache_hdr_t), hdr->data_size))
+		return false;
+
+	if (memcmp(hash, hdr->data_hash, SE_SHA_256_SIZE))
+		return false;
+
+	// Check KIP1 headers against their stored size.
+	u8 *kip_data = buf + sizeof(pkg2_cache_hdr_t) + hdr->kip_num * sizeof(u32) + ALIGN(hdr->kernel_size, 4);
+	for (u32 i = 0; i < hdr->kip_num; i++)
+	{
+		pkg2_kip1_t *kip1 = (pkg2_kip1_t *)kip_data;
+		if (kip1->magic != 0x3150494B || pkg2_calc_kip1_size(kip1) != kip_sizes[i]) // "KIP1".
+			return false;
+		kip_data += ALIGN(kip_sizes[i], 4);
+	}
+
+	return true;
+}
+
+bool pkg2_cache_load(const u8 *key, launch_ctxt_t *ctxt, link_t *kips_info, pkg2_cache_state_t *state)
+{
+	u32 size = 0;
+	u8 *buf = (u8 *)sd_file_read(PKG2_CACHE_PATH, &size);
+	if (!buf)
+		return false;
+
+	if (!_pkg2_cache_validate(key, buf, size))
+	{
+		DPRINTF("pkg2 cache is stale\n");
+		free(buf);
+		f_unlink(PKG2_CACHE_PATH);
+
+		return false;
+	}
+
+	pkg2_cache_hdr_t *hdr = (pkg2_cache_hdr_t *)buf;
+	u32 *kip_sizes = (u32 *)(buf + sizeof(pkg2_cache_hdr_t));
+	u8 *data = buf + sizeof(pkg2_cache_hdr_t) + hdr->kip_num * sizeof(u32);
+
+	// Kernel gets its own buffer, since it can be freed on errors.
+	if (!fss_is_content(ctxt, ctxt->kernel))
+		free(ctxt->kernel);
+	ctxt->kernel = malloc(hdr->kernel_size);
+	ctxt->kernel_size = hdr->kernel_size;
+	memcpy(ctxt->kernel, data, hdr->kernel_size);
+	data += ALIGN(hdr->kernel_size, 4);
+
+	for (u32 i = 0; i < hdr->kip_num; i++)
+	{
+		pkg2_add_kip(kips_info, (pkg2_kip1_t *)data);
+		data += ALIGN(kip_sizes[i], 4);
+	}
+
+	ctxt->new_pkg2 = hdr->new_pkg2;
+	ctxt->exo_ctx.hos_revision = hdr->hos_revision;
+	pkg2_newkern_ini1_val = hdr->newkern_ini1_val;
+	pkg2_keyslot = hdr->keyslot;
+	state->fs_ver = hdr->fs_ver;
+	state->exfat_compat = hdr->exfat_compat;
+
+	return true;
+}
+
+void pkg2_cache_save(const u8 *key, launch_ctxt_t *ctxt, link_t *kips_info, pkg2_cache_state_t *state)
+{
+	u32 kip_num = 0;
+	u32 data_size = ALIGN(ctxt->kernel_size, 4);
+	LIST_FOREACH_ENTRY(pkg2_kip1_info_t, ki, kips_info, link)
+	{
+		data_size += sizeof(u32) + ALIGN(ki->size, 4);
+		kip_num++;
+	}
+
+	if (!kip_num || kip_num > PKG2_CACHE_MAX_KIPS || data_size > PKG2_CACHE_MAX_DATA)
+		return;
+
+	u8 *buf = (u8 *)calloc(sizeof(pkg2_cache_hdr_t) + data_size, 1);
+	pkg2_cache_hdr_t *hdr = (pkg2_cache_hdr_t *)buf;
+	u32 *kip_sizes = (u32 *)(buf + sizeof(pkg2_cache_hdr_t));
+	u8 *data = buf + sizeof(pkg2_cache_hdr_t) + kip_num * sizeof(u32);
+
+	memcpy(data, ctxt->kernel, ctxt->kernel_size);
+	data += ALIGN(ctxt->kernel_size, 4);
+
+	u32 idx = 0;
+	LIST_FOREACH_ENTRY(pkg2_kip1_info_t, ki, kips_info, link)
+	{
+		kip_sizes[idx++] = ki->size;
+		memcpy(data, ki->kip1, ki->size);
+		data += ALIGN(ki->size, 4);
+	}
+
+	hdr->magic = PKG2_CACHE_MAGIC;
+	hdr->version = PKG2_CACHE_VERSION;
+	memcpy(hdr->key, key, SE_SHA_256_SIZE);
+	hdr->data_size = data_size;
+	hdr->kernel_size = ctxt->kernel_size;
+	hdr->kip_num = kip_num;
+	hdr->new_pkg2 = ctxt->new_pkg2;
+	hdr->newkern_ini1_val = pkg2_newkern_ini1_val;
+	hdr->keyslot = pkg2_keyslot;
+	hdr->fs_ver = state->fs_ver;
+	hdr->hos_revision = ctxt->exo_ctx.hos_revision;
+	hdr->exfat_compat = state->exfat_compat;
+
+	if (se_calc_sha256_oneshot(hdr->data_hash, buf + sizeof(pkg2_cache_hdr_t), data_size))
+		sd_save_to_file(buf, sizeof(pkg2_cache_hdr_t) + data_size, PKG2_CACHE_PATH);
+
+	free(buf);
+}
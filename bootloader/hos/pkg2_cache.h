@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PKG2_CACHE_H_
+#define _PKG2_CACHE_H_
+
+#include <bdk.h>
+
+#include "hos.h"
+
+#define PKG2_CACHE_PATH    "AtomNX/sys/pkg2_cache.bin"
+#define PKG2_CACHE_MAGIC   0x48433250 // "P2CH".
+#define PKG2_CACHE_VERSION 3
+
+typedef struct _pkg2_cache_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u8  key[SE_SHA_256_SIZE];
+	u8  data_hash[SE_SHA_256_SIZE]; // Over everything after the header.
+	u32 data_size;
+	u32 kernel_size;
+	u32 kip_num;
+	u32 new_pkg2;
+	u32 newkern_ini1_val;
+	u32 keyslot;
+	u32 fs_ver;
+	u32 hos_revision;
+	u32 exfat_compat;
+	u32 rsvd[3];
+} pkg2_cache_hdr_t;
+
+typedef struct _pkg2_cache_state_t
+{
+	u32 fs_ver;
+	u32 exfat_compat;
+} pkg2_cache_state_t;
+
+void pkg2_cache_calc_key(u8 *key, launch_ctxt_t *ctxt, u32 kb, bool emummc_enabled);
+bool pkg2_cache_load(const u8 *key, launch_ctxt_t *ctxt, link_t *kips_info, pkg2_cache_state_t *state);
+void pkg2_cache_save(const u8 *key, launch_ctxt_t *ctxt, link_t *kips_info, pkg2_cache_state_t *state);
+
+#endif
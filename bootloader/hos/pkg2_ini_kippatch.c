@@ -95,27 +95,41 @@ static ini_kip_sec_t *_ini_create_kip_section(link_t *dst, ini_kip_sec_t *ksec,
 	return ksec;
 }
 
-int ini_patch_parse(link_t *dst, char *ini_path)
+static u32 _ini_get_line(char *lbuf, u32 lbuf_size, const char *data, u32 size, u32 *pos)
+{
+	u32 len = 0;
+
+	// Same as f_gets with 'FF_USE_STRFUNC 2' that removes \r.
+	while (len < (lbuf_size - 1) && *pos < size)
+	{
+		char ch = data[(*pos)++];
+		if (ch == '\r')
+			continue;
+
+		lbuf[len++] = ch;
+		if (ch == '\n')
+			break;
+	}
+	lbuf[len] = 0;
+
+	return len;
+}
+
+static void _ini_patch_parse_buf(link_t *dst, const char *data, u32 size)
 {
-	FIL fp;
 	u32 lblen;
+	u32 data_pos = 0;
 	char *lbuf;
 	ini_kip_sec_t *ksec = NULL;
 
-	// Open ini.
-	if (f_open(&fp, ini_path, FA_READ) != FR_OK)
-		return 0;
-
 	lbuf = malloc(512);
 
 	do
 	{
 		// Fetch one line.
-		lbuf[0] = 0;
-		f_gets(lbuf, 512, &fp);
-		lblen = strlen(lbuf);
+		lblen = _ini_get_line(lbuf, 512, data, size, &data_pos);
 
-		// Remove trailing newline. Depends on 'FF_USE_STRFUNC 2' that removes \r.
+		// Remove trailing newline.
 		if (lblen && lbuf[lblen - 1] == '\n')
 			lbuf[lblen - 1] = 0;
 
@@ -167,14 +181,211 @@ int ini_patch_parse(link_t *dst, char *ini_path)
 
 			list_append(&ksec->pts, &pt->link);
 		}
-	} while (!f_eof(&fp));
-
-	f_close(&fp);
+	} while (data_pos < size);
 
 	if (ksec)
 		list_append(dst, &ksec->link);
 
 	free(lbuf);
+}
+
+int ini_patch_parse(link_t *dst, char *ini_path)
+{
+	u32 size;
+
+	// Read the whole ini at once.
+	char *data = sd_file_read(ini_path, &size);
+	if (!data)
+		return 0;
+
+	_ini_patch_parse_buf(dst, data, size);
+
+	free(data);
+
+	return 1;
+}
+
+static bool _ini_patch_db_load(link_t *dst, char *db_path, u32 ini_size, u32 ini_time)
+{
+	u32 size;
+	u8 *db = sd_file_read(db_path, &size);
+	if (!db)
+		return false;
+
+	kippatch_db_hdr_t *hdr = (kippatch_db_hdr_t *)db;
+	u8 *data = db + sizeof(kippatch_db_hdr_t);
+
+	// Check header and that it was compiled from this ini.
+	if (size < sizeof(kippatch_db_hdr_t) || hdr->magic != KIPPATCH_DB_MAGIC || hdr->version != KIPPATCH_DB_VERSION ||
+		hdr->ini_size != ini_size || hdr->ini_time != ini_time || hdr->data_size != (size - sizeof(kippatch_db_hdr_t)))
+		goto error;
+
+	// Check sizes and data. Data always ends with a null terminator.
+	u32 tables_size = hdr->sec_cnt * sizeof(kippatch_db_sec_t) + hdr->pt_cnt * sizeof(kippatch_db_pt_t);
+	if (hdr->sec_cnt > hdr->data_size || hdr->pt_cnt > hdr->data_size || tables_size > hdr->data_size ||
+		!hdr->data_size || data[hdr->data_size - 1] || crc32_calc(0, data, hdr->data_size) != hdr->data_crc32)
+		goto error;
+
+	kippatch_db_sec_t *db_secs = (kippatch_db_sec_t *)data;
+	kippatch_db_pt_t *db_pts = (kippatch_db_pt_t *)(data + hdr->sec_cnt * sizeof(kippatch_db_sec_t));
+
+	// Check all references.
+	for (u32 i = 0; i < hdr->sec_cnt; i++)
+	{
+		if (db_secs[i].name_off < tables_size || db_secs[i].name_off >= hdr->data_size ||
+			db_secs[i].pt_start > hdr->pt_cnt || db_secs[i].pt_cnt > (hdr->pt_cnt - db_secs[i].pt_start))
+			goto error;
+	}
+
+	for (u32 i = 0; i < hdr->pt_cnt; i++)
+	{
+		if (db_pts[i].name_off < tables_size || db_pts[i].name_off >= hdr->data_size)
+			goto error;
+
+		// Patches with a length must have data.
+		if (!db_pts[i].data_off && db_pts[i].length)
+			goto error;
+
+		if (db_pts[i].data_off && (db_pts[i].data_off < tables_size || db_pts[i].length > hdr->data_size ||
+			(db_pts[i].data_off + db_pts[i].length * 2) > hdr->data_size))
+			goto error;
+	}
+
+	// Create sections and patches in place.
+	u8 *nodes = calloc(hdr->sec_cnt * sizeof(ini_kip_sec_t) + hdr->pt_cnt * sizeof(ini_patchset_t), 1);
+	ini_kip_sec_t *ksecs = (ini_kip_sec_t *)nodes;
+	ini_patchset_t *pts = (ini_patchset_t *)(nodes + hdr->sec_cnt * sizeof(ini_kip_sec_t));
+	for (u32 i = 0; i < hdr->sec_cnt; i++)
+	{
+		ini_kip_sec_t *ksec = &ksecs[i];
+		ksec->name = (char *)&data[db_secs[i].name_off];
+		memcpy(ksec->hash, db_secs[i].hash, sizeof(ksec->hash));
+		list_init(&ksec->pts);
+
+		for (u32 j = db_secs[i].pt_start; j < (db_secs[i].pt_start + db_secs[i].pt_cnt); j++)
+		{
+			ini_patchset_t *pt = &pts[j];
+			pt->name = (char *)&data[db_pts[j].name_off];
+			pt->offset = db_pts[j].offset;
+			pt->length = db_pts[j].length;
+			if (db_pts[j].data_off)
+			{
+				pt->srcData = &data[db_pts[j].data_off];
+				pt->dstData = &data[db_pts[j].data_off + db_pts[j].length];
+			}
+
+			list_append(&ksec->pts, &pt->link);
+		}
+
+		list_append(dst, &ksec->link);
+	}
+
+	return true;
+
+error:
+	free(db);
+
+	return false;
+}
+
+static void _ini_patch_db_save(link_t *src, char *db_path, u32 ini_size, u32 ini_time)
+{
+	u32 sec_cnt = 0;
+	u32 pt_cnt = 0;
+	u32 pool_size = 0;
+
+	// Calculate sizes.
+	LIST_FOREACH_ENTRY(ini_kip_sec_t, ksec, src, link)
+	{
+		sec_cnt++;
+		pool_size += ALIGN(strlen(ksec->name) + 1, 4);
+		LIST_FOREACH_ENTRY(ini_patchset_t, pt, &ksec->pts, link)
+		{
+			pt_cnt++;
+			pool_size += ALIGN(strlen(pt->name) + 1, 4);
+			if (pt->srcData)
+				pool_size += ALIGN(pt->length * 2, 4);
+		}
+	}
+
+	u32 tables_size = sec_cnt * sizeof(kippatch_db_sec_t) + pt_cnt * sizeof(kippatch_db_pt_t);
+	u32 data_size = tables_size + pool_size + sizeof(u32); // Null terminated.
+	u8 *db = calloc(sizeof(kippatch_db_hdr_t) + data_size, 1);
+
+	kippatch_db_hdr_t *hdr = (kippatch_db_hdr_t *)db;
+	u8 *data = db + sizeof(kippatch_db_hdr_t);
+	kippatch_db_sec_t *db_secs = (kippatch_db_sec_t *)data;
+	kippatch_db_pt_t *db_pts = (kippatch_db_pt_t *)(data + sec_cnt * sizeof(kippatch_db_sec_t));
+
+	u32 sec_idx = 0;
+	u32 pt_idx = 0;
+	u32 pool_off = tables_size;
+	LIST_FOREACH_ENTRY(ini_kip_sec_t, ksec, src, link)
+	{
+		kippatch_db_sec_t *db_sec = &db_secs[sec_idx++];
+		db_sec->name_off = pool_off;
+		strcpy((char *)&data[pool_off], ksec->name);
+		pool_off += ALIGN(strlen(ksec->name) + 1, 4);
+		memcpy(db_sec->hash, ksec->hash, sizeof(db_sec->hash));
+		db_sec->pt_start = pt_idx;
+
+		LIST_FOREACH_ENTRY(ini_patchset_t, pt, &ksec->pts, link)
+		{
+			kippatch_db_pt_t *db_pt = &db_pts[pt_idx++];
+			db_pt->name_off = pool_off;
+			strcpy((char *)&data[pool_off], pt->name);
+			pool_off += ALIGN(strlen(pt->name) + 1, 4);
+			db_pt->offset = pt->offset;
+			db_pt->length = pt->length;
+
+			if (pt->srcData)
+			{
+				db_pt->data_off = pool_off;
+				memcpy(&data[pool_off], pt->srcData, pt->length);
+				memcpy(&data[pool_off + pt->length], pt->dstData, pt->length);
+				pool_off += ALIGN(pt->length * 2, 4);
+			}
+
+			db_sec->pt_cnt++;
+		}
+	}
+
+	hdr->magic = KIPPATCH_DB_MAGIC;
+	hdr->version = KIPPATCH_DB_VERSION;
+	hdr->ini_size = ini_size;
+	hdr->ini_time = ini_time;
+	hdr->sec_cnt = sec_cnt;
+	hdr->pt_cnt = pt_cnt;
+	hdr->data_size = data_size;
+	hdr->data_crc32 = crc32_calc(0, data, data_size);
+
+	sd_save_to_file(db, sizeof(kippatch_db_hdr_t) + data_size, db_path);
+
+	free(db);
+}
+
+int ini_patch_parse_cached(link_t *dst, char *ini_path, char *db_path)
+{
+	FILINFO fno;
+
+	if (f_stat(ini_path, &fno) != FR_OK)
+		return 0;
+
+	// Use the compiled patches if they match the ini size and modification time.
+	u32 ini_size = fno.fsize;
+	u32 ini_time = (fno.fdate << 16) | fno.ftime;
+	if (_ini_patch_db_load(dst, db_path, ini_size, ini_time))
+		return 1;
+
+	// Otherwise parse the ini and compile it.
+	char *ini = sd_file_read(ini_path, &ini_size);
+	if (!ini)
+		return 0;
+
+	_ini_patch_parse_buf(dst, ini, ini_size);
+	_ini_patch_db_save(dst, db_path, ini_size, ini_time);
+
+	free(ini);
 
 	return 1;
 }
@@ -37,6 +37,39 @@ typedef struct _ini_kip_sec_t
 	link_t link;
 } ini_kip_sec_t;
 
+#define KIPPATCH_DB_MAGIC   0x4244504B // "KPDB".
+#define KIPPATCH_DB_VERSION 2
+
+// Compiled patches.ini. All offsets are relative to the data after the header.
+typedef struct _kippatch_db_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u32 ini_size;
+	u32 ini_time; // FAT date and time.
+	u32 sec_cnt;
+	u32 pt_cnt;
+	u32 data_size;
+	u32 data_crc32;
+} kippatch_db_hdr_t;
+
+typedef struct _kippatch_db_sec_t
+{
+	u32 name_off;
+	u8  hash[8];
+	u32 pt_start;
+	u32 pt_cnt;
+} kippatch_db_sec_t;
+
+typedef struct _kippatch_db_pt_t
+{
+	u32 name_off;
+	u32 offset;   // section + offset of patch to apply.
+	u32 length;   // In bytes.
+	u32 data_off; // Source data followed by destination data. 0 if none.
+} kippatch_db_pt_t;
+
 int ini_patch_parse(link_t *dst, char *ini_path);
+int ini_patch_parse_cached(link_t *dst, char *ini_path, char *db_path);
 
 #endif
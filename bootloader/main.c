@@ -164,8 +164,9 @@ void check_power_off_from_hos()
 		{
 				gfx_clear_grey(0x1B);  //Custom Bootlogo
 			u8 *BOOTLOGO = (void *)malloc(0x4000);
-			blz_uncompress_srcdest(BOOTLOGO_BLZ, SZ_BOOTLOGO_BLZ, BOOTLOGO, SZ_BOOTLOGO);
-			gfx_set_rect_grey(BOOTLOGO, X_BOOTLOGO, Y_BOOTLOGO, 326, 544);
+			if (blz_uncompress_srcdest(BOOTLOGO_BLZ, SZ_BOOTLOGO_BLZ, BOOTLOGO, SZ_BOOTLOGO))
+				gfx_set_rect_grey(BOOTLOGO, X_BOOTLOGO, Y_BOOTLOGO, 326, 544);
+			free(BOOTLOGO);
 
 			display_backlight_brightness(10, 5000);
 			display_backlight_brightness(100, 25000);
@@ -549,7 +550,7 @@ wrong_emupath:
 
 out:
 
-	btn_wait();
+	tui_pager_wait();
 }
 
 void launch_firmware()
@@ -706,7 +707,7 @@ out:
 
 	h_cfg.emummc_force_disable = false;
 
-	btn_wait();
+	tui_pager_wait();
 }
 
 #define NYX_VER_OFF 0x9C
@@ -901,7 +902,10 @@ static void _auto_launch_firmware()
 		create_config_entry();
 
 	// Parse Atom main configuration.
-	if (!ini_parse(&ini_sections, "AtomNX/sys_ipl.ini", false))
+	u32 prof_start = get_tmr_us();
+	bool ini_parsed = ini_parse(&ini_sections, "AtomNX/sys_ipl.ini", false);
+	boot_prof_add(BOOT_PROF_INI_PARSE, prof_start);
+	if (!ini_parsed)
 		goto out; // Can't load sys_ipl.ini.
 
 	// Load configuration.
@@ -990,7 +994,10 @@ static void _auto_launch_firmware()
 		boot_entry_id = 1;
 		bootlogoCustomEntry = NULL;
 
-		if (!ini_parse(&ini_list_sections, "AtomNX/ini", true))
+		prof_start = get_tmr_us();
+		ini_parsed = ini_parse(&ini_list_sections, "AtomNX/ini", true);
+		boot_prof_add(BOOT_PROF_INI_PARSE, prof_start);
+		if (!ini_parsed)
 			goto skip_list;
 
 		LIST_FOREACH_ENTRY(ini_sec_t, ini_sec_list, &ini_list_sections, link)
@@ -1034,6 +1041,7 @@ skip_list:
 	u8 *bitmap = NULL;
 	struct _bmp_data bmpData;
 	bool bootlogoFound = false;
+	prof_start = get_tmr_us();
 	if (!(b_cfg.boot_cfg & BOOT_CFG_FROM_LAUNCH) && h_cfg.bootwait)
 	{
 		u32 fsize;
@@ -1091,6 +1099,7 @@ skip_list:
 			free(logo_buf);
 		}
 	}
+	boot_prof_add(BOOT_PROF_BOOTLOGO, prof_start);
 
 	if (b_cfg.boot_cfg & BOOT_CFG_FROM_LAUNCH)
 		display_backlight_brightness(h_cfg.backlight, 0);
@@ -1141,7 +1150,7 @@ payload_error:
 		gfx_printf("\nPress any key...\n");
 		display_backlight_brightness(h_cfg.backlight, 1000);
 		msleep(500);
-		btn_wait();
+		tui_pager_wait();
 	}
 
 out:
@@ -1311,7 +1320,8 @@ static void _check_low_battery()
 
 	// Prepare battery icon resources.
 	u8 *battery_res = malloc(ALIGN(SZ_BATTERY_EMPTY, SZ_4K));
-	blz_uncompress_srcdest(BATTERY_EMPTY_BLZ, SZ_BATTERY_EMPTY_BLZ, battery_res, SZ_BATTERY_EMPTY);
+	if (!blz_uncompress_srcdest(BATTERY_EMPTY_BLZ, SZ_BATTERY_EMPTY_BLZ, battery_res, SZ_BATTERY_EMPTY))
+		memset(battery_res, 0, SZ_BATTERY_EMPTY); // Draw blank icons instead of garbage.
 
 	u8 *battery_icon = malloc(0x95A);  // 21x38x3
 	u8 *charging_icon = malloc(0x2F4); // 21x12x3
@@ -1426,6 +1436,8 @@ extern void pivot_stack(u32 stack_top);
 
 void ipl_main()
 {
+	u32 prof_start = get_tmr_us();
+
 	// Do initial HW configuration. This is compatible with consecutive reruns without a reset.
 	hw_init();
 
@@ -1435,6 +1447,10 @@ void ipl_main()
 	// Tegra/Horizon configuration goes to 0x80000000+, package2 goes to 0xA9800000, we place our heap in between.
 	heap_init((void *)IPL_HEAP_START);
 
+	// Start a new boot timeline session. DRAM is now available.
+	boot_prof_init();
+	boot_prof_add(BOOT_PROF_HW_INIT, prof_start);
+
 #ifdef DEBUG_UART_PORT
 	uart_send(DEBUG_UART_PORT, (u8 *)"hekate: Hello!\r\n", 16);
 	uart_wait_xfer(DEBUG_UART_PORT, UART_TX_IDLE);
@@ -1450,7 +1466,9 @@ void ipl_main()
 	display_init();
 
 	// Mount SD Card.
+	prof_start = get_tmr_us();
 	h_cfg.errors |= !sd_mount() ? ERR_SD_BOOT_EN : 0;
+	boot_prof_add(BOOT_PROF_SD_MOUNT, prof_start);
 
 	// Check if watchdog was fired previously.
 	if (watchdog_fired())
@@ -1465,8 +1483,10 @@ void ipl_main()
 		h_cfg.errors |= ERR_LIBSYS_LP0;
 
 	// Train DRAM and switch to max frequency.
+	prof_start = get_tmr_us();
 	if (minerva_init()) //!TODO: Add Tegra210B01 support to minerva.
 		h_cfg.errors |= ERR_LIBSYS_MTC;
+	boot_prof_add(BOOT_PROF_MINERVA_INIT, prof_start);
 
 	// Disable watchdog protection.
 	watchdog_end();
@@ -1476,6 +1496,7 @@ skip_lp0_minerva_config:
 	u32 *fb = display_init_framebuffer_pitch();
 	gfx_init_ctxt(fb, 720, 1280, 720);
 	gfx_con_init();
+	gfx_con_set_scroll_end(1256); // Keep status bar out of console scrolling.
 
 	display_backlight_pwm_init();
 	//display_backlight_brightness(h_cfg.backlight, 1000);
@@ -1488,6 +1509,7 @@ skip_lp0_minerva_config:
 
 	// AtomNX Custom Payload Bootlogo, Seperate from AtomNX splas
 	sd_mount();
+	prof_start = get_tmr_us();
 	u8* BOOTLOGO = NULL;
 
 	struct _bmp_data
@@ -1544,6 +1566,7 @@ skip_lp0_minerva_config:
 		else
 			free(bitmap);
 	}
+	boot_prof_add(BOOT_PROF_BOOTLOGO, prof_start);
 
 	// Load saved configuration and auto boot if enabled.
 	if (!(h_cfg.errors & ERR_SD_BOOT_EN))
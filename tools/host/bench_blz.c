@@ -0,0 +1,180 @@
+/*
+ * BLZ decompression benchmark.
+ *
+ * Compares blz_uncompress_inplace against the previous byte at a time
+ * implementation on code like and mixed data. Both run in place on the same
+ * streams and their output is checked against the source data.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/compr/blz.h>
+
+#include "blz_comp.h"
+#include "host_hw.h"
+
+#define BENCH_MB 64
+
+typedef int (*blz_inplace_t)(unsigned char *, unsigned int, const blz_footer *);
+
+// Previous implementation.
+static int _blz_old_uncompress_inplace(unsigned char *dataBuf, unsigned int compSize, const blz_footer *footer)
+{
+	u32 addl_size = footer->addl_size;
+	u32 header_size = footer->header_size;
+	u32 cmp_and_hdr_size = footer->cmp_and_hdr_size;
+
+	unsigned char* cmp_start = &dataBuf[compSize] - cmp_and_hdr_size;
+	u32 cmp_ofs = cmp_and_hdr_size - header_size;
+	u32 out_ofs = cmp_and_hdr_size + addl_size;
+
+	while (out_ofs)
+	{
+		unsigned char control = cmp_start[--cmp_ofs];
+		for (unsigned int i=0; i<8; i++)
+		{
+			if (control & 0x80)
+			{
+				if (cmp_ofs < 2)
+					return 0; // Out of bounds.
+
+				cmp_ofs -= 2;
+				u16 seg_val = ((unsigned int)(cmp_start[cmp_ofs + 1]) << 8) | cmp_start[cmp_ofs];
+				u32 seg_size = ((seg_val >> 12) & 0xF) + 3;
+				u32 seg_ofs = (seg_val & 0x0FFF) + 3;
+				if (out_ofs < seg_size) // Kernel restricts segment copy to stay in bounds.
+					seg_size = out_ofs;
+
+				out_ofs -= seg_size;
+
+				for (unsigned int j = 0; j < seg_size; j++)
+					cmp_start[out_ofs + j] = cmp_start[out_ofs + j + seg_ofs];
+			}
+			else
+			{
+				// Copy directly.
+				if (cmp_ofs < 1)
+					return 0; //out of bounds
+
+				cmp_start[--out_ofs] = cmp_start[--cmp_ofs];
+			}
+			control <<= 1;
+			if (out_ofs == 0) // Blz works backwards, so if it reaches byte 0, it's done.
+				return 1;
+			}
+		}
+
+	return 1;
+}
+
+static u32 rnd_state = 0xB1E55;
+
+static u32 _rnd()
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+
+	return rnd_state;
+}
+
+static void _gen_data(u8 *buf, u32 size, u32 literal_pct)
+{
+	u32 pos = 0;
+	while (pos < size)
+	{
+		u32 r = _rnd();
+		if ((r % 100) < literal_pct || pos < 64)
+			buf[pos++] = r >> 8;
+		else
+		{
+			u32 back = 4 + ((r >> 8) % (MIN(pos, 4000) - 4));
+			u32 len = 3 + ((r >> 20) & 15);
+			for (u32 i = 0; i < len && pos < size; i++, pos++)
+				buf[pos] = buf[pos - back];
+		}
+	}
+}
+
+static u64 _cpu_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+	return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static double _bench(blz_inplace_t fn, const u8 *comp, u32 comp_len, const u8 *data, u32 size, u8 *buf)
+{
+	blz_footer footer;
+	blz_get_footer(comp, comp_len, &footer);
+
+	u32 iters = (BENCH_MB * SZ_1M) / size;
+	u64 total = 0;
+	for (u32 i = 0; i < iters; i++)
+	{
+		memcpy(buf, comp, comp_len);
+		u64 start = _cpu_us();
+		int res = fn(buf, comp_len, &footer);
+		total += _cpu_us() - start;
+
+		if (!i)
+			HOST_CHECK(res == 1 && !memcmp(buf, data, size), "decompressed data differs");
+	}
+
+	return total ? (double)iters * size / SZ_1M * 1000000 / total : 0;
+}
+
+int main()
+{
+	static const struct { const char *name; u32 size; u32 literal_pct; } sets[] = {
+		{ "code 256K",  SZ_256K, 30 },
+		{ "code 1M",    SZ_1M,   30 },
+		{ "dense 1M",   SZ_1M,   10 },
+		{ "sparse 1M",  SZ_1M,   60 },
+	};
+
+	host_init();
+
+	printf("%-10s %8s %8s %10s %10s %7s\n", "set", "size", "comp", "old MB/s", "new MB/s", "speed");
+	for (u32 i = 0; i < ARRAY_SIZE(sets); i++)
+	{
+		u32 size = sets[i].size;
+		u8 *data = malloc(size);
+		u8 *comp = malloc(size + 16);
+		u8 *buf = malloc(size + 16);
+
+		_gen_data(data, size, sets[i].literal_pct);
+		u32 comp_len = blz_host_compress(comp, data, size);
+		HOST_CHECK(comp_len, "%s: data does not compress", sets[i].name);
+		if (comp_len)
+		{
+			double old_mbs = _bench(_blz_old_uncompress_inplace, comp, comp_len, data, size, buf);
+			double new_mbs = _bench(blz_uncompress_inplace, comp, comp_len, data, size, buf);
+			printf("%-10s %8d %8d %10.1f %10.1f %6.2fx\n", sets[i].name, size, comp_len, old_mbs, new_mbs,
+				old_mbs ? new_mbs / old_mbs : 0);
+		}
+
+		free(data);
+		free(comp);
+		free(buf);
+	}
+
+	return host_report("bench_blz");
+}
@@ -0,0 +1,271 @@
+/*
+ * BMP decode benchmark.
+ *
+ * Loads the images of the stock theme from the simulated SD with
+ * bmp_to_lvimg_obj and with the previous per pixel conversion, checks that
+ * both give the same image and reports the CPU time of each. The time to
+ * read the files alone is shown so the conversion cost can be told apart.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/fatfs/ff.h>
+#include <libs/lvgl/lvgl.h>
+#include "frontend/gui.h"
+
+#include "bench_common.h"
+#include "host_hw.h"
+#include "nyx_host.h"
+
+#define BENCH_ITERS 20
+
+typedef lv_img_dsc_t *(*bmp_load_t)(const char *path);
+
+// Previous implementation.
+static lv_img_dsc_t *_bmp_old_to_lvimg_obj(const char *path)
+{
+	u32 fsize;
+	u8 *bitmap = sd_file_read(path, &fsize);
+	if (!bitmap)
+		return NULL;
+
+	struct _bmp_data
+	{
+		u32 size;
+		u32 size_x;
+		u32 size_y;
+		u32 offset;
+	};
+
+	struct _bmp_data bmpData;
+
+	// Get values manually to avoid unaligned access.
+	bmpData.size = bitmap[2] | bitmap[3] << 8 |
+		bitmap[4] << 16 | bitmap[5] << 24;
+	bmpData.offset = bitmap[10] | bitmap[11] << 8 |
+		bitmap[12] << 16 | bitmap[13] << 24;
+	bmpData.size_x = bitmap[18] | bitmap[19] << 8 |
+		bitmap[20] << 16 | bitmap[21] << 24;
+	bmpData.size_y = bitmap[22] | bitmap[23] << 8 |
+		bitmap[24] << 16 | bitmap[25] << 24;
+	// Sanity check.
+	if (bitmap[0] == 'B' &&
+		bitmap[1] == 'M' &&
+		bitmap[28] == 32 && // Only 32 bit BMPs allowed.
+		bmpData.size <= fsize)
+	{
+		// Check if non-default Bottom-Top.
+		bool flipped = false;
+		if (bmpData.size_y & 0x80000000)
+		{
+			bmpData.size_y = ~(bmpData.size_y) + 1;
+			flipped = true;
+		}
+
+		lv_img_dsc_t *img_desc = (lv_img_dsc_t *)bitmap;
+		uptr offset_copy = ALIGN((uptr)bitmap + sizeof(lv_img_dsc_t), 0x10);
+
+		img_desc->header.always_zero = 0;
+		img_desc->header.w = bmpData.size_x;
+		img_desc->header.h = bmpData.size_y;
+		img_desc->header.cf = (bitmap[28] == 32) ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+		img_desc->data_size = bmpData.size - bmpData.offset;
+		img_desc->data = (u8 *)offset_copy;
+
+		u32 *tmp = malloc(bmpData.size);
+		u32 *tmp2 = (u32 *)offset_copy;
+
+		// Copy the unaligned data to an aligned buffer.
+		memcpy((u8 *)tmp, bitmap + bmpData.offset, img_desc->data_size);
+		u32 j = 0;
+
+		if (!flipped)
+		{
+			for (u32 y = 0; y < bmpData.size_y; y++)
+			{
+				for (u32 x = 0; x < bmpData.size_x; x++)
+					tmp2[j++] = tmp[(bmpData.size_y - 1 - y ) * bmpData.size_x + x];
+			}
+		}
+		else
+		{
+			for (u32 y = 0; y < bmpData.size_y; y++)
+			{
+				for (u32 x = 0; x < bmpData.size_x; x++)
+					tmp2[j++] = tmp[y * bmpData.size_x + x];
+			}
+		}
+
+		free(tmp);
+	}
+	else
+	{
+		free(bitmap);
+		return NULL;
+	}
+
+	return (lv_img_dsc_t *)bitmap;
+}
+
+static lv_img_dsc_t *_bmp_read_only(const char *path)
+{
+	free(sd_file_read(path, NULL));
+
+	return NULL;
+}
+
+static u32 _pixel(u32 x, u32 y, u32 seed)
+{
+	return (x * 2654435761u) ^ (y * 40503u) ^ seed;
+}
+
+// 32-bit BMP with its pixel data at an unaligned offset, like the ones image editors write.
+static void _bmp_write(const char *path, u32 w, u32 h, bool top_down)
+{
+	u32 offset = 0x8A;
+	u32 size = offset + w * h * 4;
+	u8 *bmp = calloc(size, 1);
+
+	bmp[0] = 'B';
+	bmp[1] = 'M';
+	memcpy(bmp + 2, &size, 4);
+	memcpy(bmp + 10, &offset, 4);
+	u32 dib = 0x7C;
+	memcpy(bmp + 14, &dib, 4);
+	memcpy(bmp + 18, &w, 4);
+	u32 bmp_h = top_down ? -h : h;
+	memcpy(bmp + 22, &bmp_h, 4);
+	bmp[26] = 1;
+	bmp[28] = 32;
+
+	for (u32 y = 0; y < h; y++)
+	{
+		u32 file_y = top_down ? y : h - 1 - y;
+		for (u32 x = 0; x < w; x++)
+		{
+			u32 px = _pixel(x, y, w);
+			memcpy(bmp + offset + (file_y * w + x) * 4, &px, 4);
+		}
+	}
+
+	sd_save_to_file(bmp, size, path);
+	free(bmp);
+}
+
+static bool _img_check(const lv_img_dsc_t *img, u32 w, u32 h)
+{
+	if (!img || img->header.w != w || img->header.h != h ||
+		img->header.cf != LV_IMG_CF_TRUE_COLOR_ALPHA || img->data_size != w * h * 4 || ((uptr)img->data & 0xF))
+		return false;
+
+	const u32 *px = (const u32 *)img->data;
+	for (u32 y = 0; y < h; y++)
+		for (u32 x = 0; x < w; x++)
+			if (px[y * w + x] != _pixel(x, y, w))
+				return false;
+
+	return true;
+}
+
+static u64 _cpu_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+	return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static u64 _bench(bmp_load_t fn, const char *path, u32 w, u32 h)
+{
+	u64 total = 0;
+	for (u32 i = 0; i < BENCH_ITERS; i++)
+	{
+		u64 start = _cpu_us();
+		lv_img_dsc_t *img = fn(path);
+		total += _cpu_us() - start;
+
+		if (!i && fn != _bmp_read_only)
+			HOST_CHECK(_img_check(img, w, h), "%s: image differs", path);
+		free(img);
+	}
+
+	return total / BENCH_ITERS;
+}
+
+int main()
+{
+	// Startup background and launcher icons and the menu icons. Sizes approximate the stock theme.
+	static const struct { const char *path; u32 w; u32 h; bool top_down; } imgs[] = {
+		{ "AtomNX/background.bmp",        1280, 720, false },
+		{ "AtomNX/res/icon_switch.bmp",   200,  200, false },
+		{ "AtomNX/res/icon_payload.bmp",  200,  200, false },
+		{ "AtomNX/sys/gui/umssd.bmp",     200,  200, false },
+		{ "AtomNX/sys/gui/power.bmp",     200,  200, false },
+		{ "AtomNX/sys/gui/rtc.bmp",       200,  200, true  },
+		{ "AtomNX/sys/gui/about.bmp",     200,  200, true  },
+	};
+
+	nyx_host_init();
+	host_time_freeze(true);
+
+	if (!bench_sd_setup() || !sd_mount())
+		return 1;
+
+	f_mkdir("AtomNX");
+	f_mkdir("AtomNX/res");
+	f_mkdir("AtomNX/sys");
+	f_mkdir("AtomNX/sys/gui");
+	for (u32 i = 0; i < ARRAY_SIZE(imgs); i++)
+		_bmp_write(imgs[i].path, imgs[i].w, imgs[i].h, imgs[i].top_down);
+
+	// Bad files are rejected.
+	HOST_CHECK(!bmp_to_lvimg_obj("AtomNX/missing.bmp"), "missing file was loaded");
+	u32 size;
+	u8 *bmp = sd_file_read(imgs[1].path, &size);
+	u32 bad_h = 0x10000;
+	memcpy(bmp + 22, &bad_h, 4);
+	sd_save_to_file(bmp, size, "AtomNX/bad.bmp");
+	HOST_CHECK(!bmp_to_lvimg_obj("AtomNX/bad.bmp"), "oversized image was loaded");
+	free(bmp);
+
+	u64 read_total = 0, old_total = 0, new_total = 0;
+	printf("%-28s %9s %8s %8s %8s %7s\n", "image", "size", "read us", "old us", "new us", "convert");
+	for (u32 i = 0; i < ARRAY_SIZE(imgs); i++)
+	{
+		u32 w = imgs[i].w, h = imgs[i].h;
+		u64 read_us = _bench(_bmp_read_only, imgs[i].path, w, h);
+		u64 old_us = _bench(_bmp_old_to_lvimg_obj, imgs[i].path, w, h);
+		u64 new_us = _bench(bmp_to_lvimg_obj, imgs[i].path, w, h);
+
+		read_total += read_us;
+		old_total += old_us;
+		new_total += new_us;
+
+		u64 old_conv = old_us > read_us ? old_us - read_us : 0;
+		u64 new_conv = new_us > read_us ? new_us - read_us : 1;
+		printf("%-28s %4dx%-4d %8d %8d %8d %6.2fx\n", imgs[i].path, w, h, (u32)read_us, (u32)old_us, (u32)new_us,
+			(double)old_conv / new_conv);
+	}
+	printf("%-28s %9s %8d %8d %8d\n", "theme", "", (u32)read_total, (u32)old_total, (u32)new_total);
+
+	sd_unmount();
+	bench_teardown();
+
+	return host_report("bench_bmp");
+}
@@ -0,0 +1,226 @@
+/*
+ * Shared setup for host storage benchmarks and tests.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/fatfs/ff.h>
+#include <storage/mbr_gpt.h>
+
+#include "bench_common.h"
+#include "host_hw.h"
+#include "sdmmc_sim.h"
+
+#define BENCH_SD_MB 1024
+
+static char emmc_path[256];
+static char sd_path[256];
+
+typedef struct _bench_part_t
+{
+	const char *name;
+	u32 secs; // 0: Rest of the disk.
+} bench_part_t;
+
+static const bench_part_t bench_parts[] = {
+	{ "PRODINFO",  0x2000  },
+	{ "PRODINFOF", 0x2000  },
+	{ "SAFE",      0x4000  },
+	{ "SYSTEM",    0x20000 },
+	{ "USER",      0       }
+};
+
+void bench_fill(void *buf, u32 size, u32 seed)
+{
+	u32 *data = (u32 *)buf;
+
+	for (u32 i = 0; i < size / 4; i++)
+	{
+		u32 x = (seed + i / 128) * 0x9E3779B1 + (i & 127) * 0x85EBCA6B;
+		x ^= x >> 15;
+		data[i] = x;
+	}
+}
+
+static void _bench_write_gpt(u8 *emmc, u32 secs)
+{
+	gpt_t *gpt = (gpt_t *)(emmc + 512);
+
+	memset(emmc, 0, 34 * 512);
+	memcpy(&gpt->header.signature, "EFI PART", 8);
+	gpt->header.revision = 0x10000;
+	gpt->header.size = 92;
+	gpt->header.my_lba = 1;
+	gpt->header.alt_lba = secs - 1;
+	gpt->header.first_use_lba = 34;
+	gpt->header.last_use_lba = secs - 34;
+	gpt->header.part_ent_lba = 2;
+	gpt->header.num_part_ents = ARRAY_SIZE(bench_parts);
+	gpt->header.part_ent_size = sizeof(gpt_entry_t);
+
+	u32 lba = 0x800;
+	for (u32 i = 0; i < ARRAY_SIZE(bench_parts); i++)
+	{
+		gpt_entry_t *ent = &gpt->entries[i];
+		u32 part_secs = bench_parts[i].secs ? bench_parts[i].secs : (secs - 0x800 - lba);
+
+		ent->lba_start = lba;
+		ent->lba_end = lba + part_secs - 1;
+		for (u32 j = 0; bench_parts[i].name[j]; j++)
+			ent->name[j] = bench_parts[i].name[j];
+		lba += part_secs;
+	}
+}
+
+bool bench_setup(u32 emmc_mb)
+{
+	const char *tmp = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+	u32 emmc_secs = emmc_mb * 0x800;
+
+	snprintf(emmc_path, sizeof(emmc_path), "%s/nyx_host_emmc_%d.img", tmp, getpid());
+
+	if (emmc_mb < 128 || !sim_card_attach(SDMMC_4, emmc_path, SIM_CARD_MMC, emmc_secs))
+	{
+		printf("Failed to create the eMMC image\n");
+		return false;
+	}
+
+	// Fill eMMC with data.
+	for (u32 part = 0; part < 3; part++)
+		bench_fill(sim_card_data(SDMMC_4, part), (part ? SIM_BOOT_PART_SECS : emmc_secs) * 512, part << 24);
+	_bench_write_gpt(sim_card_data(SDMMC_4, 0), emmc_secs);
+
+	// BIS keys.
+	for (u32 ks = 0; ks < 6; ks++)
+	{
+		u8 key[SE_KEY_128_SIZE];
+		memset(key, 0x10 + ks, sizeof(key));
+		se_aes_key_set(ks, key, sizeof(key));
+	}
+
+	return bench_sd_setup();
+}
+
+bool bench_sd_setup()
+{
+	const char *tmp = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+
+	snprintf(sd_path, sizeof(sd_path), "%s/nyx_host_sd_%d.img", tmp, getpid());
+
+	if (!sim_card_attach(SDMMC_1, sd_path, SIM_CARD_SD, BENCH_SD_MB * 0x800))
+	{
+		printf("Failed to create the SD image\n");
+		return false;
+	}
+
+	// Format SD.
+	void *work = malloc(SZ_4M);
+	bool res = sd_initialize(false) && f_mkfs("0:", FM_FAT32, 0, work, SZ_4M) == FR_OK;
+	free(work);
+	sd_end();
+
+	if (!res)
+		printf("Failed to format the SD card\n");
+
+	return res;
+}
+
+void bench_teardown()
+{
+	sim_card_detach(SDMMC_4);
+	sim_card_detach(SDMMC_1);
+	if (emmc_path[0])
+		unlink(emmc_path);
+	if (sd_path[0])
+		unlink(sd_path);
+	emmc_path[0] = 0;
+	sd_path[0] = 0;
+}
+
+emmc_part_t *bench_gpt_part(const char *name)
+{
+	emmc_part_t *res = NULL;
+
+	if (!emmc_initialize(false))
+		return NULL;
+	sdmmc_storage_set_mmc_partition(&emmc_storage, EMMC_GPP);
+
+	LIST_INIT(gpt);
+	emmc_gpt_parse(&gpt);
+	emmc_part_t *part = emmc_part_find(&gpt, name);
+	if (part)
+	{
+		res = malloc(sizeof(emmc_part_t));
+		memcpy(res, part, sizeof(emmc_part_t));
+	}
+	emmc_gpt_free(&gpt);
+	sdmmc_storage_end(&emmc_storage);
+
+	return res;
+}
+
+bool bench_sd_file_matches(const char *path, const void *data, u32 secs)
+{
+	FIL fp;
+	bool res = false;
+	u8 *buf = malloc(SZ_1M);
+
+	if (!sd_mount())
+		goto out;
+
+	if (f_open(&fp, path, FA_READ) != FR_OK)
+		goto out;
+
+	if (f_size(&fp) != (u64)secs * 512)
+	{
+		f_close(&fp);
+		goto out;
+	}
+
+	res = true;
+	for (u64 pos = 0; pos < f_size(&fp) && res; pos += SZ_1M)
+	{
+		UINT br;
+		u32 len = MIN(SZ_1M, f_size(&fp) - pos);
+		res = f_read(&fp, buf, len, &br) == FR_OK && br == len && !memcmp(buf, (u8 *)data + pos, len);
+	}
+	f_close(&fp);
+
+out:
+	sd_unmount();
+	free(buf);
+
+	return res;
+}
+
+bool bench_sd_rename(const char *from, const char *to)
+{
+	bool res = sd_mount() && f_rename(from, to) == FR_OK;
+	sd_unmount();
+
+	return res;
+}
+
+bool bench_sd_remove(const char *path)
+{
+	bool res = sd_mount() && f_unlink(path) == FR_OK;
+	sd_unmount();
+
+	return res;
+}
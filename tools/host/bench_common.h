@@ -0,0 +1,50 @@
+/*
+ * Shared setup for host storage benchmarks and tests.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BENCH_COMMON_H_
+#define _BENCH_COMMON_H_
+
+#include <storage/emmc.h>
+#include <utils/types.h>
+
+// Serial of the simulated eMMC as used in backup paths.
+#define BENCH_EMMC_SN "c0de0003"
+
+/*
+ * Attaches a simulated eMMC of emmc_mb with a GPT (PRODINFO, PRODINFOF, SAFE,
+ * SYSTEM and USER) and filled with pattern data, and a FAT32 formatted SD
+ * card that can hold its backup. Sets the BIS keys.
+ */
+bool bench_setup(u32 emmc_mb);
+
+// Attaches and formats only the SD card.
+bool bench_sd_setup();
+void bench_teardown();
+
+// Deterministic data for a sector range.
+void bench_fill(void *buf, u32 size, u32 seed);
+
+// GPT entry of the simulated eMMC. Must be freed.
+emmc_part_t *bench_gpt_part(const char *name);
+
+// SD helpers. They mount and unmount the SD.
+bool bench_sd_file_matches(const char *path, const void *data, u32 secs);
+bool bench_sd_rename(const char *from, const char *to);
+bool bench_sd_remove(const char *path);
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * CRC32 benchmark.
+ *
+ * Compares the slice-by-8 crc32_calc against the previous table per byte
+ * implementation on backup sized chunks, at aligned and unaligned starts.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include "bench_common.h"
+#include "host_hw.h"
+
+#define BENCH_MB    256
+#define BENCH_CHUNK SZ_4M
+
+typedef u32 (*crc32_t)(u32 crc, const u8 *buf, u32 len);
+
+// Previous implementation.
+static u32 _crc32_old_calc(u32 crc, const u8 *buf, u32 len)
+{
+	const u8 *p, *q;
+	static u32 *table = NULL;
+
+	// Calculate CRC table.
+	if (!table)
+	{
+		table = calloc(256, sizeof(u32));
+		for (u32 i = 0; i < 256; i++)
+		{
+			u32 rem = i;
+			for (u32 j = 0; j < 8; j++)
+			{
+				if (rem & 1)
+				{
+					rem >>= 1;
+					rem ^= 0xedb88320;
+				}
+				else
+					rem >>= 1;
+			}
+			table[i] = rem;
+		}
+	}
+
+	crc = ~crc;
+	q = buf + len;
+	for (p = buf; p < q; p++)
+	{
+		u8 oct = *p;
+		crc = (crc >> 8) ^ table[(crc & 0xff) ^ oct];
+	}
+
+	return ~crc;
+}
+
+static u64 _cpu_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+	return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static u64 _bench(crc32_t fn, const u8 *buf, u32 off, u32 *crc)
+{
+	u64 start = _cpu_us();
+	*crc = 0;
+	for (u32 i = 0; i < BENCH_MB * SZ_1M / BENCH_CHUNK; i++)
+		*crc = fn(*crc, buf + off, BENCH_CHUNK);
+
+	return _cpu_us() - start;
+}
+
+int main()
+{
+	host_init();
+
+	u8 *buf = malloc(BENCH_CHUNK + 8);
+	bench_fill(buf, BENCH_CHUNK + 8, 0);
+
+	printf("%-10s %10s %10s %8s\n", "start", "old MB/s", "new MB/s", "speedup");
+	for (u32 off = 0; off < 4; off += 3)
+	{
+		u32 old_crc, new_crc;
+		u64 old_us = _bench(_crc32_old_calc, buf, off, &old_crc);
+		u64 new_us = _bench(crc32_calc, buf, off, &new_crc);
+		HOST_CHECK(old_crc == new_crc, "offset %d: %08X, expected %08X", off, new_crc, old_crc);
+
+		double old_mbs = (double)BENCH_MB * 1000000 / (old_us ? old_us : 1);
+		double new_mbs = (double)BENCH_MB * 1000000 / (new_us ? new_us : 1);
+		printf("%-10s %10.1f %10.1f %7.2fx\n", off ? "unaligned" : "aligned", old_mbs, new_mbs, new_mbs / old_mbs);
+	}
+
+	free(buf);
+
+	return host_report("bench_crc32");
+}
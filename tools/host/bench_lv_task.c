@@ -0,0 +1,256 @@
+/*
+ * LvGL task scheduler benchmark.
+ *
+ * Runs hundreds of tasks with mixed priorities and periods for 10 s of
+ * modeled time, at one handler pass per ms, with lv_task_handler and with the
+ * previous single list scheduler. Part of the tasks create one-shot tasks, as
+ * Nyx does for deferred work. Reports host CPU time and task runs of each.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/lvgl/lvgl.h>
+
+#include "host_hw.h"
+
+#define BENCH_MS 10000
+
+typedef struct _sched_t
+{
+	void (*handler)(void);
+	lv_task_t *(*create)(void (*task)(void *), uint32_t period, lv_task_prio_t prio, void *param);
+	void (*once)(lv_task_t *task);
+} sched_t;
+
+static const sched_t *sched;
+static u64 runs;
+
+// Previous implementation. One list sorted by priority, walked again from the head after every run.
+static lv_ll_t old_ll;
+static lv_task_t *old_act;
+static bool old_deleted;
+static bool old_created;
+
+static lv_task_t *_old_task_create(void (*task)(void *), uint32_t period, lv_task_prio_t prio, void *param)
+{
+	lv_task_t *new_lv_task = NULL;
+	lv_task_t *tmp;
+
+	// Create task lists in order of priority from high to low.
+	tmp = lv_ll_get_head(&old_ll);
+	if (NULL == tmp)
+		new_lv_task = lv_ll_ins_head(&old_ll);
+	else
+	{
+		do
+		{
+			if (tmp->prio <= prio)
+			{
+				new_lv_task = lv_ll_ins_prev(&old_ll, tmp);
+				break;
+			}
+			tmp = lv_ll_get_next(&old_ll, tmp);
+		} while (tmp != NULL);
+
+		if (tmp == NULL)
+			new_lv_task = lv_ll_ins_tail(&old_ll);
+	}
+
+	new_lv_task->period = period;
+	new_lv_task->task = task;
+	new_lv_task->prio = prio;
+	new_lv_task->param = param;
+	new_lv_task->once = 0;
+	new_lv_task->last_run = lv_tick_get();
+
+	old_created = true;
+
+	return new_lv_task;
+}
+
+static void _old_task_del(lv_task_t *lv_task_p)
+{
+	lv_ll_rem(&old_ll, lv_task_p);
+	lv_mem_free(lv_task_p);
+
+	if (old_act == lv_task_p)
+		old_deleted = true;
+}
+
+static void _old_task_once(lv_task_t *lv_task_p)
+{
+	lv_task_p->once = 1;
+}
+
+static bool _old_task_exec(lv_task_t *lv_task_p)
+{
+	bool exec = false;
+
+	// Execute if at least 'period' time elapsed.
+	uint32_t elp = lv_tick_elaps(lv_task_p->last_run);
+	if (elp >= lv_task_p->period)
+	{
+		lv_task_p->last_run = lv_tick_get();
+		old_deleted = false;
+		old_created = false;
+		lv_task_p->task(lv_task_p->param);
+
+		// Delete if it was a one shot lv_task.
+		if (old_deleted == false && lv_task_p->once != 0)
+			_old_task_del(lv_task_p);
+		exec = true;
+	}
+
+	return exec;
+}
+
+static void _old_task_handler()
+{
+	lv_task_t *task_interrupter = NULL;
+	lv_task_t *next;
+	bool end_flag;
+	do
+	{
+		end_flag = true;
+		old_deleted = false;
+		old_created = false;
+		old_act = lv_ll_get_head(&old_ll);
+		while (old_act)
+		{
+			next = lv_ll_get_next(&old_ll, old_act);
+
+			if (old_act->prio == LV_TASK_PRIO_OFF)
+				break;
+
+			if (old_act == task_interrupter)
+			{
+				task_interrupter = NULL;
+				old_act = next;
+				continue;
+			}
+
+			if (old_act->prio == LV_TASK_PRIO_HIGHEST)
+				_old_task_exec(old_act);
+			else if (task_interrupter)
+			{
+				if (old_act->prio > task_interrupter->prio)
+				{
+					if (_old_task_exec(old_act))
+					{
+						task_interrupter = old_act;
+						end_flag = false;
+						break;
+					}
+				}
+			}
+			else
+			{
+				if (_old_task_exec(old_act))
+				{
+					task_interrupter = old_act;
+					end_flag = false;
+					break;
+				}
+			}
+
+			if (old_deleted)
+				break;
+			if (old_created)
+				break;
+
+			old_act = next;
+		}
+	} while (!end_flag);
+}
+
+static const sched_t sched_old = { _old_task_handler, _old_task_create, _old_task_once };
+static const sched_t sched_new = { lv_task_handler, lv_task_create, lv_task_once };
+
+static void _task_run(void *param)
+{
+	runs++;
+}
+
+// Defers work to a one-shot task, like the Nyx storage and SD card checks.
+static void _task_defer(void *param)
+{
+	runs++;
+
+	lv_task_t *task = sched->create(_task_run, LV_TASK_ONESHOT, LV_TASK_PRIO_LOWEST, NULL);
+	sched->once(task);
+}
+
+static u64 _cpu_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+	return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static u64 _bench(const sched_t *s, u32 tasks, u64 *task_runs)
+{
+	sched = s;
+	runs = 0;
+
+	lv_mem_init();
+	lv_task_init();
+	lv_ll_init(&old_ll, sizeof(lv_task_t));
+
+	u32 rnd = 1;
+	for (u32 i = 0; i < tasks; i++)
+	{
+		rnd = rnd * 1103515245 + 12345;
+		u32 period = 10 + (rnd >> 8) % 500;
+		lv_task_prio_t prio = 1 + (rnd >> 20) % (LV_TASK_PRIO_NUM - 1);
+		s->create((i % 8) ? _task_run : _task_defer, period, prio, NULL);
+	}
+
+	u64 start = _cpu_us();
+	for (u32 ms = 0; ms < BENCH_MS; ms++)
+	{
+		host_time_add(1000);
+		s->handler();
+	}
+	*task_runs = runs;
+
+	return _cpu_us() - start;
+}
+
+int main()
+{
+	host_init();
+	host_time_freeze(true);
+
+	printf("%6s %10s %10s %10s %10s %8s\n", "tasks", "old runs", "new runs", "old us", "new us", "speedup");
+	for (u32 tasks = 100; tasks <= 500; tasks += 200)
+	{
+		u64 old_runs, new_runs;
+		u64 old_us = _bench(&sched_old, tasks, &old_runs);
+		u64 new_us = _bench(&sched_new, tasks, &new_runs);
+
+		// Both run every task once per period. Run times may differ by a tick, so counts differ a little.
+		HOST_CHECK(new_runs >= old_runs * 95 / 100 && new_runs <= old_runs * 105 / 100, "%d tasks: %d runs, old %d",
+			tasks, (u32)new_runs, (u32)old_runs);
+		printf("%6d %10d %10d %10d %10d %7.2fx\n", tasks, (u32)old_runs, (u32)new_runs, (u32)old_us, (u32)new_us,
+			(double)old_us / (new_us ? new_us : 1));
+	}
+
+	return host_report("bench_lv_task");
+}
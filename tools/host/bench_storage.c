@@ -0,0 +1,243 @@
+/*
+ * Storage benchmark for the host build.
+ *
+ * Runs the Nyx eMMC backup and restore paths and raw BIS crypto I/O against
+ * simulated eMMC and SD cards and reports throughput and operation counts.
+ * Throughput is given for modeled time (card latency model and sleeps) and
+ * for host CPU time (the cost of the code itself).
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/fatfs/ff.h>
+#include "frontend/fe_emmc_tools.h"
+
+#include "bench_common.h"
+#include "host_hw.h"
+#include "nyx_host.h"
+#include "sdmmc_sim.h"
+#include "se_soft.h"
+
+typedef struct _bench_sample_t
+{
+	u64 modeled_us;
+	u64 host_us;
+	u64 slept_us;
+	sim_stats_t emmc;
+	sim_stats_t sd;
+	se_soft_stats_t se;
+} bench_sample_t;
+
+static u64 _host_cpu_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+	return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void _bench_start(bench_sample_t *s)
+{
+	s->modeled_us = host_time_us();
+	s->host_us = _host_cpu_us();
+	s->slept_us = host_sleep_stats()->slept_us;
+	s->emmc = *sim_card_stats(SDMMC_4);
+	s->sd = *sim_card_stats(SDMMC_1);
+	s->se = *se_soft_stats();
+}
+
+static void _bench_report(const char *name, bench_sample_t *s, u64 bytes)
+{
+	u64 modeled = host_time_us() - s->modeled_us;
+	u64 host = _host_cpu_us() - s->host_us;
+	u64 slept = host_sleep_stats()->slept_us - s->slept_us;
+	sim_stats_t *emmc = sim_card_stats(SDMMC_4);
+	sim_stats_t *sd = sim_card_stats(SDMMC_1);
+
+	// Fully cached workloads take no modeled time.
+	char modeled_mbs[16] = "    n/a";
+	if (modeled)
+		snprintf(modeled_mbs, sizeof(modeled_mbs), "%7.1f", (double)bytes / SZ_1M * 1000000 / modeled);
+
+	printf("%-10s %7.1f MB  modeled %s MB/s  host %7.1f MB/s  sleep %6d ms\n", name,
+		(double)bytes / SZ_1M, modeled_mbs,
+		host ? (double)bytes / SZ_1M * 1000000 / host : 0,
+		(u32)(slept / 1000));
+	printf("%-10s eMMC cmds %6lu rd %6lu wr %6lu err %lu init %lu | SD cmds %6lu rd %6lu wr %6lu err %lu init %lu | SE ops %lu\n", "",
+		emmc->cmds - s->emmc.cmds, emmc->reads - s->emmc.reads, emmc->writes - s->emmc.writes,
+		emmc->errors - s->emmc.errors, emmc->inits - s->emmc.inits,
+		sd->cmds - s->sd.cmds, sd->reads - s->sd.reads, sd->writes - s->sd.writes,
+		sd->errors - s->sd.errors, sd->inits - s->sd.inits,
+		se_soft_stats()->ops - s->se.ops);
+}
+
+static void _bench_dump(emmc_tool_gui_t *gui, u32 emmc_secs)
+{
+	bench_sample_t s;
+	u64 bytes = (u64)emmc_secs * 512 + SIM_BOOT_PART_SECS * 512 * 2;
+
+	_bench_start(&s);
+	dump_emmc_selected(PART_BOOT | PART_RAW, gui);
+	_bench_report("dump", &s, bytes);
+
+	HOST_CHECK(bench_sd_file_matches("backup/" BENCH_EMMC_SN "/rawnand.bin", sim_card_data(SDMMC_4, 0), emmc_secs),
+		"rawnand.bin does not match the eMMC");
+	HOST_CHECK(bench_sd_file_matches("backup/" BENCH_EMMC_SN "/BOOT0", sim_card_data(SDMMC_4, 1), SIM_BOOT_PART_SECS),
+		"BOOT0 does not match the eMMC");
+}
+
+static void _bench_restore(emmc_tool_gui_t *gui, u32 emmc_secs)
+{
+	bench_sample_t s;
+	u64 bytes = (u64)emmc_secs * 512;
+	u8 hash[SE_SHA_256_SIZE];
+	u8 *emmc = sim_card_data(SDMMC_4, 0);
+
+	se_calc_sha256_oneshot(hash, emmc, emmc_secs * 512);
+	HOST_CHECK(bench_sd_rename("backup/" BENCH_EMMC_SN "/rawnand.bin", "backup/" BENCH_EMMC_SN "/restore/rawnand.bin"),
+		"failed to stage rawnand.bin for restore");
+
+	// Clobber everything after the GPT.
+	memset(emmc + SZ_1M, 0x5A, (u64)emmc_secs * 512 - SZ_1M);
+
+	// The countdown before the restore is not part of the workload.
+	u64 countdown = 6 * 1000000;
+	_bench_start(&s);
+	s.modeled_us += countdown;
+	s.slept_us += countdown;
+	restore_emmc_selected(PART_RAW, gui);
+	_bench_report("restore", &s, bytes);
+
+	u8 hash_after[SE_SHA_256_SIZE];
+	se_calc_sha256_oneshot(hash_after, emmc, emmc_secs * 512);
+	HOST_CHECK(!memcmp(hash, hash_after, SE_SHA_256_SIZE), "restored eMMC does not match the backup");
+}
+
+static void _bench_bis(emmc_part_t *system, bool cache)
+{
+	bench_sample_t s;
+	u32 secs = system->lba_end - system->lba_start + 1;
+	u32 chunk = 0x800; // 1MB.
+	u8 *buf = malloc(chunk * 512);
+	u8 *cmp = malloc(chunk * 512);
+
+	emmc_initialize(false);
+	sdmmc_storage_set_mmc_partition(&emmc_storage, EMMC_GPP);
+	nx_emmc_bis_init(system, cache, 0);
+
+	// Sequential write.
+	_bench_start(&s);
+	for (u32 sct = 0; sct < secs; sct += chunk)
+	{
+		bench_fill(buf, chunk * 512, sct);
+		HOST_CHECK(nx_emmc_bis_write(sct, chunk, buf), "BIS write failed at %X", sct);
+	}
+	nx_emmc_bis_end();
+	_bench_report(cache ? "bis wr$" : "bis wr", &s, (u64)secs * 512);
+
+	// Sequential read.
+	nx_emmc_bis_init(system, cache, 0);
+	_bench_start(&s);
+	for (u32 sct = 0; sct < secs; sct += chunk)
+	{
+		HOST_CHECK(nx_emmc_bis_read(sct, chunk, buf), "BIS read failed at %X", sct);
+		bench_fill(cmp, chunk * 512, sct);
+		HOST_CHECK(!memcmp(buf, cmp, chunk * 512), "BIS data mismatch at %X", sct);
+	}
+	_bench_report(cache ? "bis rd$" : "bis rd", &s, (u64)secs * 512);
+
+	// Small reads, the FatFs metadata pattern.
+	_bench_start(&s);
+	u32 rnd = 1;
+	for (u32 i = 0; i < 4096; i++)
+	{
+		rnd = rnd * 1103515245 + 12345;
+		u32 sct = (rnd >> 8) % (secs - 8);
+		HOST_CHECK(nx_emmc_bis_read(sct, 1, buf), "BIS read failed at %X", sct);
+	}
+	_bench_report(cache ? "bis 512$" : "bis 512", &s, 4096 * 512);
+	nx_emmc_bis_end();
+
+	sdmmc_storage_end(&emmc_storage);
+
+	// The ciphertext must not be the plaintext.
+	bench_fill(cmp, 512, 0);
+	HOST_CHECK(memcmp(sim_card_data(SDMMC_4, 0) + (u64)system->lba_start * 512, cmp, 512), "BIS data is not encrypted");
+
+	free(buf);
+	free(cmp);
+}
+
+static void _usage(const char *name)
+{
+	printf("Usage: %s [-m emmc_mb] [-r read_mbs] [-w write_mbs] [-l cmd_us] [-c crc_ppm] [-t timeout_ppm] [-s seed]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	u32 emmc_mb = 256;
+	sim_latency_t lat = { 30, 300, 100 };
+	sim_errors_t err = { 1, 0, 0 };
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:r:w:l:c:t:s:h")) != -1)
+	{
+		switch (opt)
+		{
+		case 'm': emmc_mb = atoi(optarg); break;
+		case 'r': lat.read_mbs = atoi(optarg); break;
+		case 'w': lat.write_mbs = atoi(optarg); break;
+		case 'l': lat.cmd_us = atoi(optarg); break;
+		case 'c': err.crc_ppm = atoi(optarg); break;
+		case 't': err.timeout_ppm = atoi(optarg); break;
+		case 's': err.seed = atoi(optarg); break;
+		default:
+			_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	nyx_host_init();
+	host_time_freeze(true);
+
+	if (!bench_setup(emmc_mb))
+		return 1;
+
+	sim_card_set_latency(SDMMC_4, &lat);
+	sim_card_set_errors(SDMMC_4, &err);
+
+	printf("eMMC %d MB, %d/%d MB/s, %d us/cmd, crc %d ppm, timeout %d ppm\n",
+		emmc_mb, lat.read_mbs, lat.write_mbs, lat.cmd_us, err.crc_ppm, err.timeout_ppm);
+
+	emmc_tool_gui_t gui;
+	nyx_host_emmc_gui(&gui);
+
+	_bench_dump(&gui, emmc_mb * 0x800);
+	_bench_restore(&gui, emmc_mb * 0x800);
+
+	emmc_part_t *system = bench_gpt_part("SYSTEM");
+	_bench_bis(system, false);
+	_bench_bis(system, true);
+	free(system);
+
+	bench_teardown();
+
+	return host_report("bench_storage");
+}
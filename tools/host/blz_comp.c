@@ -0,0 +1,198 @@
+/*
+ * BLZ compressor for host tests and benchmarks.
+ *
+ * Greedy backwards LZ with a 3 byte hash, matching the stream format that
+ * blz_uncompress_inplace decodes. Matches only copy from bytes that are
+ * already decoded, so the stream is valid for in place decompression.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bdk.h>
+
+#include <libs/compr/blz.h>
+
+#include "blz_comp.h"
+
+#define BLZ_MIN_MATCH 3
+#define BLZ_MAX_MATCH 18
+#define BLZ_MAX_OFS   (0xFFF + 3)
+#define BLZ_HASH_BITS 16
+
+typedef struct _blz_tok_t
+{
+	u16 len; // 0 for a literal.
+	u16 ofs;
+} blz_tok_t;
+
+static u32 _blz_hash(const u8 *p)
+{
+	return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761U) >> (32 - BLZ_HASH_BITS);
+}
+
+// Tokens in decode order, from the end of the data to its start.
+static u32 _blz_tokenize(blz_tok_t *toks, const u8 *src, u32 size)
+{
+	u32 *last = malloc((1 << BLZ_HASH_BITS) * sizeof(u32));
+	memset(last, 0xFF, (1 << BLZ_HASH_BITS) * sizeof(u32));
+
+	u32 cnt = 0;
+	u32 pos = size;
+	u32 next_end = size;
+	while (pos)
+	{
+		// Sources end at least 3 bytes past the destination end. Add the ends that became valid.
+		while (next_end >= pos + BLZ_MIN_MATCH)
+		{
+			last[_blz_hash(&src[next_end - BLZ_MIN_MATCH])] = next_end;
+			next_end--;
+		}
+
+		u32 len = 0;
+		u32 ofs = 0;
+		if (pos >= BLZ_MIN_MATCH)
+		{
+			u32 end = last[_blz_hash(&src[pos - BLZ_MIN_MATCH])];
+			if (end != 0xFFFFFFFF && end - pos <= BLZ_MAX_OFS)
+			{
+				ofs = end - pos;
+				u32 max = MIN(MIN(BLZ_MAX_MATCH, ofs), pos);
+				while (len < max && src[pos - 1 - len] == src[end - 1 - len])
+					len++;
+			}
+		}
+
+		if (len >= BLZ_MIN_MATCH)
+		{
+			toks[cnt].len = len;
+			toks[cnt].ofs = ofs;
+			pos -= len;
+		}
+		else
+		{
+			toks[cnt].len = 0;
+			pos--;
+		}
+		cnt++;
+	}
+
+	free(last);
+
+	return cnt;
+}
+
+// Writes the stream of the first cnt tokens in read order and then reverses it.
+static u32 _blz_emit(u8 *dst, const blz_tok_t *toks, u32 cnt, const u8 *src, u32 size)
+{
+	u32 len = 0;
+	u32 pos = size;
+
+	for (u32 i = 0; i < cnt;)
+	{
+		u32 ctrl_idx = len++;
+		u8 ctrl = 0;
+		for (u32 bit = 0; bit < 8 && i < cnt; bit++, i++)
+		{
+			if (toks[i].len)
+			{
+				u16 val = ((toks[i].len - BLZ_MIN_MATCH) << 12) | (toks[i].ofs - BLZ_MIN_MATCH);
+				ctrl |= 0x80 >> bit;
+				dst[len++] = val >> 8;
+				dst[len++] = val & 0xFF;
+				pos -= toks[i].len;
+			}
+			else
+				dst[len++] = src[--pos];
+		}
+		dst[ctrl_idx] = ctrl;
+	}
+
+	// Stored in reverse, since it is read backwards.
+	for (u32 i = 0; i < len / 2; i++)
+	{
+		u8 tmp = dst[i];
+		dst[i] = dst[len - 1 - i];
+		dst[len - 1 - i] = tmp;
+	}
+
+	return len;
+}
+
+u32 blz_host_compress(u8 *dst, const u8 *src, u32 size)
+{
+	blz_tok_t *toks = malloc((size + 1) * sizeof(blz_tok_t));
+	u8 *stream = malloc(size * 2 + 16);
+	u32 cnt = _blz_tokenize(toks, src, size);
+	u32 res = 0;
+
+	// Tokens are in decode order, so a raw prefix is a run of tokens at the end of the list.
+	// Find the shortest prefix for which output never overtakes unread input.
+	u32 raw_toks = 0;
+	u32 raw = 0;
+	for (;;)
+	{
+		u32 last = cnt - raw_toks;
+		u32 stream_len = _blz_emit(stream, toks, last, src, size);
+		u32 hdr_size = ALIGN(stream_len, 4) - stream_len + sizeof(blz_footer);
+		u32 out_size = size - raw;
+		if (stream_len + hdr_size >= out_size)
+			break; // Does not compress.
+
+		// Simulate the decoder positions.
+		bool safe = true;
+		s64 in = stream_len;
+		s64 out = out_size;
+		for (u32 i = 0; i < last && safe; i++)
+		{
+			if (!(i & 7))
+				in--;
+			in -= toks[i].len ? 2 : 1;
+			out -= toks[i].len ? toks[i].len : 1;
+			safe = out >= in;
+		}
+
+		if (safe)
+		{
+			memcpy(dst, src, raw);
+			memcpy(dst + raw, stream, stream_len);
+			memset(dst + raw + stream_len, 0xFF, hdr_size - sizeof(blz_footer));
+
+			blz_footer footer;
+			footer.cmp_and_hdr_size = stream_len + hdr_size;
+			footer.header_size = hdr_size;
+			footer.addl_size = out_size - footer.cmp_and_hdr_size;
+			memcpy(dst + raw + stream_len + hdr_size - sizeof(blz_footer), &footer, sizeof(blz_footer));
+
+			res = raw + footer.cmp_and_hdr_size;
+			break;
+		}
+
+		// Move the first 16 bytes or more of the data to the raw prefix.
+		u32 moved = 0;
+		while (moved < 16 && raw_toks < cnt)
+		{
+			blz_tok_t *tok = &toks[cnt - 1 - raw_toks++];
+			moved += tok->len ? tok->len : 1;
+		}
+		raw += moved;
+		if (raw_toks == cnt)
+			break;
+	}
+
+	free(toks);
+	free(stream);
+
+	return res;
+}
@@ -0,0 +1,31 @@
+/*
+ * BLZ compressor for host tests and benchmarks.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BLZ_COMP_H_
+#define _BLZ_COMP_H_
+
+#include <utils/types.h>
+
+/*
+ * Compresses src to a stream that decompresses in place, with a raw prefix
+ * where needed. dst must hold size + 16 bytes. Returns the compressed size
+ * with the footer or 0 if the data does not compress.
+ */
+u32 blz_host_compress(u8 *dst, const u8 *src, u32 size);
+
+#endif
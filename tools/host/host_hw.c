@@ -0,0 +1,216 @@
+/*
+ * Host build hardware glue.
+ *
+ * Backs the physical address window with host memory, models time and stubs
+ * the SoC functions that the portable bdk and Nyx code reaches.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <execinfo.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+#include <bdk.h>
+
+#include "host_hw.h"
+
+u32 host_failures = 0;
+
+static struct timespec host_t0;
+static u64  host_time_offset = 0;
+static bool host_time_frozen = false;
+static host_sleep_stats_t host_sleeps = {0};
+
+volatile nyx_storage_t *nyx_str = (nyx_storage_t *)NYX_STORAGE_ADDR;
+
+static void _host_crash(int sig)
+{
+	void *frames[32];
+	int n = backtrace(frames, ARRAY_SIZE(frames));
+
+	fprintf(stderr, "Caught signal %d\n", sig);
+	backtrace_symbols_fd(frames, n, 2);
+	_exit(128 + sig);
+}
+
+void host_init()
+{
+	static bool mapped = false;
+
+	if (!mapped)
+	{
+		// Lazily backed. Only touched pages use memory.
+		void *base = mmap((void *)HOST_PHYS_START, HOST_PHYS_END - HOST_PHYS_START, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+		if (base != (void *)HOST_PHYS_START)
+		{
+			fprintf(stderr, "Failed to map the physical window at 0x%lX\n", HOST_PHYS_START);
+			exit(2);
+		}
+		mapped = true;
+
+		signal(SIGSEGV, _host_crash);
+		signal(SIGBUS, _host_crash);
+		signal(SIGABRT, _host_crash);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &host_t0);
+	host_time_offset = 0;
+	host_time_frozen = false;
+	memset(&host_sleeps, 0, sizeof(host_sleeps));
+
+	gfx_init_ctxt((u32 *)NYX_FB_ADDRESS, 720, 1280, 720);
+	gfx_con_init();
+	gfx_con.mute = true;
+}
+
+u64 host_time_us()
+{
+	if (host_time_frozen)
+		return host_time_offset;
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	u64 real = (u64)(now.tv_sec - host_t0.tv_sec) * 1000000 + (now.tv_nsec - host_t0.tv_nsec) / 1000;
+
+	return real + host_time_offset;
+}
+
+void host_time_add(u64 us)
+{
+	host_time_offset += us;
+}
+
+void host_time_freeze(bool freeze)
+{
+	if (freeze && !host_time_frozen)
+		host_time_offset = host_time_us();
+
+	host_time_frozen = freeze;
+}
+
+host_sleep_stats_t *host_sleep_stats()
+{
+	return &host_sleeps;
+}
+
+int host_report(const char *name)
+{
+	if (host_failures)
+		printf("%s: %d failure(s)\n", name, host_failures);
+	else
+		printf("%s: OK\n", name);
+
+	return host_failures ? 1 : 0;
+}
+
+/*
+ * Timers.
+ */
+
+u32 get_tmr_us() { return (u32)host_time_us(); }
+u32 get_tmr_ms() { return (u32)(host_time_us() / 1000); }
+u32 get_tmr_s()  { return (u32)(host_time_us() / 1000000); }
+
+void bpmp_usleep(u32 us)
+{
+	host_sleeps.sleeps++;
+	host_sleeps.slept_us += us;
+	host_time_add(us);
+}
+
+void bpmp_msleep(u32 ms)   { bpmp_usleep(ms * 1000); }
+void usleep(u32 us)        { bpmp_usleep(us); }
+void msleep(u32 ms)        { bpmp_usleep(ms * 1000); }
+void timer_usleep(u32 us)  { bpmp_usleep(us); }
+
+void watchdog_start(u32 us, u32 mode) {}
+void watchdog_end() {}
+void watchdog_handle() {}
+bool watchdog_fired() { return false; }
+
+/*
+ * SoC.
+ */
+
+void bpmp_halt()
+{
+	fprintf(stderr, "bpmp_halt\n");
+	exit(3);
+}
+
+bpmp_mmu_maint_stats_t bpmp_mmu_maint_stats;
+void bpmp_mmu_maintenance(u32 op, bool force) {}
+void bpmp_clk_rate_get() {}
+
+bool mc_client_has_access(void *address) { return true; }
+
+void minerva_change_freq(minerva_freq_t freq) {}
+
+u32 fuse_read_hw_state() { return FUSE_NX_HW_STATE_PROD; }
+
+void hw_reinit_workaround(bool coreboot, u32 magic) {}
+
+void heap_init(void *base) {}
+void heap_set(heap_t *heap) {}
+void heap_monitor(heap_monitor_t *mon, bool print_node_stats) { memset(mon, 0, sizeof(heap_monitor_t)); }
+
+/*
+ * Libc functions that newlib has.
+ */
+
+char *itoa(int value, char *buf, int radix)
+{
+	static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+	char tmp[34];
+	u32 uval = (radix == 10 && value < 0) ? -value : (u32)value;
+	u32 pos = 0;
+
+	do
+	{
+		tmp[pos++] = digits[uval % radix];
+		uval /= radix;
+	} while (uval);
+
+	char *dst = buf;
+	if (radix == 10 && value < 0)
+		*dst++ = '-';
+	while (pos)
+		*dst++ = tmp[--pos];
+	*dst = 0;
+
+	return buf;
+}
+
+/*
+ * FatFs system functions.
+ */
+
+void *ff_memalloc(UINT msize) { return malloc(msize); }
+void  ff_memfree(void *mblock) { free(mblock); }
+
+DWORD get_fattime()
+{
+	// 2022-01-01 00:00:00 plus modeled time.
+	struct tm tm;
+	time_t now = 1640995200 + host_time_us() / 1000000;
+	gmtime_r(&now, &tm);
+
+	return ((DWORD)(tm.tm_year - 80) << 25) | ((DWORD)(tm.tm_mon + 1) << 21) | ((DWORD)tm.tm_mday << 16) |
+		((DWORD)tm.tm_hour << 11) | ((DWORD)tm.tm_min << 5) | ((DWORD)tm.tm_sec >> 1);
+}
@@ -0,0 +1,64 @@
+/*
+ * Host build hardware glue.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _HOST_HW_H_
+#define _HOST_HW_H_
+
+#include <stdio.h>
+
+#include <utils/types.h>
+
+// Physical address window that is backed by host memory. Covers IRAM, MMIO and DRAM.
+#define HOST_PHYS_START 0x40000000UL
+#define HOST_PHYS_END   0x100000000UL
+
+typedef struct _host_sleep_stats_t
+{
+	u64 sleeps;   // bpmp_usleep/msleep/usleep/msleep calls.
+	u64 slept_us; // Total modeled sleep time.
+} host_sleep_stats_t;
+
+// Maps the physical window, sets up the console framebuffer and resets the clock.
+void host_init();
+
+// Modeled time. Real elapsed time plus all modeled device latency and sleeps.
+u64  host_time_us();
+void host_time_add(u64 us);
+
+// When set, only modeled time advances. Makes timing based tests deterministic.
+void host_time_freeze(bool freeze);
+
+host_sleep_stats_t *host_sleep_stats();
+
+// Test helpers.
+extern u32 host_failures;
+
+#define HOST_CHECK(cond, ...) \
+	do { \
+		if (!(cond)) \
+		{ \
+			host_failures++; \
+			printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+		} \
+	} while (0)
+
+int host_report(const char *name);
+
+#endif
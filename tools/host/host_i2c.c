@@ -0,0 +1,244 @@
+/*
+ * Host I2C bus model.
+ *
+ * Implements the i2c.h API over per device register files, with transfer
+ * counting and failure injection.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <soc/i2c.h>
+
+#include "host_i2c.h"
+
+#define HOST_I2C_BUSES    6
+#define HOST_I2C_DEVS     128
+#define HOST_I2C_REGS_MAX 512
+
+typedef struct _host_i2c_dev_t
+{
+	bool attached;
+	u32 width;
+	u32 fail_reg;
+	u32 fail_count;
+	u32 xfers;
+	u8 regs[HOST_I2C_REGS_MAX];
+} host_i2c_dev_t;
+
+static host_i2c_dev_t *host_i2c_devs[HOST_I2C_BUSES][HOST_I2C_DEVS];
+static u32 host_i2c_total_xfers = 0;
+
+static host_i2c_dev_t *_host_i2c_dev(u32 i2c_idx, u32 dev_addr)
+{
+	if (i2c_idx >= HOST_I2C_BUSES || dev_addr >= HOST_I2C_DEVS)
+		return NULL;
+
+	host_i2c_dev_t *dev = host_i2c_devs[i2c_idx][dev_addr];
+
+	return (dev && dev->attached) ? dev : NULL;
+}
+
+// Returns the register file window of a transfer or NULL if it NAKs.
+static u8 *_host_i2c_xfer(u32 i2c_idx, u32 dev_addr, u32 reg, u32 size)
+{
+	host_i2c_total_xfers++;
+
+	host_i2c_dev_t *dev = _host_i2c_dev(i2c_idx, dev_addr);
+	if (!dev)
+		return NULL;
+
+	dev->xfers++;
+
+	if (dev->fail_count && (dev->fail_reg == ~0U || dev->fail_reg == reg))
+	{
+		dev->fail_count--;
+		return NULL;
+	}
+
+	u32 off = reg * dev->width;
+	if (off + size > HOST_I2C_REGS_MAX)
+		return NULL;
+
+	return &dev->regs[off];
+}
+
+void host_i2c_attach(u32 i2c_idx, u32 dev_addr, u32 width)
+{
+	if (i2c_idx >= HOST_I2C_BUSES || dev_addr >= HOST_I2C_DEVS)
+		return;
+
+	if (!host_i2c_devs[i2c_idx][dev_addr])
+		host_i2c_devs[i2c_idx][dev_addr] = calloc(1, sizeof(host_i2c_dev_t));
+
+	host_i2c_dev_t *dev = host_i2c_devs[i2c_idx][dev_addr];
+	memset(dev, 0, sizeof(host_i2c_dev_t));
+	dev->attached = true;
+	dev->width = width ? width : 1;
+}
+
+void host_i2c_reset()
+{
+	for (u32 i = 0; i < HOST_I2C_BUSES; i++)
+	{
+		for (u32 j = 0; j < HOST_I2C_DEVS; j++)
+		{
+			free(host_i2c_devs[i][j]);
+			host_i2c_devs[i][j] = NULL;
+		}
+	}
+	host_i2c_total_xfers = 0;
+}
+
+u8 *host_i2c_regs(u32 i2c_idx, u32 dev_addr)
+{
+	host_i2c_dev_t *dev = _host_i2c_dev(i2c_idx, dev_addr);
+
+	return dev ? dev->regs : NULL;
+}
+
+void host_i2c_set_reg16(u32 i2c_idx, u32 dev_addr, u32 reg, u16 val)
+{
+	host_i2c_dev_t *dev = _host_i2c_dev(i2c_idx, dev_addr);
+
+	if (dev)
+		memcpy(&dev->regs[reg * dev->width], &val, 2);
+}
+
+u16 host_i2c_get_reg16(u32 i2c_idx, u32 dev_addr, u32 reg)
+{
+	u16 val = 0;
+	host_i2c_dev_t *dev = _host_i2c_dev(i2c_idx, dev_addr);
+
+	if (dev)
+		memcpy(&val, &dev->regs[reg * dev->width], 2);
+
+	return val;
+}
+
+void host_i2c_fail(u32 i2c_idx, u32 dev_addr, u32 reg, u32 count)
+{
+	host_i2c_dev_t *dev = _host_i2c_dev(i2c_idx, dev_addr);
+
+	if (dev)
+	{
+		dev->fail_reg = reg;
+		dev->fail_count = count;
+	}
+}
+
+u32 host_i2c_xfers(u32 i2c_idx, u32 dev_addr)
+{
+	host_i2c_dev_t *dev = _host_i2c_dev(i2c_idx, dev_addr);
+
+	return dev ? dev->xfers : 0;
+}
+
+void i2c_init(u32 i2c_idx)
+{
+}
+
+int i2c_recv_buf(u8 *buf, u32 size, u32 i2c_idx, u32 dev_addr)
+{
+	if (size > 8)
+		return 0;
+
+	u8 *regs = _host_i2c_xfer(i2c_idx, dev_addr, 0, size);
+	if (!regs)
+		return 0;
+
+	memcpy(buf, regs, size);
+
+	return 1;
+}
+
+// Packet mode transfers return 0 on success, like i2c.c.
+int i2c_send_buf_big(u32 i2c_idx, u32 dev_addr, u8 *buf, u32 size)
+{
+	if (!size || size > 32)
+		return 0;
+
+	// First byte is the register.
+	u8 *regs = _host_i2c_xfer(i2c_idx, dev_addr, buf[0], size - 1);
+	if (!regs)
+		return 1;
+
+	memcpy(regs, buf + 1, size - 1);
+
+	return 0;
+}
+
+int i2c_recv_buf_big(u8 *buf, u32 size, u32 i2c_idx, u32 dev_addr, u32 reg)
+{
+	if (size > 32)
+		return 0;
+
+	u8 *regs = _host_i2c_xfer(i2c_idx, dev_addr, reg, size);
+	if (!regs)
+		return 1;
+
+	memcpy(buf, regs, size);
+
+	return 0;
+}
+
+int i2c_send_buf_small(u32 i2c_idx, u32 dev_addr, u32 reg, u8 *buf, u32 size)
+{
+	if (size > 7)
+		return 0;
+
+	u8 *regs = _host_i2c_xfer(i2c_idx, dev_addr, reg, size);
+	if (!regs)
+		return 0;
+
+	memcpy(regs, buf, size);
+
+	return 1;
+}
+
+int i2c_recv_buf_small(u8 *buf, u32 size, u32 i2c_idx, u32 dev_addr, u32 reg)
+{
+	if (size > 8)
+		return 0;
+
+	// Register write and then read, like i2c.c.
+	if (!_host_i2c_xfer(i2c_idx, dev_addr, reg, 0))
+		return 0;
+
+	u8 *regs = _host_i2c_xfer(i2c_idx, dev_addr, reg, size);
+	if (!regs)
+		return 0;
+
+	memcpy(buf, regs, size);
+
+	return 1;
+}
+
+int i2c_send_byte(u32 i2c_idx, u32 dev_addr, u32 reg, u8 val)
+{
+	return i2c_send_buf_small(i2c_idx, dev_addr, reg, &val, 1);
+}
+
+u8 i2c_recv_byte(u32 i2c_idx, u32 dev_addr, u32 reg)
+{
+	u8 tmp = 0;
+	i2c_recv_buf_small(&tmp, 1, i2c_idx, dev_addr, reg);
+
+	return tmp;
+}
+
+u32 i2c_get_xfer_count()
+{
+	return host_i2c_total_xfers;
+}
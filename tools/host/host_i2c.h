@@ -0,0 +1,44 @@
+/*
+ * Host I2C bus model.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _HOST_I2C_H_
+#define _HOST_I2C_H_
+
+#include <utils/types.h>
+
+/*
+ * Every device is a register file. A transfer at register reg accesses the
+ * bytes from reg * width on, so devices with 16-bit registers (fuel gauge)
+ * and 8-bit registers (PMIC) can be modeled. Devices not attached NAK.
+ * Return values and transfer counts follow i2c.c: small reads are a register
+ * write and a read, packet mode transfers are one and return 0 on success.
+ */
+void host_i2c_attach(u32 i2c_idx, u32 dev_addr, u32 width);
+void host_i2c_reset();
+
+u8  *host_i2c_regs(u32 i2c_idx, u32 dev_addr);
+void host_i2c_set_reg16(u32 i2c_idx, u32 dev_addr, u32 reg, u16 val);
+u16  host_i2c_get_reg16(u32 i2c_idx, u32 dev_addr, u32 reg);
+
+// Makes the next count transfers to a device fail. Transfers to any register fail when reg is ~0.
+void host_i2c_fail(u32 i2c_idx, u32 dev_addr, u32 reg, u32 count);
+
+// Transfers that reached an attached device, failed ones included.
+u32 host_i2c_xfers(u32 i2c_idx, u32 dev_addr);
+
+#endif
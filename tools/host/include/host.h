@@ -0,0 +1,40 @@
+/*
+ * Host build glue. Force-included before every bdk source.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _HOST_H_
+#define _HOST_H_
+
+// Pull in the libc types first so that bdk names that clash with them can be renamed.
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+
+// In newlib's stdlib.h but not in glibc's. Defined in host_hw.c.
+char *itoa(int value, char *buf, int radix);
+
+// The bdk usleep returns nothing.
+#define usleep libc_usleep
+#include <unistd.h>
+#undef usleep
+
+// soc/clock.h has its own clock_t.
+#define clock_t bdk_clock_t
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Nyx glue for the host build.
+ *
+ * Provides the parts of nyx.c and gui.c that the linked frontend code calls,
+ * a headless LvGL display and scripted buttons.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <bdk.h>
+
+#include "config.h"
+#include <libs/fatfs/ff.h>
+#include <libs/lvgl/lvgl.h>
+#include "frontend/gui.h"
+
+#include "host_hw.h"
+#include "nyx_host.h"
+
+nyx_config n_cfg;
+hekate_config h_cfg;
+
+lv_style_t mbox_darken;
+
+static nyx_host_ui_t host_ui = {0};
+static u32 host_btn_wait = BTN_POWER;
+static u32 host_btn_vol = 0;
+
+// Same as in nyx.c.
+char *emmcsn_path_impl(char *path, char *sub_dir, char *filename, sdmmc_storage_t *storage)
+{
+	static char emmc_sn[9] = {0};
+
+	// Check if eMMC S/N storage has valid data and skip parsing in that case.
+	if (emmc_sn[0] && strcmp(emmc_sn, "00000000"))
+		goto create_dir;
+
+	// Get actual eMMC S/N.
+	if (!storage)
+	{
+		if (!emmc_initialize(false))
+			strcpy(emmc_sn, "00000000");
+		else
+		{
+			itoa(emmc_storage.cid.serial, emmc_sn, 16);
+			sdmmc_storage_end(&emmc_storage);
+		}
+	}
+	else
+		itoa(storage->cid.serial, emmc_sn, 16);
+
+create_dir:
+	// Check if only eMMC S/N was requested.
+	if (!path)
+		return emmc_sn;
+
+	// Create main folder.
+	strcpy(path, "backup");
+	f_mkdir(path);
+
+	// Create eMMC S/N folder.
+	strcat(path, "/");
+	strcat(path, emmc_sn);
+	f_mkdir(path);
+
+	// Create sub folder if defined. Dir slash must be included.
+	strcat(path, sub_dir);  // Can be a null-terminator.
+	if (strlen(sub_dir))
+		f_mkdir(path);
+
+	// Add filename.
+	strcat(path, "/");
+	strcat(path, filename); // Can be a null-terminator.
+
+	return emmc_sn;
+}
+
+void manual_system_maintenance(bool refresh)
+{
+	host_ui.maintenance++;
+	if (refresh)
+	{
+		host_ui.refreshes++;
+		if (host_ui.render)
+			lv_refr_now();
+	}
+}
+
+lv_res_t mbox_action(lv_obj_t *btns, const char *txt)
+{
+	lv_obj_t *mbox = lv_mbox_get_from_btn(btns);
+	lv_obj_t *dark_bg = lv_obj_get_parent(mbox);
+
+	lv_obj_del(dark_bg);
+
+	return LV_RES_INV;
+}
+
+u8 btn_wait()
+{
+	return host_btn_wait;
+}
+
+u8 btn_read_vol()
+{
+	return host_btn_vol;
+}
+
+static void _host_disp_flush(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const lv_color_t *color_p)
+{
+	host_ui.flushes++;
+	lv_flush_ready();
+}
+
+void nyx_host_init()
+{
+	static bool lv_ready = false;
+
+	host_init();
+
+	memset(&n_cfg, 0, sizeof(n_cfg));
+	n_cfg.verification = 1;
+
+	if (!lv_ready)
+	{
+		lv_init();
+
+		lv_disp_drv_t disp_drv;
+		lv_disp_drv_init(&disp_drv);
+		disp_drv.disp_flush = _host_disp_flush;
+		lv_disp_drv_register(&disp_drv);
+
+		lv_theme_set_current(lv_theme_cwad_init(0, NULL));
+		lv_ready = true;
+	}
+}
+
+void nyx_host_emmc_gui(emmc_tool_gui_t *gui)
+{
+	static lv_style_t bar_teal_bg, bar_teal_ind, bar_white_ind;
+
+	lv_style_copy(&bar_teal_bg, lv_theme_get_current()->bar.bg);
+	lv_style_copy(&bar_teal_ind, lv_theme_get_current()->bar.indic);
+	lv_style_copy(&bar_white_ind, lv_theme_get_current()->bar.indic);
+
+	memset(gui, 0, sizeof(emmc_tool_gui_t));
+	lv_obj_t *parent = lv_scr_act();
+	gui->label_log = lv_label_create(parent, NULL);
+	gui->label_info = lv_label_create(parent, NULL);
+	gui->label_pct = lv_label_create(parent, NULL);
+	gui->label_finish = lv_label_create(parent, NULL);
+	gui->bar = lv_bar_create(parent, NULL);
+	gui->bar_teal_bg = &bar_teal_bg;
+	gui->bar_teal_ind = &bar_teal_ind;
+	gui->bar_white_ind = &bar_white_ind;
+}
+
+void nyx_host_set_buttons(u32 wait, u32 vol)
+{
+	host_btn_wait = wait;
+	host_btn_vol = vol;
+}
+
+nyx_host_ui_t *nyx_host_ui()
+{
+	return &host_ui;
+}
+
+void save_emummc_cfg(u32 part_idx, u32 sector_start, const char *path)
+{
+}
@@ -0,0 +1,44 @@
+/*
+ * Nyx glue for the host build.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NYX_HOST_H_
+#define _NYX_HOST_H_
+
+#include <utils/types.h>
+#include "frontend/gui.h"
+
+typedef struct _nyx_host_ui_t
+{
+	bool render;     // Render the screen on refresh requests. Off by default.
+	u64 maintenance; // manual_system_maintenance calls.
+	u64 refreshes;   // manual_system_maintenance calls that asked for a refresh.
+	u64 flushes;     // Display flushes.
+} nyx_host_ui_t;
+
+// Runs host_init and brings up LvGL with a headless display.
+void nyx_host_init();
+
+// Creates the objects that the eMMC tools update.
+void nyx_host_emmc_gui(emmc_tool_gui_t *gui);
+
+// Sets what btn_wait and btn_read_vol return.
+void nyx_host_set_buttons(u32 wait, u32 vol);
+
+nyx_host_ui_t *nyx_host_ui();
+
+#endif
@@ -0,0 +1,697 @@
+/*
+ * Simulated SDMMC controller and cards for the host build.
+ *
+ * Implements the sdmmc_driver.h API on top of file backed SD and eMMC card
+ * models, so that the real sdmmc.c storage layer, the FatFs disk io and
+ * everything above them run unmodified. Each card answers the command set
+ * that sdmmc.c issues during init and data transfers, charges modeled time
+ * for commands and data and can fail transfers at a seeded rate.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+
+#include <storage/mmc.h>
+#include <storage/sd_def.h>
+#include <storage/sdmmc.h>
+#include <storage/sdmmc_driver.h>
+
+#include "host_hw.h"
+#include "sdmmc_sim.h"
+
+#define SIM_CONTROLLERS 4
+
+typedef struct _sim_card_t
+{
+	bool attached;
+	bool present;
+	u32  type;
+	int  fd;
+	u8  *data;
+	u64  size;
+	u32  user_secs;
+
+	// Controller side.
+	u32  power;
+	u32  bus_width;
+
+	// Card side.
+	u32  state;
+	bool app_cmd;
+	u32  rca;
+	u32  partition;
+	u32  sd_speed;
+	u32  cid[4];
+	u32  csd[4];
+	u8   ext_csd[512];
+
+	// Last response.
+	u32  rsp[4];
+
+	sim_latency_t lat;
+	sim_errors_t  err;
+	sim_stats_t   stats;
+
+	sim_flip_t flips[SIM_FLIPS_MAX];
+	u32 flips_cnt;
+} sim_card_t;
+
+static sim_card_t sim_cards[SIM_CONTROLLERS];
+
+static const sim_latency_t sim_lat_mmc = { 30, 300, 100 };
+static const sim_latency_t sim_lat_sd  = { 50, 90,  60  };
+
+// Sets a field of a 128-bit register, in the layout that unstuff_bits reads.
+static void _sim_set_bits(u32 *reg, u32 start, u32 size, u32 val)
+{
+	for (u32 i = 0; i < size; i++)
+	{
+		u32 bit = start + i;
+		u32 off = 3 - bit / 32;
+		if (val & BIT(i))
+			reg[off] |= BIT(bit & 31);
+		else
+			reg[off] &= ~BIT(bit & 31);
+	}
+}
+
+static u32 _sim_rand(sim_card_t *card)
+{
+	// xorshift32.
+	u32 x = card->err.seed ? card->err.seed : 0x12345678;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	card->err.seed = x;
+
+	return x;
+}
+
+static void _sim_card_regs_init(sim_card_t *card, u32 sdmmc_id)
+{
+	memset(card->cid, 0, sizeof(card->cid));
+	memset(card->csd, 0, sizeof(card->csd));
+	memset(card->ext_csd, 0, sizeof(card->ext_csd));
+
+	if (card->type == SIM_CARD_MMC)
+	{
+		_sim_set_bits(card->cid, 120, 8, 0x15); // Samsung.
+		_sim_set_bits(card->cid, 104, 8, 0x01);
+		_sim_set_bits(card->cid, 96,  8, 'B');
+		_sim_set_bits(card->cid, 88,  8, 'J');
+		_sim_set_bits(card->cid, 80,  8, 'T');
+		_sim_set_bits(card->cid, 72,  8, 'D');
+		_sim_set_bits(card->cid, 64,  8, '4');
+		_sim_set_bits(card->cid, 56,  8, 'R');
+		_sim_set_bits(card->cid, 48,  8, 0x01);
+		_sim_set_bits(card->cid, 16, 32, 0xC0DE0000 | sdmmc_id);
+		_sim_set_bits(card->cid, 12,  4, 1);
+		_sim_set_bits(card->cid, 8,   4, 2);
+
+		_sim_set_bits(card->csd, 126, 2, 3);
+		_sim_set_bits(card->csd, 122, 4, 4);      // MMC v4.
+		_sim_set_bits(card->csd, 84, 12, 0x8F5);
+		_sim_set_bits(card->csd, 80,  4, 9);
+		_sim_set_bits(card->csd, 62, 12, 0xFFF);  // Real size is in EXT_CSD.
+		_sim_set_bits(card->csd, 47,  3, 7);
+
+		card->ext_csd[EXT_CSD_REV] = 8;
+		card->ext_csd[EXT_CSD_STRUCTURE] = 2;
+		card->ext_csd[EXT_CSD_CARD_TYPE] = EXT_CSD_CARD_TYPE_HS_52 | EXT_CSD_CARD_TYPE_HS200_1_8V | EXT_CSD_CARD_TYPE_HS400_1_8V;
+		card->ext_csd[EXT_CSD_BOOT_MULT] = (SIM_BOOT_PART_SECS * 512) >> 17;
+		card->ext_csd[EXT_CSD_RPMB_MULT] = 0x20;
+		*(u32 *)&card->ext_csd[EXT_CSD_SEC_CNT] = card->user_secs;
+	}
+	else
+	{
+		_sim_set_bits(card->cid, 120, 8, 0x03); // SanDisk.
+		_sim_set_bits(card->cid, 104, 16, 0x5344);
+		_sim_set_bits(card->cid, 96,  8, 'S');
+		_sim_set_bits(card->cid, 88,  8, 'I');
+		_sim_set_bits(card->cid, 80,  8, 'M');
+		_sim_set_bits(card->cid, 72,  8, 'S');
+		_sim_set_bits(card->cid, 64,  8, 'D');
+		_sim_set_bits(card->cid, 60,  4, 8);
+		_sim_set_bits(card->cid, 24, 32, 0x5D000000 | sdmmc_id);
+		_sim_set_bits(card->cid, 12,  8, 22);
+		_sim_set_bits(card->cid, 8,   4, 1);
+
+		_sim_set_bits(card->csd, 126, 2, 1);      // SDHC/SDXC.
+		_sim_set_bits(card->csd, 84, 12, 0x5B5);  // Has CCC_APP_SPEC.
+		_sim_set_bits(card->csd, 80,  4, 9);
+		_sim_set_bits(card->csd, 48, 22, (card->user_secs >> 10) - 1);
+	}
+}
+
+int sim_card_attach(u32 sdmmc_id, const char *path, u32 type, u32 user_secs)
+{
+	sim_card_t *card = &sim_cards[sdmmc_id];
+
+	if (card->attached)
+		sim_card_detach(sdmmc_id);
+
+	memset(card, 0, sizeof(sim_card_t));
+	card->type = type;
+	card->user_secs = user_secs;
+	card->size = (u64)user_secs * 512;
+	if (type == SIM_CARD_MMC)
+		card->size += (u64)SIM_BOOT_PART_SECS * 512 * 2;
+
+	card->fd = -1;
+	if (path)
+	{
+		card->fd = open(path, O_RDWR | O_CREAT, 0644);
+		if (card->fd < 0 || ftruncate(card->fd, card->size))
+		{
+			fprintf(stderr, "sim: failed to open %s\n", path);
+			return 0;
+		}
+		card->data = mmap(NULL, card->size, PROT_READ | PROT_WRITE, MAP_SHARED, card->fd, 0);
+	}
+	else
+		card->data = mmap(NULL, card->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+	if (card->data == MAP_FAILED)
+	{
+		card->data = NULL;
+		return 0;
+	}
+
+	card->lat = type == SIM_CARD_MMC ? sim_lat_mmc : sim_lat_sd;
+	card->attached = true;
+	card->present = true;
+	_sim_card_regs_init(card, sdmmc_id);
+
+	return 1;
+}
+
+void sim_card_detach(u32 sdmmc_id)
+{
+	sim_card_t *card = &sim_cards[sdmmc_id];
+
+	if (!card->attached)
+		return;
+
+	munmap(card->data, card->size);
+	if (card->fd >= 0)
+		close(card->fd);
+	memset(card, 0, sizeof(sim_card_t));
+}
+
+void sim_card_set_present(u32 sdmmc_id, bool present)
+{
+	sim_cards[sdmmc_id].present = present;
+}
+
+void sim_card_set_latency(u32 sdmmc_id, const sim_latency_t *lat)
+{
+	sim_cards[sdmmc_id].lat = *lat;
+}
+
+void sim_card_set_errors(u32 sdmmc_id, const sim_errors_t *err)
+{
+	sim_cards[sdmmc_id].err = *err;
+}
+
+int sim_card_add_flip(u32 sdmmc_id, const sim_flip_t *flip)
+{
+	sim_card_t *card = &sim_cards[sdmmc_id];
+
+	if (card->flips_cnt >= SIM_FLIPS_MAX || flip->bit >= 512 * 8)
+		return 0;
+
+	card->flips[card->flips_cnt++] = *flip;
+
+	return 1;
+}
+
+void sim_card_clear_flips(u32 sdmmc_id)
+{
+	sim_cards[sdmmc_id].flips_cnt = 0;
+}
+
+sim_stats_t *sim_card_stats(u32 sdmmc_id)
+{
+	return &sim_cards[sdmmc_id].stats;
+}
+
+u8 *sim_card_data(u32 sdmmc_id, u32 partition)
+{
+	sim_card_t *card = &sim_cards[sdmmc_id];
+
+	if (card->type != SIM_CARD_MMC)
+		return card->data;
+
+	switch (partition)
+	{
+	case 1:
+		return card->data;
+	case 2:
+		return card->data + SIM_BOOT_PART_SECS * 512;
+	default:
+		return card->data + SIM_BOOT_PART_SECS * 512 * 2;
+	}
+}
+
+static u32 _sim_part_secs(sim_card_t *card)
+{
+	if (card->type == SIM_CARD_MMC && (card->partition == 1 || card->partition == 2))
+		return SIM_BOOT_PART_SECS;
+
+	return card->user_secs;
+}
+
+// Flips the armed bits of the sectors in a done xfer. buf is what got stored or returned.
+static void _sim_apply_flips(sim_card_t *card, u32 sector, u32 count, u8 *buf, bool is_write)
+{
+	u32 partition = card->type == SIM_CARD_MMC ? card->partition : 0;
+
+	for (u32 i = 0; i < card->flips_cnt; i++)
+	{
+		sim_flip_t *flip = &card->flips[i];
+		if (flip->on_write != is_write || flip->partition != partition || flip->sector < sector ||
+			flip->sector >= sector + count)
+			continue;
+
+		if (flip->skip)
+		{
+			flip->skip--;
+			continue;
+		}
+
+		buf[(u64)(flip->sector - sector) * 512 + flip->bit / 8] ^= BIT(flip->bit % 8);
+	}
+}
+
+/*
+ * Driver API.
+ */
+
+int sdmmc_get_io_power(sdmmc_t *sdmmc)
+{
+	return sim_cards[sdmmc->id].power;
+}
+
+u32 sdmmc_get_bus_width(sdmmc_t *sdmmc)
+{
+	return sim_cards[sdmmc->id].bus_width;
+}
+
+void sdmmc_set_bus_width(sdmmc_t *sdmmc, u32 bus_width)
+{
+	sim_cards[sdmmc->id].bus_width = bus_width;
+}
+
+void sdmmc_save_tap_value(sdmmc_t *sdmmc) {}
+
+int sdmmc_setup_clock(sdmmc_t *sdmmc, u32 type)
+{
+	return 1;
+}
+
+void sdmmc_card_clock_powersave(sdmmc_t *sdmmc, int powersave_enable)
+{
+	sdmmc->powersave_enabled = powersave_enable;
+}
+
+int sdmmc_get_rsp(sdmmc_t *sdmmc, u32 *rsp, u32 size, u32 type)
+{
+	sim_card_t *card = &sim_cards[sdmmc->id];
+
+	if (sdmmc->expected_rsp_type != type)
+		return 0;
+
+	switch (type)
+	{
+	case SDMMC_RSP_TYPE_1:
+	case SDMMC_RSP_TYPE_3:
+	case SDMMC_RSP_TYPE_4:
+	case SDMMC_RSP_TYPE_5:
+		if (size < 4)
+			return 0;
+		rsp[0] = card->rsp[0];
+		break;
+
+	case SDMMC_RSP_TYPE_2:
+		if (size < 16)
+			return 0;
+		memcpy(rsp, card->rsp, 16);
+		break;
+
+	default:
+		return 0;
+	}
+
+	return 1;
+}
+
+int sdmmc_tuning_execute(sdmmc_t *sdmmc, u32 type, u32 cmd)
+{
+	return sim_cards[sdmmc->id].present;
+}
+
+int sdmmc_stop_transmission(sdmmc_t *sdmmc, u32 *rsp)
+{
+	sim_card_t *card = &sim_cards[sdmmc->id];
+
+	if (!card->present)
+		return 0;
+
+	card->stats.cmds++;
+	card->state = R1_STATE_TRAN;
+	*rsp = R1_STATE(R1_STATE_TRAN) | R1_READY_FOR_DATA;
+
+	return 1;
+}
+
+bool sdmmc_get_sd_inserted()
+{
+	return sim_cards[SDMMC_1].attached && sim_cards[SDMMC_1].present;
+}
+
+int sdmmc_init(sdmmc_t *sdmmc, u32 id, u32 power, u32 bus_width, u32 type, int powersave_enable)
+{
+	sim_card_t *card = &sim_cards[id];
+
+	memset(sdmmc, 0, sizeof(sdmmc_t));
+	sdmmc->id = id;
+	sdmmc->divisor = 1;
+	sdmmc->clock_stopped = 1;
+
+	if (!card->attached)
+		return 0;
+
+	card->power = power;
+	card->bus_width = bus_width;
+	card->state = R1_STATE_IDLE;
+	card->app_cmd = false;
+	card->partition = 0;
+	card->sd_speed = 0;
+	card->stats.inits++;
+
+	return 1;
+}
+
+void sdmmc_end(sdmmc_t *sdmmc)
+{
+	sim_cards[sdmmc->id].power = SDMMC_POWER_OFF;
+}
+
+void sdmmc_init_cmd(sdmmc_cmd_t *cmdbuf, u16 cmd, u32 arg, u32 rsp_type, u32 check_busy)
+{
+	cmdbuf->cmd = cmd;
+	cmdbuf->arg = arg;
+	cmdbuf->rsp_type = rsp_type;
+	cmdbuf->check_busy = check_busy;
+}
+
+int sdmmc_enable_low_voltage(sdmmc_t *sdmmc)
+{
+	if (sdmmc->id != SDMMC_1)
+		return 0;
+
+	sim_cards[sdmmc->id].power = SDMMC_POWER_1_8;
+
+	return 1;
+}
+
+static void _sim_r1(sim_card_t *card, u32 state)
+{
+	card->rsp[0] = R1_STATE(state) | R1_READY_FOR_DATA | (card->app_cmd ? R1_APP_CMD : 0);
+}
+
+static void _sim_charge(sim_card_t *card, u32 bytes, bool is_write)
+{
+	u32 mbs = is_write ? card->lat.write_mbs : card->lat.read_mbs;
+
+	host_time_add(card->lat.cmd_us + (mbs ? bytes / mbs : 0));
+}
+
+static int _sim_data(sim_card_t *card, sdmmc_req_t *req, const void *src)
+{
+	if (!req || req->is_write)
+		return 0;
+
+	memcpy(req->buf, src, req->blksize * req->num_sectors);
+	_sim_charge(card, req->blksize * req->num_sectors, false);
+
+	return 1;
+}
+
+static int _sim_rw(sim_card_t *card, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
+{
+	bool is_write = cmd->cmd == MMC_WRITE_MULTIPLE_BLOCK;
+
+	if (!req || req->blksize != 512 || (bool)req->is_write != is_write)
+		return 0;
+
+	u32 sector = cmd->arg;
+	u32 count = req->num_sectors;
+
+	if ((u64)sector + count > _sim_part_secs(card))
+	{
+		card->rsp[0] = R1_STATE(card->state) | R1_OUT_OF_RANGE;
+		card->stats.errors++;
+		return 0;
+	}
+
+	// Pick where a random CRC error or timeout hits, if any.
+	u32 good = count;
+	u32 ppm = card->err.crc_ppm + card->err.timeout_ppm;
+	if (ppm && (_sim_rand(card) % 1000000) < ppm)
+		good = _sim_rand(card) % count;
+
+	u8 *data = sim_card_data(card - sim_cards, card->partition) + (u64)sector * 512;
+	if (is_write)
+	{
+		memcpy(data, req->buf, (u64)good * 512);
+		_sim_apply_flips(card, sector, good, data, true);
+		card->stats.writes++;
+		card->stats.write_secs += good;
+	}
+	else
+	{
+		memcpy(req->buf, data, (u64)good * 512);
+		_sim_apply_flips(card, sector, good, req->buf, false);
+		card->stats.reads++;
+		card->stats.read_secs += good;
+	}
+	_sim_charge(card, good * 512, is_write);
+
+	if (blkcnt_out)
+		*blkcnt_out = good;
+
+	_sim_r1(card, R1_STATE_TRAN);
+
+	if (good != count)
+	{
+		card->stats.errors++;
+		return 0;
+	}
+
+	return 1;
+}
+
+static void _sim_sd_switch(sim_card_t *card, u32 arg, u8 *buf)
+{
+	u32 mode = arg >> 31;
+	u32 access = arg & 0xF;
+	u32 power = (arg >> 12) & 0xF;
+
+	memset(buf, 0, 64);
+	buf[1]  = 200; // Max power consumption.
+	buf[7]  = BIT(SD_SET_POWER_LIMIT_0_72) | BIT(SD_SET_POWER_LIMIT_1_44);
+	buf[13] = SD_MODE_UHS_SDR12 | SD_MODE_UHS_SDR25 | SD_MODE_UHS_SDR50 | SD_MODE_UHS_SDR104 | SD_MODE_UHS_DDR50;
+
+	if (access == 0xF)
+		access = card->sd_speed;
+	else if (access > UHS_DDR50_BUS_SPEED)
+		access = 0xF;
+	else if (mode == SD_SWITCH_SET)
+		card->sd_speed = access;
+
+	if (power == 0xF)
+		power = SD_SET_POWER_LIMIT_0_72;
+	else if (power > SD_SET_POWER_LIMIT_1_44)
+		power = 0xF;
+
+	buf[16] = access;
+	buf[15] = power << 4;
+}
+
+int sdmmc_execute_cmd(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
+{
+	sim_card_t *card = &sim_cards[sdmmc->id];
+	bool is_mmc = card->type == SIM_CARD_MMC;
+	bool app_cmd = card->app_cmd;
+	u8 buf[64];
+
+	sdmmc->expected_rsp_type = cmd->rsp_type;
+
+	if (!card->attached || !card->present || card->power == SDMMC_POWER_OFF)
+		return 0;
+
+	card->stats.cmds++;
+	card->app_cmd = false;
+	memset(card->rsp, 0, sizeof(card->rsp));
+
+	if (!req)
+		host_time_add(card->lat.cmd_us);
+
+	if (app_cmd)
+	{
+		switch (cmd->cmd)
+		{
+		case SD_APP_SET_BUS_WIDTH:
+			_sim_r1(card, card->state);
+			return 1;
+
+		case SD_APP_SD_STATUS:
+			memset(buf, 0, sizeof(buf));
+			buf[0]  = SD_BUS_WIDTH_4 << 6;
+			buf[8]  = 4;    // Class 10.
+			buf[10] = 0x90; // 4MB AU.
+			buf[14] = 0x19; // U1, 16MB UHS AU.
+			_sim_r1(card, card->state);
+			return _sim_data(card, req, buf);
+
+		case SD_APP_OP_COND:
+			card->rsp[0] = SD_OCR_BUSY | SD_OCR_CCS | SD_OCR_VDD_32_33 | (cmd->arg & SD_OCR_S18R);
+			card->state = R1_STATE_READY;
+			return 1;
+
+		case SD_APP_SET_CLR_CARD_DETECT:
+			_sim_r1(card, card->state);
+			return 1;
+
+		case SD_APP_SEND_SCR:
+			memset(buf, 0, sizeof(buf));
+			buf[0] = 0x02; // SD 3.0x.
+			buf[1] = 0x35; // 1-bit and 4-bit bus.
+			buf[2] = 0x80; // Spec v3.
+			_sim_r1(card, card->state);
+			return _sim_data(card, req, buf);
+
+		default:
+			break;
+		}
+	}
+
+	switch (cmd->cmd)
+	{
+	case MMC_GO_IDLE_STATE:
+		card->state = R1_STATE_IDLE;
+		card->partition = 0;
+		card->ext_csd[EXT_CSD_PART_CONFIG] = 0;
+		return 1;
+
+	case MMC_SEND_OP_COND:
+		if (!is_mmc)
+			return 0;
+		card->rsp[0] = MMC_CARD_BUSY | MMC_CARD_CCS | (cmd->arg & (MMC_CARD_VDD_18 | MMC_CARD_VDD_27_34));
+		card->state = R1_STATE_READY;
+		return 1;
+
+	case MMC_ALL_SEND_CID:
+		memcpy(card->rsp, card->cid, 16);
+		card->state = R1_STATE_IDENT;
+		return 1;
+
+	case MMC_SET_RELATIVE_ADDR:
+		if (is_mmc)
+		{
+			_sim_r1(card, card->state);
+			card->rca = cmd->arg >> 16;
+		}
+		else
+		{
+			card->rca = 0xAAAA;
+			card->rsp[0] = (card->rca << 16) | R1_STATE(card->state) | R1_READY_FOR_DATA;
+		}
+		card->state = R1_STATE_STBY;
+		return 1;
+
+	case MMC_SWITCH:
+		if (is_mmc)
+		{
+			u32 index = (cmd->arg >> 16) & 0xFF;
+			u32 value = (cmd->arg >> 8) & 0xFF;
+			card->ext_csd[index] = value;
+			if (index == EXT_CSD_PART_CONFIG)
+				card->partition = value & 7;
+			_sim_r1(card, card->state);
+			return 1;
+		}
+		_sim_sd_switch(card, cmd->arg, buf);
+		_sim_r1(card, card->state);
+		return _sim_data(card, req, buf);
+
+	case MMC_SELECT_CARD:
+		_sim_r1(card, card->state);
+		if ((cmd->arg >> 16) == card->rca)
+			card->state = R1_STATE_TRAN;
+		return 1;
+
+	case MMC_SEND_EXT_CSD:
+		if (is_mmc)
+		{
+			_sim_r1(card, card->state);
+			return _sim_data(card, req, card->ext_csd);
+		}
+		card->rsp[0] = cmd->arg & 0xFFF; // SD_SEND_IF_COND.
+		return 1;
+
+	case MMC_SEND_CSD:
+		memcpy(card->rsp, card->csd, 16);
+		return 1;
+
+	case SD_SWITCH_VOLTAGE:
+		if (is_mmc)
+			return 0;
+		_sim_r1(card, card->state);
+		return 1;
+
+	case MMC_STOP_TRANSMISSION:
+		card->state = R1_STATE_TRAN;
+		_sim_r1(card, card->state);
+		return 1;
+
+	case MMC_SEND_STATUS:
+		_sim_r1(card, card->state);
+		return 1;
+
+	case MMC_SET_BLOCKLEN:
+		_sim_r1(card, card->state);
+		return cmd->arg == 512;
+
+	case MMC_READ_MULTIPLE_BLOCK:
+	case MMC_WRITE_MULTIPLE_BLOCK:
+		if (card->state != R1_STATE_TRAN)
+			return 0;
+		return _sim_rw(card, cmd, req, blkcnt_out);
+
+	case MMC_APP_CMD:
+		card->app_cmd = true;
+		_sim_r1(card, card->state);
+		return 1;
+
+	default:
+		card->rsp[0] = R1_STATE(card->state) | R1_ILLEGAL_COMMAND;
+		return 0;
+	}
+}
@@ -0,0 +1,86 @@
+/*
+ * Simulated SDMMC controller and cards for the host build.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SDMMC_SIM_H_
+#define _SDMMC_SIM_H_
+
+#include <utils/types.h>
+
+#define SIM_CARD_SD   0
+#define SIM_CARD_MMC  1
+
+#define SIM_BOOT_PART_SECS 0x2000 // 4MB per eMMC boot partition.
+
+typedef struct _sim_latency_t
+{
+	u32 cmd_us;    // Per command overhead.
+	u32 read_mbs;  // Sequential read throughput. 0: Instant.
+	u32 write_mbs; // Sequential write throughput. 0: Instant.
+} sim_latency_t;
+
+typedef struct _sim_errors_t
+{
+	u32 seed;
+	u32 crc_ppm;     // Chance per data transfer to end in a CRC error.
+	u32 timeout_ppm; // Chance per data transfer to end in a data timeout.
+} sim_errors_t;
+
+#define SIM_FLIPS_MAX 64
+
+typedef struct _sim_flip_t
+{
+	u32  partition; // 0: User area, 1: BOOT0, 2: BOOT1.
+	u32  sector;
+	u32  bit;       // Bit offset in the sector.
+	bool on_write;  // Flip what gets stored on writes, else what gets returned on reads.
+	u32  skip;      // Xfers of the sector to leave alone first.
+} sim_flip_t;
+
+typedef struct _sim_stats_t
+{
+	u64 cmds;
+	u64 reads;
+	u64 writes;
+	u64 read_secs;
+	u64 write_secs;
+	u64 errors;
+	u64 inits;
+} sim_stats_t;
+
+/*
+ * Attaches a card to a controller. The card is backed by the file at path, which
+ * is created sparse if needed. A NULL path uses an anonymous mapping.
+ * eMMC images hold BOOT0, BOOT1 and then the user area.
+ */
+int  sim_card_attach(u32 sdmmc_id, const char *path, u32 type, u32 user_secs);
+void sim_card_detach(u32 sdmmc_id);
+
+void sim_card_set_present(u32 sdmmc_id, bool present);
+void sim_card_set_latency(u32 sdmmc_id, const sim_latency_t *lat);
+void sim_card_set_errors(u32 sdmmc_id, const sim_errors_t *err);
+
+// Silent bit flips. The xfer still succeeds.
+int  sim_card_add_flip(u32 sdmmc_id, const sim_flip_t *flip);
+void sim_card_clear_flips(u32 sdmmc_id);
+
+sim_stats_t *sim_card_stats(u32 sdmmc_id);
+
+// Backing data of a partition. 0: User area, 1: BOOT0, 2: BOOT1.
+u8 *sim_card_data(u32 sdmmc_id, u32 partition);
+
+#endif
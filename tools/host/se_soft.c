@@ -0,0 +1,645 @@
+/*
+ * Software Security Engine for the host build.
+ *
+ * Implements the bdk se.h API with a plain AES-128 and SHA-256 so that code
+ * that encrypts, decrypts or hashes through the SE can run on the host.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <sec/se.h>
+
+#include "se_soft.h"
+
+typedef struct _se_soft_ks_t
+{
+	u8  key[SE_AES_MAX_KEY_SIZE];
+	u8  iv[SE_AES_IV_SIZE];
+	u32 flags;
+	u32 rk[44];   // Expanded encryption key.
+	u32 rk_d[44]; // Expanded decryption key.
+} se_soft_ks_t;
+
+typedef struct _se_soft_sha_t
+{
+	u32 state[8];
+	u8  block[64];
+	u32 block_len;
+	u64 total;
+	u64 done;
+} se_soft_sha_t;
+
+static se_soft_ks_t  se_ks[SE_AES_KEYSLOT_COUNT];
+static se_soft_sha_t se_sha;
+static u32 _se_sha256_bytes = 0;
+static u64 _se_prng_state = 0x853C49E6748FEA9BULL;
+static se_soft_stats_t se_stats;
+
+static u8 sbox[256];
+static u8 isbox[256];
+static bool tables_ready = false;
+
+static u8 _xtime(u8 x)
+{
+	return (x << 1) ^ ((x & 0x80) ? 0x1B : 0);
+}
+
+static u8 _gmul(u8 a, u8 b)
+{
+	u8 res = 0;
+	while (b)
+	{
+		if (b & 1)
+			res ^= a;
+		a = _xtime(a);
+		b >>= 1;
+	}
+
+	return res;
+}
+
+static void _se_tables_init()
+{
+	if (tables_ready)
+		return;
+
+	// Generate the S-box from the multiplicative inverse and the affine transform.
+	u8 p = 1, q = 1;
+	do
+	{
+		p = p ^ (p << 1) ^ ((p & 0x80) ? 0x1B : 0);
+		q ^= q << 1;
+		q ^= q << 2;
+		q ^= q << 4;
+		if (q & 0x80)
+			q ^= 0x09;
+
+		u8 x = q ^ (q << 1 | q >> 7) ^ (q << 2 | q >> 6) ^ (q << 3 | q >> 5) ^ (q << 4 | q >> 4);
+		sbox[p] = x ^ 0x63;
+	} while (p != 1);
+	sbox[0] = 0x63;
+
+	for (u32 i = 0; i < 256; i++)
+		isbox[sbox[i]] = i;
+
+	tables_ready = true;
+}
+
+static void _se_key_expand(se_soft_ks_t *ks)
+{
+	static const u8 rcon[10] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36 };
+
+	_se_tables_init();
+
+	for (u32 i = 0; i < 4; i++)
+		ks->rk[i] = (ks->key[4 * i] << 24) | (ks->key[4 * i + 1] << 16) | (ks->key[4 * i + 2] << 8) | ks->key[4 * i + 3];
+
+	for (u32 i = 4; i < 44; i++)
+	{
+		u32 t = ks->rk[i - 1];
+		if (!(i % 4))
+		{
+			t = (t << 8) | (t >> 24);
+			t = (sbox[t >> 24] << 24) | (sbox[(t >> 16) & 0xFF] << 16) | (sbox[(t >> 8) & 0xFF] << 8) | sbox[t & 0xFF];
+			t ^= rcon[i / 4 - 1] << 24;
+		}
+		ks->rk[i] = ks->rk[i - 4] ^ t;
+	}
+
+	// Decryption uses the same round keys in reverse order.
+	for (u32 r = 0; r <= 10; r++)
+		for (u32 j = 0; j < 4; j++)
+			ks->rk_d[r * 4 + j] = ks->rk[(10 - r) * 4 + j];
+}
+
+static void _add_round_key(u8 *s, const u32 *rk)
+{
+	for (u32 i = 0; i < 4; i++)
+	{
+		s[4 * i]     ^= rk[i] >> 24;
+		s[4 * i + 1] ^= rk[i] >> 16;
+		s[4 * i + 2] ^= rk[i] >> 8;
+		s[4 * i + 3] ^= rk[i];
+	}
+}
+
+static void _aes_encrypt_block(const se_soft_ks_t *ks, u8 *dst, const u8 *src)
+{
+	u8 s[16], t[16];
+	memcpy(s, src, 16);
+	_add_round_key(s, &ks->rk[0]);
+
+	for (u32 r = 1; r <= 10; r++)
+	{
+		// SubBytes and ShiftRows.
+		for (u32 c = 0; c < 4; c++)
+			for (u32 row = 0; row < 4; row++)
+				t[4 * c + row] = sbox[s[4 * ((c + row) % 4) + row]];
+
+		// MixColumns.
+		if (r != 10)
+		{
+			for (u32 c = 0; c < 4; c++)
+			{
+				u8 *col = &t[4 * c];
+				u8 a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+				u8 all = a0 ^ a1 ^ a2 ^ a3;
+				col[0] ^= all ^ _xtime(a0 ^ a1);
+				col[1] ^= all ^ _xtime(a1 ^ a2);
+				col[2] ^= all ^ _xtime(a2 ^ a3);
+				col[3] ^= all ^ _xtime(a3 ^ a0);
+			}
+		}
+
+		memcpy(s, t, 16);
+		_add_round_key(s, &ks->rk[r * 4]);
+	}
+
+	memcpy(dst, s, 16);
+}
+
+static void _aes_decrypt_block(const se_soft_ks_t *ks, u8 *dst, const u8 *src)
+{
+	u8 s[16], t[16];
+	memcpy(s, src, 16);
+	_add_round_key(s, &ks->rk_d[0]);
+
+	for (u32 r = 1; r <= 10; r++)
+	{
+		// InvShiftRows and InvSubBytes.
+		for (u32 c = 0; c < 4; c++)
+			for (u32 row = 0; row < 4; row++)
+				t[4 * ((c + row) % 4) + row] = isbox[s[4 * c + row]];
+
+		_add_round_key(t, &ks->rk_d[r * 4]);
+
+		// InvMixColumns.
+		if (r != 10)
+		{
+			for (u32 c = 0; c < 4; c++)
+			{
+				u8 *col = &t[4 * c];
+				u8 a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+				col[0] = _gmul(a0, 14) ^ _gmul(a1, 11) ^ _gmul(a2, 13) ^ _gmul(a3, 9);
+				col[1] = _gmul(a0, 9)  ^ _gmul(a1, 14) ^ _gmul(a2, 11) ^ _gmul(a3, 13);
+				col[2] = _gmul(a0, 13) ^ _gmul(a1, 9)  ^ _gmul(a2, 14) ^ _gmul(a3, 11);
+				col[3] = _gmul(a0, 11) ^ _gmul(a1, 13) ^ _gmul(a2, 9)  ^ _gmul(a3, 14);
+			}
+		}
+
+		memcpy(s, t, 16);
+	}
+
+	memcpy(dst, s, 16);
+}
+
+static void _gf256_mul_x(void *block)
+{
+	u8 *pdata = (u8 *)block;
+	u32 carry = 0;
+
+	for (int i = 0xF; i >= 0; i--)
+	{
+		u8 b = pdata[i];
+		pdata[i] = (b << 1) | carry;
+		carry = b >> 7;
+	}
+
+	if (carry)
+		pdata[0xF] ^= 0x87;
+}
+
+static void _gf256_mul_x_le(void *block)
+{
+	u32 *pdata = (u32 *)block;
+	u32 carry = 0;
+
+	for (u32 i = 0; i < 4; i++)
+	{
+		u32 b = pdata[i];
+		pdata[i] = (b << 1) | carry;
+		carry = b >> 31;
+	}
+
+	if (carry)
+		pdata[0x0] ^= 0x87;
+}
+
+void se_rsa_acc_ctrl(u32 rs, u32 flags) {}
+
+void se_key_acc_ctrl(u32 ks, u32 flags)
+{
+	se_ks[ks].flags = flags;
+}
+
+u32 se_key_acc_ctrl_get(u32 ks)
+{
+	return se_ks[ks].flags;
+}
+
+void se_get_aes_keys(u8 *buf, u8 *keys, u32 keysize)
+{
+	for (u32 i = 0; i < SE_AES_KEYSLOT_COUNT; i++)
+		memcpy(keys + i * keysize, se_ks[i].key, MIN(keysize, SE_AES_MAX_KEY_SIZE));
+}
+
+void se_aes_key_set(u32 ks, void *key, u32 size)
+{
+	memcpy(se_ks[ks].key, key, size);
+	_se_key_expand(&se_ks[ks]);
+}
+
+void se_aes_iv_set(u32 ks, void *iv)
+{
+	memcpy(se_ks[ks].iv, iv, SE_AES_IV_SIZE);
+}
+
+void se_aes_key_get(u32 ks, void *key, u32 size)
+{
+	memcpy(key, se_ks[ks].key, size);
+}
+
+void se_aes_key_clear(u32 ks)
+{
+	memset(se_ks[ks].key, 0, SE_AES_MAX_KEY_SIZE);
+	_se_key_expand(&se_ks[ks]);
+}
+
+void se_aes_iv_clear(u32 ks)
+{
+	memset(se_ks[ks].iv, 0, SE_AES_IV_SIZE);
+}
+
+int se_aes_unwrap_key(u32 ks_dst, u32 ks_src, const void *input)
+{
+	u8 key[SE_KEY_128_SIZE];
+	_aes_decrypt_block(&se_ks[ks_src], key, input);
+	se_aes_key_set(ks_dst, key, SE_KEY_128_SIZE);
+	se_stats.ops++;
+
+	return 1;
+}
+
+int se_aes_crypt_ecb(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size)
+{
+	u8 *pdst = (u8 *)dst;
+	const u8 *psrc = (const u8 *)src;
+
+	for (u32 i = 0; i < src_size / SE_AES_BLOCK_SIZE && (i + 1) * SE_AES_BLOCK_SIZE <= dst_size; i++)
+	{
+		if (enc)
+			_aes_encrypt_block(&se_ks[ks], pdst + i * SE_AES_BLOCK_SIZE, psrc + i * SE_AES_BLOCK_SIZE);
+		else
+			_aes_decrypt_block(&se_ks[ks], pdst + i * SE_AES_BLOCK_SIZE, psrc + i * SE_AES_BLOCK_SIZE);
+	}
+
+	se_stats.ops++;
+	se_stats.aes_bytes += src_size;
+
+	return 1;
+}
+
+int se_aes_crypt_cbc(u32 ks, u32 enc, void *dst, u32 dst_size, const void *src, u32 src_size)
+{
+	u8 *pdst = (u8 *)dst;
+	const u8 *psrc = (const u8 *)src;
+	u8 prev[SE_AES_BLOCK_SIZE];
+	u8 tmp[SE_AES_BLOCK_SIZE];
+
+	memcpy(prev, se_ks[ks].iv, SE_AES_BLOCK_SIZE);
+	for (u32 i = 0; i < src_size / SE_AES_BLOCK_SIZE && (i + 1) * SE_AES_BLOCK_SIZE <= dst_size; i++)
+	{
+		if (enc)
+		{
+			for (u32 j = 0; j < SE_AES_BLOCK_SIZE; j++)
+				tmp[j] = psrc[j] ^ prev[j];
+			_aes_encrypt_block(&se_ks[ks], pdst, tmp);
+			memcpy(prev, pdst, SE_AES_BLOCK_SIZE);
+		}
+		else
+		{
+			memcpy(tmp, psrc, SE_AES_BLOCK_SIZE);
+			_aes_decrypt_block(&se_ks[ks], pdst, psrc);
+			for (u32 j = 0; j < SE_AES_BLOCK_SIZE; j++)
+				pdst[j] ^= prev[j];
+			memcpy(prev, tmp, SE_AES_BLOCK_SIZE);
+		}
+
+		psrc += SE_AES_BLOCK_SIZE;
+		pdst += SE_AES_BLOCK_SIZE;
+	}
+
+	se_stats.ops++;
+	se_stats.aes_bytes += src_size;
+
+	return 1;
+}
+
+int se_aes_crypt_block_ecb(u32 ks, u32 enc, void *dst, const void *src)
+{
+	return se_aes_crypt_ecb(ks, enc, dst, SE_AES_BLOCK_SIZE, src, SE_AES_BLOCK_SIZE);
+}
+
+int se_aes_crypt_ctr(u32 ks, void *dst, u32 dst_size, const void *src, u32 src_size, void *ctr)
+{
+	u8 *pdst = (u8 *)dst;
+	const u8 *psrc = (const u8 *)src;
+	u8 cnt[SE_AES_IV_SIZE];
+	u8 pad[SE_AES_BLOCK_SIZE];
+
+	// The linear counter is a big endian 128-bit value. The caller's copy is not updated.
+	memcpy(cnt, ctr, SE_AES_IV_SIZE);
+	u32 size = MIN(src_size, dst_size);
+	for (u32 pos = 0; pos < size; pos += SE_AES_BLOCK_SIZE)
+	{
+		_aes_encrypt_block(&se_ks[ks], pad, cnt);
+		for (u32 j = 0; j < SE_AES_BLOCK_SIZE && pos + j < size; j++)
+			pdst[pos + j] = psrc[pos + j] ^ pad[j];
+
+		for (int j = SE_AES_IV_SIZE - 1; j >= 0; j--)
+			if (++cnt[j])
+				break;
+	}
+
+	se_stats.ops++;
+	se_stats.aes_bytes += size;
+
+	return 1;
+}
+
+int se_aes_xts_crypt_sec(u32 tweak_ks, u32 crypt_ks, u32 enc, u64 sec, void *dst, void *src, u32 secsize)
+{
+	u8 tweak[SE_AES_BLOCK_SIZE];
+	u8 *pdst = (u8 *)dst;
+	u8 *psrc = (u8 *)src;
+
+	for (int i = 0xF; i >= 0; i--)
+	{
+		tweak[i] = sec & 0xFF;
+		sec >>= 8;
+	}
+	se_aes_crypt_block_ecb(tweak_ks, ENCRYPT, tweak, tweak);
+
+	for (u32 i = 0; i < secsize / SE_AES_BLOCK_SIZE; i++)
+	{
+		for (u32 j = 0; j < SE_AES_BLOCK_SIZE; j++)
+			pdst[j] = psrc[j] ^ tweak[j];
+		se_aes_crypt_block_ecb(crypt_ks, enc, pdst, pdst);
+		for (u32 j = 0; j < SE_AES_BLOCK_SIZE; j++)
+			pdst[j] = pdst[j] ^ tweak[j];
+		_gf256_mul_x(tweak);
+		psrc += SE_AES_BLOCK_SIZE;
+		pdst += SE_AES_BLOCK_SIZE;
+	}
+
+	return 1;
+}
+
+int se_aes_xts_crypt_sec_nx(u32 tweak_ks, u32 crypt_ks, u32 enc, u64 sec, u8 *tweak, bool regen_tweak, u32 tweak_exp, void *dst, void *src, u32 sec_size)
+{
+	u32 *pdst = (u32 *)dst;
+	u32 *psrc = (u32 *)src;
+	u32 *ptweak = (u32 *)tweak;
+
+	if (regen_tweak)
+	{
+		for (int i = 0xF; i >= 0; i--)
+		{
+			tweak[i] = sec & 0xFF;
+			sec >>= 8;
+		}
+		se_aes_crypt_block_ecb(tweak_ks, ENCRYPT, tweak, tweak);
+	}
+
+	for (u32 i = 0; i < (tweak_exp << 5); i++)
+		_gf256_mul_x_le(tweak);
+
+	u8 orig_tweak[SE_KEY_128_SIZE] __attribute__((aligned(4)));
+	memcpy(orig_tweak, tweak, SE_KEY_128_SIZE);
+
+	for (u32 i = 0; i < (sec_size >> 4); i++)
+	{
+		for (u32 j = 0; j < 4; j++)
+			pdst[j] = psrc[j] ^ ptweak[j];
+
+		_gf256_mul_x_le(tweak);
+		psrc += 4;
+		pdst += 4;
+	}
+
+	se_aes_crypt_ecb(crypt_ks, enc, dst, sec_size, dst, sec_size);
+
+	pdst = (u32 *)dst;
+	ptweak = (u32 *)orig_tweak;
+	for (u32 i = 0; i < (sec_size >> 4); i++)
+	{
+		for (u32 j = 0; j < 4; j++)
+			pdst[j] = pdst[j] ^ ptweak[j];
+
+		_gf256_mul_x_le(orig_tweak);
+		pdst += 4;
+	}
+
+	return 1;
+}
+
+int se_aes_xts_crypt(u32 tweak_ks, u32 crypt_ks, u32 enc, u64 sec, void *dst, void *src, u32 secsize, u32 num_secs)
+{
+	u8 *pdst = (u8 *)dst;
+	u8 *psrc = (u8 *)src;
+
+	for (u32 i = 0; i < num_secs; i++)
+		se_aes_xts_crypt_sec(tweak_ks, crypt_ks, enc, sec + i, pdst + secsize * i, psrc + secsize * i, secsize);
+
+	return 1;
+}
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void _sha256_block(u32 *state, const u8 *block)
+{
+	static const u32 k[64] = {
+		0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+		0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+		0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+		0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+		0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+		0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+		0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+		0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+	};
+
+	u32 w[64];
+	for (u32 i = 0; i < 16; i++)
+		w[i] = (block[4 * i] << 24) | (block[4 * i + 1] << 16) | (block[4 * i + 2] << 8) | block[4 * i + 3];
+	for (u32 i = 16; i < 64; i++)
+	{
+		u32 s0 = ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		u32 s1 = ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	u32 a = state[0], b = state[1], c = state[2], d = state[3];
+	u32 e = state[4], f = state[5], g = state[6], h = state[7];
+	for (u32 i = 0; i < 64; i++)
+	{
+		u32 t1 = h + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+		u32 t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+
+	state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+	state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+static void _sha256_update(se_soft_sha_t *sha, const u8 *src, u32 size)
+{
+	sha->done += size;
+
+	while (size)
+	{
+		u32 len = MIN(size, 64 - sha->block_len);
+		memcpy(&sha->block[sha->block_len], src, len);
+		sha->block_len += len;
+		src += len;
+		size -= len;
+
+		if (sha->block_len == 64)
+		{
+			_sha256_block(sha->state, sha->block);
+			sha->block_len = 0;
+		}
+	}
+}
+
+static void _sha256_final(se_soft_sha_t *sha)
+{
+	u64 bits = sha->done << 3;
+	u8 pad = 0x80;
+
+	// Keep the message counter untouched by the padding.
+	u64 done = sha->done;
+	_sha256_update(sha, &pad, 1);
+	pad = 0;
+	while (sha->block_len != 56)
+		_sha256_update(sha, &pad, 1);
+
+	u8 len[8];
+	for (u32 i = 0; i < 8; i++)
+		len[i] = bits >> (56 - 8 * i);
+	_sha256_update(sha, len, 8);
+	sha->done = done;
+}
+
+static void _sha256_out(se_soft_sha_t *sha, void *hash)
+{
+	u8 *out = (u8 *)hash;
+	for (u32 i = 0; i < 8; i++)
+	{
+		out[4 * i]     = sha->state[i] >> 24;
+		out[4 * i + 1] = sha->state[i] >> 16;
+		out[4 * i + 2] = sha->state[i] >> 8;
+		out[4 * i + 3] = sha->state[i];
+	}
+}
+
+static void _sha256_msg_left(se_soft_sha_t *sha, u32 *msg_left)
+{
+	if (!msg_left)
+		return;
+
+	u64 left = (sha->total - sha->done) << 3;
+	msg_left[0] = (u32)left;
+	msg_left[1] = (u32)(left >> 32);
+}
+
+int se_calc_sha256(void *hash, u32 *msg_left, const void *src, u32 src_size, u64 total_size, u32 sha_cfg, bool is_oneshot)
+{
+	static const u32 sha256_iv[8] = {
+		0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+	};
+
+	if (src_size > 0xFFFFFF || !hash)
+		return 0;
+
+	if (!total_size)
+		total_size = src_size;
+
+	// The engine has a single context. Continuing resumes it.
+	if (sha_cfg == SHA_INIT_HASH)
+	{
+		memset(&se_sha, 0, sizeof(se_sha));
+		memcpy(se_sha.state, sha256_iv, sizeof(sha256_iv));
+		se_sha.total = total_size;
+	}
+
+	_sha256_update(&se_sha, src, src_size);
+	_se_sha256_bytes += src_size;
+	se_stats.ops++;
+	se_stats.sha_bytes += src_size;
+
+	if (se_sha.done >= se_sha.total)
+		_sha256_final(&se_sha);
+
+	if (is_oneshot)
+	{
+		_sha256_msg_left(&se_sha, msg_left);
+		_sha256_out(&se_sha, hash);
+	}
+
+	return 1;
+}
+
+int se_calc_sha256_oneshot(void *hash, const void *src, u32 src_size)
+{
+	return se_calc_sha256(hash, NULL, src, src_size, 0, SHA_INIT_HASH, true);
+}
+
+u32 se_calc_sha256_get_bytes()
+{
+	return _se_sha256_bytes;
+}
+
+int se_calc_sha256_finalize(void *hash, u32 *msg_left)
+{
+	_sha256_msg_left(&se_sha, msg_left);
+	_sha256_out(&se_sha, hash);
+
+	return 1;
+}
+
+int se_gen_prng128(void *dst)
+{
+	u8 *out = (u8 *)dst;
+
+	// Deterministic, so that runs can be reproduced.
+	for (u32 i = 0; i < 16; i++)
+	{
+		_se_prng_state = _se_prng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+		out[i] = _se_prng_state >> 56;
+	}
+
+	se_stats.ops++;
+
+	return 1;
+}
+
+se_soft_stats_t *se_soft_stats()
+{
+	return &se_stats;
+}
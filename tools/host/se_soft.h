@@ -0,0 +1,33 @@
+/*
+ * Software Security Engine for the host build.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SE_SOFT_H_
+#define _SE_SOFT_H_
+
+#include <utils/types.h>
+
+typedef struct _se_soft_stats_t
+{
+	u64 ops;
+	u64 aes_bytes;
+	u64 sha_bytes;
+} se_soft_stats_t;
+
+se_soft_stats_t *se_soft_stats();
+
+#endif
@@ -0,0 +1,334 @@
+/*
+ * Tests for BLZ decompression.
+ *
+ * Round trips generated data and the bootloader logos, and fuzzes the
+ * decoder against the previous implementation. The previous implementation
+ * is kept here with checks added that flag every access it would do outside
+ * the decompressed region. Where it stays in bounds, both must return the
+ * same result and data. Where it does not, the current one must reject the
+ * stream.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/compr/blz.h>
+#include "../../bootloader/gfx/logos.h"
+
+#include "blz_comp.h"
+#include "host_hw.h"
+
+#define FUZZ_ITERS 200000
+
+static u32 rnd_state = 0xB12B12;
+
+static u32 _rnd()
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+
+	return rnd_state;
+}
+
+// Code like data. Repeated words, zero runs and some noise.
+static void _gen_data(u8 *buf, u32 size, u32 kind)
+{
+	static const char *words[] = { "ldr", "str", "mov", "bl ", "\x00\x00\xA0\xE3", "\x1E\xFF\x2F\xE1", "kip", "nx" };
+
+	u32 pos = 0;
+	while (pos < size)
+	{
+		u32 r = _rnd();
+		switch (kind)
+		{
+		case 0: // Zeros.
+			buf[pos++] = 0;
+			break;
+		case 1: // Words.
+		{
+			const char *w = words[r & 7];
+			for (u32 i = 0; i < 4 && pos < size; i++)
+				buf[pos++] = w[i];
+			break;
+		}
+		default: // Mixed.
+			if ((r & 0xF) < 3)
+				buf[pos++] = r >> 8;
+			else if ((r & 0xF) < 5)
+			{
+				for (u32 i = 0; i < (r >> 24) && pos < size; i++)
+					buf[pos++] = 0;
+			}
+			else if (pos > 64)
+			{
+				u32 back = 1 + ((r >> 8) % MIN(pos, 3000));
+				u32 len = 3 + ((r >> 20) & 31);
+				for (u32 i = 0; i < len && pos < size; i++, pos++)
+					buf[pos] = buf[pos - back];
+			}
+			else
+				buf[pos++] = r >> 16;
+			break;
+		}
+	}
+}
+
+// Previous blz_uncompress_srcdest with out of bounds detection.
+static int _blz_old_srcdest(const u8 *comp, u32 comp_len, u8 *dst, u32 dst_size, bool *oob)
+{
+	*oob = false;
+
+	blz_footer footer;
+	if (comp_len < sizeof(blz_footer))
+		return 0;
+	memcpy(&footer, &comp[comp_len - sizeof(blz_footer)], sizeof(blz_footer));
+
+	u32 num_comp = comp_len - sizeof(blz_footer);
+	if (dst_size < num_comp)
+		goto oob;
+	memcpy(dst, comp, num_comp);
+	memset(&dst[num_comp], 0, dst_size - num_comp);
+
+	if (footer.cmp_and_hdr_size > comp_len || footer.header_size > footer.cmp_and_hdr_size)
+		goto oob;
+
+	u8 *cmp_start = &dst[comp_len] - footer.cmp_and_hdr_size;
+	u32 cmp_ofs = footer.cmp_and_hdr_size - footer.header_size;
+	u64 out_size = (u64)footer.cmp_and_hdr_size + footer.addl_size;
+	if ((u64)comp_len + footer.addl_size > dst_size)
+		goto oob;
+	u32 out_ofs = out_size;
+
+	while (out_ofs)
+	{
+		if (cmp_ofs < 1)
+			goto oob;
+
+		u8 control = cmp_start[--cmp_ofs];
+		for (u32 i = 0; i < 8; i++)
+		{
+			if (control & 0x80)
+			{
+				if (cmp_ofs < 2)
+					return 0;
+
+				cmp_ofs -= 2;
+				u16 seg_val = ((u32)(cmp_start[cmp_ofs + 1]) << 8) | cmp_start[cmp_ofs];
+				u32 seg_size = ((seg_val >> 12) & 0xF) + 3;
+				u32 seg_ofs = (seg_val & 0x0FFF) + 3;
+				if (out_ofs < seg_size)
+					seg_size = out_ofs;
+
+				out_ofs -= seg_size;
+				if (out_ofs + seg_ofs + seg_size > out_size)
+					goto oob;
+
+				for (u32 j = 0; j < seg_size; j++)
+					cmp_start[out_ofs + j] = cmp_start[out_ofs + j + seg_ofs];
+			}
+			else
+			{
+				if (cmp_ofs < 1)
+					return 0;
+
+				cmp_start[--out_ofs] = cmp_start[--cmp_ofs];
+			}
+			control <<= 1;
+			if (out_ofs == 0)
+				return 1;
+		}
+	}
+
+	return 1;
+
+oob:
+	*oob = true;
+	return 0;
+}
+
+static void _test_roundtrip()
+{
+	static const u32 sizes[] = { 64, 100, 333, 4096, 4097, 65536, 300001, SZ_1M };
+	u32 cases = 0;
+
+	for (u32 s = 0; s < ARRAY_SIZE(sizes); s++)
+	{
+		for (u32 kind = 0; kind < 3; kind++)
+		{
+			u32 size = sizes[s];
+			u8 *data = malloc(size);
+			u8 *comp = malloc(size + 16);
+			u8 *out = malloc(size + SZ_4K);
+			_gen_data(data, size, kind);
+
+			u32 comp_len = blz_host_compress(comp, data, size);
+			if (!comp_len)
+				goto next;
+			cases++;
+
+			// Exact and bigger destinations. The rest must be cleared.
+			for (u32 extra = 0; extra <= SZ_4K; extra += SZ_4K)
+			{
+				memset(out, 0xAA, size + extra);
+				int res = blz_uncompress_srcdest(comp, comp_len, out, size + extra);
+				HOST_CHECK(res == 1, "size %d kind %d: decompression failed", size, kind);
+				HOST_CHECK(!memcmp(out, data, size), "size %d kind %d: data differs", size, kind);
+
+				bool clear = true;
+				for (u32 i = size; i < size + extra; i++)
+					clear &= !out[i];
+				HOST_CHECK(clear, "size %d kind %d: destination past the data was not cleared", size, kind);
+			}
+
+			// Small destination.
+			HOST_CHECK(!blz_uncompress_srcdest(comp, comp_len, out, size - 1),
+				"size %d kind %d: destination overflow was not rejected", size, kind);
+
+		next:
+			free(data);
+			free(comp);
+			free(out);
+		}
+	}
+
+	HOST_CHECK(cases >= 18, "only %d round trip cases compressed", cases);
+}
+
+static void _test_logos()
+{
+	static const struct { const u8 *blz; u32 blz_size; u32 size; } logos[] = {
+		{ BOOTLOGO_BLZ, SZ_BOOTLOGO_BLZ, SZ_BOOTLOGO },
+		{ BATTERY_EMPTY_BLZ, SZ_BATTERY_EMPTY_BLZ, SZ_BATTERY_EMPTY },
+	};
+
+	for (u32 i = 0; i < ARRAY_SIZE(logos); i++)
+	{
+		bool oob;
+		u8 *ref = malloc(logos[i].size);
+		u8 *out = malloc(logos[i].size);
+
+		int ref_res = _blz_old_srcdest(logos[i].blz, logos[i].blz_size, ref, logos[i].size, &oob);
+		HOST_CHECK(ref_res == 1 && !oob, "logo %d: previous decoder failed", i);
+		HOST_CHECK(blz_uncompress_srcdest(logos[i].blz, logos[i].blz_size, out, logos[i].size) == 1,
+			"logo %d: decompression failed", i);
+		HOST_CHECK(!memcmp(ref, out, logos[i].size), "logo %d: data differs from the previous decoder", i);
+
+		// The main.c callers rely on this failing for a small destination.
+		HOST_CHECK(!blz_uncompress_srcdest(logos[i].blz, logos[i].blz_size, out, logos[i].size - 1),
+			"logo %d: destination overflow was not rejected", i);
+
+		free(ref);
+		free(out);
+	}
+}
+
+static void _test_fuzz()
+{
+	u32 size = 8192;
+	u8 *data = malloc(size);
+	u8 *base = malloc(size + 16);
+	u8 *comp = malloc(size + 16);
+	u8 *ref = malloc(size * 2);
+	u8 *out = malloc(size * 2);
+	u32 oob_cnt = 0, ok_cnt = 0, fail_cnt = 0;
+	u32 base_len = 0;
+
+	for (u32 iter = 0; iter < FUZZ_ITERS; iter++)
+	{
+		// New base stream every 1000 iterations.
+		if (!(iter % 1000))
+		{
+			do
+			{
+				size = 64 + (_rnd() % 8000);
+				_gen_data(data, size, 1 + (_rnd() & 1));
+				base_len = blz_host_compress(base, data, size);
+			} while (!base_len);
+		}
+
+		u32 comp_len = base_len;
+		memcpy(comp, base, base_len);
+
+		// Mutate.
+		u32 r = _rnd();
+		u32 flips = 1 + (r & 3);
+		for (u32 i = 0; i < flips; i++)
+			comp[_rnd() % comp_len] ^= 1 << (_rnd() & 7);
+		if (r & 0x10) // Footer field.
+		{
+			u32 field = (_rnd() % 3) * 4;
+			u32 val = (r & 0x20) ? _rnd() : (_rnd() % (comp_len * 2));
+			memcpy(&comp[comp_len - sizeof(blz_footer) + field], &val, sizeof(u32));
+		}
+		if (r & 0x40) // Truncation.
+		{
+			u32 cut = _rnd() % 32;
+			if (cut < comp_len)
+			{
+				memmove(&comp[comp_len - cut - sizeof(blz_footer)], &comp[comp_len - sizeof(blz_footer)], sizeof(blz_footer));
+				comp_len -= cut;
+			}
+		}
+
+		u32 dst_size = (r & 0x80) ? size : size + (_rnd() % size);
+		if (dst_size < comp_len)
+			dst_size = comp_len;
+
+		bool oob;
+		memset(ref, 0x55, dst_size);
+		memset(out, 0x55, dst_size);
+		int ref_res = _blz_old_srcdest(comp, comp_len, ref, dst_size, &oob);
+		int res = blz_uncompress_srcdest(comp, comp_len, out, dst_size);
+
+		if (oob)
+		{
+			oob_cnt++;
+			HOST_CHECK(!res, "iter %d: stream out of bounds for the previous decoder was accepted", iter);
+		}
+		else
+		{
+			ref_res ? ok_cnt++ : fail_cnt++;
+			HOST_CHECK(res == ref_res, "iter %d: result %d, previous decoder %d", iter, res, ref_res);
+			if (res && ref_res)
+				HOST_CHECK(!memcmp(ref, out, dst_size), "iter %d: data differs from the previous decoder", iter);
+		}
+
+		if (host_failures > 10)
+			break;
+	}
+
+	printf("fuzz: %d ok, %d failed, %d out of bounds\n", ok_cnt, fail_cnt, oob_cnt);
+
+	free(data);
+	free(base);
+	free(comp);
+	free(ref);
+	free(out);
+}
+
+int main()
+{
+	host_init();
+
+	_test_roundtrip();
+	_test_logos();
+	_test_fuzz();
+
+	return host_report("test_blz");
+}
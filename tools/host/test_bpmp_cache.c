@@ -0,0 +1,365 @@
+/*
+ * BPMP cache model and range maintenance tests.
+ *
+ * Models the BPMP cache controller registers and a cache in front of a DRAM
+ * window, and runs bpmp_mmu_maintenance_range on it the way the SDMMC and
+ * USB drivers do around DMA. The CPU side goes through the cache and the
+ * device side to memory. Checks that the device reads what the CPU wrote,
+ * that the CPU reads what the device wrote, and that CPU data that shares a
+ * line with a buffer is kept, in write-back and write-through modes. Reports
+ * the maintenance operations per MB of the SDMMC and USB transfer sizes.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+// Cache controller registers go to the model. The host_hw.c versions of the other calls are renamed.
+static vu32 *_cache_reg(u32 off);
+#undef BPMP_CACHE_CTRL
+#define BPMP_CACHE_CTRL(off) (*_cache_reg(off))
+#define bpmp_mmu_maint_stats bpmp_mmu_maint_stats_bpmp
+#define bpmp_mmu_maintenance _bpmp_mmu_maintenance
+#define bpmp_clk_rate_get    _bpmp_clk_rate_get
+#define bpmp_usleep          _bpmp_usleep
+#define bpmp_msleep          _bpmp_msleep
+#define bpmp_halt            _bpmp_halt
+
+#include "../../bdk/soc/bpmp.c"
+
+#undef bpmp_mmu_maint_stats
+#undef bpmp_mmu_maintenance
+#undef bpmp_clk_rate_get
+#undef bpmp_usleep
+#undef bpmp_msleep
+#undef bpmp_halt
+
+#include "host_hw.h"
+
+// Used by the BPMP clock code.
+void clock_enable_pllc(u32 divn) {}
+void clock_disable_pllc() {}
+
+#define LINE_SIZE  BPMP_MMU_CACHE_LINE_SIZE
+#define MODEL_BASE SDMMC_UPPER_BUFFER
+#define MODEL_SIZE SZ_64K
+#define MODEL_LINES (MODEL_SIZE / LINE_SIZE)
+
+typedef struct _cache_line_t
+{
+	bool valid;
+	bool dirty;
+	u8 data[LINE_SIZE];
+} cache_line_t;
+
+static u32 regs[0x100 / sizeof(u32)];
+static cache_line_t lines[MODEL_LINES];
+static bool maint_pending;
+
+// Memory as the device sees it.
+static u8 *mem = (u8 *)MODEL_BASE;
+
+static cache_line_t *_line(u32 addr)
+{
+	return &lines[(addr - MODEL_BASE) / LINE_SIZE];
+}
+
+static void _line_clean(u32 addr)
+{
+	cache_line_t *line = _line(addr);
+	if (line->valid && line->dirty)
+		memcpy(mem + ALIGN_DOWN(addr - MODEL_BASE, LINE_SIZE), line->data, LINE_SIZE);
+	line->dirty = false;
+}
+
+static void _line_op(u32 op, u32 addr)
+{
+	if (op == BPMP_MMU_MAINT_CLEAN_PHY || op == BPMP_MMU_MAINT_CLEAN_INVALID_PHY)
+		_line_clean(addr);
+	if (op == BPMP_MMU_MAINT_INVALID_PHY || op == BPMP_MMU_MAINT_CLEAN_INVALID_PHY)
+		_line(addr)->valid = false;
+}
+
+static void _maint_exec()
+{
+	u32 op = regs[BPMP_CACHE_MAINT_REQ / 4] & 0xFF;
+	u32 addr = regs[BPMP_CACHE_MAINT_ADDR / 4];
+
+	switch (op)
+	{
+	case BPMP_MMU_MAINT_CLEAN_PHY:
+	case BPMP_MMU_MAINT_INVALID_PHY:
+	case BPMP_MMU_MAINT_CLEAN_INVALID_PHY:
+		if ((addr & (LINE_SIZE - 1)) || addr < MODEL_BASE || addr >= MODEL_BASE + MODEL_SIZE)
+		{
+			HOST_CHECK(false, "line maintenance on %08X", addr);
+			break;
+		}
+		_line_op(op, addr);
+		break;
+
+	case BPMP_MMU_MAINT_CLEAN_WAY:
+	case BPMP_MMU_MAINT_INVALID_WAY:
+	case BPMP_MMU_MAINT_CLN_INV_WAY:
+		for (u32 i = 0; i < MODEL_LINES; i++)
+			_line_op(op - BPMP_MMU_MAINT_CLEAN_WAY + BPMP_MMU_MAINT_CLEAN_PHY, MODEL_BASE + i * LINE_SIZE);
+		break;
+
+	default:
+		HOST_CHECK(false, "maintenance op %d", op);
+		break;
+	}
+}
+
+// Requests run when the driver polls for them to be done.
+static vu32 *_cache_reg(u32 off)
+{
+	if (off == BPMP_CACHE_MAINT_REQ)
+		maint_pending = true;
+	else if (off == BPMP_CACHE_INT_RAW_EVENT)
+	{
+		regs[BPMP_CACHE_INT_RAW_EVENT / 4] &= ~regs[BPMP_CACHE_INT_CLEAR / 4];
+		regs[BPMP_CACHE_INT_CLEAR / 4] = 0;
+		if (maint_pending)
+		{
+			_maint_exec();
+			regs[BPMP_CACHE_INT_RAW_EVENT / 4] |= INT_MAINT_DONE;
+			maint_pending = false;
+		}
+	}
+
+	return &regs[off / 4];
+}
+
+static bool _write_through()
+{
+	return regs[BPMP_CACHE_CONFIG / 4] & CFG_FORCE_WRITE_THROUGH;
+}
+
+static cache_line_t *_line_fill(u32 addr)
+{
+	cache_line_t *line = _line(addr);
+	if (!line->valid)
+	{
+		memcpy(line->data, mem + ALIGN_DOWN(addr - MODEL_BASE, LINE_SIZE), LINE_SIZE);
+		line->valid = true;
+		line->dirty = false;
+	}
+
+	return line;
+}
+
+static u8 _cpu_read(u32 addr)
+{
+	return _line_fill(addr)->data[addr & (LINE_SIZE - 1)];
+}
+
+static void _cpu_write(u32 addr, u8 val)
+{
+	cache_line_t *line = _line_fill(addr);
+	line->data[addr & (LINE_SIZE - 1)] = val;
+	if (_write_through())
+		mem[addr - MODEL_BASE] = val;
+	else
+		line->dirty = true;
+}
+
+static void _cpu_fill(u32 addr, u32 size, u8 seed)
+{
+	for (u32 i = 0; i < size; i++)
+		_cpu_write(addr + i, seed + i);
+}
+
+static bool _cpu_check(u32 addr, u32 size, u8 seed)
+{
+	for (u32 i = 0; i < size; i++)
+		if (_cpu_read(addr + i) != (u8)(seed + i))
+			return false;
+
+	return true;
+}
+
+static void _dev_fill(u32 addr, u32 size, u8 seed)
+{
+	for (u32 i = 0; i < size; i++)
+		mem[addr - MODEL_BASE + i] = seed + i;
+}
+
+static bool _dev_check(u32 addr, u32 size, u8 seed)
+{
+	for (u32 i = 0; i < size; i++)
+		if (mem[addr - MODEL_BASE + i] != (u8)(seed + i))
+			return false;
+
+	return true;
+}
+
+static void _model_reset(bool write_back)
+{
+	memset(lines, 0, sizeof(lines));
+	memset(mem, 0, MODEL_SIZE);
+	memset(regs, 0, sizeof(regs));
+	maint_pending = false;
+
+	bpmp_mmu_enable();
+	if (write_back)
+		regs[BPMP_CACHE_CONFIG / 4] &= ~CFG_FORCE_WRITE_THROUGH;
+}
+
+typedef struct _xfer_t
+{
+	u32 off;
+	u32 size;
+} xfer_t;
+
+// Unaligned starts and ends, single lines, the 13 byte CSW, sectors and a range above the line limit.
+static const xfer_t xfers[] = {
+	{ 0,    LINE_SIZE },
+	{ 8,    13        },
+	{ 0x1F, 2         },
+	{ 0x40, 512       },
+	{ 0x44, 512       },
+	{ 0x60, 0x1005    },
+	{ 0x80, SZ_16K    },
+};
+
+// CPU data around the buffer, in the lines it shares with it.
+#define GUARD LINE_SIZE
+
+static void _test_dev_read(bool write_back)
+{
+	for (u32 i = 0; i < ARRAY_SIZE(xfers); i++)
+	{
+		u32 buf = MODEL_BASE + GUARD + xfers[i].off;
+		u32 size = xfers[i].size;
+
+		_model_reset(write_back);
+		_cpu_fill(buf - GUARD, GUARD, 0x10);
+		_cpu_fill(buf, size, 0x20);
+		_cpu_fill(buf + size, GUARD, 0x30);
+
+		// Like an SDMMC read or USB OUT. Clean before, device writes, invalidate after.
+		bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, (void *)(uptr)buf, size);
+		_dev_fill(buf, size, 0x40);
+		bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, (void *)(uptr)buf, size);
+
+		HOST_CHECK(_cpu_check(buf, size, 0x40), "%s, %d bytes at +%X: CPU reads stale data after device write",
+			write_back ? "write-back" : "write-through", size, xfers[i].off);
+		HOST_CHECK(_cpu_check(buf - GUARD, GUARD, 0x10) && _cpu_check(buf + size, GUARD, 0x30),
+			"%s, %d bytes at +%X: CPU data next to the buffer was lost", write_back ? "write-back" : "write-through",
+			size, xfers[i].off);
+	}
+}
+
+static void _test_dev_write(bool write_back)
+{
+	for (u32 i = 0; i < ARRAY_SIZE(xfers); i++)
+	{
+		u32 buf = MODEL_BASE + GUARD + xfers[i].off;
+		u32 size = xfers[i].size;
+
+		// Like an SDMMC write or USB IN. The device must see what the CPU wrote.
+		_model_reset(write_back);
+		_cpu_fill(buf, size, 0x50);
+		bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, (void *)(uptr)buf, size);
+
+		HOST_CHECK(_dev_check(buf, size, 0x50), "%s, %d bytes at +%X: device reads stale data",
+			write_back ? "write-back" : "write-through", size, xfers[i].off);
+	}
+}
+
+static void _test_dirty_during_dma()
+{
+	// A line shared with the buffer gets dirty again while the device writes, e.g. a struct next to it.
+	// The device data must win. The CPU write is lost, so buffers must not share lines with such data.
+	u32 buf = MODEL_BASE + GUARD + 8;
+	u32 size = 100;
+
+	_model_reset(true);
+	_cpu_fill(buf, size, 0x20);
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, (void *)(uptr)buf, size);
+	_cpu_write(buf - 1, 0xEE);
+	_cpu_write(buf + size, 0xEE);
+	_dev_fill(buf, size, 0x40);
+	bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, (void *)(uptr)buf, size);
+
+	HOST_CHECK(_dev_check(buf, size, 0x40), "stale CPU data was written over device data");
+	HOST_CHECK(_cpu_check(buf, size, 0x40), "CPU reads stale data after device write");
+}
+
+static void _test_no_invalidate()
+{
+	// The model catches missing maintenance.
+	u32 buf = MODEL_BASE + GUARD;
+
+	_model_reset(true);
+	_cpu_fill(buf, 64, 0x20);
+	_dev_fill(buf, 64, 0x40);
+	HOST_CHECK(!_cpu_check(buf, 64, 0x40), "model did not keep stale lines");
+	HOST_CHECK(!_dev_check(buf, 64, 0x20), "model wrote back dirty lines without a clean");
+}
+
+static void _test_ops_per_mb()
+{
+	static const u32 sizes[] = { 13, 512, SZ_4K, SZ_16K, SZ_1M };
+
+	printf("%-10s %10s %10s %12s\n", "transfer", "line ops", "way ops", "ops per MB");
+	for (u32 i = 0; i < ARRAY_SIZE(sizes); i++)
+	{
+		u32 size = sizes[i];
+		u32 count = MAX(1, SZ_4M / size);
+
+		_model_reset(false);
+		memset(&bpmp_mmu_maint_stats_bpmp, 0, sizeof(bpmp_mmu_maint_stats_bpmp));
+
+		// Clean and invalidate, like a read.
+		for (u32 j = 0; j < count; j++)
+		{
+			bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_CLEAN_WAY, (void *)(uptr)MODEL_BASE, size);
+			bpmp_mmu_maintenance_range(BPMP_MMU_MAINT_INVALID_WAY, (void *)(uptr)MODEL_BASE, size);
+		}
+
+		bpmp_mmu_maint_stats_t *stats = &bpmp_mmu_maint_stats_bpmp;
+		u32 ops_per_mb = (u64)(stats->way_ops + stats->line_ops) * SZ_1M / ((u64)count * size);
+		HOST_CHECK(stats->bytes == (u64)count * size * 2, "%d bytes counted, expected %d", (u32)stats->bytes, count * size * 2);
+
+		// Ranges up to the limit use lines, bigger ones whole cache ops.
+		if (size <= BPMP_MMU_MAINT_RANGE_MAX)
+			HOST_CHECK(!stats->way_ops && stats->line_ops == count * 2 * (ALIGN(size, LINE_SIZE) / LINE_SIZE),
+				"%d bytes: %d line and %d way ops", size, stats->line_ops, stats->way_ops);
+		else
+			HOST_CHECK(!stats->line_ops && stats->way_ops == count * 2, "%d bytes: %d line and %d way ops", size,
+				stats->line_ops, stats->way_ops);
+
+		printf("%-10d %10d %10d %12d\n", size, stats->line_ops, stats->way_ops, ops_per_mb);
+	}
+}
+
+int main()
+{
+	host_init();
+
+	_test_dev_read(true);
+	_test_dev_read(false);
+	_test_dev_write(true);
+	_test_dev_write(false);
+	_test_dirty_during_dma();
+	_test_no_invalidate();
+	_test_ops_per_mb();
+
+	return host_report("test_bpmp_cache");
+}
@@ -0,0 +1,124 @@
+/*
+ * Tests for crc32_calc.
+ *
+ * Checks the slice-by-8 CRC32 against known vectors and against a bytewise
+ * reference for every alignment and length tail, and that chained calls give
+ * the same result as one call over the whole buffer.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include "bench_common.h"
+#include "host_hw.h"
+
+static u32 _crc32_ref(u32 crc, const u8 *buf, u32 len)
+{
+	crc = ~crc;
+	while (len--)
+	{
+		crc ^= *buf++;
+		for (u32 i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+static void _test_vectors()
+{
+	static const struct { const char *data; u32 crc; } vectors[] = {
+		{ "",                                            0x00000000 },
+		{ "a",                                           0xE8B7BE43 },
+		{ "abc",                                         0x352441C2 },
+		{ "123456789",                                   0xCBF43926 },
+		{ "message digest",                              0x20159D7F },
+		{ "The quick brown fox jumps over the lazy dog", 0x414FA339 },
+	};
+
+	for (u32 i = 0; i < ARRAY_SIZE(vectors); i++)
+	{
+		u32 crc = crc32_calc(0, (const u8 *)vectors[i].data, strlen(vectors[i].data));
+		HOST_CHECK(crc == vectors[i].crc, "\"%s\": %08X, expected %08X", vectors[i].data, crc, vectors[i].crc);
+	}
+
+	// 32 bytes of zeros and of ones, from RFC 3720.
+	u8 buf[32];
+	memset(buf, 0, sizeof(buf));
+	HOST_CHECK(crc32_calc(0, buf, sizeof(buf)) == 0x190A55AD, "zeros: %08X", crc32_calc(0, buf, sizeof(buf)));
+	memset(buf, 0xFF, sizeof(buf));
+	HOST_CHECK(crc32_calc(0, buf, sizeof(buf)) == 0xFF6CAB0B, "ones: %08X", crc32_calc(0, buf, sizeof(buf)));
+}
+
+static void _test_unaligned()
+{
+	u32 size = 256;
+	u8 *buf = malloc(size + 16);
+	bench_fill(buf, size + 16, 0x1234);
+
+	// Every start alignment with every length tail, through the head, slice and tail loops.
+	for (u32 off = 0; off < 8; off++)
+	{
+		for (u32 len = 0; len <= size; len++)
+		{
+			u32 crc = crc32_calc(0, buf + off, len);
+			u32 ref = _crc32_ref(0, buf + off, len);
+			if (crc != ref)
+			{
+				HOST_CHECK(false, "offset %d, length %d: %08X, expected %08X", off, len, crc, ref);
+				break;
+			}
+		}
+	}
+
+	free(buf);
+}
+
+static void _test_chained()
+{
+	u32 size = SZ_1M + 13;
+	u8 *buf = malloc(size);
+	bench_fill(buf, size, 0x5678);
+
+	u32 whole = crc32_calc(0, buf, size);
+	HOST_CHECK(whole == _crc32_ref(0, buf, size), "1MB: %08X, expected %08X", whole, _crc32_ref(0, buf, size));
+
+	// Odd chunk sizes, so later chunks start unaligned.
+	u32 crc = 0;
+	for (u32 pos = 0, chunk = 1; pos < size; pos += chunk, chunk = chunk * 3 + 1)
+		crc = crc32_calc(crc, buf + pos, MIN(chunk, size - pos));
+	HOST_CHECK(crc == whole, "chained: %08X, expected %08X", crc, whole);
+
+	// Chained like the backup does, per 4MB file chunk.
+	crc = crc32_calc(0, buf, SZ_512K);
+	crc = crc32_calc(crc, buf + SZ_512K, size - SZ_512K);
+	HOST_CHECK(crc == whole, "two chunks: %08X, expected %08X", crc, whole);
+
+	free(buf);
+}
+
+int main()
+{
+	host_init();
+
+	_test_vectors();
+	_test_unaligned();
+	_test_chained();
+
+	return host_report("test_crc32");
+}
@@ -0,0 +1,527 @@
+/*
+ * Tests for the Nyx eMMC backup and restore tools.
+ *
+ * Runs dump_emmc_selected and restore_emmc_selected against a simulated eMMC
+ * and SD card and checks the CRC32 files the backup writes and that restores
+ * stop on backup files that do not match them. Then injects storage faults in
+ * dumps, restores and BIS accesses and checks that transient ones are retried
+ * to the right data and that lasting ones fail instead of leaving wrong data.
+ * Last, flips bits on eMMC writes and SD reads and checks that the readback
+ * restore verification reports the exact bad LBA regions.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include "config.h"
+#include <libs/fatfs/ff.h>
+#include "frontend/fe_emmc_tools.h"
+
+#include "bench_common.h"
+#include "host_hw.h"
+#include "nyx_host.h"
+#include "sdmmc_sim.h"
+
+#define EMMC_MB   128
+#define EMMC_SECS (EMMC_MB * 0x800)
+
+#define BACKUP_DIR  "backup/" BENCH_EMMC_SN
+#define RESTORE_DIR BACKUP_DIR "/restore"
+
+extern nyx_config n_cfg;
+
+static emmc_tool_gui_t gui;
+
+static void _log_clear()
+{
+	lv_label_set_text(gui.label_log, "");
+}
+
+static bool _log_has(const char *text)
+{
+	return strstr(lv_label_get_text(gui.label_log), text) != NULL;
+}
+
+static bool _sd_exists(const char *path)
+{
+	bool res = sd_mount() && f_stat(path, NULL) == FR_OK;
+	sd_unmount();
+
+	return res;
+}
+
+static bool _sd_save(const char *path, const void *data, u32 size)
+{
+	bool res = sd_mount() && !sd_save_to_file((void *)data, size, path);
+	sd_unmount();
+
+	return res;
+}
+
+static bool _sd_save_crc32(const char *path, const void *data, u32 size)
+{
+	char sidecar[128];
+	char txt[128];
+	const char *name = strrchr(path, '/') + 1;
+
+	s_printf(sidecar, "%s.crc32", path);
+	s_printf(txt, "%08X  %s\n", crc32_calc(0, data, size), name);
+
+	return _sd_save(sidecar, txt, strlen(txt));
+}
+
+static void _emmc_clobber()
+{
+	// Everything after the GPT.
+	memset(sim_card_data(SDMMC_4, 0) + SZ_1M, 0x5A, (u64)EMMC_SECS * 512 - SZ_1M);
+}
+
+static void _test_dump()
+{
+	u8 *emmc = sim_card_data(SDMMC_4, 0);
+
+	// Every backup file gets a CRC32 file in the sha1sum/crc32 tool format.
+	n_cfg.crc32_sidecar = 1;
+	n_cfg.verification = 2;
+	_log_clear();
+	dump_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(!_log_has("#FF0000"), "dump failed:\n%s", lv_label_get_text(gui.label_log));
+	HOST_CHECK(bench_sd_file_matches(BACKUP_DIR "/rawnand.bin", emmc, EMMC_SECS), "rawnand.bin does not match the eMMC");
+
+	char expected[32];
+	s_printf(expected, "%08X  rawnand.bin\n", crc32_calc(0, emmc, EMMC_SECS * 512));
+
+	u32 size = 0;
+	sd_mount();
+	char *txt = sd_file_read(BACKUP_DIR "/rawnand.bin.crc32", &size);
+	sd_unmount();
+	HOST_CHECK(txt && size == strlen(expected) && !memcmp(txt, expected, size), "CRC32 file is \"%.*s\", expected \"%s\"",
+		txt ? size : 0, txt ? txt : "", expected);
+	free(txt);
+
+	// A CRC32 file that cannot be written fails the backup.
+	bench_sd_remove(BACKUP_DIR "/rawnand.bin");
+	bench_sd_remove(BACKUP_DIR "/rawnand.bin.crc32");
+	sd_mount();
+	f_mkdir(BACKUP_DIR "/rawnand.bin.crc32");
+	sd_unmount();
+
+	_log_clear();
+	dump_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(_log_has("CRC32 file could not be written"), "unwritable CRC32 file was not reported:\n%s",
+		lv_label_get_text(gui.label_log));
+	HOST_CHECK(!_log_has("Finished"), "backup finished without its CRC32 file");
+
+	bench_sd_remove(BACKUP_DIR "/rawnand.bin.crc32");
+	bench_sd_remove(BACKUP_DIR "/rawnand.bin");
+	n_cfg.crc32_sidecar = 0;
+}
+
+static void _test_restore()
+{
+	u32 size = EMMC_SECS * 512;
+	u8 *emmc = sim_card_data(SDMMC_4, 0);
+	u8 *backup = malloc(size);
+	memcpy(backup, emmc, size);
+
+	// Clean backup with a CRC32 file.
+	n_cfg.verification = 1;
+	HOST_CHECK(_sd_save(RESTORE_DIR "/rawnand.bin", backup, size), "failed to stage rawnand.bin");
+	HOST_CHECK(_sd_save_crc32(RESTORE_DIR "/rawnand.bin", backup, size), "failed to stage rawnand.bin.crc32");
+	_emmc_clobber();
+	_log_clear();
+	restore_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(!_log_has("#FF0000"), "clean restore failed:\n%s", lv_label_get_text(gui.label_log));
+	HOST_CHECK(!memcmp(emmc, backup, size), "restored eMMC does not match the backup");
+
+	// A flipped bit in the backup file passes the eMMC verification, but not the CRC32 file.
+	backup[size / 2 + 123] ^= 0x10;
+	HOST_CHECK(_sd_save(RESTORE_DIR "/rawnand.bin", backup, size), "failed to stage rawnand.bin");
+	_log_clear();
+	restore_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(_log_has("does not match its CRC32 file"), "corrupted backup was not reported:\n%s",
+		lv_label_get_text(gui.label_log));
+
+	// Without it, the restore goes through.
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin.crc32");
+	_log_clear();
+	restore_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(!_log_has("#FF0000") && !memcmp(emmc, backup, size), "restore without CRC32 file failed:\n%s",
+		lv_label_get_text(gui.label_log));
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin");
+	backup[size / 2 + 123] ^= 0x10;
+
+	// Split backup. Each part is checked when it ends, so a bad first part stops before the second is written.
+	u32 half = size / 2;
+	HOST_CHECK(_sd_save(RESTORE_DIR "/rawnand.bin.00", backup, half), "failed to stage part 00");
+	HOST_CHECK(_sd_save_crc32(RESTORE_DIR "/rawnand.bin.00", backup, half), "failed to stage part 00 CRC32");
+	HOST_CHECK(_sd_save(RESTORE_DIR "/rawnand.bin.01", backup + half, half), "failed to stage part 01");
+	HOST_CHECK(_sd_save_crc32(RESTORE_DIR "/rawnand.bin.01", backup + half, half), "failed to stage part 01 CRC32");
+	_emmc_clobber();
+	_log_clear();
+	restore_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(!_log_has("#FF0000") && !memcmp(emmc, backup, size), "split restore failed:\n%s",
+		lv_label_get_text(gui.label_log));
+
+	backup[SZ_1M + 7] ^= 0x01;
+	HOST_CHECK(_sd_save(RESTORE_DIR "/rawnand.bin.00", backup, half), "failed to stage part 00");
+	_emmc_clobber();
+	_log_clear();
+	restore_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(_log_has("rawnand.bin.00 does not match its CRC32 file"), "corrupted part was not reported:\n%s",
+		lv_label_get_text(gui.label_log));
+	HOST_CHECK(emmc[half] == 0x5A && emmc[size - 1] == 0x5A, "restore went on after a corrupted part");
+
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin.00");
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin.00.crc32");
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin.01");
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin.01.crc32");
+	backup[SZ_1M + 7] ^= 0x01;
+	memcpy(emmc, backup, size);
+	free(backup);
+}
+
+static void _test_dump_faults()
+{
+	static const u32 types[] = { SDMMC_FAULT_CRC, SDMMC_FAULT_TIMEOUT, SDMMC_FAULT_BUSY };
+	u8 *emmc = sim_card_data(SDMMC_4, 0);
+
+	n_cfg.verification = 0;
+
+	// Hits that clear within the sdmmc retries (5) and after its reinit at a lower speed (3 more).
+	for (u32 i = 0; i < ARRAY_SIZE(types); i++)
+	{
+		for (u32 count = 2; count <= 6; count += 4)
+		{
+			int slot = sdmmc_fault_add(SDMMC_4, types[i], EMMC_SECS / 2 + 5, count);
+			_log_clear();
+			dump_emmc_selected(PART_RAW, &gui);
+			HOST_CHECK(!_log_has("#FF0000"), "fault %d x%d: dump failed:\n%s", types[i], count,
+				lv_label_get_text(gui.label_log));
+			HOST_CHECK(bench_sd_file_matches(BACKUP_DIR "/rawnand.bin", emmc, EMMC_SECS),
+				"fault %d x%d: rawnand.bin does not match the eMMC", types[i], count);
+			HOST_CHECK(sdmmc_fault_get_hits(slot) == count, "fault %d x%d: %d hits", types[i], count,
+				sdmmc_fault_get_hits(slot));
+
+			sdmmc_fault_clear();
+			bench_sd_remove(BACKUP_DIR "/rawnand.bin");
+		}
+	}
+
+	// Lasting fault. sdmmc gives up after the lowest speed and the dump stops and removes the partial file.
+	sdmmc_fault_add(SDMMC_4, SDMMC_FAULT_TIMEOUT, EMMC_SECS / 2 + 5, 0);
+	_log_clear();
+	dump_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(_log_has("Aborting"), "lasting fault did not abort the dump:\n%s", lv_label_get_text(gui.label_log));
+	HOST_CHECK(!_sd_exists(BACKUP_DIR "/rawnand.bin"), "aborted dump left rawnand.bin");
+	sdmmc_fault_clear();
+
+	// Removed card. Every xfer after the first hit fails and no reinit is tried.
+	u64 inits = sim_card_stats(SDMMC_4)->inits;
+	dump_emmc_selected(PART_BOOT, &gui);
+	u64 clean_inits = sim_card_stats(SDMMC_4)->inits - inits;
+
+	int slot = sdmmc_fault_add(SDMMC_4, SDMMC_FAULT_REMOVED, EMMC_SECS / 2 + 5, 1);
+	inits = sim_card_stats(SDMMC_4)->inits;
+	_log_clear();
+	dump_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(_log_has("Aborting") && !_sd_exists(BACKUP_DIR "/rawnand.bin"), "removed card did not abort the dump:\n%s",
+		lv_label_get_text(gui.label_log));
+	HOST_CHECK(sim_card_stats(SDMMC_4)->inits - inits == clean_inits, "removed card was reinitialized %d times",
+		(u32)(sim_card_stats(SDMMC_4)->inits - inits - clean_inits));
+	HOST_CHECK(sdmmc_fault_get_hits(slot) > 1, "removed card did not fail later xfers");
+	sdmmc_fault_clear();
+
+	// A reinit selects the user area. Retried BOOT0 reads must still come from BOOT0.
+	slot = sdmmc_fault_add(SDMMC_4, SDMMC_FAULT_CRC, 0x100, 6);
+	_log_clear();
+	dump_emmc_selected(PART_BOOT, &gui);
+	HOST_CHECK(!_log_has("#FF0000"), "BOOT dump with reinit failed:\n%s", lv_label_get_text(gui.label_log));
+	HOST_CHECK(sdmmc_fault_get_hits(slot) == 6, "BOOT fault %d hits", sdmmc_fault_get_hits(slot));
+	HOST_CHECK(bench_sd_file_matches(BACKUP_DIR "/BOOT0", sim_card_data(SDMMC_4, 1), SIM_BOOT_PART_SECS),
+		"BOOT0 does not match after a reinit");
+	HOST_CHECK(bench_sd_file_matches(BACKUP_DIR "/BOOT1", sim_card_data(SDMMC_4, 2), SIM_BOOT_PART_SECS),
+		"BOOT1 does not match after a reinit");
+	sdmmc_fault_clear();
+
+	bench_sd_remove(BACKUP_DIR "/BOOT0");
+	bench_sd_remove(BACKUP_DIR "/BOOT1");
+}
+
+static void _test_restore_faults()
+{
+	u32 size = EMMC_SECS * 512;
+	u8 *emmc = sim_card_data(SDMMC_4, 0);
+	u8 *backup = malloc(size);
+	memcpy(backup, emmc, size);
+
+	n_cfg.verification = 1;
+	HOST_CHECK(_sd_save(RESTORE_DIR "/rawnand.bin", backup, size), "failed to stage rawnand.bin");
+
+	// Write faults that clear within the sdmmc retries and after its reinit.
+	for (u32 count = 2; count <= 6; count += 4)
+	{
+		int slot = sdmmc_fault_add(SDMMC_4, SDMMC_FAULT_TIMEOUT, EMMC_SECS / 4 + 9, count);
+		_emmc_clobber();
+		_log_clear();
+		restore_emmc_selected(PART_RAW, &gui);
+		HOST_CHECK(!_log_has("#FF0000") && !memcmp(emmc, backup, size), "write fault x%d: restore failed:\n%s", count,
+			lv_label_get_text(gui.label_log));
+		HOST_CHECK(sdmmc_fault_get_hits(slot) == count, "write fault x%d: %d hits", count, sdmmc_fault_get_hits(slot));
+		sdmmc_fault_clear();
+	}
+
+	// Lasting fault. The restore stops and says so.
+	sdmmc_fault_add(SDMMC_4, SDMMC_FAULT_CRC, EMMC_SECS / 4 + 9, 0);
+	_emmc_clobber();
+	_log_clear();
+	restore_emmc_selected(PART_RAW, &gui);
+	HOST_CHECK(_log_has("inoperative state"), "lasting write fault was not reported:\n%s",
+		lv_label_get_text(gui.label_log));
+	HOST_CHECK(!_log_has("Finished"), "restore finished with a lasting write fault");
+	sdmmc_fault_clear();
+
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin");
+	memcpy(emmc, backup, size);
+	free(backup);
+}
+
+static void _emmc_reinit()
+{
+	emmc_initialize(false);
+	sdmmc_storage_set_mmc_partition(&emmc_storage, EMMC_GPP);
+}
+
+static bool _bis_cluster_matches(const u8 *buf, const u8 *data, u32 cluster)
+{
+	return !memcmp(buf + cluster * 32 * 512, data + cluster * 32 * 512, 32 * 512);
+}
+
+static void _test_bis_faults()
+{
+	const u32 clusters = 8;
+	const u32 secs = clusters * 32;
+	emmc_part_t *user = bench_gpt_part("USER");
+	u8 *data = malloc(secs * 512);
+	u8 *buf = malloc(secs * 512);
+
+	_emmc_reinit();
+
+	// Cached writes. The flush must write every dirty cluster.
+	bench_fill(data, secs * 512, 0xB15);
+	nx_emmc_bis_init(user, true, 0);
+	HOST_CHECK(nx_emmc_bis_read(0, secs, buf), "BIS read failed");
+	HOST_CHECK(nx_emmc_bis_write(0, secs, data), "BIS cached write failed");
+	HOST_CHECK(!nx_emmc_bis_end(), "BIS flush failed");
+
+	nx_emmc_bis_init(user, false, 0);
+	HOST_CHECK(nx_emmc_bis_read(0, secs, buf), "BIS read failed");
+	for (u32 i = 0; i < clusters; i++)
+		HOST_CHECK(_bis_cluster_matches(buf, data, i), "BIS cluster %d was not written by the flush", i);
+	nx_emmc_bis_end();
+
+	// A cluster that can't be written fails the flush. The eMMC is unusable after it, like a real one.
+	bench_fill(data, secs * 512, 0xB16);
+	nx_emmc_bis_init(user, true, 0);
+	HOST_CHECK(nx_emmc_bis_read(0, secs, buf), "BIS read failed");
+	HOST_CHECK(nx_emmc_bis_write(0, secs, data), "BIS cached write failed");
+	int slot = sdmmc_fault_add(SDMMC_4, SDMMC_FAULT_TIMEOUT, user->lba_start + 2 * 32 + 3, 0);
+	HOST_CHECK(nx_emmc_bis_end(), "BIS flush write error was not reported");
+	HOST_CHECK(sdmmc_fault_get_hits(slot), "BIS flush did not reach the faulty cluster");
+	sdmmc_fault_clear();
+
+	_emmc_reinit();
+	nx_emmc_bis_init(user, false, 0);
+	HOST_CHECK(nx_emmc_bis_read(0, secs, buf), "BIS read failed");
+	HOST_CHECK(_bis_cluster_matches(buf, data, 0) && _bis_cluster_matches(buf, data, 1),
+		"BIS clusters before the faulty one were not written");
+	HOST_CHECK(!_bis_cluster_matches(buf, data, 2), "BIS faulty cluster was written");
+	nx_emmc_bis_end();
+
+	// Current contents, for the cached reads.
+	memcpy(data, buf, secs * 512);
+
+	// A failed cluster read must not be served from the cache later.
+	nx_emmc_bis_init(user, true, 0);
+	HOST_CHECK(nx_emmc_bis_read(0, 32, buf), "BIS read failed");
+	slot = sdmmc_fault_add(SDMMC_4, SDMMC_FAULT_CRC, user->lba_start + 5 * 32 + 1, 0);
+	HOST_CHECK(!nx_emmc_bis_read(5 * 32, 1, buf), "BIS read with a lasting fault succeeded");
+	sdmmc_fault_clear();
+
+	_emmc_reinit();
+	memset(buf, 0, secs * 512);
+	HOST_CHECK(nx_emmc_bis_read(5 * 32, 32, buf + 5 * 32 * 512) && _bis_cluster_matches(buf, data, 5),
+		"BIS served a failed cluster read from the cache");
+	HOST_CHECK(!nx_emmc_bis_end(), "BIS end failed");
+
+	sdmmc_storage_end(&emmc_storage);
+
+	free(buf);
+	free(data);
+	free(user);
+}
+
+static u32 _log_count(const char *text)
+{
+	u32 count = 0;
+	for (const char *pos = lv_label_get_text(gui.label_log); (pos = strstr(pos, text)); pos++)
+		count++;
+
+	return count;
+}
+
+static bool _log_has_region(u32 first, u32 last)
+{
+	char txt[64];
+	s_printf(txt, "Mismatch @LBA %08X - %08X (%d blocks)", first, last, last - first + 1);
+
+	return _log_has(txt);
+}
+
+static void _flip(u32 sdmmc_id, u32 sector, u32 bit, bool on_write, u32 skip)
+{
+	sim_flip_t flip = { .partition = 0, .sector = sector, .bit = bit, .on_write = on_write, .skip = skip };
+	HOST_CHECK(sim_card_add_flip(sdmmc_id, &flip), "failed to arm a flip at %X", sector);
+}
+
+// SD card sector that holds a sector of a file. The file must be contiguous.
+static u32 _sd_file_sector(const char *path, u32 sct_off)
+{
+	FIL fp;
+	u32 sector = 0;
+
+	sd_mount();
+	if (f_open(&fp, path, FA_READ) == FR_OK)
+	{
+		sector = sd_fs.database + (fp.obj.sclust - 2) * sd_fs.csize + sct_off;
+		f_close(&fp);
+	}
+	sd_unmount();
+
+	return sector;
+}
+
+// Restores the staged backup. The armed flips are cleared after.
+static bool _readback_restore()
+{
+	_emmc_clobber();
+	_log_clear();
+	restore_emmc_selected(PART_RAW, &gui);
+	sim_card_clear_flips(SDMMC_4);
+	sim_card_clear_flips(SDMMC_1);
+
+	return !_log_has("#FF0000");
+}
+
+static void _test_restore_readback()
+{
+	u32 size = EMMC_SECS * 512;
+	u8 *emmc = sim_card_data(SDMMC_4, 0);
+	u8 *backup = malloc(size);
+	memcpy(backup, emmc, size);
+
+	n_cfg.verification = 1;
+	n_cfg.restore_readback = 1;
+	HOST_CHECK(_sd_save(RESTORE_DIR "/rawnand.bin", backup, size), "failed to stage rawnand.bin");
+
+	// Clean restore. The backup is read from SD only once.
+	u64 sd_read_secs = sim_card_stats(SDMMC_1)->read_secs;
+	HOST_CHECK(_readback_restore() && !memcmp(emmc, backup, size), "clean readback restore failed:\n%s",
+		lv_label_get_text(gui.label_log));
+	HOST_CHECK(strstr(lv_label_get_text(gui.label_finish), "verified"), "clean readback restore was not verified");
+	sd_read_secs = sim_card_stats(SDMMC_1)->read_secs - sd_read_secs;
+	HOST_CHECK(sd_read_secs < EMMC_SECS + EMMC_SECS / 16, "readback verification read %d sectors from SD",
+		(u32)sd_read_secs);
+
+	// Single flip.
+	_flip(SDMMC_4, 0x12345, 3, true, 0);
+	HOST_CHECK(!_readback_restore(), "single flip was not found");
+	HOST_CHECK(_log_has_region(0x12345, 0x12345) && _log_count("Mismatch @LBA") == 1 &&
+		_log_has("1 blocks do not match"), "single flip:\n%s", lv_label_get_text(gui.label_log));
+
+	// A run across a chunk edge is one region.
+	for (u32 sct = 0x3FFE; sct <= 0x4001; sct++)
+		_flip(SDMMC_4, sct, sct & 0xFFF, true, 0);
+	HOST_CHECK(!_readback_restore(), "run across chunk edge was not found");
+	HOST_CHECK(_log_has_region(0x3FFE, 0x4001) && _log_count("Mismatch @LBA") == 1,
+		"run across chunk edge:\n%s", lv_label_get_text(gui.label_log));
+
+	// First and last sectors.
+	_flip(SDMMC_4, 0, 0, true, 0);
+	_flip(SDMMC_4, EMMC_SECS - 1, 4095, true, 0);
+	HOST_CHECK(!_readback_restore(), "first and last sector flips were not found");
+	HOST_CHECK(_log_has_region(0, 0) && _log_has_region(EMMC_SECS - 1, EMMC_SECS - 1) &&
+		_log_has("2 blocks do not match"), "first and last sectors:\n%s", lv_label_get_text(gui.label_log));
+
+	// Only 16 regions are listed.
+	for (u32 i = 0; i < 20; i++)
+		_flip(SDMMC_4, i * 0x3000 + 7, i, true, 0);
+	HOST_CHECK(!_readback_restore(), "20 flips were not found");
+	HOST_CHECK(_log_count("Mismatch @LBA") == 16 && _log_has("...and 4 more regions.") &&
+		_log_has("20 blocks do not match"), "20 flips:\n%s", lv_label_get_text(gui.label_log));
+
+	// Source that differs from what was written is blamed as a whole chunk, merged with the runs next to it.
+	u32 sd_sct = _sd_file_sector(RESTORE_DIR "/rawnand.bin", 0x8000 + 10);
+	HOST_CHECK(sd_sct && !memcmp(sim_card_data(SDMMC_1, 0) + (u64)sd_sct * 512, backup + (0x8000 + 10) * 512, 512),
+		"rawnand.bin is not contiguous on SD");
+	_flip(SDMMC_4, 0x7FFF, 1, true, 0);
+	_flip(SDMMC_4, 0x8000 + 10, 9, true, 0);
+	_flip(SDMMC_1, sd_sct, 9, false, 1);
+	_flip(SDMMC_4, 0xA000, 1, true, 0);
+	HOST_CHECK(!_readback_restore(), "changed source was not found");
+	HOST_CHECK(_log_has_region(0x7FFF, 0xA000) && _log_count("Mismatch @LBA") == 1 &&
+		_log_has("8194 blocks do not match"), "changed source:\n%s", lv_label_get_text(gui.label_log));
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin");
+
+	// Split backup. Regions are at eMMC LBAs, not part offsets.
+	u32 half = size / 2;
+	HOST_CHECK(_sd_save(RESTORE_DIR "/rawnand.bin.00", backup, half), "failed to stage part 00");
+	HOST_CHECK(_sd_save(RESTORE_DIR "/rawnand.bin.01", backup + half, half), "failed to stage part 01");
+	_flip(SDMMC_4, EMMC_SECS / 2 + 0x10, 0, true, 0);
+	HOST_CHECK(!_readback_restore(), "flip in part 01 was not found");
+	HOST_CHECK(_log_has_region(EMMC_SECS / 2 + 0x10, EMMC_SECS / 2 + 0x10) && _log_count("Mismatch @LBA") == 1,
+		"flip in part 01:\n%s", lv_label_get_text(gui.label_log));
+
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin.00");
+	bench_sd_remove(RESTORE_DIR "/rawnand.bin.01");
+	n_cfg.restore_readback = 0;
+	memcpy(emmc, backup, size);
+	free(backup);
+}
+
+int main()
+{
+	nyx_host_init();
+	host_time_freeze(true);
+
+	if (!bench_setup(EMMC_MB))
+		return 1;
+
+	nyx_host_emmc_gui(&gui);
+
+	_test_dump();
+	_test_restore();
+	_test_dump_faults();
+	_test_restore_faults();
+	_test_bis_faults();
+	_test_restore_readback();
+
+	bench_teardown();
+
+	return host_report("test_emmc_tools");
+}
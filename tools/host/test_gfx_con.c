@@ -0,0 +1,313 @@
+/*
+ * Golden image tests for the bootloader console.
+ *
+ * Renders text with bootloader/gfx/gfx.c into a host framebuffer and compares
+ * it against images drawn by a plain per pixel renderer from the same font.
+ * Covers glyphs, scrolling, the status bar area, clearing and scrollback.
+ * Mismatching images are written to build/ as PPM files.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+// Count the bytes the console moves when scrolling.
+static u64 moved_bytes;
+static void *_test_memmove(void *dst, const void *src, size_t len);
+#define memmove _test_memmove
+#define abs _gfx_abs // Clashes with libc.
+
+// Statics of the console, like the font, are needed for the reference.
+#include "../../bootloader/gfx/gfx.c"
+
+#undef memmove
+#undef abs
+
+#include "host_hw.h"
+
+#define FB_W       720
+#define FB_H       1280
+#define SCROLL_END 1256
+#define BG_COL     0xFF102030
+#define SBAR_COL   0xFF303030
+
+static u32 *ref;
+
+static void *_test_memmove(void *dst, const void *src, size_t len)
+{
+	moved_bytes += len;
+
+	return memmove(dst, src, len);
+}
+
+static void _ref_glyph(u32 *fb, u32 x, u32 y, char c, u32 fntsz, u32 fg, u32 bg, bool fill)
+{
+	const u8 *glyph = &_gfx_font[8 * (c - 32)];
+	u32 scale = fntsz / 8;
+
+	for (u32 gy = 0; gy < 8; gy++)
+	{
+		for (u32 gx = 0; gx < 8; gx++)
+		{
+			bool on = glyph[gy] & (1 << gx);
+			if (!on && !fill)
+				continue;
+
+			for (u32 sy = 0; sy < scale; sy++)
+				for (u32 sx = 0; sx < scale; sx++)
+					fb[(y + gy * scale + sy) * FB_W + x + gx * scale + sx] = on ? fg : bg;
+		}
+	}
+}
+
+static void _ref_text(u32 *fb, u32 x, u32 y, const char *s, u32 fntsz, u32 fg, u32 bg, bool fill)
+{
+	for (; *s; s++, x += fntsz)
+		_ref_glyph(fb, x, y, *s, fntsz, fg, bg, fill);
+}
+
+static void _fill(u32 *fb, u32 y, u32 rows, u32 color)
+{
+	for (u32 i = 0; i < rows * FB_W; i++)
+		fb[y * FB_W + i] = color;
+}
+
+static void _pattern(u32 *fb)
+{
+	for (u32 i = 0; i < FB_W * FB_H; i++)
+		fb[i] = 0xFF000000 | (i * 2654435761u >> 8);
+}
+
+static void _dump_ppm(const char *name, const u32 *fb)
+{
+	char path[128];
+	snprintf(path, sizeof(path), "build/%s.ppm", name);
+
+	FILE *f = fopen(path, "wb");
+	if (!f)
+		return;
+
+	fprintf(f, "P6\n%d %d\n255\n", FB_W, FB_H);
+	for (u32 i = 0; i < FB_W * FB_H; i++)
+	{
+		u8 rgb[3] = { fb[i] >> 16, fb[i] >> 8, fb[i] };
+		fwrite(rgb, 1, 3, f);
+	}
+	fclose(f);
+}
+
+static bool _compare(const char *name)
+{
+	u32 *fb = gfx_ctxt.fb;
+
+	for (u32 i = 0; i < FB_W * FB_H; i++)
+	{
+		if (fb[i] != ref[i])
+		{
+			char out[64];
+			HOST_CHECK(false, "%s: pixel %d,%d is %08X, expected %08X", name, i % FB_W, i / FB_W, fb[i], ref[i]);
+			snprintf(out, sizeof(out), "%s_out", name);
+			_dump_ppm(out, fb);
+			snprintf(out, sizeof(out), "%s_ref", name);
+			_dump_ppm(out, ref);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void _con_reset(u32 bgcol)
+{
+	gfx_con_init();
+	gfx_con_set_scroll_end(SCROLL_END);
+	gfx_con_setcol(TXT_CLR_DEFAULT, 1, bgcol);
+
+	_fill(gfx_ctxt.fb, 0, SCROLL_END, bgcol);
+	_fill(gfx_ctxt.fb + SCROLL_END * FB_W, 0, FB_H - SCROLL_END, SBAR_COL);
+	_fill(ref, 0, SCROLL_END, bgcol);
+	_fill(ref + SCROLL_END * FB_W, 0, FB_H - SCROLL_END, SBAR_COL);
+}
+
+static void _test_glyphs()
+{
+	static const u32 colors[] = { TXT_CLR_DEFAULT, TXT_CLR_WARNING, TXT_CLR_ERROR, TXT_CLR_CYAN_L };
+	char line[96];
+
+	gfx_con_init();
+	_pattern(gfx_ctxt.fb);
+	_pattern(ref);
+
+	u32 y = 0;
+	for (u32 fill = 0; fill < 2; fill++)
+	{
+		for (u32 fntsz = 8; fntsz <= 16; fntsz += 8)
+		{
+			u32 per_line = FB_W / fntsz;
+			for (u32 c = 32; c <= 126; c += per_line)
+			{
+				u32 len = 0;
+				for (u32 i = c; i <= 126 && len < per_line; i++)
+					line[len++] = i;
+				line[len] = 0;
+
+				u32 fg = colors[(c / per_line) & 3];
+				gfx_con.fntsz = fntsz;
+				gfx_con_setcol(fg, fill, TXT_CLR_GREY_D);
+				gfx_con_setpos(0, y);
+				gfx_puts(line);
+				_ref_text(ref, 0, y, line, fntsz, fg, TXT_CLR_GREY_D, fill);
+
+				y += fntsz + 4;
+			}
+		}
+	}
+
+	_compare("glyphs");
+}
+
+static u32 _line_text(char *buf, u32 i)
+{
+	s_printf(buf, "Line %d: the quick brown fox", i);
+
+	return strlen(buf);
+}
+
+static void _expect_lines(u32 last, u32 cursor_y, u32 fntsz, u32 back)
+{
+	char text[64];
+
+	_fill(ref, 0, SCROLL_END, BG_COL);
+	for (int i = last, y = cursor_y - fntsz + back; i >= 0 && y >= 0; i--, y -= fntsz)
+	{
+		if (y + fntsz > SCROLL_END)
+			continue;
+		_line_text(text, i);
+		_ref_text(ref, 0, y, text, fntsz, TXT_CLR_DEFAULT, BG_COL, true);
+	}
+}
+
+static void _test_scroll(u32 fntsz, u32 lines)
+{
+	char text[64];
+	char name[32];
+
+	_con_reset(BG_COL);
+	gfx_con.fntsz = fntsz;
+	moved_bytes = 0;
+
+	for (u32 i = 0; i < lines; i++)
+	{
+		_line_text(text, i);
+		gfx_printf("%s\n", text);
+	}
+
+	// Freed rows are cleared with the console background and the status bar is kept.
+	s_printf(name, "scroll_%d", fntsz);
+	_expect_lines(lines - 1, gfx_con.y, fntsz, 0);
+	_compare(name);
+
+	// The region is moved a few times per screen, not on every line.
+	u32 region = SCROLL_END * FB_W * 4;
+	HOST_CHECK(moved_bytes / lines < region / 8, "%s: %d bytes moved per line", name, (u32)(moved_bytes / lines));
+	printf("%s: %d KB moved per line\n", name, (u32)(moved_bytes / lines / 1024));
+
+	// Page through the scrollback and back.
+	u32 *live = malloc(FB_W * FB_H * 4);
+	memcpy(live, gfx_ctxt.fb, FB_W * FB_H * 4);
+
+	u32 max_back = (GFX_CON_HIST_ROWS - SCROLL_END / 8) * 8;
+	u32 cursor_y = gfx_con.y;
+	for (u32 back = fntsz * 7; ; back += fntsz * 29)
+	{
+		u32 shown = gfx_con_scrollback(back);
+		HOST_CHECK(shown == MIN(back, max_back), "%s: scrolled back %d, expected %d", name, shown, MIN(back, max_back));
+
+		s_printf(name, "scrollback_%d_%d", fntsz, shown);
+		_expect_lines(lines - 1, cursor_y, fntsz, shown);
+		if (!_compare(name) || shown < back)
+			break;
+	}
+
+	gfx_con_scrollback(0);
+	HOST_CHECK(!memcmp(live, gfx_ctxt.fb, FB_W * FB_H * 4), "scroll_%d: live console was not restored", fntsz);
+
+	// Printing while scrolled back goes to the live console.
+	gfx_con_scrollback(fntsz * 3);
+	gfx_puts("x");
+	memcpy(ref, live, FB_W * FB_H * 4);
+	_ref_glyph(ref, 0, cursor_y, 'x', fntsz, TXT_CLR_DEFAULT, BG_COL, true);
+	s_printf(name, "scroll_%d_print", fntsz);
+	_compare(name);
+
+	free(live);
+}
+
+static void _test_clear()
+{
+	char text[64];
+
+	_con_reset(TXT_CLR_BG);
+	for (u32 i = 0; i < 10; i++)
+	{
+		_line_text(text, i);
+		gfx_printf("%k%s\n", i & 1 ? TXT_CLR_WARNING : TXT_CLR_DEFAULT, text);
+	}
+	u32 *before = malloc(FB_W * FB_H * 4);
+	memcpy(before, gfx_ctxt.fb, FB_W * FB_H * 4);
+
+	// Like tui_do_menu. The cleared text goes to history.
+	gfx_clear_partial_grey(0x1B, 0, SCROLL_END);
+	gfx_con_setpos(0, 0);
+	gfx_con_setcol(TXT_CLR_DEFAULT, 1, TXT_CLR_BG);
+	gfx_puts("menu");
+
+	HOST_CHECK(gfx_con_scrollback(10 * 16) == 10 * 16, "cleared text is not in history");
+	memcpy(ref, before, FB_W * FB_H * 4);
+	_ref_text(ref, 0, 10 * 16, "menu", 16, TXT_CLR_DEFAULT, TXT_CLR_BG, true);
+	_compare("clear_history");
+	gfx_con_scrollback(0);
+
+	// A partial clear drops the text in its rows.
+	gfx_clear_partial_grey(0x1B, 0, 64);
+	gfx_clear_partial_grey(0x1B, 0, SCROLL_END);
+	HOST_CHECK(gfx_con_scrollback(16) == 16, "cleared rows are not in history");
+	_fill(ref, 0, SCROLL_END, TXT_CLR_BG);
+	_compare("clear_partial");
+	gfx_con_scrollback(0);
+
+	free(before);
+}
+
+int main()
+{
+	host_init();
+
+	u32 *fb = malloc(FB_W * FB_H * 4);
+	ref = malloc(FB_W * FB_H * 4);
+	gfx_init_ctxt(fb, FB_W, FB_H, FB_W);
+
+	_test_glyphs();
+	_test_scroll(16, 1000);
+	_test_scroll(8, 3000);
+	_test_clear();
+
+	free(fb);
+	free(ref);
+
+	return host_report("test_gfx_con");
+}
@@ -0,0 +1,228 @@
+/*
+ * Tests for the tool log view.
+ *
+ * Checks the visible lines and scrollback against a plain copy of the
+ * history, and that the per append cost stays flat over 100k lines.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/lvgl/lvgl.h>
+#include "frontend/gui_log.h"
+
+#include "host_hw.h"
+#include "nyx_host.h"
+
+#define ROWS        12
+#define FLAT_LINES  100000
+#define FLAT_BATCH  10000
+
+static lv_obj_t *_log_create(u32 rows)
+{
+	lv_obj_t *cont = lv_cont_create(lv_scr_act(), NULL);
+	lv_cont_set_fit(cont, false, false);
+	lv_obj_set_size(cont, 500, 400);
+
+	lv_obj_t *label = lv_label_create(cont, NULL);
+	lv_label_set_recolor(label, true);
+	lv_label_set_long_mode(label, LV_LABEL_LONG_BREAK);
+	lv_label_set_static_text(label, "");
+	lv_obj_set_width(label, 480);
+	nyx_log_attach(label, rows);
+
+	return label;
+}
+
+static void _log_delete(lv_obj_t *label)
+{
+	lv_obj_del(lv_obj_get_parent(label));
+}
+
+static void _line(char *buf, u32 i)
+{
+	s_printf(buf, "#C7EA46 %d:# Line %d of the log\n", i, i);
+}
+
+// Expected view of lines [top, bottom] out of lines produced by _line.
+static void _expect(char *buf, u32 top, u32 bottom)
+{
+	buf[0] = 0;
+	for (u32 i = top; i <= bottom; i++)
+		_line(buf + strlen(buf), i);
+}
+
+static void _test_basic()
+{
+	lv_obj_t *label = _log_create(3);
+
+	// Partial lines are joined.
+	nyx_log_append(label, "abc");
+	nyx_log_append(label, "def\n");
+	nyx_log_append(label, "ghi");
+	HOST_CHECK(!strcmp(lv_label_get_text(label), "abcdef\nghi"), "partial lines: '%s'", lv_label_get_text(label));
+
+	// Only the last rows are shown. A trailing empty line is not counted.
+	nyx_log_append(label, "\n1\n2\n3\n");
+	HOST_CHECK(!strcmp(lv_label_get_text(label), "1\n2\n3\n"), "visible lines: '%s'", lv_label_get_text(label));
+
+	// Scrollback.
+	nyx_log_scroll(label, 1);
+	HOST_CHECK(!strcmp(lv_label_get_text(label), "ghi\n1\n2\n"), "scrolled back: '%s'", lv_label_get_text(label));
+	nyx_log_scroll(label, 100);
+	HOST_CHECK(!strcmp(lv_label_get_text(label), "abcdef\nghi\n1\n"), "scrolled to the top: '%s'", lv_label_get_text(label));
+
+	// New lines do not move a scrolled back view.
+	nyx_log_append(label, "4\n5");
+	HOST_CHECK(!strcmp(lv_label_get_text(label), "abcdef\nghi\n1\n"), "view moved on append: '%s'", lv_label_get_text(label));
+	nyx_log_scroll(label, -100);
+	HOST_CHECK(!strcmp(lv_label_get_text(label), "3\n4\n5"), "scrolled to the end: '%s'", lv_label_get_text(label));
+
+	// And the view follows again.
+	nyx_log_append(label, "\n6\n");
+	HOST_CHECK(!strcmp(lv_label_get_text(label), "4\n5\n6\n"), "view does not follow: '%s'", lv_label_get_text(label));
+
+	// Replace.
+	nyx_log_set_text(label, "new\n");
+	nyx_log_scroll(label, 5);
+	HOST_CHECK(!strcmp(lv_label_get_text(label), "new\n"), "set text: '%s'", lv_label_get_text(label));
+
+	// Overlong lines are broken.
+	char *long_line = malloc(NYX_LOG_LINE_MAX * 2 + 1);
+	memset(long_line, 'x', NYX_LOG_LINE_MAX * 2);
+	long_line[NYX_LOG_LINE_MAX * 2] = 0;
+	nyx_log_set_text(label, long_line);
+	const char *text = lv_label_get_text(label);
+	u32 lines = 0, len = 0, max_len = 0;
+	for (u32 i = 0; text[i]; i++)
+	{
+		len++;
+		if (text[i] == '\n')
+		{
+			lines++;
+			max_len = MAX(max_len, len);
+			len = 0;
+		}
+	}
+	HOST_CHECK(lines == 2 && max_len <= NYX_LOG_LINE_MAX, "long line: %d lines, longest %d", lines, max_len);
+	free(long_line);
+
+	_log_delete(label);
+}
+
+static void _test_history()
+{
+	char line[64];
+	char *exp = malloc(ROWS * 64);
+	lv_obj_t *label = _log_create(ROWS);
+
+	u32 total = NYX_LOG_HIST_LINES * 3 + 7;
+	for (u32 i = 0; i < total; i++)
+	{
+		_line(line, i);
+		nyx_log_append(label, line);
+
+		if (i >= ROWS && !(i % 97))
+		{
+			_expect(exp, i - ROWS + 1, i);
+			HOST_CHECK(!strcmp(lv_label_get_text(label), exp), "line %d: view differs", i);
+		}
+	}
+
+	// Scroll through the whole history one page at a time.
+	int last = total - 1;
+	int oldest = last;
+	for (int back = ROWS; back < (int)total; back += ROWS)
+	{
+		nyx_log_scroll(label, ROWS);
+		const char *text = lv_label_get_text(label);
+		int top = -1;
+		sscanf(text, "#C7EA46 %d:#", &top);
+		if (top != last - back - ROWS + 1)
+		{
+			// Oldest kept lines reached.
+			oldest = top;
+			break;
+		}
+
+		_expect(exp, top, last - back);
+		HOST_CHECK(!strcmp(text, exp), "scrolled back %d: view differs", back);
+	}
+
+	// Scrollback is bounded by lines and bytes. All of it must be reachable.
+	int kept = last - oldest + 1;
+	HOST_CHECK(kept >= NYX_LOG_HIST_SIZE / 40 && kept <= NYX_LOG_HIST_LINES,
+		"%d lines of scrollback", kept);
+	_expect(exp, oldest, oldest + ROWS - 1);
+	HOST_CHECK(!strcmp(lv_label_get_text(label), exp), "oldest page differs");
+
+	_log_delete(label);
+	free(exp);
+}
+
+static u64 _cpu_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+	return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void _test_flat_cost()
+{
+	char line[64];
+	lv_obj_t *label = _log_create(0);
+
+	u32 batches = FLAT_LINES / FLAT_BATCH;
+	u64 batch_us[FLAT_LINES / FLAT_BATCH];
+	for (u32 b = 0; b < batches; b++)
+	{
+		u64 start = _cpu_us();
+		for (u32 i = 0; i < FLAT_BATCH; i++)
+		{
+			_line(line, b * FLAT_BATCH + i);
+			nyx_log_append(label, line);
+		}
+		batch_us[b] = _cpu_us() - start;
+	}
+
+	// The first batch fills the scrollback. Compare the rest against the second one.
+	u64 min_us = batch_us[1], max_us = batch_us[1];
+	for (u32 b = 2; b < batches; b++)
+	{
+		min_us = MIN(min_us, batch_us[b]);
+		max_us = MAX(max_us, batch_us[b]);
+	}
+
+	printf("%d lines: %.2f-%.2f us per append\n", FLAT_LINES, (double)min_us / FLAT_BATCH, (double)max_us / FLAT_BATCH);
+	HOST_CHECK(batch_us[batches - 1] < batch_us[1] * 2 + 20000, "append cost grows: %.2f us first, %.2f us last",
+		(double)batch_us[1] / FLAT_BATCH, (double)batch_us[batches - 1] / FLAT_BATCH);
+
+	_log_delete(label);
+}
+
+int main()
+{
+	nyx_host_init();
+
+	_test_basic();
+	_test_history();
+	_test_flat_cost();
+
+	return host_report("test_gui_log");
+}
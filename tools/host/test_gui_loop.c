@@ -0,0 +1,192 @@
+/*
+ * Simulation of the Nyx GUI loop.
+ *
+ * Runs gui_loop_step on modeled time with the LvGL system tasks and tasks
+ * with the periods of the Nyx ones. Checks that every task runs on time, that
+ * the loop sleeps between them, that a sleep is never longer than the input
+ * read period and reports wakeups against the previous polling loop.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/lvgl/lvgl.h>
+#include <libs/lvgl/lv_misc/lv_gc.h>
+#include "frontend/gui_loop.h"
+
+#include "host_hw.h"
+#include "nyx_host.h"
+
+#define SIM_MS       10000
+#define TASK_COST_US 200   // Modeled run time of each task.
+#define PASS_COST_US 20    // Modeled run time of a task handler pass with nothing due.
+
+typedef struct _task_rec_t
+{
+	const char *name;
+	u32 period;
+	lv_task_prio_t prio;
+	u32 runs;
+	u32 due;
+	u32 late_max;
+} task_rec_t;
+
+static task_rec_t recs[] = {
+	{ "status bar",     5000, LV_TASK_PRIO_LOW    },
+	{ "storage",        2000, LV_TASK_PRIO_LOWEST },
+	{ "battery",        1000, LV_TASK_PRIO_LOW    },
+	{ "fast",           7,    LV_TASK_PRIO_HIGH   },
+};
+
+static void _task(void *param)
+{
+	task_rec_t *rec = (task_rec_t *)param;
+	u32 now = get_tmr_ms();
+
+	if (now - rec->due > rec->late_max)
+		rec->late_max = now - rec->due;
+	rec->due = now + rec->period;
+	rec->runs++;
+
+	host_time_add(TASK_COST_US);
+}
+
+// Previous loop. It ran the task handler back to back.
+static u32 _poll_loop(u32 ms)
+{
+	u32 passes = 0;
+	u32 end = get_tmr_ms() + ms;
+	while (get_tmr_ms() < end)
+	{
+		lv_task_handler();
+		host_time_add(PASS_COST_US);
+		passes++;
+	}
+
+	return passes;
+}
+
+static void _test_periods()
+{
+	for (u32 i = 0; i < ARRAY_SIZE(recs); i++)
+	{
+		recs[i].due = get_tmr_ms() + recs[i].period;
+		lv_task_create(_task, recs[i].period, recs[i].prio, &recs[i]);
+	}
+
+	gui_loop_init();
+
+	u32 start = get_tmr_ms();
+	u32 steps = 0;
+	while (get_tmr_ms() - start <= SIM_MS)
+	{
+		gui_loop_step(false);
+		steps++;
+	}
+
+	for (u32 i = 0; i < ARRAY_SIZE(recs); i++)
+	{
+		task_rec_t *rec = &recs[i];
+
+		// Runs are at most one tick late, so a task may lose a run per period.
+		u32 min_runs = SIM_MS / (rec->period + 1);
+		HOST_CHECK(rec->runs >= min_runs && rec->runs <= SIM_MS / rec->period, "%s: %d runs, expected %d..%d",
+			rec->name, rec->runs, min_runs, SIM_MS / rec->period);
+		HOST_CHECK(rec->late_max <= 1, "%s: ran %d ms late", rec->name, rec->late_max);
+		printf("%-12s period %4d ms: %4d runs, %d ms late at most\n", rec->name, rec->period, rec->runs, rec->late_max);
+	}
+
+	// The fast task bounds the sleep. Without a wakeup per run, it would starve the others.
+	HOST_CHECK(steps <= recs[3].runs * 2, "%d loop steps for %d runs of the fast task", steps, recs[3].runs);
+}
+
+static void _test_idle()
+{
+	// Only the LvGL tasks. Display refresh, input reading and animations.
+	for (u32 i = 0; i < ARRAY_SIZE(recs); i++)
+		recs[i].runs = 0;
+	for (u32 prio = LV_TASK_PRIO_LOWEST; prio < LV_TASK_PRIO_NUM; prio++)
+	{
+		lv_task_t *task = lv_ll_get_head(&LV_GC_ROOT(_lv_task_ll)[prio]);
+		while (task)
+		{
+			lv_task_t *next = lv_ll_get_next(&LV_GC_ROOT(_lv_task_ll)[prio], task);
+			if (task->task == _task)
+				lv_task_del(task);
+			task = next;
+		}
+	}
+
+	gui_loop_init();
+	u32 start = get_tmr_ms();
+	while (get_tmr_ms() - start <= 2000)
+		gui_loop_step(false);
+	u32 idle_wakeups = gui_loop_stats.wakeups;
+
+	u32 polls = _poll_loop(1000);
+
+	// At most one wakeup per LvGL task period.
+	u32 max_wakeups = 3 * 1000 / LV_REFR_PERIOD + 3;
+	HOST_CHECK(idle_wakeups && idle_wakeups <= max_wakeups, "idle: %d wakeups per second, expected 1..%d",
+		idle_wakeups, max_wakeups);
+	HOST_CHECK(gui_loop_stats.busy_pct < 5, "idle: %d%% busy", gui_loop_stats.busy_pct);
+	printf("idle: %d wakeups per second, %d%% busy. Polling loop: %d passes per second\n",
+		idle_wakeups, gui_loop_stats.busy_pct, polls);
+	HOST_CHECK(polls > idle_wakeups * 100, "polling loop only took %d passes", polls);
+}
+
+static void _test_max_sleep()
+{
+	// Pause every task, like while input and refresh tasks are off. The loop still wakes up.
+	lv_task_t *paused[32];
+	lv_task_prio_t prios[32];
+	u32 count = 0;
+	for (u32 prio = LV_TASK_PRIO_LOWEST; prio < LV_TASK_PRIO_NUM; prio++)
+	{
+		lv_task_t *task;
+		while ((task = lv_ll_get_head(&LV_GC_ROOT(_lv_task_ll)[prio])) && count < ARRAY_SIZE(paused))
+		{
+			paused[count] = task;
+			prios[count++] = prio;
+			lv_task_set_prio(task, LV_TASK_PRIO_OFF);
+		}
+	}
+	HOST_CHECK(count && lv_task_time_till_next() == UINT32_MAX, "%d tasks paused, next in %d ms", count,
+		lv_task_time_till_next());
+
+	u32 start = get_tmr_us();
+	gui_loop_step(false);
+	u32 slept = get_tmr_us() - start;
+	HOST_CHECK(slept == GUI_LOOP_MAX_SLEEP_MS * 1000, "slept %d us without tasks, expected %d", slept,
+		GUI_LOOP_MAX_SLEEP_MS * 1000);
+
+	for (u32 i = 0; i < count; i++)
+		lv_task_set_prio(paused[i], prios[i]);
+}
+
+int main()
+{
+	nyx_host_init();
+	host_time_freeze(true);
+
+	_test_periods();
+	_test_idle();
+	_test_max_sleep();
+
+	return host_report("test_gui_loop");
+}
@@ -0,0 +1,161 @@
+/*
+ * Tests for the rate limited storage progress.
+ *
+ * Runs a synthetic I/O loop that posts its position after every chunk, with
+ * chunks from 4KB to 4GB and modeled time per chunk. Checks that the redraw
+ * count is bounded by elapsed time and percentage steps and not by chunk
+ * count, that the bar never goes back, that slow chunks still redraw every
+ * time and that the shown rate and time left match the modeled transfer.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <utils/sprintf.h>
+#include <libs/lvgl/lvgl.h>
+#include "frontend/gui_progress.h"
+
+#include "host_hw.h"
+#include "nyx_host.h"
+
+#define RATE_KB_S (64 * 1024) // Modeled transfer rate.
+
+typedef struct _io_res_t
+{
+	u32 chunks;
+	u32 refreshes;
+	u32 time_ms;
+} io_res_t;
+
+// Posts progress after every chunk, like the eMMC and emuMMC tool loops.
+static io_res_t _io_loop(lv_obj_t *bar, lv_obj_t *label, char *txt_buf, u32 total_sct, u32 chunk_sct)
+{
+	io_res_t res = {0};
+	nyx_progress_t prog;
+	u32 lba_start = 0x1000;
+	u32 lba_curr = lba_start;
+	u32 time_start = get_tmr_ms();
+	u64 ui_refreshes = nyx_host_ui()->refreshes;
+	s16 bar_last = 0;
+
+	nyx_progress_init(&prog, bar, label, txt_buf, lba_start, lba_start + total_sct, lba_curr);
+	nyx_progress_set(&prog, 0);
+
+	while (lba_curr - lba_start < total_sct)
+	{
+		u32 num = MIN(chunk_sct, total_sct - (lba_curr - lba_start));
+		host_time_add((u64)num * 1000000 / 2 / RATE_KB_S);
+		lba_curr += num;
+		res.chunks++;
+
+		nyx_progress_update(&prog, lba_curr);
+
+		s16 bar_val = lv_bar_get_value(bar);
+		HOST_CHECK(bar_val >= bar_last && bar_val <= 100, "chunk %d sectors: bar went from %d to %d", chunk_sct, bar_last,
+			bar_val);
+		bar_last = bar_val;
+	}
+
+	nyx_progress_set(&prog, 100);
+	HOST_CHECK(!strcmp(lv_label_get_text(label), " "SYMBOL_DOT" 100%"), "chunk %d sectors: final label '%s'", chunk_sct,
+		lv_label_get_text(label));
+
+	res.refreshes = prog.refreshes;
+	res.time_ms = get_tmr_ms() - time_start;
+
+	// Every redraw asks for a screen refresh and nothing else does.
+	HOST_CHECK(nyx_host_ui()->refreshes - ui_refreshes == res.refreshes, "chunk %d sectors: %d UI refreshes for %d redraws",
+		chunk_sct, (u32)(nyx_host_ui()->refreshes - ui_refreshes), res.refreshes);
+
+	return res;
+}
+
+static void _test_bounded(lv_obj_t *bar, lv_obj_t *label, char *txt_buf)
+{
+	// 8GB. Chunks from 4KB to 4GB.
+	const u32 total_sct = 0x1000000;
+
+	printf("%-12s %10s %10s %10s\n", "chunk (KB)", "chunks", "redraws", "time (s)");
+	for (u32 chunk_sct = 8; chunk_sct <= 0x800000; chunk_sct <<= 2)
+	{
+		io_res_t res = _io_loop(bar, label, txt_buf, total_sct, chunk_sct);
+
+		// One redraw per period at most, and at most one per percent plus one per stats period.
+		u32 max_time = res.time_ms / NYX_PROGRESS_PERIOD_MS;
+		u32 max_steps = 100 + res.time_ms / NYX_PROGRESS_STATS_PERIOD_MS;
+		u32 max = MIN(max_time, max_steps) + 2;
+
+		HOST_CHECK(res.refreshes <= max, "chunk %d sectors: %d redraws in %d ms, expected at most %d", chunk_sct,
+			res.refreshes, res.time_ms, max);
+		HOST_CHECK(res.refreshes <= res.chunks + 2, "chunk %d sectors: %d redraws for %d chunks", chunk_sct, res.refreshes,
+			res.chunks);
+
+		printf("%-12d %10d %10d %10d\n", chunk_sct / 2, res.chunks, res.refreshes, res.time_ms / 1000);
+	}
+}
+
+static void _test_slow_chunks(lv_obj_t *bar, lv_obj_t *label, char *txt_buf)
+{
+	// 4GB chunks take a minute each. Every post must redraw.
+	io_res_t res = _io_loop(bar, label, txt_buf, 0x2000000, 0x800000);
+	HOST_CHECK(res.refreshes == res.chunks + 2, "%d redraws for %d slow chunks", res.refreshes, res.chunks);
+}
+
+static void _test_stats(lv_obj_t *bar, lv_obj_t *label, char *txt_buf)
+{
+	nyx_progress_t prog;
+	u32 total_sct = 0x400000; // 2GB, 32s at the modeled rate.
+	u32 lba_curr = 0;
+
+	nyx_progress_init(&prog, bar, label, txt_buf, 0, total_sct, lba_curr);
+
+	// Half way, in 4MB chunks.
+	while (lba_curr < total_sct / 2)
+	{
+		host_time_add(8192ULL * 1000000 / 2 / RATE_KB_S);
+		lba_curr += 8192;
+		nyx_progress_update(&prog, lba_curr);
+	}
+
+	HOST_CHECK(prog.rate >= RATE_KB_S * 9 / 10 && prog.rate <= RATE_KB_S * 11 / 10, "rate %d KiB/s, modeled %d KiB/s",
+		prog.rate, RATE_KB_S);
+
+	// About 16s left, from the position of the last redraw.
+	char expected[64];
+	u32 left = ((total_sct - prog.lba_last) >> 1) / prog.rate;
+	s_printf(expected, "%d.%d MB/s, 0m %02ds left", prog.rate >> 10, ((prog.rate & 0x3FF) * 10) >> 10, left);
+
+	const char *txt = lv_label_get_text(label);
+	HOST_CHECK(left >= 15 && left <= 16 && strstr(txt, expected), "label '%s', expected '%s'", txt, expected);
+}
+
+int main()
+{
+	nyx_host_init();
+	host_time_freeze(true);
+
+	lv_obj_t *bar = lv_bar_create(lv_scr_act(), NULL);
+	lv_obj_t *label = lv_label_create(lv_scr_act(), NULL);
+	char *txt_buf = (char *)malloc(SZ_4K);
+
+	_test_bounded(bar, label, txt_buf);
+	_test_slow_chunks(bar, label, txt_buf);
+	_test_stats(bar, label, txt_buf);
+
+	free(txt_buf);
+
+	return host_report("test_gui_progress");
+}
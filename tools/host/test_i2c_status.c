@@ -0,0 +1,161 @@
+/*
+ * Tests for the batched status bar I2C reads.
+ *
+ * Runs the RTC and fuel gauge drivers against the host I2C bus model. Checks
+ * that the batched reads decode the same values as the per register reads,
+ * that they take the expected number of bus transactions and that a fuel
+ * gauge that does not answer returns an error and leaves the readings alone.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include "host_hw.h"
+#include "host_i2c.h"
+
+static void _rtc_set(u8 control, u8 sec, u8 min, u8 hour, u8 weekday, u8 month, u8 year, u8 date)
+{
+	u8 *regs = host_i2c_regs(I2C_5, MAX77620_RTC_I2C_ADDR);
+
+	regs[MAX77620_RTC_CONTROL_REG] = control;
+	regs[MAX77620_RTC_SEC_REG]     = sec;
+	regs[MAX77620_RTC_MIN_REG]     = min;
+	regs[MAX77620_RTC_HOUR_REG]    = hour;
+	regs[MAX77620_RTC_WEEKDAY_REG] = weekday;
+	regs[MAX77620_RTC_MONTH_REG]   = month;
+	regs[MAX77620_RTC_YEAR_REG]    = year;
+	regs[MAX77620_RTC_DATE_REG]    = date;
+}
+
+static void _test_rtc()
+{
+	static const struct {
+		u8 control, sec, min, hour, weekday, month, year, date;
+		rtc_time_t exp;
+	} vectors[] = {
+		// 24h mode. Top bits of every register are not part of the value.
+		{ MAX77620_RTC_24H | MAX77620_RTC_BIN_FORMAT, 45, 30, 13, BIT(2), 6, 22, 15,
+			{ .weekday = 3, .sec = 45, .min = 30, .hour = 13, .day = 15, .month = 5, .year = 2022 } },
+		{ MAX77620_RTC_24H | MAX77620_RTC_BIN_FORMAT, 0x80 | 59, 0x80 | 59, 23, BIT(6), 0xF0 | 12, 0x80 | 99, 0xE0 | 31,
+			{ .weekday = 7, .sec = 59, .min = 59, .hour = 23, .day = 31, .month = 11, .year = 2099 } },
+		// 12h mode.
+		{ MAX77620_RTC_BIN_FORMAT, 0, 5, MAX77620_RTC_HOUR_PM_MASK | 1, BIT(0), 1, 0, 1,
+			{ .weekday = 1, .sec = 0, .min = 5, .hour = 13, .day = 1, .month = 0, .year = 2000 } },
+		{ MAX77620_RTC_BIN_FORMAT, 7, 8, 11, BIT(4), 3, 23, 9,
+			{ .weekday = 5, .sec = 7, .min = 8, .hour = 11, .day = 9, .month = 2, .year = 2023 } },
+	};
+
+	host_i2c_attach(I2C_5, MAX77620_RTC_I2C_ADDR, 1);
+
+	for (u32 i = 0; i < ARRAY_SIZE(vectors); i++)
+	{
+		_rtc_set(vectors[i].control, vectors[i].sec, vectors[i].min, vectors[i].hour, vectors[i].weekday,
+			vectors[i].month, vectors[i].year, vectors[i].date);
+
+		rtc_time_t time;
+		memset(&time, 0xAA, sizeof(time));
+
+		u32 xfers = host_i2c_xfers(I2C_5, MAX77620_RTC_I2C_ADDR);
+		u32 total = i2c_get_xfer_count();
+		max77620_rtc_get_time(&time);
+		xfers = host_i2c_xfers(I2C_5, MAX77620_RTC_I2C_ADDR) - xfers;
+		total = i2c_get_xfer_count() - total;
+
+		const rtc_time_t *exp = &vectors[i].exp;
+		HOST_CHECK(!memcmp(&time, exp, sizeof(time)),
+			"vector %d: %04d-%02d-%02d %02d:%02d:%02d wd %d, expected %04d-%02d-%02d %02d:%02d:%02d wd %d", i,
+			time.year, time.month, time.day, time.hour, time.min, time.sec, time.weekday,
+			exp->year, exp->month, exp->day, exp->hour, exp->min, exp->sec, exp->weekday);
+
+		// Update request, control read and one time regs read. Was 17 with per register reads.
+		HOST_CHECK(xfers == 5 && total == 5, "vector %d: %d RTC transactions, %d counted, expected 5", i, xfers, total);
+
+		// Update request was sent.
+		u8 update = host_i2c_regs(I2C_5, MAX77620_RTC_I2C_ADDR)[MAX77620_RTC_UPDATE0_REG];
+		HOST_CHECK(update == MAX77620_RTC_READ_UPDATE, "vector %d: update reg %02X", i, update);
+	}
+}
+
+static void _test_batt()
+{
+	static const struct { u16 soc, vcell, current; } vectors[] = {
+		{ 0x5A80, 6080 << 3, (u16)-1000 },
+		{ 0x6400, 0xFFF8,    0x7FFF     },
+		{ 0x0000, 0,         0x8000     },
+		{ 0x1380, 5440 << 3, 320        },
+	};
+
+	host_i2c_attach(I2C_1, MAXIM17050_I2C_ADDR, 2);
+
+	for (u32 i = 0; i < ARRAY_SIZE(vectors); i++)
+	{
+		host_i2c_set_reg16(I2C_1, MAXIM17050_I2C_ADDR, MAX17050_RepSOC, vectors[i].soc);
+		host_i2c_set_reg16(I2C_1, MAXIM17050_I2C_ADDR, MAX17050_VCELL, vectors[i].vcell);
+		host_i2c_set_reg16(I2C_1, MAXIM17050_I2C_ADDR, MAX17050_Current, vectors[i].current);
+
+		// Per register reads.
+		int exp_soc, exp_volt, exp_curr;
+		max17050_get_property(MAX17050_RepSOC, &exp_soc);
+		max17050_get_property(MAX17050_VCELL, &exp_volt);
+		max17050_get_property(MAX17050_Current, &exp_curr);
+
+		int soc = -1, volt = -1, curr = -1;
+		u32 xfers = host_i2c_xfers(I2C_1, MAXIM17050_I2C_ADDR);
+		int res = max17050_get_batt_status(&soc, &volt, &curr);
+		xfers = host_i2c_xfers(I2C_1, MAXIM17050_I2C_ADDR) - xfers;
+
+		HOST_CHECK(!res, "vector %d: returned %d", i, res);
+		HOST_CHECK(soc == exp_soc && volt == exp_volt && curr == exp_curr,
+			"vector %d: soc %04X, %d mV, %d uA, expected soc %04X, %d mV, %d uA", i, soc, volt, curr, exp_soc, exp_volt,
+			exp_curr);
+		HOST_CHECK(max17050_get_cached_batt_volt() == (u32)volt, "vector %d: cached %d mV, read %d mV", i,
+			max17050_get_cached_batt_volt(), volt);
+
+		// Was 6 with per register reads.
+		HOST_CHECK(xfers == 1, "vector %d: %d fuel gauge transactions, expected 1", i, xfers);
+	}
+
+	// Fuel gauge does not answer. The last readings must stay.
+	u32 cached = max17050_get_cached_batt_volt();
+	int soc = 0x1234, volt = 4321, curr = -5678;
+	host_i2c_fail(I2C_1, MAXIM17050_I2C_ADDR, ~0, 1);
+	int res = max17050_get_batt_status(&soc, &volt, &curr);
+
+	HOST_CHECK(res, "NAK returned %d", res);
+	HOST_CHECK(soc == 0x1234 && volt == 4321 && curr == -5678, "NAK changed readings to soc %04X, %d mV, %d uA", soc, volt,
+		curr);
+	HOST_CHECK(max17050_get_cached_batt_volt() == cached, "NAK changed cached voltage to %d mV",
+		max17050_get_cached_batt_volt());
+
+	// Fuel gauge not present.
+	host_i2c_reset();
+	res = max17050_get_batt_status(&soc, &volt, &curr);
+	HOST_CHECK(res && soc == 0x1234, "missing fuel gauge returned %d, soc %04X", res, soc);
+}
+
+int main()
+{
+	host_init();
+
+	_test_rtc();
+	_test_batt();
+
+	host_i2c_reset();
+
+	return host_report("test_i2c_status");
+}
@@ -0,0 +1,473 @@
+/*
+ * Tests for the ianos pre-linked library images.
+ *
+ * Builds ARM position independent libraries, loads them with ianos_loader
+ * from the ELF and from the pre-linked image, at the same and at different
+ * addresses, and compares the memory images and entry points the library is
+ * started with. Stale, corrupt and truncated images must fall back to the ELF,
+ * also when the library was replaced by one with the same size and timestamp.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+// Libraries are placed in the physical window, so their addresses fit the firmware's u32 casts.
+static void *_test_malloc(size_t size);
+static void  _test_free(void *ptr);
+static void  _test_ep(u32 ep, void *config, void *params);
+
+// Build the loader as it is on the firmware, for 32-bit ARM ELFs.
+#undef __amd64__
+#undef __x86_64__
+#undef __LP64__
+#define __arm__ 1
+#define uptr u32
+#define malloc _test_malloc
+#define free _test_free
+#define entrypoint(config, params) _test_ep((u32)(uintptr_t)entrypoint, config, params) // Do not run the library.
+
+#include "../../bdk/ianos/elfload/elfload.c"
+#include "../../bdk/ianos/elfload/elfreloc_arm.c"
+
+// Count loads from the ELF.
+static u32 elf_loads;
+#define el_load(ctx, alloc) (elf_loads++, el_load(ctx, alloc))
+
+#include "../../bdk/ianos/ianos.c"
+
+#undef __arm__
+#undef uptr
+#undef malloc
+#undef free
+#undef el_load
+#undef entrypoint
+
+#include "bench_common.h"
+#include "host_hw.h"
+
+#define LIB_PATH     "libsys_test.bso"
+#define LIB_PL_PATH  "libsys_test.bsl"
+#define ARENA_START  0xE8000000
+#define ARENA_END    0xEC000000
+
+heap_t _heap;
+
+int max7762x_regulator_set_voltage(u32 id, u32 mv) { return 0; }
+
+typedef struct _lib_desc_t
+{
+	u32 text_size;
+	u32 data_size;
+	u32 bss_size;
+	u32 rels;     // R_ARM_RELATIVE relocations.
+	u32 seed;
+} lib_desc_t;
+
+typedef struct _lib_t
+{
+	u8 *elf;
+	u32 size;
+	u32 entry;
+	u32 mem_size;
+} lib_t;
+
+typedef struct _load_t
+{
+	u32 ep;
+	u32 base;
+	u8 *image;
+} load_t;
+
+static u32 arena_next;
+static load_t last_load;
+static u32 last_mem_size;
+
+static u32 rnd_state;
+
+static u32 _rnd()
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+
+	return rnd_state;
+}
+
+static void *_test_malloc(size_t size)
+{
+	u32 addr = ALIGN(arena_next, 0x10);
+	if (addr + size > ARENA_END)
+		return NULL;
+
+	arena_next = addr + size;
+
+	return (void *)(uintptr_t)addr;
+}
+
+static void _test_free(void *ptr)
+{
+	// Arena memory is reclaimed by resetting the arena.
+	if ((uintptr_t)ptr >= ARENA_START && (uintptr_t)ptr < ARENA_END)
+		return;
+
+	free(ptr);
+}
+
+static void _test_ep(u32 ep, void *config, void *params)
+{
+	bdkParams_t bdk = (bdkParams_t)params;
+	HOST_CHECK(bdk->extension_magic == IANOS_EXT0 && bdk->memcpy, "bad entrypoint arguments");
+
+	// The image is found from the entry point, like the library itself would.
+	last_load.ep = ep;
+	last_load.base = ep - ((u32 *)config)[0];
+	last_load.image = malloc(last_mem_size);
+	memcpy(last_load.image, (void *)(uintptr_t)last_load.base, last_mem_size);
+
+	// Libraries change their data once running. That must not reach the pre-linked image.
+	for (u32 i = 0; i < last_mem_size; i += 4)
+		*(u32 *)(uintptr_t)(last_load.base + i) ^= 0xA5A5A5A5;
+}
+
+/*
+ * Library layout: ELF and program headers, text with relocated literals,
+ * the relocation table and the dynamic table in the first segment. Data with
+ * relocated pointers and bss in the second. Section headers at the end.
+ */
+static void _lib_build(lib_t *lib, const lib_desc_t *desc)
+{
+	rnd_state = desc->seed;
+
+	u32 phdrs_off = sizeof(Elf32_Ehdr);
+	u32 text_off = phdrs_off + 3 * sizeof(Elf32_Phdr);
+	u32 rel_off = ALIGN(text_off + desc->text_size, 4);
+	u32 rel_cnt = desc->rels + 2; // Plus R_ARM_NONE ones.
+	u32 dyn_off = rel_off + rel_cnt * sizeof(Elf32_Rel);
+	u32 dyn_cnt = 4;
+	u32 seg0_end = dyn_off + dyn_cnt * sizeof(Elf32_Dyn);
+	u32 data_off = ALIGN(seg0_end, 0x10);
+	u32 shstr_off = data_off + desc->data_size;
+	static const char shstr[] = "\0.shstrtab\0.symtab";
+	u32 sym_off = ALIGN(shstr_off + sizeof(shstr), 4);
+	u32 sh_off = sym_off + sizeof(Elf32_Sym);
+
+	lib->size = sh_off + 3 * sizeof(Elf32_Shdr);
+	lib->elf = calloc(lib->size, 1);
+	lib->mem_size = data_off + desc->data_size + desc->bss_size;
+	lib->entry = text_off + (_rnd() % (desc->text_size / 4)) * 4;
+
+	u8 *elf = lib->elf;
+	Elf32_Ehdr *eh = (Elf32_Ehdr *)elf;
+	memcpy(eh->e_ident, ELFMAG, SELFMAG);
+	eh->e_ident[EI_CLASS] = ELFCLASS32;
+	eh->e_ident[EI_DATA] = ELFDATA2LSB;
+	eh->e_ident[EI_VERSION] = EV_CURRENT;
+	eh->e_type = ET_DYN;
+	eh->e_machine = EM_ARM;
+	eh->e_version = EV_CURRENT;
+	eh->e_entry = lib->entry;
+	eh->e_phoff = phdrs_off;
+	eh->e_shoff = sh_off;
+	eh->e_ehsize = sizeof(Elf32_Ehdr);
+	eh->e_phentsize = sizeof(Elf32_Phdr);
+	eh->e_phnum = 3;
+	eh->e_shentsize = sizeof(Elf32_Shdr);
+	eh->e_shnum = 3;
+	eh->e_shstrndx = 1;
+
+	Elf32_Phdr *ph = (Elf32_Phdr *)(elf + phdrs_off);
+	ph[0].p_type = PT_LOAD;
+	ph[0].p_filesz = ph[0].p_memsz = seg0_end;
+	ph[0].p_align = 0x10;
+	ph[1].p_type = PT_LOAD;
+	ph[1].p_offset = ph[1].p_vaddr = ph[1].p_paddr = data_off;
+	ph[1].p_filesz = desc->data_size;
+	ph[1].p_memsz = desc->data_size + desc->bss_size;
+	ph[1].p_align = 0x10;
+	ph[2].p_type = PT_DYNAMIC;
+	ph[2].p_offset = ph[2].p_vaddr = ph[2].p_paddr = dyn_off;
+	ph[2].p_filesz = ph[2].p_memsz = dyn_cnt * sizeof(Elf32_Dyn);
+
+	for (u32 i = 0; i < desc->text_size; i++)
+		elf[text_off + i] = _rnd();
+	for (u32 i = 0; i < desc->data_size; i++)
+		elf[data_off + i] = _rnd();
+
+	// Relative relocations hold library offsets. A quarter are text literals, the rest data pointers.
+	Elf32_Rel *rel = (Elf32_Rel *)(elf + rel_off);
+	for (u32 i = 0; i < desc->rels; i++)
+	{
+		u32 off = (i & 3) ? data_off + (i * 4 % desc->data_size) : text_off + (i * 4 % desc->text_size);
+		rel[i].r_offset = off;
+		rel[i].r_info = ELF32_R_INFO(0, R_ARM_RELATIVE);
+		*(u32 *)(elf + off) = _rnd() % lib->mem_size;
+	}
+	rel[desc->rels].r_offset = text_off;
+	rel[desc->rels].r_info = ELF32_R_INFO(0, R_ARM_NONE);
+	rel[desc->rels + 1].r_offset = data_off;
+	rel[desc->rels + 1].r_info = ELF32_R_INFO(0, R_ARM_NONE);
+
+	Elf32_Dyn *dyn = (Elf32_Dyn *)(elf + dyn_off);
+	dyn[0].d_tag = DT_REL;
+	dyn[0].d_un.d_ptr = rel_off;
+	dyn[1].d_tag = DT_RELSZ;
+	dyn[1].d_un.d_val = rel_cnt * sizeof(Elf32_Rel);
+	dyn[2].d_tag = DT_RELENT;
+	dyn[2].d_un.d_val = sizeof(Elf32_Rel);
+	dyn[3].d_tag = DT_NULL;
+
+	memcpy(elf + shstr_off, shstr, sizeof(shstr));
+
+	Elf32_Shdr *sh = (Elf32_Shdr *)(elf + sh_off);
+	sh[1].sh_name = 1;
+	sh[1].sh_type = SHT_STRTAB;
+	sh[1].sh_offset = shstr_off;
+	sh[1].sh_size = sizeof(shstr);
+	sh[2].sh_name = 11;
+	sh[2].sh_type = SHT_SYMTAB;
+	sh[2].sh_offset = sym_off;
+	sh[2].sh_size = sizeof(Elf32_Sym);
+	sh[2].sh_entsize = sizeof(Elf32_Sym);
+}
+
+static void _lib_install(lib_t *lib)
+{
+	// Keep timestamps apart, like a module copied later.
+	host_time_add(2000000);
+	HOST_CHECK(sd_save_to_file(lib->elf, lib->size, LIB_PATH) == FR_OK, "failed to write the library");
+}
+
+static void _load_free(load_t *load)
+{
+	free(load->image);
+	memset(load, 0, sizeof(load_t));
+}
+
+static bool _load(load_t *load, const lib_t *lib, u32 addr, bool *from_elf)
+{
+	u32 config[1] = { lib->entry };
+
+	arena_next = addr;
+	elf_loads = 0;
+	last_mem_size = lib->mem_size;
+	memset(&last_load, 0, sizeof(load_t));
+	memset((void *)(uintptr_t)ARENA_START, 0xCC, ARENA_END - ARENA_START);
+
+	uintptr_t ep = ianos_loader(LIB_PATH, DRAM_LIB, config);
+
+	*load = last_load;
+	*from_elf = elf_loads != 0;
+
+	return ep && ep == load->ep;
+}
+
+// A load from the ELF at the same address is the reference.
+static void _check_same(const char *what, const lib_t *lib, load_t *load, u32 addr)
+{
+	load_t ref;
+	bool from_elf;
+
+	f_unlink(LIB_PL_PATH);
+	if (!_load(&ref, lib, addr, &from_elf))
+	{
+		HOST_CHECK(false, "%s: reference load failed", what);
+		return;
+	}
+
+	HOST_CHECK(ref.base == load->base, "%s: reference loaded at %08X, not %08X", what, ref.base, load->base);
+	HOST_CHECK(ref.ep == load->ep, "%s: entry %08X, expected %08X", what, load->ep, ref.ep);
+
+	u32 diff = lib->mem_size;
+	for (u32 i = 0; i < lib->mem_size; i++)
+	{
+		if (ref.image[i] != load->image[i])
+		{
+			diff = i;
+			break;
+		}
+	}
+	HOST_CHECK(diff == lib->mem_size, "%s: image differs at offset %X", what, diff);
+
+	_load_free(&ref);
+}
+
+static void _test_cached(const lib_desc_t *desc)
+{
+	static const u32 bases[] = { ARENA_START, ARENA_START + 0x1230, ARENA_START + 0x3000000 };
+	char what[64];
+	lib_t lib;
+	load_t load;
+	bool from_elf;
+
+	_lib_build(&lib, desc);
+	_lib_install(&lib);
+	f_unlink(LIB_PL_PATH);
+
+	// First load is from the ELF and saves the pre-linked image.
+	HOST_CHECK(_load(&load, &lib, bases[0], &from_elf) && from_elf, "%d: first load failed", desc->seed);
+	FILINFO fno;
+	HOST_CHECK(f_stat(LIB_PL_PATH, &fno) == FR_OK, "%d: pre-linked image was not saved", desc->seed);
+	_load_free(&load);
+
+	for (u32 i = 0; i < ARRAY_SIZE(bases); i++)
+	{
+		// Saved image was relocated for bases[0], so the others rebase it.
+		s_printf(what, "lib %d at %08X", desc->seed, bases[i]);
+		bool ok = _load(&load, &lib, bases[i], &from_elf);
+		HOST_CHECK(ok && !from_elf, "%s: pre-linked image was not used", what);
+		if (ok)
+			_check_same(what, &lib, &load, bases[i]);
+		_load_free(&load);
+
+		// The reference load saved the image again at this base. Keep the original one.
+		f_unlink(LIB_PL_PATH);
+		_load(&load, &lib, bases[0], &from_elf);
+		_load_free(&load);
+	}
+
+	free(lib.elf);
+}
+
+static void _test_invalid()
+{
+	static const lib_desc_t desc = { 0x800, 0x400, 0x200, 100, 77 };
+	lib_t lib, lib2;
+	load_t load;
+	bool from_elf;
+
+	_lib_build(&lib, &desc);
+	_lib_install(&lib);
+	f_unlink(LIB_PL_PATH);
+	_load(&load, &lib, ARENA_START, &from_elf);
+	_load_free(&load);
+
+	u32 pl_size;
+	u8 *pl = sd_file_read(LIB_PL_PATH, &pl_size);
+	if (!pl)
+	{
+		HOST_CHECK(false, "pre-linked image was not saved");
+		return;
+	}
+
+	for (u32 c = 0; c < 5; c++)
+	{
+		const char *what = NULL;
+		u8 *bad = malloc(pl_size);
+		u32 bad_size = pl_size;
+		memcpy(bad, pl, pl_size);
+
+		switch (c)
+		{
+		case 0:
+			what = "image byte";
+			bad[sizeof(ianos_pl_hdr_t) + 0x123] ^= 1;
+			break;
+		case 1:
+			what = "relocation";
+			bad[pl_size - 4] ^= 1;
+			break;
+		case 2:
+			what = "truncated";
+			bad_size -= 8;
+			break;
+		case 3:
+			what = "version";
+			((ianos_pl_hdr_t *)bad)->version++;
+			break;
+		case 4:
+			what = "oversized relocation count";
+			((ianos_pl_hdr_t *)bad)->rel_cnt = 0x7FFFFFFF;
+			break;
+		}
+		sd_save_to_file(bad, bad_size, LIB_PL_PATH);
+		free(bad);
+
+		// Rejected images are removed and the library is loaded from the ELF.
+		bool ok = _load(&load, &lib, ARENA_START + 0x100, &from_elf);
+		HOST_CHECK(ok && from_elf, "%s: bad image was used", what);
+		if (ok)
+			_check_same(what, &lib, &load, ARENA_START + 0x100);
+		_load_free(&load);
+	}
+
+	// A changed library is not served from the old image.
+	lib_desc_t desc2 = desc;
+	desc2.seed++;
+	desc2.data_size += 0x10;
+	_lib_build(&lib2, &desc2);
+	sd_save_to_file(pl, pl_size, LIB_PL_PATH);
+	_lib_install(&lib2);
+
+	bool ok = _load(&load, &lib2, ARENA_START, &from_elf);
+	HOST_CHECK(ok && from_elf, "stale image was used");
+	if (ok)
+		_check_same("stale", &lib2, &load, ARENA_START);
+	_load_free(&load);
+
+	// A different build with the same size and timestamp is not served from the old image either.
+	lib_t lib3;
+	desc2 = desc;
+	desc2.seed += 2;
+	_lib_build(&lib3, &desc2);
+	_lib_install(&lib);
+	f_unlink(LIB_PL_PATH);
+	_load(&load, &lib, ARENA_START, &from_elf);
+	_load_free(&load);
+
+	FILINFO fno, fno3;
+	f_stat(LIB_PATH, &fno);
+	sd_save_to_file(lib3.elf, lib3.size, LIB_PATH);
+	f_stat(LIB_PATH, &fno3);
+	HOST_CHECK(fno.fsize == fno3.fsize && fno.fdate == fno3.fdate && fno.ftime == fno3.ftime,
+		"same stamp library has a different size or timestamp");
+
+	ok = _load(&load, &lib3, ARENA_START, &from_elf);
+	HOST_CHECK(ok && from_elf, "same stamp stale image was used");
+	if (ok)
+		_check_same("same stamp", &lib3, &load, ARENA_START);
+	_load_free(&load);
+
+	free(pl);
+	free(lib.elf);
+	free(lib2.elf);
+	free(lib3.elf);
+}
+
+int main()
+{
+	static const lib_desc_t libs[] = {
+		{ 0x40,    0x40,   0,       8,    1 },
+		{ 0x3000,  0x800,  0x1000,  200,  2 },
+		{ 0x10000, 0x4000, 0x20000, 3000, 3 }, // Minerva sized.
+	};
+
+	host_init();
+	host_time_freeze(true);
+
+	if (!bench_sd_setup() || !sd_mount())
+		return 1;
+
+	for (u32 i = 0; i < ARRAY_SIZE(libs); i++)
+		_test_cached(&libs[i]);
+	_test_invalid();
+
+	sd_unmount();
+	bench_teardown();
+
+	return host_report("test_ianos");
+}
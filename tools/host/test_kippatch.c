@@ -0,0 +1,328 @@
+/*
+ * Tests for the compiled patches.ini database.
+ *
+ * Checks that the patches loaded from bootloader/sys/patches.bin are the same
+ * as the ones the text parser produces, that the database is keyed on the ini
+ * size and modification time and that bad databases are rejected.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/fatfs/ff.h>
+#include "../../bootloader/hos/pkg2_ini_kippatch.h"
+
+#include "bench_common.h"
+#include "host_hw.h"
+#include "nyx_host.h"
+
+#define INI_PATH "bootloader/patches.ini"
+#define DB_PATH  "bootloader/sys/patches.bin"
+
+static const char *ini_fixed[] = {
+	// Typical.
+	"[FS:b0f1ea5e2bd4a9f1]\n"
+	".nogc=0:1234:4:11223344,55667788\n"
+	".nogc=0:8:1:AA,BB\n"
+	"[Loader:0123456789abcdef]\n"
+	".noacidsigchk=1:30:2:0094,00E0\n",
+
+	// CRLF, comments, blank lines and no trailing newline.
+	"# Comment\r\n\r\n[FS:0000000000000001]\r\n.a=0:10:2:0102,0304\r\n\r\n.b=2:FF:1:ff,00",
+
+	// Patches before any section, empty sections and an out of range kip section.
+	".orphan=0:0:1:00,11\n[A:1111111111111111]\n[B:2222222222222222]\n.x=7:0:1:00,00\n.y=3:0:0:,\n",
+
+	// Lowercase hex, leading spaces in data and a very long line.
+	"[Long:abcdefabcdefabcd]\n.long=5:fffff:40: "
+	"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f, "
+	"3f3e3d3c3b3a393837363534333231302f2e2d2c2b2a292827262524232221201f1e1d1c1b1a191817161514131211100f0e0d0c0b0a09080706050403020100\n",
+
+	// Empty.
+	"",
+};
+
+static u32 rnd_state = 1;
+
+static u32 _rnd()
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+
+	return rnd_state;
+}
+
+static char *_ini_random(u32 *size)
+{
+	char *ini = calloc(SZ_64K, 1);
+	u32 pos = 0;
+	u32 secs = _rnd() % 12;
+
+	for (u32 i = 0; i < secs; i++)
+	{
+		pos += sprintf(ini + pos, "[K%d:%08x%08x]%s", i, _rnd(), _rnd(), (_rnd() & 3) ? "\n" : "\r\n");
+
+		u32 pts = _rnd() % 8;
+		for (u32 j = 0; j < pts; j++)
+		{
+			u32 len = _rnd() % 24;
+			pos += sprintf(ini + pos, ".p%d_%d=%d:%x:%x:", i, j, _rnd() % 8, _rnd() & 0xFFFFF, len);
+			for (u32 k = 0; k < len; k++)
+				pos += sprintf(ini + pos, "%02X", _rnd() & 0xFF);
+			pos += sprintf(ini + pos, ",");
+			for (u32 k = 0; k < len; k++)
+				pos += sprintf(ini + pos, "%02x", _rnd() & 0xFF);
+			pos += sprintf(ini + pos, "\n");
+
+			if (!(_rnd() % 5))
+				pos += sprintf(ini + pos, "# comment\n\n");
+		}
+	}
+
+	*size = pos;
+
+	return ini;
+}
+
+static bool _patches_equal(link_t *a, link_t *b)
+{
+	link_t *sa = a->next;
+	link_t *sb = b->next;
+
+	while (sa != a && sb != b)
+	{
+		ini_kip_sec_t *ka = CONTAINER_OF(sa, ini_kip_sec_t, link);
+		ini_kip_sec_t *kb = CONTAINER_OF(sb, ini_kip_sec_t, link);
+
+		if (strcmp(ka->name, kb->name) || memcmp(ka->hash, kb->hash, sizeof(ka->hash)))
+			return false;
+
+		link_t *pa = ka->pts.next;
+		link_t *pb = kb->pts.next;
+		while (pa != &ka->pts && pb != &kb->pts)
+		{
+			ini_patchset_t *ta = CONTAINER_OF(pa, ini_patchset_t, link);
+			ini_patchset_t *tb = CONTAINER_OF(pb, ini_patchset_t, link);
+
+			if (strcmp(ta->name, tb->name) || ta->offset != tb->offset || ta->length != tb->length)
+				return false;
+
+			if (!ta->srcData != !tb->srcData)
+				return false;
+
+			if (ta->srcData && (memcmp(ta->srcData, tb->srcData, ta->length) || memcmp(ta->dstData, tb->dstData, ta->length)))
+				return false;
+
+			pa = pa->next;
+			pb = pb->next;
+		}
+
+		if (pa != &ka->pts || pb != &kb->pts)
+			return false;
+
+		sa = sa->next;
+		sb = sb->next;
+	}
+
+	return sa == a && sb == b;
+}
+
+static void _ini_write(const char *ini, u32 size)
+{
+	HOST_CHECK(sd_save_to_file((void *)ini, size, INI_PATH) == FR_OK, "failed to write the ini");
+}
+
+static bool _check_equivalence(const char *ini, u32 size, const char *name)
+{
+	u32 failures = host_failures;
+
+	f_unlink(DB_PATH);
+	_ini_write(ini, size);
+
+	LIST_INIT(text);
+	LIST_INIT(miss);
+	LIST_INIT(hit);
+	HOST_CHECK(ini_patch_parse(&text, INI_PATH), "%s: text parse failed", name);
+	HOST_CHECK(ini_patch_parse_cached(&miss, INI_PATH, DB_PATH), "%s: compile failed", name);
+
+	FILINFO fno;
+	HOST_CHECK(f_stat(DB_PATH, &fno) == FR_OK, "%s: database was not saved", name);
+
+	HOST_CHECK(ini_patch_parse_cached(&hit, INI_PATH, DB_PATH), "%s: database load failed", name);
+	HOST_CHECK(_patches_equal(&text, &miss), "%s: compiled patches differ from the text parser", name);
+	HOST_CHECK(_patches_equal(&text, &hit), "%s: loaded patches differ from the text parser", name);
+
+	return failures == host_failures;
+}
+
+static void _test_corpus()
+{
+	char name[32];
+
+	for (u32 i = 0; i < ARRAY_SIZE(ini_fixed); i++)
+	{
+		s_printf(name, "fixed %d", i);
+		_check_equivalence(ini_fixed[i], strlen(ini_fixed[i]), name);
+	}
+
+	for (u32 i = 0; i < 200; i++)
+	{
+		u32 size;
+		char *ini = _ini_random(&size);
+		s_printf(name, "random %d", i);
+		bool ok = _check_equivalence(ini, size, name);
+		free(ini);
+		if (!ok)
+			break;
+	}
+}
+
+static void _test_keying()
+{
+	const char *ini_a = ini_fixed[0];
+	char *ini_b = strdup(ini_a);
+	ini_b[strlen(ini_b) - 2] = 'F'; // Same size, different destination data.
+
+	f_unlink(DB_PATH);
+	_ini_write(ini_a, strlen(ini_a));
+	LIST_INIT(a);
+	ini_patch_parse_cached(&a, INI_PATH, DB_PATH);
+
+	// Same size and modification time. The database is used without reading the ini.
+	_ini_write(ini_b, strlen(ini_b));
+	LIST_INIT(same_time);
+	ini_patch_parse_cached(&same_time, INI_PATH, DB_PATH);
+	HOST_CHECK(_patches_equal(&a, &same_time), "database was not used for an unchanged size and time");
+
+	// Newer modification time. The ini is parsed again.
+	host_time_add(2 * 1000000);
+	_ini_write(ini_b, strlen(ini_b));
+	LIST_INIT(text_b);
+	LIST_INIT(newer);
+	ini_patch_parse(&text_b, INI_PATH);
+	ini_patch_parse_cached(&newer, INI_PATH, DB_PATH);
+	HOST_CHECK(!_patches_equal(&a, &text_b), "test inis must differ");
+	HOST_CHECK(_patches_equal(&text_b, &newer), "database was used after the ini changed");
+
+	// And the new database is used.
+	LIST_INIT(newer_hit);
+	ini_patch_parse_cached(&newer_hit, INI_PATH, DB_PATH);
+	HOST_CHECK(_patches_equal(&text_b, &newer_hit), "recompiled database differs");
+
+	free(ini_b);
+}
+
+static void _db_resign(u8 *db)
+{
+	kippatch_db_hdr_t *hdr = (kippatch_db_hdr_t *)db;
+	u8 *data = db + sizeof(kippatch_db_hdr_t);
+
+	hdr->data_crc32 = crc32_calc(0, data, hdr->data_size);
+}
+
+static void _test_bad_db()
+{
+	const char *ini = ini_fixed[0];
+	u32 db_size;
+
+	f_unlink(DB_PATH);
+	_ini_write(ini, strlen(ini));
+	LIST_INIT(text);
+	LIST_INIT(first);
+	ini_patch_parse(&text, INI_PATH);
+	ini_patch_parse_cached(&first, INI_PATH, DB_PATH);
+
+	u8 *good = sd_file_read(DB_PATH, &db_size);
+	HOST_CHECK(good, "database was not saved");
+	if (!good)
+		return;
+
+	u8 *db = malloc(db_size);
+
+	for (u32 test = 0; test < 5; test++)
+	{
+		memcpy(db, good, db_size);
+		kippatch_db_hdr_t *hdr = (kippatch_db_hdr_t *)db;
+		kippatch_db_pt_t *pts = (kippatch_db_pt_t *)(db + sizeof(kippatch_db_hdr_t) + hdr->sec_cnt * sizeof(kippatch_db_sec_t));
+
+		const char *what = "";
+		switch (test)
+		{
+		case 0:
+			what = "corrupted data";
+			db[db_size - 8] ^= 1;
+			break;
+		case 1:
+			what = "patch with a length and no data";
+			pts[0].data_off = 0;
+			_db_resign(db);
+			break;
+		case 2:
+			what = "patch data out of range";
+			pts[0].length = 0x10000;
+			_db_resign(db);
+			break;
+		case 3:
+			what = "name out of range";
+			pts[1].name_off = hdr->data_size;
+			_db_resign(db);
+			break;
+		case 4:
+			what = "old version";
+			hdr->version = 1;
+			break;
+		}
+
+		sd_save_to_file(db, db_size, DB_PATH);
+
+		LIST_INIT(loaded);
+		ini_patch_parse_cached(&loaded, INI_PATH, DB_PATH);
+		HOST_CHECK(_patches_equal(&text, &loaded), "%s: database was not rejected", what);
+
+		// Rejected databases are recompiled.
+		u32 size;
+		u8 *regen = sd_file_read(DB_PATH, &size);
+		HOST_CHECK(regen && size == db_size && !memcmp(regen, good, db_size), "%s: database was not recompiled", what);
+		free(regen);
+	}
+
+	free(db);
+	free(good);
+}
+
+int main()
+{
+	nyx_host_init();
+	host_time_freeze(true);
+
+	if (!bench_sd_setup() || !sd_mount())
+		return 1;
+
+	f_mkdir("bootloader");
+	f_mkdir("bootloader/sys");
+
+	_test_corpus();
+	_test_keying();
+	_test_bad_db();
+
+	sd_unmount();
+	bench_teardown();
+
+	return host_report("test_kippatch");
+}
@@ -0,0 +1,487 @@
+/*
+ * Alloc trace replay for the LvGL allocator.
+ *
+ * Records the lv_mem_alloc, lv_mem_free and lv_mem_realloc calls of a Nyx
+ * like UI workload, or loads a trace file given as argument, and replays it on
+ * a fresh heap. After every call, all entries are walked and checked against
+ * the free lists and counters, and the data of every live allocation is
+ * checked. Reallocating to and from 0 bytes is tested on its own.
+ *
+ * Trace files have one call per line:
+ *   a <id> <size>            lv_mem_alloc
+ *   f <id>                   lv_mem_free
+ *   r <id> <new id> <size>   lv_mem_realloc
+ * Id 0 is NULL or a 0 byte memory.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+// The checks need the entries and free lists. The calls are wrapped to record them.
+#define lv_mem_alloc   _lv_mem_alloc
+#define lv_mem_free    _lv_mem_free
+#define lv_mem_realloc _lv_mem_realloc
+#include "../../bdk/libs/lvgl/lv_misc/lv_mem.c"
+#undef lv_mem_alloc
+#undef lv_mem_free
+#undef lv_mem_realloc
+
+#include <libs/lvgl/lvgl.h>
+
+#include "host_hw.h"
+#include "nyx_host.h"
+
+enum
+{
+	TRACE_ALLOC   = 'a',
+	TRACE_FREE    = 'f',
+	TRACE_REALLOC = 'r'
+};
+
+typedef struct _trace_op_t
+{
+	u8  op;
+	u32 id;
+	u32 new_id;
+	u32 size;
+} trace_op_t;
+
+static trace_op_t *trace;
+static u32 trace_len;
+static u32 trace_cap;
+static u32 trace_ids;
+
+// Id of each recorded allocation, by its header slot in the heap.
+static u32 ptr_ids[LV_MEM_SIZE / sizeof(lv_mem_header_t)];
+static bool recording;
+
+static u32 *_ptr_slot(const void *p)
+{
+	if (!p || p == &zero_mem)
+		return NULL;
+
+	return &ptr_ids[((const u8 *)p - work_mem) / sizeof(lv_mem_header_t)];
+}
+
+static u32 _ptr_id(const void *p)
+{
+	u32 *slot = _ptr_slot(p);
+
+	return slot ? *slot : 0;
+}
+
+static u32 _ptr_new_id(const void *p)
+{
+	u32 *slot = _ptr_slot(p);
+	if (!slot)
+		return 0;
+
+	*slot = ++trace_ids;
+
+	return *slot;
+}
+
+static void _trace_add(u8 op, u32 id, u32 new_id, u32 size)
+{
+	if (trace_len == trace_cap)
+	{
+		trace_cap = trace_cap ? trace_cap * 2 : 4096;
+		trace = realloc(trace, trace_cap * sizeof(trace_op_t));
+	}
+
+	trace[trace_len++] = (trace_op_t){ op, id, new_id, size };
+}
+
+void *lv_mem_alloc(uint32_t size)
+{
+	void *p = _lv_mem_alloc(size);
+	if (recording)
+		_trace_add(TRACE_ALLOC, _ptr_new_id(p), 0, size);
+
+	return p;
+}
+
+void lv_mem_free(const void *data)
+{
+	if (recording)
+		_trace_add(TRACE_FREE, _ptr_id(data), 0, 0);
+	_lv_mem_free(data);
+}
+
+void *lv_mem_realloc(void *data_p, uint32_t new_size)
+{
+	u32 id = recording ? _ptr_id(data_p) : 0;
+	void *p = _lv_mem_realloc(data_p, new_size);
+	if (recording)
+		_trace_add(TRACE_REALLOC, id, p == data_p ? id : _ptr_new_id(p), new_size);
+
+	return p;
+}
+
+// Walks all entries. Returns false and reports the first broken one.
+static bool _heap_check()
+{
+	lv_mem_ent_t *e = (lv_mem_ent_t *)work_mem;
+	u32 prev_size = 0;
+	bool prev_free = false;
+	u32 frees = 0, free_bytes = 0, used = 0;
+
+	while (e)
+	{
+		u32 off = (u8 *)e - work_mem;
+		u32 size = e->header.d_size;
+		if (!size || (size & (sizeof(lv_mem_header_t) - 1)))
+		{
+			HOST_CHECK(false, "entry at %X has size %d", off, size);
+			return false;
+		}
+		if (e->header.prev_size != prev_size)
+		{
+			HOST_CHECK(false, "entry at %X has previous size %d, expected %d", off, e->header.prev_size, prev_size);
+			return false;
+		}
+		if (!e->header.used && prev_free)
+		{
+			HOST_CHECK(false, "entry at %X is free after a free entry", off);
+			return false;
+		}
+
+		if (e->header.used)
+			used++;
+		else
+		{
+			frees++;
+			free_bytes += size;
+		}
+		prev_size = size;
+		prev_free = !e->header.used;
+
+		if (&e->first_data + size > work_mem + LV_MEM_SIZE)
+		{
+			HOST_CHECK(false, "entry at %X of %d bytes ends past the heap", off, size);
+			return false;
+		}
+		e = ent_get_next(e);
+	}
+
+	if (frees != free_cnt || free_bytes != free_size || used != used_cnt)
+	{
+		HOST_CHECK(false, "%d free entries of %d bytes and %d used, counted %d of %d bytes and %d", frees, free_bytes,
+			used, free_cnt, free_size, used_cnt);
+		return false;
+	}
+
+	// Every free entry is in the bin of its size, once.
+	u32 listed = 0;
+	for (u32 bin = 0; bin < LV_MEM_BIN_NUM; bin++)
+	{
+		if (!free_bins[bin] != !(free_bin_map & BIT(bin)))
+		{
+			HOST_CHECK(false, "bin %d map bit does not match its list", bin);
+			return false;
+		}
+
+		lv_mem_ent_t *prev = NULL;
+		for (e = free_bins[bin]; e; prev = e, e = e->header.next_free)
+		{
+			if (e->header.used || ent_bin(e->header.d_size) != bin || e->header.prev_free != prev || ++listed > frees)
+			{
+				HOST_CHECK(false, "bin %d has a wrong entry at %X", bin, (u8 *)e - work_mem);
+				return false;
+			}
+		}
+	}
+	if (listed != frees)
+	{
+		HOST_CHECK(false, "%d free entries, %d in the bins", frees, listed);
+		return false;
+	}
+
+	return true;
+}
+
+static u8 _pattern(u32 id, u32 i)
+{
+	return (u8)(id * 37 + i * 7);
+}
+
+static void _fill(u8 *p, u32 id, u32 size)
+{
+	for (u32 i = 0; i < size; i++)
+		p[i] = _pattern(id, i);
+}
+
+static bool _data_check(const u8 *p, u32 id, u32 size)
+{
+	for (u32 i = 0; i < size; i++)
+		if (p[i] != _pattern(id, i))
+			return false;
+
+	return true;
+}
+
+static void _test_realloc_zero()
+{
+	lv_mem_init();
+	lv_mem_monitor_t mon;
+	lv_mem_monitor(&mon);
+	u32 empty_size = mon.free_size;
+
+	void *a = lv_mem_alloc(64);
+	void *b = lv_mem_alloc(100);
+	void *c = lv_mem_alloc(40);
+
+	// Truncating to 0 bytes frees the entry.
+	void *z = lv_mem_realloc(b, 0);
+	HOST_CHECK(z == &zero_mem && !lv_mem_get_size(z), "realloc to 0 gave %p of %d bytes", z, lv_mem_get_size(z));
+	HOST_CHECK(_heap_check() && used_cnt == 2, "heap broken after realloc to 0");
+
+	// A 0 byte memory grows like NULL.
+	void *g = lv_mem_realloc(z, 70);
+	HOST_CHECK(g && g != &zero_mem && lv_mem_get_size(g) >= 70, "realloc from 0 gave %p of %d bytes", g, lv_mem_get_size(g));
+	HOST_CHECK(_heap_check() && used_cnt == 3, "heap broken after realloc from 0");
+	HOST_CHECK(lv_mem_realloc(&zero_mem, 0) == &zero_mem && _heap_check(), "realloc of 0 to 0 bytes");
+
+	lv_mem_free(a);
+	lv_mem_free(g);
+	HOST_CHECK(lv_mem_realloc(c, 0) == &zero_mem, "realloc of the last entry to 0");
+	lv_mem_monitor(&mon);
+	HOST_CHECK(_heap_check() && mon.free_cnt == 1 && mon.free_size == empty_size && !mon.used_cnt,
+		"heap not joined back: %d free entries of %d bytes, %d used", mon.free_cnt, mon.free_size, mon.used_cnt);
+}
+
+// Nyx like UI. Windows with lists and text that changes, message boxes and big buffers.
+static void _workload()
+{
+	static const char *mbox_btns[] = { "\211", "\222OK", "\211", "" };
+	char txt[256];
+
+	for (u32 round = 0; round < 20; round++)
+	{
+		lv_obj_t *win = lv_win_create(lv_scr_act(), NULL);
+		lv_win_set_title(win, "eMMC Backup");
+
+		lv_obj_t *list = lv_list_create(win, NULL);
+		for (u32 i = 0; i < 40; i++)
+		{
+			s_printf(txt, "Entry %d of round %d", i, round);
+			lv_list_add(list, NULL, txt, NULL);
+		}
+
+		lv_obj_t *label = lv_label_create(win, NULL);
+		lv_obj_t *ta = lv_ta_create(win, NULL);
+		for (u32 i = 0; i < 60; i++)
+		{
+			// Status text of varying length, like the progress and log labels.
+			u32 len = s_snprintf(txt, sizeof(txt), "#00DDFF %d%%# Sector %08X", i * 100 / 60, i * 0x800);
+			memset(txt + len, '.', (i * 13) % 150);
+			txt[len + (i * 13) % 150] = 0;
+			lv_label_set_text(label, txt);
+
+			lv_ta_add_text(ta, "log line\n");
+
+			if (!(i % 10))
+			{
+				lv_obj_t *mbox = lv_mbox_create(lv_scr_act(), NULL);
+				lv_mbox_set_text(mbox, txt);
+				lv_mbox_add_btns(mbox, mbox_btns, NULL);
+				host_time_add(5000);
+				lv_task_handler();
+				lv_obj_del(mbox);
+			}
+		}
+
+		// Big buffers, like decoded images, and a buffer that is emptied.
+		u8 *buf = lv_mem_alloc(720 * 1280 * 4 / (round % 4 + 1));
+		void *scratch = lv_mem_alloc(512 + round * 32);
+		scratch = lv_mem_realloc(scratch, 0);
+		scratch = lv_mem_realloc(scratch, 128);
+		lv_mem_free(scratch);
+
+		host_time_add(30000);
+		lv_task_handler();
+
+		lv_obj_del(win);
+		lv_mem_free(buf);
+	}
+}
+
+static bool _trace_load(const char *path)
+{
+	FILE *fp = fopen(path, "r");
+	if (!fp)
+	{
+		HOST_CHECK(false, "failed to open %s", path);
+		return false;
+	}
+
+	char line[128];
+	while (fgets(line, sizeof(line), fp))
+	{
+		trace_op_t op = { 0 };
+		int n = 0;
+		switch (line[0])
+		{
+		case TRACE_ALLOC:
+			n = sscanf(line + 1, "%u %u", &op.id, &op.size) == 2;
+			break;
+		case TRACE_FREE:
+			n = sscanf(line + 1, "%u", &op.id) == 1;
+			break;
+		case TRACE_REALLOC:
+			n = sscanf(line + 1, "%u %u %u", &op.id, &op.new_id, &op.size) == 3;
+			break;
+		case '#':
+		case '\n':
+			continue;
+		}
+		if (!n)
+		{
+			HOST_CHECK(false, "bad trace line: %s", line);
+			fclose(fp);
+			return false;
+		}
+
+		_trace_add(line[0], op.id, op.new_id, op.size);
+		trace_ids = MAX(trace_ids, MAX(op.id, op.new_id));
+	}
+	fclose(fp);
+
+	return true;
+}
+
+static void _replay()
+{
+	void **ptrs = calloc(trace_ids + 1, sizeof(void *));
+	u32 *sizes = calloc(trace_ids + 1, sizeof(u32));
+	u32 peak = 0, used = 0;
+
+	lv_mem_init();
+
+	u32 i;
+	for (i = 0; i < trace_len; i++)
+	{
+		trace_op_t *op = &trace[i];
+		void *p = ptrs[op->id];
+		u32 size = sizes[op->id];
+
+		if (op->id && !p && op->op != TRACE_ALLOC)
+		{
+			HOST_CHECK(false, "op %d uses id %d which is not allocated", i, op->id);
+			break;
+		}
+		if (p && !_data_check(p, op->id, size))
+		{
+			HOST_CHECK(false, "op %d: data of id %d was overwritten", i, op->id);
+			break;
+		}
+
+		switch (op->op)
+		{
+		case TRACE_ALLOC:
+			p = lv_mem_alloc(op->size);
+			if (!op->id)
+				break;
+			if (!p || p == &zero_mem)
+			{
+				HOST_CHECK(false, "op %d: allocating %d bytes failed", i, op->size);
+				goto out;
+			}
+			ptrs[op->id] = p;
+			sizes[op->id] = op->size;
+			_fill(p, op->id, op->size);
+			used += op->size;
+			break;
+
+		case TRACE_FREE:
+			lv_mem_free(p);
+			ptrs[op->id] = NULL;
+			used -= size;
+			break;
+
+		case TRACE_REALLOC:
+			p = lv_mem_realloc(p, op->size);
+			ptrs[op->id] = NULL;
+			used -= size;
+			if (!op->size)
+			{
+				if (p != &zero_mem)
+				{
+					HOST_CHECK(false, "op %d: realloc to 0 bytes gave %p", i, p);
+					goto out;
+				}
+				break;
+			}
+			if (!p || p == &zero_mem || !op->new_id)
+			{
+				HOST_CHECK(false, "op %d: reallocating to %d bytes failed", i, op->size);
+				goto out;
+			}
+			if (!_data_check(p, op->id, MIN(size, op->size)))
+			{
+				HOST_CHECK(false, "op %d: realloc of id %d lost its data", i, op->id);
+				goto out;
+			}
+			ptrs[op->new_id] = p;
+			sizes[op->new_id] = op->size;
+			_fill(p, op->new_id, op->size);
+			used += op->size;
+			break;
+		}
+
+		peak = MAX(peak, used);
+		if (!_heap_check())
+		{
+			HOST_CHECK(false, "heap broken after op %d (%c %d %d)", i, op->op, op->id, op->size);
+			break;
+		}
+	}
+
+out:
+	printf("replay: %d of %d calls, %d allocations, %d KiB peak, %d entries used at the end\n", i, trace_len,
+		trace_ids, peak / 1024, used_cnt);
+
+	free(ptrs);
+	free(sizes);
+}
+
+int main(int argc, char *argv[])
+{
+	host_init();
+	host_time_freeze(true);
+
+	if (argc > 1)
+	{
+		if (!_trace_load(argv[1]))
+			return host_report("test_lv_mem");
+	}
+	else
+	{
+		// Record from LvGL init, so every freed pointer has an id.
+		recording = true;
+		nyx_host_init();
+		_workload();
+		recording = false;
+	}
+
+	// Both reset the heap. LvGL is not used after this.
+	_test_realloc_zero();
+	_replay();
+
+	return host_report("test_lv_mem");
+}
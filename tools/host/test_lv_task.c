@@ -0,0 +1,349 @@
+/*
+ * Tests for the LvGL task scheduler.
+ *
+ * Checks the run order across and within priorities, that due tasks run once
+ * per handler pass, one-shot tasks, tasks that create, delete or move other
+ * tasks while the handler walks the lists, and lv_task_time_till_next. A
+ * randomized churn run checks that the priority lists stay sorted by due time.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include <libs/lvgl/lvgl.h>
+#include <libs/lvgl/lv_misc/lv_gc.h>
+
+#include "host_hw.h"
+
+#define TASK_LL(prio) (&LV_GC_ROOT(_lv_task_ll)[prio])
+
+static char order[64];
+static u32 order_len;
+
+static void _reset()
+{
+	lv_mem_init();
+	lv_task_init();
+
+	order_len = 0;
+	order[0] = 0;
+}
+
+static u32 _count(lv_task_prio_t prio)
+{
+	u32 count = 0;
+	lv_task_t *task;
+	LL_READ(*TASK_LL(prio), task)
+		count++;
+
+	return count;
+}
+
+static void _tick(u32 ms)
+{
+	host_time_add(ms * 1000);
+}
+
+// Records its parameter as a character.
+static void _task_mark(void *param)
+{
+	if (order_len < sizeof(order) - 1)
+	{
+		order[order_len++] = (char)(uptr)param;
+		order[order_len] = 0;
+	}
+}
+
+static void _test_order()
+{
+	_reset();
+
+	lv_task_create(_task_mark, 10, LV_TASK_PRIO_LOW,     (void *)'A');
+	lv_task_create(_task_mark, 10, LV_TASK_PRIO_HIGHEST, (void *)'B');
+	lv_task_create(_task_mark, 10, LV_TASK_PRIO_MID,     (void *)'C');
+	lv_task_create(_task_mark, 5,  LV_TASK_PRIO_LOW,     (void *)'D');
+	lv_task_create(_task_mark, 1,  LV_TASK_PRIO_OFF,     (void *)'X');
+
+	// Nothing is due yet.
+	_tick(4);
+	lv_task_handler();
+	HOST_CHECK(!order_len, "ran \"%s\" before any task was due", order);
+	HOST_CHECK(lv_task_time_till_next() == 1, "next task in %d ms, expected 1", lv_task_time_till_next());
+
+	// Higher priorities first. In a priority, earlier due first.
+	_tick(6);
+	lv_task_handler();
+	HOST_CHECK(!strcmp(order, "BCDA"), "run order \"%s\", expected \"BCDA\"", order);
+
+	// Every task ran, so the next one is D again.
+	HOST_CHECK(lv_task_time_till_next() == 5, "next task in %d ms, expected 5", lv_task_time_till_next());
+
+	// Tasks that are always due still run once per pass.
+	_reset();
+	lv_task_create(_task_mark, 0, LV_TASK_PRIO_MID, (void *)'a');
+	lv_task_create(_task_mark, 0, LV_TASK_PRIO_LOW, (void *)'b');
+	for (u32 i = 0; i < 3; i++)
+		lv_task_handler();
+	HOST_CHECK(!strcmp(order, "ababab"), "always due tasks ran \"%s\"", order);
+	HOST_CHECK(!lv_task_time_till_next(), "always due task is not due");
+
+	// No enabled task.
+	_reset();
+	lv_task_create(_task_mark, 1, LV_TASK_PRIO_OFF, (void *)'X');
+	HOST_CHECK(lv_task_time_till_next() == UINT32_MAX, "next task in %d ms without tasks", lv_task_time_till_next());
+}
+
+static lv_task_t *self_del;
+
+static void _task_self_del(void *param)
+{
+	_task_mark(param);
+	lv_task_del(self_del);
+}
+
+static void _test_oneshot()
+{
+	_reset();
+
+	lv_task_t *task = lv_task_create(_task_mark, LV_TASK_ONESHOT, LV_TASK_PRIO_LOWEST, (void *)'o');
+	lv_task_once(task);
+	self_del = lv_task_create(_task_self_del, 0, LV_TASK_PRIO_LOWEST, (void *)'s');
+	lv_task_once(self_del);
+
+	lv_task_handler();
+	lv_task_handler();
+	HOST_CHECK(!strcmp(order, "os"), "one-shot tasks ran \"%s\"", order);
+	HOST_CHECK(!_count(LV_TASK_PRIO_LOWEST), "%d one-shot tasks left", _count(LV_TASK_PRIO_LOWEST));
+
+	// A task made ready runs on the next pass, not after its period.
+	task = lv_task_create(_task_mark, 1000, LV_TASK_PRIO_LOW, (void *)'r');
+	lv_task_ready(task);
+	lv_task_handler();
+	HOST_CHECK(!strcmp(order, "osr"), "ready task did not run: \"%s\"", order);
+
+	// Changing the period moves the task.
+	lv_task_set_period(task, 2);
+	_tick(2);
+	lv_task_handler();
+	HOST_CHECK(!strcmp(order, "osrr"), "task did not run after a shorter period: \"%s\"", order);
+}
+
+static lv_task_t *victim;
+
+static void _task_create(void *param)
+{
+	_task_mark(param);
+	lv_task_create(_task_mark, 0, LV_TASK_PRIO_HIGHEST, (void *)'n');
+	lv_task_create(_task_mark, 0, LV_TASK_PRIO_LOWEST, (void *)'m');
+}
+
+static void _task_del_victim(void *param)
+{
+	_task_mark(param);
+	if (victim)
+		lv_task_del(victim);
+	victim = NULL;
+}
+
+static void _task_prio_victim(void *param)
+{
+	_task_mark(param);
+	if (victim)
+		lv_task_set_prio(victim, LV_TASK_PRIO_OFF);
+	victim = NULL;
+}
+
+static void _test_changes()
+{
+	// Tasks created by a task wait for the next pass, also in lists not walked yet.
+	_reset();
+	lv_task_t *task = lv_task_create(_task_create, 0, LV_TASK_PRIO_MID, (void *)'c');
+	lv_task_once(task);
+	lv_task_handler();
+	HOST_CHECK(!strcmp(order, "c"), "created tasks ran in the same pass: \"%s\"", order);
+	lv_task_handler();
+	HOST_CHECK(!strcmp(order, "cnm"), "created tasks did not run: \"%s\"", order);
+
+	// Deleting the task the walk goes to next.
+	_reset();
+	lv_task_create(_task_del_victim, 0, LV_TASK_PRIO_MID, (void *)'d');
+	victim = lv_task_create(_task_mark, 0, LV_TASK_PRIO_MID, (void *)'v');
+	lv_task_create(_task_mark, 0, LV_TASK_PRIO_MID, (void *)'w');
+	lv_task_handler();
+	HOST_CHECK(!strcmp(order, "dw"), "deleted task ran or walk stopped: \"%s\"", order);
+	HOST_CHECK(_count(LV_TASK_PRIO_MID) == 2, "%d tasks left", _count(LV_TASK_PRIO_MID));
+
+	// Turning off the task the walk goes to next.
+	_reset();
+	lv_task_create(_task_prio_victim, 0, LV_TASK_PRIO_LOW, (void *)'p');
+	victim = lv_task_create(_task_mark, 0, LV_TASK_PRIO_LOW, (void *)'v');
+	lv_task_create(_task_mark, 0, LV_TASK_PRIO_LOW, (void *)'w');
+	lv_task_handler();
+	lv_task_handler();
+	HOST_CHECK(!strcmp(order, "pwpw"), "task turned off ran or walk stopped: \"%s\"", order);
+	HOST_CHECK(_count(LV_TASK_PRIO_OFF) == 1, "%d tasks off", _count(LV_TASK_PRIO_OFF));
+}
+
+static void _test_move_before_head()
+{
+	lv_ll_t ll;
+	lv_ll_init(&ll, sizeof(u32));
+	u32 *a = lv_ll_ins_tail(&ll);
+	u32 *b = lv_ll_ins_tail(&ll);
+	u32 *c = lv_ll_ins_tail(&ll);
+
+	lv_ll_move_before(&ll, c, a);
+	HOST_CHECK(lv_ll_get_head(&ll) == c && lv_ll_get_next(&ll, c) == a && lv_ll_get_tail(&ll) == b,
+		"moving before the head did not update it");
+
+	lv_ll_clear(&ll);
+}
+
+#define CHURN_TASKS 200
+#define CHURN_PASSES 3000
+
+typedef struct _churn_t
+{
+	lv_task_t *task;
+	u32 runs;
+	u32 last_pass;
+	u32 bad_runs;
+} churn_t;
+
+static churn_t churn[CHURN_TASKS];
+static u32 churn_pass;
+static u32 rnd = 1;
+
+static u32 _rand()
+{
+	rnd = rnd * 1103515245 + 12345;
+
+	return rnd >> 8;
+}
+
+static void _task_churn(void *param)
+{
+	churn_t *c = (churn_t *)param;
+
+	if (!c->task || c->last_pass == churn_pass)
+		c->bad_runs++;
+	c->last_pass = churn_pass;
+	c->runs++;
+
+	// Change a random task.
+	churn_t *other = &churn[_rand() % CHURN_TASKS];
+	switch (_rand() % 6)
+	{
+	case 0:
+		if (other->task && other != c)
+		{
+			lv_task_del(other->task);
+			other->task = NULL;
+		}
+		break;
+	case 1:
+		if (!other->task)
+			other->task = lv_task_create(_task_churn, _rand() % 50, _rand() % LV_TASK_PRIO_NUM, other);
+		break;
+	case 2:
+		if (other->task)
+			lv_task_set_prio(other->task, _rand() % LV_TASK_PRIO_NUM);
+		break;
+	case 3:
+		if (other->task)
+			lv_task_set_period(other->task, _rand() % 50);
+		break;
+	case 4:
+		if (other->task)
+			lv_task_ready(other->task);
+		break;
+	case 5:
+		if (other->task)
+			lv_task_reset(other->task);
+		break;
+	}
+}
+
+static bool _lists_sorted()
+{
+	for (u32 prio = 0; prio < LV_TASK_PRIO_NUM; prio++)
+	{
+		u32 last = 0;
+		lv_task_t *task;
+		LL_READ(*TASK_LL(prio), task)
+		{
+			if (task->prio != prio)
+				return false;
+
+			u32 elapsed = lv_tick_elaps(task->last_run);
+			u32 remaining = elapsed >= task->period ? 0 : task->period - elapsed;
+			if (remaining < last)
+				return false;
+			last = remaining;
+		}
+	}
+
+	return true;
+}
+
+static void _test_churn()
+{
+	_reset();
+	memset(churn, 0, sizeof(churn));
+
+	for (u32 i = 0; i < CHURN_TASKS; i++)
+		churn[i].task = lv_task_create(_task_churn, _rand() % 50, 1 + _rand() % (LV_TASK_PRIO_NUM - 1), &churn[i]);
+
+	u32 unsorted = 0;
+	for (churn_pass = 1; churn_pass <= CHURN_PASSES; churn_pass++)
+	{
+		_tick(_rand() % 3);
+		lv_task_handler();
+		unsorted += !_lists_sorted();
+	}
+
+	u32 live = 0, listed = 0, runs = 0, bad = 0;
+	for (u32 i = 0; i < CHURN_TASKS; i++)
+	{
+		live += !!churn[i].task;
+		runs += churn[i].runs;
+		bad += churn[i].bad_runs;
+	}
+	for (u32 prio = 0; prio < LV_TASK_PRIO_NUM; prio++)
+		listed += _count(prio);
+
+	HOST_CHECK(!unsorted, "lists unsorted after %d of %d passes", unsorted, CHURN_PASSES);
+	HOST_CHECK(!bad, "%d runs of deleted tasks or repeated runs in a pass", bad);
+	HOST_CHECK(live == listed, "%d tasks alive, %d in the lists", live, listed);
+	HOST_CHECK(runs > CHURN_PASSES, "only %d runs", runs);
+	printf("churn: %d passes, %d runs, %d tasks alive\n", CHURN_PASSES, runs, live);
+}
+
+int main()
+{
+	host_init();
+	host_time_freeze(true);
+
+	_test_order();
+	_test_oneshot();
+	_test_changes();
+	_test_move_before_head();
+	_test_churn();
+
+	return host_report("test_lv_task");
+}
@@ -0,0 +1,358 @@
+/*
+ * Tests for building and encrypting package2.
+ *
+ * pkg2_build_encrypt encrypts the kernel from its buffer and continues the
+ * CTR stream over the unaligned kernel tail and INI1. This checks its output
+ * against a reference that builds the plain package first and then runs
+ * single pass AES-CTR and SHA-256 over it, for a corpus of kernel sizes,
+ * INI1 offsets and KIP sets. Also checks that the built-in patches hash, which
+ * keys the pkg2 cache, changes with every part of the patch tables.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include "../../bootloader/hos/hos.h"
+#include "../../bootloader/hos/pkg2.h"
+#include "../../bootloader/storage/emummc.h"
+
+#include "host_hw.h"
+
+#define PKG2_KEYSLOT 8
+#define PKG2_MAX     SZ_1M
+
+// Defined by the bootloader.
+emummc_cfg_t emu_cfg;
+const u8 package2_keyseed[SE_KEY_128_SIZE] = {0};
+extern u8 pkg2_keyslot;
+
+typedef struct _pkg2_case_t
+{
+	u32  kernel_size;
+	bool new_pkg2;
+	bool meso;
+	u32  ini1_off; // Non Mesosphere new kernels.
+	u32  kips;
+	bool is_exo;
+} pkg2_case_t;
+
+static u32 rnd_state = 0x1234567;
+
+static u32 _rnd()
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+
+	return rnd_state;
+}
+
+static void _rnd_fill(void *buf, u32 size)
+{
+	for (u32 i = 0; i < size; i++)
+		((u8 *)buf)[i] = _rnd();
+}
+
+static void _test_primitives()
+{
+	// NIST SP 800-38A F.5.1, first block.
+	static u8 key[SE_KEY_128_SIZE] = {
+		0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+	static u8 ctr[SE_AES_IV_SIZE] = {
+		0xF0, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD, 0xFE, 0xFF };
+	static const u8 pt[SE_AES_BLOCK_SIZE] = {
+		0x6B, 0xC1, 0xBE, 0xE2, 0x2E, 0x40, 0x9F, 0x96, 0xE9, 0x3D, 0x7E, 0x11, 0x73, 0x93, 0x17, 0x2A };
+	static const u8 ct[SE_AES_BLOCK_SIZE] = {
+		0x87, 0x4D, 0x61, 0x91, 0xB6, 0x20, 0xE3, 0x26, 0x1B, 0xEF, 0x68, 0x64, 0x99, 0x0D, 0xB6, 0xCE };
+
+	// FIPS 180-2 "abc".
+	static const u8 sha_abc[SE_SHA_256_SIZE] = {
+		0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+		0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD };
+
+	u8 out[SE_SHA_256_SIZE];
+
+	se_aes_key_set(PKG2_KEYSLOT, key, sizeof(key));
+	se_aes_crypt_ctr(PKG2_KEYSLOT, out, sizeof(pt), pt, sizeof(pt), ctr);
+	HOST_CHECK(!memcmp(out, ct, sizeof(ct)), "AES-CTR does not match the known answer");
+
+	se_calc_sha256_oneshot(out, "abc", 3);
+	HOST_CHECK(!memcmp(out, sha_abc, sizeof(sha_abc)), "SHA-256 does not match the known answer");
+}
+
+static u32 _ref_ini1(u8 *dst, link_t *kips)
+{
+	pkg2_ini1_t *ini1 = (pkg2_ini1_t *)dst;
+	u32 size = sizeof(pkg2_ini1_t);
+
+	memset(ini1, 0, sizeof(pkg2_ini1_t));
+	ini1->magic = INI1_MAGIC;
+	LIST_FOREACH_ENTRY(pkg2_kip1_info_t, ki, kips, link)
+	{
+		memcpy(dst + size, ki->kip1, ki->size);
+		size += ki->size;
+		ini1->num_procs++;
+	}
+	size = ALIGN(size, 4);
+	ini1->size = size;
+
+	return size;
+}
+
+// Plain package, then single pass encryption and hashing per section.
+static void _ref_build(u8 *kern_sec, u32 *kern_size, u8 *ini1_sec, u32 *ini1_size, u8 *sha,
+	const pkg2_case_t *c, const u8 *kernel, link_t *kips)
+{
+	u8 ctr[SE_AES_IV_SIZE] = {0};
+
+	memcpy(kern_sec, kernel, c->kernel_size);
+	*kern_size = c->kernel_size;
+	*ini1_size = 0;
+
+	if (c->new_pkg2)
+	{
+		*(u32 *)(kern_sec + (c->meso ? 8 : c->ini1_off)) = c->kernel_size;
+		*kern_size += _ref_ini1(kern_sec + c->kernel_size, kips);
+	}
+	else
+	{
+		*ini1_size = _ref_ini1(ini1_sec, kips);
+		se_aes_crypt_ctr(PKG2_KEYSLOT, ini1_sec, *ini1_size, ini1_sec, *ini1_size, ctr);
+	}
+
+	se_aes_crypt_ctr(PKG2_KEYSLOT, kern_sec, *kern_size, kern_sec, *kern_size, ctr);
+
+	se_calc_sha256_oneshot(sha, kern_sec, *kern_size);
+	se_calc_sha256_oneshot(sha + SE_SHA_256_SIZE, ini1_sec, *ini1_size);
+}
+
+static bool _check_case(const pkg2_case_t *c, u8 *dst, u8 *ref_kern, u8 *ref_ini1)
+{
+	u32 failures = host_failures;
+	char name[64];
+	s_printf(name, "%s%s size %X off %X kips %d%s", c->new_pkg2 ? "new" : "old", c->meso ? " meso" : "",
+		c->kernel_size, c->ini1_off, c->kips, c->is_exo ? " exo" : "");
+
+	// Kernel.
+	u8 *kernel = malloc(c->kernel_size);
+	_rnd_fill(kernel, c->kernel_size);
+	*(u32 *)(kernel + 4) = c->meso ? ATM_MESOSPHERE : 0;
+	u8 *kernel_orig = malloc(c->kernel_size);
+	memcpy(kernel_orig, kernel, c->kernel_size);
+
+	// KIPs.
+	LIST_INIT(kips);
+	pkg2_kip1_info_t *kis = calloc(c->kips, sizeof(pkg2_kip1_info_t));
+	for (u32 i = 0; i < c->kips; i++)
+	{
+		kis[i].size = sizeof(pkg2_kip1_t) + (_rnd() % 0x3000);
+		kis[i].kip1 = malloc(kis[i].size);
+		_rnd_fill(kis[i].kip1, kis[i].size);
+		list_append(&kips, &kis[i].link);
+	}
+
+	// Build.
+	pkg1_id_t pkg1_id = { .kb = KB_FIRMWARE_VERSION_900 };
+	launch_ctxt_t ctxt = {0};
+	ctxt.pkg1_id = &pkg1_id;
+	ctxt.kernel = kernel;
+	ctxt.kernel_size = c->kernel_size;
+	ctxt.new_pkg2 = c->new_pkg2;
+	pkg2_newkern_ini1_val = c->ini1_off;
+	pkg2_keyslot = PKG2_KEYSLOT;
+
+	memset(dst, 0, PKG2_MAX);
+	pkg2_build_encrypt(dst, &ctxt, &kips, c->is_exo);
+
+	// Reference.
+	u8 ref_sha[SE_SHA_256_SIZE * 2];
+	u32 ref_kern_size, ref_ini1_size;
+	memset(ref_kern, 0, PKG2_MAX);
+	memset(ref_ini1, 0, PKG2_MAX);
+	_ref_build(ref_kern, &ref_kern_size, ref_ini1, &ref_ini1_size, ref_sha, c, kernel_orig, &kips);
+
+	// Header.
+	pkg2_hdr_t hdr;
+	u8 ctr[SE_AES_IV_SIZE];
+	memcpy(&hdr, dst + 0x100, sizeof(pkg2_hdr_t));
+	memcpy(ctr, hdr.ctr, SE_AES_IV_SIZE);
+	se_aes_crypt_ctr(PKG2_KEYSLOT, &hdr, sizeof(pkg2_hdr_t), &hdr, sizeof(pkg2_hdr_t), ctr);
+
+	HOST_CHECK(hdr.magic == PKG2_MAGIC, "%s: bad header magic", name);
+	HOST_CHECK(hdr.sec_size[PKG2_SEC_KERNEL] == ref_kern_size, "%s: kernel section size %X, expected %X",
+		name, hdr.sec_size[PKG2_SEC_KERNEL], ref_kern_size);
+	HOST_CHECK(hdr.sec_size[PKG2_SEC_INI1] == ref_ini1_size, "%s: INI1 section size %X, expected %X",
+		name, hdr.sec_size[PKG2_SEC_INI1], ref_ini1_size);
+
+	// Sections.
+	u8 *sec = dst + 0x100 + sizeof(pkg2_hdr_t);
+	HOST_CHECK(!memcmp(sec, ref_kern, ref_kern_size), "%s: kernel section differs from the reference", name);
+	HOST_CHECK(!memcmp(sec + ref_kern_size, ref_ini1, ref_ini1_size), "%s: INI1 section differs from the reference", name);
+
+	if (!c->is_exo)
+	{
+		HOST_CHECK(!memcmp(&hdr.sec_sha256[SE_SHA_256_SIZE * PKG2_SEC_KERNEL], ref_sha, SE_SHA_256_SIZE),
+			"%s: kernel hash differs from the reference", name);
+		HOST_CHECK(!memcmp(&hdr.sec_sha256[SE_SHA_256_SIZE * PKG2_SEC_INI1], ref_sha + SE_SHA_256_SIZE, SE_SHA_256_SIZE),
+			"%s: INI1 hash differs from the reference", name);
+	}
+
+	// The source kernel must not be changed.
+	HOST_CHECK(!memcmp(kernel, kernel_orig, c->kernel_size), "%s: source kernel was modified", name);
+
+	for (u32 i = 0; i < c->kips; i++)
+		free(kis[i].kip1);
+	free(kis);
+	free(kernel);
+	free(kernel_orig);
+
+	return failures == host_failures;
+}
+
+static bool _patches_hash_changed(const u8 *hash)
+{
+	u8 curr[SE_SHA_256_SIZE];
+	pkg2_calc_patches_hash(curr);
+
+	return memcmp(curr, hash, sizeof(curr));
+}
+
+// The pkg2 cache key must change with any built-in patch.
+static void _test_patches_hash()
+{
+	u8 hash[SE_SHA_256_SIZE];
+	static const u8 zero[SE_SHA_256_SIZE] = {0};
+
+	pkg2_calc_patches_hash(hash);
+	HOST_CHECK(memcmp(hash, zero, sizeof(zero)), "patches hash is zero");
+	HOST_CHECK(!_patches_hash_changed(hash), "patches hash is not stable");
+
+	// FS patch offset and data.
+	kip1_id_t *ids;
+	u32 ids_cnt;
+	pkg2_get_ids(&ids, &ids_cnt);
+
+	kip1_patch_t *patch = NULL;
+	for (u32 i = ids_cnt; i > 0 && !patch; i--)
+		for (kip1_patchset_t *ps = ids[i - 1].patchset; ps && ps->name && !patch; ps++)
+			if (ps->patches && ps->patches[0].length)
+				patch = &ps->patches[0];
+
+	HOST_CHECK(patch, "no built-in FS patch");
+	if (patch)
+	{
+		patch->offset ^= 4;
+		HOST_CHECK(_patches_hash_changed(hash), "FS patch offset change kept the hash");
+		patch->offset ^= 4;
+
+		char *dst = patch->dstData;
+		char data[64];
+		memcpy(data, dst, MIN(patch->length, sizeof(data)));
+		data[0] ^= 1;
+		patch->dstData = data;
+		HOST_CHECK(_patches_hash_changed(hash), "FS patch data change kept the hash");
+		patch->dstData = dst;
+	}
+
+	// Kernel patch value and instruction array.
+	const pkg2_kernel_id_t *kern_id = pkg2_identify((u8 *)"\xb8\xc5\x0c\x68\x25\xa9\xb9\x5b"); // 1.0.0.
+	HOST_CHECK(kern_id, "1.0.0 kernel not identified");
+	if (kern_id)
+	{
+		kernel_patch_t *kp = kern_id->kernel_patchset;
+		kp[0].val ^= 1;
+		HOST_CHECK(_patches_hash_changed(hash), "kernel patch value change kept the hash");
+		kp[0].val ^= 1;
+
+		for (; kp->id != 0xFFFFFFFF && kp->id != ATM_ARR_PATCH; kp++)
+			;
+		HOST_CHECK(kp->id == ATM_ARR_PATCH, "1.0.0 kernel has no array patch");
+		if (kp->id == ATM_ARR_PATCH)
+		{
+			kp->ptr[kp->val - 1] ^= 1;
+			HOST_CHECK(_patches_hash_changed(hash), "kernel array patch change kept the hash");
+			kp->ptr[kp->val - 1] ^= 1;
+		}
+	}
+
+	HOST_CHECK(!_patches_hash_changed(hash), "patches hash did not come back");
+}
+
+int main()
+{
+	host_init();
+
+	_test_primitives();
+	_test_patches_hash();
+
+	u8 key[SE_KEY_128_SIZE];
+	_rnd_fill(key, sizeof(key));
+	se_aes_key_set(PKG2_KEYSLOT, key, sizeof(key));
+
+	u8 *dst = malloc(PKG2_MAX);
+	u8 *ref_kern = malloc(PKG2_MAX);
+	u8 *ref_ini1 = malloc(PKG2_MAX);
+	u32 cases = 0;
+
+	// Every unaligned kernel tail, with the INI1 offset in the encrypted part and in the tail.
+	for (u32 tail = 0; tail < SE_AES_BLOCK_SIZE; tail += 4)
+	{
+		for (u32 kips = 0; kips < 4; kips++)
+		{
+			u32 size = 0x20000 + tail;
+			const pkg2_case_t corpus[] = {
+				{ size, false, false, 0,        kips, false },
+				{ size, false, false, 0,        kips, true  },
+				{ size, true,  true,  0,        kips, false },
+				{ size, true,  false, 0x1C4,    kips, false },
+				{ size, true,  false, 0x1C4,    kips, true  },
+				{ size, true,  false, size - 4, kips, false },
+			};
+
+			for (u32 i = 0; i < ARRAY_SIZE(corpus); i++, cases++)
+				if (!_check_case(&corpus[i], dst, ref_kern, ref_ini1))
+					goto out;
+		}
+	}
+
+	// Random sizes and offsets.
+	for (u32 i = 0; i < 200; i++, cases++)
+	{
+		pkg2_case_t c;
+		c.kernel_size = ALIGN(0x1000 + (_rnd() % 0x60000), 4);
+		c.new_pkg2 = _rnd() & 1;
+		c.meso = c.new_pkg2 && !(_rnd() % 3);
+		c.ini1_off = c.new_pkg2 && !c.meso ? ALIGN(8 + (_rnd() % (c.kernel_size - 12)), 4) : 0;
+		if (c.ini1_off + 4 > c.kernel_size)
+			c.ini1_off = c.kernel_size - 4;
+		c.kips = _rnd() % 8;
+		c.is_exo = _rnd() & 1;
+
+		if (!_check_case(&c, dst, ref_kern, ref_ini1))
+			break;
+	}
+
+out:
+	printf("test_pkg2: %d cases\n", cases);
+
+	free(dst);
+	free(ref_kern);
+	free(ref_ini1);
+
+	return host_report("test_pkg2");
+}
@@ -0,0 +1,219 @@
+/*
+ * Tests for s_printf and s_snprintf.
+ *
+ * Compares the output and return value against glibc snprintf for integer,
+ * string and char conversions with all flag, width, precision and length
+ * combinations, on edge and random values and for every truncation size.
+ * Where the bdk differs on purpose, the format is adjusted for glibc first:
+ * hex is upper case and the space flag only pads. Also checks outputs the
+ * old formatter gave, which the GUI relies on.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include "host_hw.h"
+
+static u32 compared;
+
+// Makes the glibc format that gives the bdk output.
+static void _glibc_fmt(char *out, const char *fmt)
+{
+	bool spec = false;
+	for (; *fmt; fmt++)
+	{
+		if (!spec)
+		{
+			spec = *fmt == '%';
+			*out++ = *fmt;
+			continue;
+		}
+
+		if (*fmt == ' ')
+			continue;
+		if (*fmt == 'x')
+		{
+			*out++ = 'X';
+			spec = false;
+			continue;
+		}
+
+		*out++ = *fmt;
+		if (*fmt == '%' || (*fmt >= 'a' && *fmt <= 'z' && *fmt != 'l' && *fmt != 'h' && *fmt != 'j' && *fmt != 'z') ||
+			(*fmt >= 'A' && *fmt <= 'Z'))
+			spec = false;
+	}
+	*out = '\0';
+}
+
+#define COMPARE(fmt, ...) \
+	do { \
+		char _exp[512], _got[512], _gfmt[64]; \
+		_glibc_fmt(_gfmt, fmt); \
+		int _exp_len = snprintf(_exp, sizeof(_exp), _gfmt, __VA_ARGS__); \
+		int _got_len = s_snprintf(_got, sizeof(_got), fmt, __VA_ARGS__); \
+		compared++; \
+		HOST_CHECK(_got_len == _exp_len && !strcmp(_got, _exp), "\"%s\": \"%s\" (%d), glibc \"%s\" (%d)", \
+			fmt, _got, _got_len, _exp, _exp_len); \
+	} while (0)
+
+static const char *const flags[] = { "", "-", "0", " ", "+", "#", "-0", "0+", "- ", "-#", "0#" };
+static const char *const widths[] = { "", "1", "5", "12", "25" };
+static const char *const precs[] = { "", ".", ".0", ".1", ".3", ".11", ".22" };
+
+static const s64 values[] = {
+	0, 1, -1, 9, 10, 99, 100, -100, 12345, 0x7FFFFFFF, -0x7FFFFFFF - 1, 0x80000000, 0xFFFFFFFF,
+	999999999, 1000000000, 4294967296, 999999999999999999, 0x7FFFFFFFFFFFFFFF, -0x7FFFFFFFFFFFFFFF - 1,
+};
+
+static void _test_ints()
+{
+	static const char conv[] = "diuxX";
+	char fmt[32];
+
+	for (u32 f = 0; f < ARRAY_SIZE(flags); f++)
+		for (u32 w = 0; w < ARRAY_SIZE(widths); w++)
+			for (u32 p = 0; p < ARRAY_SIZE(precs); p++)
+				for (u32 c = 0; c < sizeof(conv) - 1; c++)
+					for (u32 v = 0; v < ARRAY_SIZE(values); v++)
+					{
+						s_printf(fmt, "%%%s%s%s%c", flags[f], widths[w], precs[p], conv[c]);
+						COMPARE(fmt, (int)values[v]);
+
+						s_printf(fmt, "%%%s%s%sl%c", flags[f], widths[w], precs[p], conv[c]);
+						COMPARE(fmt, (long)values[v]);
+
+						s_printf(fmt, "%%%s%s%sll%c", flags[f], widths[w], precs[p], conv[c]);
+						COMPARE(fmt, (long long)values[v]);
+
+						s_printf(fmt, "%%%s%s%sh%c", flags[f], widths[w], precs[p], conv[c]);
+						COMPARE(fmt, (int)values[v]);
+
+						s_printf(fmt, "%%%s%s%shh%c", flags[f], widths[w], precs[p], conv[c]);
+						COMPARE(fmt, (int)values[v]);
+					}
+}
+
+static void _test_random()
+{
+	u64 seed = 0x9E3779B97F4A7C15;
+	for (u32 i = 0; i < 200000; i++)
+	{
+		seed = seed * 6364136223846793005 + 1442695040888963407;
+		u64 v = seed >> (seed & 63);
+
+		COMPARE("%d", (int)v);
+		COMPARE("%u", (u32)v);
+		COMPARE("%08X", (u32)v);
+		COMPARE("%lld", (long long)v);
+		COMPARE("%llu", (unsigned long long)v);
+		COMPARE("%016llX", (unsigned long long)v);
+	}
+}
+
+static void _test_strings()
+{
+	static const char *const strs[] = { "", "a", "emummc", "#FF8000 Vendor:#" };
+	char fmt[32];
+
+	for (u32 f = 0; f < 3; f++)
+		for (u32 w = 0; w < ARRAY_SIZE(widths); w++)
+			for (u32 p = 0; p < ARRAY_SIZE(precs); p++)
+				for (u32 s = 0; s < ARRAY_SIZE(strs); s++)
+				{
+					s_printf(fmt, "%%%s%s%ss|", flags[f], widths[w], precs[p]);
+					COMPARE(fmt, strs[s]);
+				}
+
+	for (u32 w = 0; w < ARRAY_SIZE(widths); w++)
+	{
+		s_printf(fmt, "%%%sc|%%-%sc|", widths[w], widths[w]);
+		COMPARE(fmt, 'Z', 'q');
+	}
+
+	COMPARE("%*d|%-*d|%.*d|%*.*s|", 6, 42, 6, 42, 4, 7, 8, 3, "abcdef");
+	COMPARE("%*d|", -6, 42);
+	COMPARE("%zu %jd %lu %%", (size_t)123, (intmax_t)-5, (unsigned long)77);
+	COMPARE("100%% %s %c%c %d", "done", 'o', 'k', 3);
+}
+
+static void _test_truncation()
+{
+	static const char *const fmts[] = { "%s/%08X-%d", "#96FF00 %02d: %s#" };
+
+	for (u32 f = 0; f < ARRAY_SIZE(fmts); f++)
+		for (u32 size = 0; size < 40; size++)
+		{
+			char exp[64], got[64];
+			memset(exp, 0x55, sizeof(exp));
+			memset(got, 0x55, sizeof(got));
+
+			int exp_len = f ? snprintf(exp, size, fmts[f], 7, "BOOT0 and BOOT1") :
+							  snprintf(exp, size, fmts[f], "emuMMC/RAW1", 0xDEADBEEF, -12);
+			int got_len = f ? s_snprintf(got, size, fmts[f], 7, "BOOT0 and BOOT1") :
+							  s_snprintf(got, size, fmts[f], "emuMMC/RAW1", 0xDEADBEEF, -12);
+			compared++;
+
+			HOST_CHECK(got_len == exp_len && !memcmp(got, exp, sizeof(got)), "\"%s\", size %d: \"%.*s\" (%d), glibc \"%.*s\" (%d)",
+				fmts[f], size, size, got, got_len, size, exp, exp_len);
+		}
+}
+
+// Outputs of the old formatter that must not change.
+static void _test_legacy()
+{
+	static const struct { const char *fmt; u32 v; const char *out; } vectors[] = {
+		{ "%x",      0xABCDEF,   "ABCDEF"     },
+		{ "%08x",    0x1234ABCD, "1234ABCD"   },
+		{ "%02x",    0xA,        "0A"         },
+		{ "%X",      0xBEEF,     "BEEF"       },
+		{ "% 5d",    42,         "   42"      },
+		{ "% 2d",    12345,      "12345"      },
+		{ "% 3d",    -7,         " -7"        },
+		{ "%3d",     7,          "  7"        },
+		{ "%02d",    5,          "05"         },
+		{ "%d",      0xFFFFFFFF, "-1"         },
+		{ "%d",      0x80000000, "-2147483648"},
+	};
+
+	char buf[32];
+	for (u32 i = 0; i < ARRAY_SIZE(vectors); i++)
+	{
+		s_printf(buf, vectors[i].fmt, vectors[i].v);
+		HOST_CHECK(!strcmp(buf, vectors[i].out), "\"%s\": \"%s\", expected \"%s\"", vectors[i].fmt, buf, vectors[i].out);
+	}
+
+	// Pointers are upper case hex without prefix.
+	s_printf(buf, "%p", (void *)0x8000ABCD);
+	HOST_CHECK(!strcmp(buf, "8000ABCD"), "\"%%p\": \"%s\"", buf);
+}
+
+int main()
+{
+	host_init();
+
+	_test_ints();
+	_test_random();
+	_test_strings();
+	_test_truncation();
+	_test_legacy();
+
+	printf("compared %d formats with glibc\n", compared);
+
+	return host_report("test_sprintf");
+}
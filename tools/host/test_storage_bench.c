@@ -0,0 +1,261 @@
+/*
+ * Tests for the storage benchmark runner.
+ *
+ * Runs bench_run against a mocked storage with programmed latencies and
+ * checks the I/O it issues, the totals, the latency percentiles, errors and
+ * aborts. Also checks the latency buckets and the random patterns.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include "frontend/fe_storage_bench.h"
+
+#include "host_hw.h"
+
+#define MOCK_MAX_IOS 4096
+
+typedef struct _mock_io_t
+{
+	u32 sector;
+	u32 num;
+	bool write;
+} mock_io_t;
+
+typedef struct _mock_t
+{
+	sdmmc_storage_t storage; // First, so the storage pointer is the mock.
+	mock_io_t ios[MOCK_MAX_IOS];
+	u32 count;
+	u32 fail_at;
+	u32 (*latency)(u32 idx, bool write);
+	u8 *buf;
+} mock_t;
+
+static mock_t mock;
+
+static int _mock_io(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf, bool write)
+{
+	mock_t *m = (mock_t *)storage;
+
+	HOST_CHECK(m == &mock && buf == m->buf, "I/O on wrong storage or buffer");
+	if (m->count >= MOCK_MAX_IOS)
+		return 0;
+
+	mock_io_t *io = &m->ios[m->count];
+	io->sector = sector;
+	io->num = num_sectors;
+	io->write = write;
+
+	host_time_add(m->latency(m->count, write));
+
+	// Clean before and invalidate after, like the SDMMC driver on transfers above 4KB.
+	bpmp_mmu_maint_stats.way_ops += 2;
+
+	return m->count++ != m->fail_at;
+}
+
+static int _mock_read(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+{
+	return _mock_io(storage, sector, num_sectors, buf, false);
+}
+
+static int _mock_write(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+{
+	return _mock_io(storage, sector, num_sectors, buf, true);
+}
+
+static const bench_ops_t mock_ops = {
+	.read  = _mock_read,
+	.write = _mock_write,
+};
+
+static void _mock_reset(u32 (*latency)(u32 idx, bool write))
+{
+	memset(&mock, 0, sizeof(mock));
+	mock.fail_at = -1;
+	mock.latency = latency;
+	mock.buf = (u8 *)&mock;
+}
+
+static u32 _lat_fixed(u32 idx, bool write)
+{
+	return write ? 900 : 300;
+}
+
+// 1 in 100 I/Os is slow.
+static u32 _lat_tail(u32 idx, bool write)
+{
+	return (idx % 100) == 99 ? 20000 : 100 + (idx % 7);
+}
+
+typedef struct _progress_t
+{
+	u32 calls;
+	u32 last_pct;
+	u32 stop_at;
+	bool monotonic;
+} progress_t;
+
+static bool _progress(u32 pct, void *param)
+{
+	progress_t *p = (progress_t *)param;
+
+	if (pct < p->last_pct || pct > 100)
+		p->monotonic = false;
+	p->last_pct = pct;
+	p->calls++;
+
+	return pct < p->stop_at;
+}
+
+static void _test_buckets()
+{
+	// Every latency falls in the first bucket whose max covers it, within 25%.
+	u32 prev_max = 0;
+	for (u32 i = 0; i < BENCH_LAT_BUCKETS; i++)
+	{
+		u32 max = bench_lat_bucket_max(i);
+		HOST_CHECK(!i || max > prev_max, "bucket %d max %d not above %d", i, max, prev_max);
+		prev_max = max;
+	}
+
+	for (u32 us = 0; us < 5000000; us += 1 + us / 64)
+	{
+		bench_lat_t lat = {0};
+		bench_lat_add(&lat, us);
+		u32 idx = 0;
+		while (!lat.hist[idx])
+			idx++;
+
+		u32 max = bench_lat_bucket_max(idx);
+		HOST_CHECK(max >= us && (!idx || bench_lat_bucket_max(idx - 1) < us), "%d us in bucket %d", us, idx);
+		HOST_CHECK(max - us <= us / 4, "%d us bucket max %d", us, max);
+	}
+}
+
+static void _test_pattern()
+{
+	static u32 pattern[MOCK_MAX_IOS];
+
+	// Writes are 4KB aligned.
+	bench_gen_pattern(pattern, MOCK_MAX_IOS, 8, 0x80000, 8, 30);
+	u32 writes = 0;
+	bool aligned = true, in_range = true;
+	for (u32 i = 0; i < MOCK_MAX_IOS; i++)
+	{
+		u32 off = pattern[i] & BENCH_IO_OFF_MASK;
+		writes += !!(pattern[i] & BENCH_IO_WRITE);
+		aligned &= !(off & 7);
+		in_range &= off + 8 <= 0x80000;
+	}
+	HOST_CHECK(aligned && in_range, "aligned pattern: aligned %d, in range %d", aligned, in_range);
+	HOST_CHECK(writes > MOCK_MAX_IOS * 25 / 100 && writes < MOCK_MAX_IOS * 35 / 100, "%d writes of %d", writes, MOCK_MAX_IOS);
+
+	// Reads go to any sector.
+	bench_gen_pattern(pattern, MOCK_MAX_IOS, 8, 0x100000, 1, 0);
+	u32 unaligned = 0;
+	in_range = true;
+	for (u32 i = 0; i < MOCK_MAX_IOS; i++)
+	{
+		HOST_CHECK(!(pattern[i] & BENCH_IO_WRITE), "write in read pattern");
+		unaligned += !!(pattern[i] & 7);
+		in_range &= pattern[i] + 8 <= 0x100000;
+	}
+	HOST_CHECK(in_range && unaligned > MOCK_MAX_IOS / 2, "read pattern: in range %d, %d unaligned", in_range, unaligned);
+}
+
+static void _test_run()
+{
+	static u32 pattern[1000];
+	bench_res_t res;
+	progress_t prog;
+
+	// Sequential reads.
+	_mock_reset(_lat_fixed);
+	memset(&prog, 0, sizeof(prog));
+	prog.stop_at = 101;
+	prog.monotonic = true;
+	int err = bench_run(&mock_ops, &mock.storage, 0x1000, NULL, 64, 0x100, mock.buf, &res, _progress, &prog);
+	HOST_CHECK(!err && mock.count == 64, "sequential: error %d, %d I/Os", err, mock.count);
+	for (u32 i = 0; i < mock.count; i++)
+		HOST_CHECK(mock.ios[i].sector == 0x1000 + i * 0x100 && mock.ios[i].num == 0x100 && !mock.ios[i].write,
+			"sequential I/O %d: sector %X", i, mock.ios[i].sector);
+	HOST_CHECK(res.ios == 64 && res.sectors == 64 * 0x100 && res.time_us == 64 * 300, "sequential totals: %d %d %d",
+		res.ios, res.sectors, res.time_us);
+	// 8MB in 19.2ms.
+	HOST_CHECK(bench_rate_1k(&res) == 416666 && bench_iops(&res) == 3333, "rate %d, iops %d",
+		bench_rate_1k(&res), bench_iops(&res));
+	HOST_CHECK(prog.calls == 64 && prog.last_pct == 100 && prog.monotonic, "progress: %d calls, last %d", prog.calls, prog.last_pct);
+	HOST_CHECK(res.maint_ops == 128 && bench_maint_ops_per_mb(&res) == 16, "%d cache ops, %d per MB", res.maint_ops,
+		bench_maint_ops_per_mb(&res));
+
+	// Patterns pick the offset and the operation.
+	_mock_reset(_lat_fixed);
+	bench_gen_pattern(pattern, 1000, 8, 0x8000, 8, 50);
+	err = bench_run(&mock_ops, &mock.storage, 0x200, pattern, 1000, 8, mock.buf, &res, NULL, NULL);
+	u32 writes = 0;
+	for (u32 i = 0; i < mock.count; i++)
+	{
+		bool write = !!(pattern[i] & BENCH_IO_WRITE);
+		writes += write;
+		HOST_CHECK(mock.ios[i].sector == 0x200 + (pattern[i] & BENCH_IO_OFF_MASK) && mock.ios[i].write == write,
+			"pattern I/O %d differs", i);
+	}
+	HOST_CHECK(!err && res.time_us == writes * 900 + (1000 - writes) * 300, "pattern: error %d, time %d", err, res.time_us);
+	// Percentiles are bucket bounds.
+	u32 p0 = bench_lat_percentile(&res.lat, 0);
+	HOST_CHECK(res.lat.max_us == 900 && p0 >= 300 && p0 <= 300 * 5 / 4, "pattern latency: max %d, min %d", res.lat.max_us, p0);
+
+	// Tail latency shows in p99 and max, not in p50.
+	_mock_reset(_lat_tail);
+	err = bench_run(&mock_ops, &mock.storage, 0, NULL, 1000, 8, mock.buf, &res, NULL, NULL);
+	u32 p50 = bench_lat_percentile(&res.lat, 50);
+	u32 p99 = bench_lat_percentile(&res.lat, 99);
+	u32 p100 = bench_lat_percentile(&res.lat, 100);
+	HOST_CHECK(!err && res.lat.count == 1000 && res.lat.max_us == 20000, "tail: error %d, %d samples, max %d",
+		err, res.lat.count, res.lat.max_us);
+	HOST_CHECK(p50 >= 100 && p50 <= 106 * 5 / 4, "p50 %d", p50);
+	HOST_CHECK(p99 >= 100 && p99 <= 106 * 5 / 4 && p100 == 20000, "p99 %d, p100 %d", p99, p100);
+	HOST_CHECK(res.lat.total_us == res.time_us, "latency total %d, time %d", (u32)res.lat.total_us, res.time_us);
+
+	// A failed I/O stops the run.
+	_mock_reset(_lat_fixed);
+	mock.fail_at = 10;
+	err = bench_run(&mock_ops, &mock.storage, 0, NULL, 100, 8, mock.buf, &res, NULL, NULL);
+	HOST_CHECK(err == 1 && mock.count == 11 && res.ios == 10, "error: %d, %d I/Os, %d counted", err, mock.count, res.ios);
+
+	// So does the progress callback.
+	_mock_reset(_lat_fixed);
+	memset(&prog, 0, sizeof(prog));
+	prog.stop_at = 50;
+	err = bench_run(&mock_ops, &mock.storage, 0, NULL, 100, 8, mock.buf, &res, _progress, &prog);
+	HOST_CHECK(err == BENCH_ABORTED && mock.count == 50 && res.ios == 50, "abort: %d, %d I/Os", err, mock.count);
+}
+
+int main()
+{
+	host_init();
+	host_time_freeze(true);
+
+	_test_buckets();
+	_test_pattern();
+	_test_run();
+
+	return host_report("test_storage_bench");
+}
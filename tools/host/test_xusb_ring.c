@@ -0,0 +1,316 @@
+/*
+ * XUSB device bulk ring tests.
+ *
+ * Runs xusb_device_ep1_out_read_big against a model of the device controller.
+ * The model fetches Normal TRBs by cycle bit, follows the Link TRB and toggles
+ * its cycle, writes a pattern to the TRB buffers and posts transfer events on
+ * the two event ring segments. Events can be reversed, posted twice or stopped,
+ * like a host that goes away. Checks data, byte counts, the queued TRB bitmap,
+ * the event ring and EP context invalidation per interrupt and that the ring
+ * lines up with the controller again after an error exit.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+
+#include <bdk.h>
+
+#include "host_hw.h"
+
+// Controller registers go to the model.
+static vu32 *_xhci_reg(u32 off);
+#undef XUSB_DEV_XHCI
+#define XUSB_DEV_XHCI(off) (*_xhci_reg(off))
+
+#include "../../bdk/usb/usb_descriptors.c"
+#include "../../bdk/usb/xusbd.c"
+
+// Used by the controller init and power code.
+void clock_enable_pllu() {}
+void clock_disable_pllu() {}
+void clock_enable_utmipll() {}
+void mc_enable_ahb_redirect() {}
+
+#define EVT_SLOTS (XUSB_TRB_SLOTS * 2)
+#define XFER_BUF  ((u8 *)USB_EP_BULK_OUT_BUF_ADDR)
+
+typedef struct _xhci_model_t
+{
+	u32 regs[0x100 / sizeof(u32)];
+	bool ip_polled;
+	bool ip_clear;
+
+	// Bulk OUT ring.
+	u32 deq;
+	u32 ccs;
+
+	// Event ring.
+	u32 evt_idx;
+	u32 evt_cycle;
+
+	// Host behaviour.
+	bool reverse;     // Post each batch of events in reverse order.
+	bool duplicate;   // Post every event twice.
+	u32 budget;       // TRBs to complete before the host stops. 0 is unlimited.
+	u32 residual;     // Bytes not sent per TRB.
+
+	u32 completed;
+	u32 interrupts;
+	u64 data_off;     // Offset of the pattern in the host stream.
+} xhci_model_t;
+
+static xhci_model_t xhci;
+
+// Event ring and EP context invalidations by the driver.
+static u32 evt_invalidates;
+static u32 ctx_invalidates;
+
+void bpmp_mmu_maintenance_range(u32 op, const void *buf, u32 size)
+{
+	if (op != BPMP_MMU_MAINT_INVALID_WAY)
+		return;
+
+	if (buf == xusb_evtq->xusb_event_ring_seg0 && size >= sizeof(event_trb_t) * EVT_SLOTS)
+		evt_invalidates++;
+	else if (buf == (void *)xusb_evtq->xusb_ep_ctxt && size >= sizeof(xusb_evtq->xusb_ep_ctxt))
+		ctx_invalidates++;
+}
+
+static u8 _pattern(u64 off)
+{
+	return (off >> 12) ^ off ^ 0x5A;
+}
+
+static event_trb_t *_evt_slot(u32 idx)
+{
+	return idx < XUSB_TRB_SLOTS ? &xusb_evtq->xusb_event_ring_seg0[idx] :
+								  &xusb_evtq->xusb_event_ring_seg1[idx - XUSB_TRB_SLOTS];
+}
+
+static void _post_event(data_trb_t *trb, u32 residual)
+{
+	transfer_event_trb_t *evt = (transfer_event_trb_t *)_evt_slot(xhci.evt_idx);
+
+	memset(evt, 0, sizeof(transfer_event_trb_t));
+	evt->trb_pointer_lo = (u32)trb;
+	evt->trb_tx_len = residual;
+	evt->comp_code = XUSB_COMP_SUCCESS;
+	evt->trb_type = XUSB_TRB_TRANSFER;
+	evt->ep_id = USB_EP_BULK_OUT;
+	evt->cycle = xhci.evt_cycle;
+
+	xhci.evt_idx++;
+	if (xhci.evt_idx == EVT_SLOTS)
+	{
+		xhci.evt_idx = 0;
+		xhci.evt_cycle ^= 1;
+	}
+}
+
+// Fetches and completes the TRBs the driver owns over to the controller, then posts their events.
+static void _xhci_run()
+{
+	data_trb_t *ring = xusb_evtq->xusb_bulkout_event_queue;
+	data_trb_t *done[XUSB_TRB_SLOTS];
+	u32 done_cnt = 0;
+
+	while (ring[xhci.deq].cycle == xhci.ccs && done_cnt < XUSB_TRB_SLOTS)
+	{
+		data_trb_t *trb = &ring[xhci.deq];
+		if (trb->trb_type == XUSB_TRB_LINK)
+		{
+			link_trb_t *link_trb = (link_trb_t *)trb;
+			if (link_trb->toggle_cycle)
+				xhci.ccs ^= 1;
+			xhci.deq = ((data_trb_t *)(link_trb->ring_seg_ptrlo << 4)) - ring;
+			continue;
+		}
+
+		// Host stopped sending.
+		if (xhci.budget && xhci.completed == xhci.budget)
+			break;
+
+		HOST_CHECK(trb->trb_type == XUSB_TRB_NORMAL && trb->ioc, "slot %d: bad TRB type %d", xhci.deq, trb->trb_type);
+
+		u8 *buf = (u8 *)trb->databufptr_lo;
+		u32 len = trb->trb_tx_len - xhci.residual;
+		for (u32 i = 0; i < len; i++)
+			buf[i] = _pattern(xhci.data_off + i);
+		xhci.data_off += len;
+
+		done[done_cnt++] = trb;
+		xhci.completed++;
+		xhci.deq++;
+	}
+
+	if (!done_cnt)
+		return;
+
+	for (u32 i = 0; i < done_cnt; i++)
+	{
+		data_trb_t *trb = done[xhci.reverse ? done_cnt - 1 - i : i];
+		_post_event(trb, xhci.residual);
+		if (xhci.duplicate)
+			_post_event(trb, xhci.residual);
+	}
+
+	xhci.regs[XUSB_DEV_XHCI_EREPLO / 4] = (u32)_evt_slot(xhci.evt_idx) | XCHI_ECS;
+	xhci.regs[XUSB_DEV_XHCI_ST / 4] |= XHCI_ST_IP;
+	xhci.interrupts++;
+}
+
+// The driver polls ST for the interrupt and then writes it back to clear it.
+static vu32 *_xhci_reg(u32 off)
+{
+	if (off == XUSB_DEV_XHCI_ST)
+	{
+		u32 *st = &xhci.regs[XUSB_DEV_XHCI_ST / 4];
+		if (xhci.ip_clear)
+		{
+			*st &= ~XHCI_ST_IP;
+			xhci.ip_clear = false;
+		}
+
+		if (!(*st & XHCI_ST_IP))
+			_xhci_run();
+
+		if (*st & XHCI_ST_IP)
+		{
+			if (xhci.ip_polled)
+				xhci.ip_clear = true;
+			xhci.ip_polled = !xhci.ip_polled;
+		}
+	}
+
+	return &xhci.regs[off / 4];
+}
+
+static void _setup()
+{
+	memset(&xhci, 0, sizeof(xhci));
+	xhci.ccs = 1;
+	xhci.evt_cycle = 1;
+	evt_invalidates = 0;
+	ctx_invalidates = 0;
+
+	memset(xusb_evtq, 0, sizeof(xusbd_event_queues_t));
+	memset(&usbd_xotg_controller_ctxt, 0, sizeof(usbd_xotg_controller_ctxt));
+	usbd_xotg = &usbd_xotg_controller_ctxt;
+	usbd_xotg->desc = &usb_gadget_ums_descriptors;
+	usbd_xotg->gadget = USB_GADGET_UMS;
+
+	_xusbd_ep_init_event_ring();
+	_xusb_ep_init_context(USB_EP_BULK_OUT);
+}
+
+static bool _check_data(u32 len, u64 data_off)
+{
+	for (u32 i = 0; i < len; i++)
+		if (XFER_BUF[i] != _pattern(data_off + i))
+			return false;
+
+	return true;
+}
+
+// Checks that the driver ring state matches the controller.
+static void _check_ring(const char *name)
+{
+	data_trb_t *ring = xusb_evtq->xusb_bulkout_event_queue;
+
+	HOST_CHECK(!usbd_xotg->tx_trb_queued[USB_DIR_OUT], "%s: TRBs still queued %04X", name,
+		usbd_xotg->tx_trb_queued[USB_DIR_OUT]);
+	HOST_CHECK(!usbd_xotg->tx_count[USB_DIR_OUT], "%s: %d TRBs counted", name, usbd_xotg->tx_count[USB_DIR_OUT]);
+	HOST_CHECK(usbd_xotg->bulkout_epenqueue_ptr == &ring[xhci.deq], "%s: enqueue at slot %d, controller at %d", name,
+		(u32)(usbd_xotg->bulkout_epenqueue_ptr - ring), xhci.deq);
+	HOST_CHECK((usbd_xotg->bulkout_producer_cycle & 1) == xhci.ccs, "%s: producer cycle %d, controller cycle %d", name,
+		usbd_xotg->bulkout_producer_cycle & 1, xhci.ccs);
+	HOST_CHECK(ring[xhci.deq].cycle != xhci.ccs, "%s: controller owns a TRB past enqueue", name);
+}
+
+static void _test_read(const char *name, u32 len, u32 reads, bool reverse, bool duplicate, u32 residual)
+{
+	_setup();
+	xhci.reverse = reverse;
+	xhci.duplicate = duplicate;
+	xhci.residual = residual;
+
+	for (u32 i = 0; i < reads; i++)
+	{
+		u32 bytes_read = 0;
+		u64 data_off = xhci.data_off;
+		u32 trbs = ALIGN(len, USB_EP_BUFFER_MAX_SIZE) / USB_EP_BUFFER_MAX_SIZE;
+		u32 expected = len - trbs * residual;
+
+		memset(XFER_BUF, 0, len);
+		int res = xusb_device_ep1_out_read_big(XFER_BUF, len, &bytes_read);
+
+		HOST_CHECK(!res, "%s, read %d: error %d", name, i, res);
+		HOST_CHECK(bytes_read == expected, "%s, read %d: %d bytes read, expected %d", name, i, bytes_read, expected);
+		if (!residual)
+			HOST_CHECK(_check_data(len, data_off), "%s, read %d: data mismatch", name, i);
+		_check_ring(name);
+	}
+
+	HOST_CHECK(evt_invalidates == xhci.interrupts, "%s: %d event ring invalidates for %d interrupts", name,
+		evt_invalidates, xhci.interrupts);
+	HOST_CHECK(ctx_invalidates == xhci.interrupts, "%s: %d EP context invalidates for %d interrupts", name,
+		ctx_invalidates, xhci.interrupts);
+}
+
+static void _test_error_exit(const char *name, u32 budget, bool reverse)
+{
+	_setup();
+	xhci.reverse = reverse;
+
+	// Offset the ring so the rewind crosses the Link TRB.
+	u32 bytes_read = 0;
+	int res = xusb_device_ep1_out_read_big(XFER_BUF, USB_EP_BUFFER_MAX_SIZE * 10, &bytes_read);
+	HOST_CHECK(!res, "%s: warm up error %d", name, res);
+
+	// Host stops after some TRBs.
+	xhci.budget = xhci.completed + budget;
+	res = xusb_device_ep1_out_read_big(XFER_BUF, SZ_4M, &bytes_read);
+	HOST_CHECK(res == USB_ERROR_TIMEOUT, "%s: error %d, expected timeout", name, res);
+	HOST_CHECK(!bytes_read, "%s: %d bytes read on error", name, bytes_read);
+	_check_ring(name);
+
+	// Host is back. The ring must continue where the controller is.
+	xhci.budget = 0;
+	u64 data_off = xhci.data_off;
+	res = xusb_device_ep1_out_read_big(XFER_BUF, SZ_1M, &bytes_read);
+	HOST_CHECK(!res && bytes_read == SZ_1M, "%s: read after error: error %d, %d bytes", name, res, bytes_read);
+	HOST_CHECK(_check_data(SZ_1M, data_off), "%s: read after error: data mismatch", name);
+	_check_ring(name);
+}
+
+int main()
+{
+	host_init();
+	host_time_freeze(true);
+
+	// 4MB is 64 TRBs, so the ring wraps over the Link TRB several times.
+	_test_read("in order", SZ_4M, 3, false, false, 0);
+	_test_read("reversed", SZ_4M, 3, true, false, 0);
+	_test_read("duplicate", SZ_4M, 3, true, true, 0);
+	_test_read("unaligned", SZ_4M + SZ_4K + 512, 2, true, false, 0);
+	_test_read("short", SZ_1M, 2, false, false, 512);
+
+	_test_error_exit("stop", 3, false);
+	_test_error_exit("stop reversed", 3, true);
+	_test_error_exit("stop at once", 0, false);
+
+	return host_report("test_xusb_ring");
+}
@@ -0,0 +1,375 @@
+/*
+ * Compiles patches.ini to the binary patch database used by the bootloader.
+ *
+ * Usage: kippatch_db patches.ini patches.bin
+ *
+ * The parser mirrors bootloader/hos/pkg2_ini_kippatch.c and the output must
+ * be byte identical to the one the bootloader generates on SD.
+ *
+ * The database is keyed on the ini size and FAT modification time. The time
+ * is taken from the local mtime of the ini, so the ini must be copied to SD
+ * with its modification time preserved or the bootloader recompiles it.
+ *
+ * Copyright (c) 2022 CantWeAllDisagree
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+typedef uint8_t  u8;
+typedef uint32_t u32;
+
+#define ALIGN(x, a) (((x) + (a) - 1) & ~((a) - 1))
+#define KPS(x) ((u32)(x) << 29)
+
+#define KIPPATCH_DB_MAGIC   0x4244504B // "KPDB".
+#define KIPPATCH_DB_VERSION 2
+
+typedef struct _kippatch_db_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u32 ini_size;
+	u32 ini_time; // FAT date and time.
+	u32 sec_cnt;
+	u32 pt_cnt;
+	u32 data_size;
+	u32 data_crc32;
+} kippatch_db_hdr_t;
+
+typedef struct _kippatch_db_sec_t
+{
+	u32 name_off;
+	u8  hash[8];
+	u32 pt_start;
+	u32 pt_cnt;
+} kippatch_db_sec_t;
+
+typedef struct _kippatch_db_pt_t
+{
+	u32 name_off;
+	u32 offset;
+	u32 length;
+	u32 data_off;
+} kippatch_db_pt_t;
+
+typedef struct _patch_t
+{
+	char *name;
+	u32 offset;
+	u32 length;
+	u8 *srcData;
+	u8 *dstData;
+	struct _patch_t *next;
+} patch_t;
+
+typedef struct _section_t
+{
+	char *name;
+	u8 hash[8];
+	patch_t *pts;
+	patch_t *pts_last;
+	struct _section_t *next;
+} section_t;
+
+static u32 _crc32(const u8 *buf, u32 len)
+{
+	u32 crc = ~0u;
+
+	for (u32 i = 0; i < len; i++)
+	{
+		crc ^= buf[i];
+		for (u32 j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+static u8 *_htoa(u8 *result, const char *ptr, u8 byte_len, u8 *buf)
+{
+	char ch = *ptr;
+	u32 ascii_len = byte_len * 2;
+	if (!result)
+		result = buf;
+	u8 *dst = result;
+
+	while (ch == ' ' || ch == '\t')
+		ch = *(++ptr);
+
+	bool shift = true;
+	while (ascii_len)
+	{
+		u8 tmp = 0;
+		if (ch >= '0' && ch <= '9')
+			tmp = (ch - '0');
+		else if (ch >= 'A' && ch <= 'F')
+			tmp = (ch - 'A' + 10);
+		else if (ch >= 'a' && ch <= 'f')
+			tmp = (ch - 'a' + 10);
+
+		if (shift)
+			*dst = (tmp << 4) & 0xF0;
+		else
+		{
+			*dst |= (tmp & 0x0F);
+			dst++;
+		}
+
+		ascii_len--;
+		ch = *(++ptr);
+		shift = !shift;
+	}
+
+	return result;
+}
+
+static u32 _find_patch_section_name(char *lbuf, u32 lblen, char schar)
+{
+	u32 i;
+	for (i = 0; i < lblen  && lbuf[i] != schar && lbuf[i] != '\n'; i++)
+		;
+	lbuf[i] = 0;
+
+	return i;
+}
+
+static u32 _ini_get_line(char *lbuf, u32 lbuf_size, const char *data, u32 size, u32 *pos)
+{
+	u32 len = 0;
+
+	while (len < (lbuf_size - 1) && *pos < size)
+	{
+		char ch = data[(*pos)++];
+		if (ch == '\r')
+			continue;
+
+		lbuf[len++] = ch;
+		if (ch == '\n')
+			break;
+	}
+	lbuf[len] = 0;
+
+	return len;
+}
+
+static section_t *_parse(const char *data, u32 size)
+{
+	section_t *first = NULL;
+	section_t *ksec = NULL;
+	char lbuf[512];
+	u32 data_pos = 0;
+	u32 lblen;
+
+	do
+	{
+		lblen = _ini_get_line(lbuf, sizeof(lbuf), data, size, &data_pos);
+
+		if (lblen && lbuf[lblen - 1] == '\n')
+			lbuf[lblen - 1] = 0;
+
+		if (lblen > 2 && lbuf[0] == '[')
+		{
+			_find_patch_section_name(lbuf, lblen, ']');
+
+			section_t *sec = calloc(1, sizeof(section_t));
+			char *name = &lbuf[1];
+			u32 i = _find_patch_section_name(name, strlen(name), ':') + 1;
+			sec->name = strdup(name);
+			_htoa(sec->hash, &name[i], 8, NULL);
+
+			if (ksec)
+				ksec->next = sec;
+			else
+				first = sec;
+			ksec = sec;
+		}
+		else if (ksec && lbuf[0] == '.')
+		{
+			u32 str_start = 0;
+			u32 pos = _find_patch_section_name(lbuf, lblen, '=');
+
+			patch_t *pt = calloc(1, sizeof(patch_t));
+			pt->name = strdup(&lbuf[1]);
+
+			u8 kip_sidx = lbuf[pos + 1] - '0';
+			pos += 3;
+
+			if (kip_sidx < 6)
+			{
+				pt->offset = KPS(kip_sidx);
+				str_start = _find_patch_section_name(&lbuf[pos], lblen - pos, ':');
+				pt->offset |= strtol(&lbuf[pos], NULL, 16);
+				pos += str_start + 1;
+
+				str_start = _find_patch_section_name(&lbuf[pos], lblen - pos, ':');
+				pt->length = strtol(&lbuf[pos], NULL, 16);
+				pos += str_start + 1;
+
+				u8 *buf = malloc(pt->length * 2 + 1);
+
+				str_start = _find_patch_section_name(&lbuf[pos], lblen - pos, ',');
+				pt->srcData = _htoa(NULL, &lbuf[pos], pt->length, buf);
+				pos += str_start + 1;
+
+				pt->dstData = _htoa(NULL, &lbuf[pos], pt->length, buf + pt->length);
+			}
+
+			if (ksec->pts_last)
+				ksec->pts_last->next = pt;
+			else
+				ksec->pts = pt;
+			ksec->pts_last = pt;
+		}
+	} while (data_pos < size);
+
+	return first;
+}
+
+static u8 *_compile(section_t *secs, u32 ini_size, u32 ini_time, u32 *db_size)
+{
+	u32 sec_cnt = 0;
+	u32 pt_cnt = 0;
+	u32 pool_size = 0;
+
+	for (section_t *ksec = secs; ksec; ksec = ksec->next)
+	{
+		sec_cnt++;
+		pool_size += ALIGN(strlen(ksec->name) + 1, 4);
+		for (patch_t *pt = ksec->pts; pt; pt = pt->next)
+		{
+			pt_cnt++;
+			pool_size += ALIGN(strlen(pt->name) + 1, 4);
+			if (pt->srcData)
+				pool_size += ALIGN(pt->length * 2, 4);
+		}
+	}
+
+	u32 tables_size = sec_cnt * sizeof(kippatch_db_sec_t) + pt_cnt * sizeof(kippatch_db_pt_t);
+	u32 data_size = tables_size + pool_size + sizeof(u32);
+	u8 *db = calloc(1, sizeof(kippatch_db_hdr_t) + data_size);
+
+	kippatch_db_hdr_t *hdr = (kippatch_db_hdr_t *)db;
+	u8 *data = db + sizeof(kippatch_db_hdr_t);
+	kippatch_db_sec_t *db_secs = (kippatch_db_sec_t *)data;
+	kippatch_db_pt_t *db_pts = (kippatch_db_pt_t *)(data + sec_cnt * sizeof(kippatch_db_sec_t));
+
+	u32 sec_idx = 0;
+	u32 pt_idx = 0;
+	u32 pool_off = tables_size;
+	for (section_t *ksec = secs; ksec; ksec = ksec->next)
+	{
+		kippatch_db_sec_t *db_sec = &db_secs[sec_idx++];
+		db_sec->name_off = pool_off;
+		strcpy((char *)&data[pool_off], ksec->name);
+		pool_off += ALIGN(strlen(ksec->name) + 1, 4);
+		memcpy(db_sec->hash, ksec->hash, sizeof(db_sec->hash));
+		db_sec->pt_start = pt_idx;
+
+		for (patch_t *pt = ksec->pts; pt; pt = pt->next)
+		{
+			kippatch_db_pt_t *db_pt = &db_pts[pt_idx++];
+			db_pt->name_off = pool_off;
+			strcpy((char *)&data[pool_off], pt->name);
+			pool_off += ALIGN(strlen(pt->name) + 1, 4);
+			db_pt->offset = pt->offset;
+			db_pt->length = pt->length;
+
+			if (pt->srcData)
+			{
+				db_pt->data_off = pool_off;
+				memcpy(&data[pool_off], pt->srcData, pt->length);
+				memcpy(&data[pool_off + pt->length], pt->dstData, pt->length);
+				pool_off += ALIGN(pt->length * 2, 4);
+			}
+
+			db_sec->pt_cnt++;
+		}
+	}
+
+	hdr->magic = KIPPATCH_DB_MAGIC;
+	hdr->version = KIPPATCH_DB_VERSION;
+	hdr->ini_size = ini_size;
+	hdr->ini_time = ini_time;
+	hdr->sec_cnt = sec_cnt;
+	hdr->pt_cnt = pt_cnt;
+	hdr->data_size = data_size;
+	hdr->data_crc32 = _crc32(data, data_size);
+
+	*db_size = sizeof(kippatch_db_hdr_t) + data_size;
+
+	return db;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s patches.ini patches.bin\n", argv[0]);
+		return 1;
+	}
+
+	FILE *in = fopen(argv[1], "rb");
+	if (!in)
+	{
+		fprintf(stderr, "Failed to open %s\n", argv[1]);
+		return 1;
+	}
+
+	struct stat st;
+	struct tm tm;
+	if (fstat(fileno(in), &st) || !localtime_r(&st.st_mtime, &tm))
+	{
+		fprintf(stderr, "Failed to stat %s\n", argv[1]);
+		fclose(in);
+		return 1;
+	}
+
+	// FAT date and time. Seconds have a 2s resolution.
+	u32 ini_size = st.st_size;
+	u32 ini_time = ((u32)(tm.tm_year - 80) << 25) | ((u32)(tm.tm_mon + 1) << 21) | ((u32)tm.tm_mday << 16) |
+		((u32)tm.tm_hour << 11) | ((u32)tm.tm_min << 5) | ((u32)tm.tm_sec >> 1);
+
+	char *ini = malloc(ini_size + 1);
+	if (fread(ini, 1, ini_size, in) != ini_size)
+	{
+		fprintf(stderr, "Failed to read %s\n", argv[1]);
+		fclose(in);
+		return 1;
+	}
+	fclose(in);
+
+	u32 db_size;
+	section_t *secs = _parse(ini, ini_size);
+	u8 *db = _compile(secs, ini_size, ini_time, &db_size);
+
+	FILE *out = fopen(argv[2], "wb");
+	if (!out || fwrite(db, 1, db_size, out) != db_size)
+	{
+		fprintf(stderr, "Failed to write %s\n", argv[2]);
+		return 1;
+	}
+	fclose(out);
+
+	printf("%s: %d kips, %d patches, %d bytes\n", argv[2],
+		((kippatch_db_hdr_t *)db)->sec_cnt, ((kippatch_db_hdr_t *)db)->pt_cnt, db_size);
+
+	return 0;
+}